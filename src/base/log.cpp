@@ -3,8 +3,14 @@
 #include "color.h"
 #include "system.h"
 
+#include "tl/threading.h"
+
+#include <algorithm>
 #include <atomic>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #if defined(CONF_FAMILY_WINDOWS)
 #define WIN32_LEAN_AND_MEAN
@@ -73,6 +79,41 @@ void log_set_scope_logger(ILogger *logger)
 	}
 }
 
+// Separate declaration, as attributes are not allowed on function definitions
+static void log_message_format(CLogMessage *pMsg, LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
+	GNUC_ATTRIBUTE((format(printf, 6, 0)));
+
+static void log_message_format(CLogMessage *pMsg, LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
+{
+	pMsg->m_Level = level;
+	pMsg->m_HaveColor = have_color;
+	pMsg->m_Color = color;
+	str_timestamp_format(pMsg->m_aTimestamp, sizeof(pMsg->m_aTimestamp), FORMAT_SPACE);
+	pMsg->m_TimestampLength = str_length(pMsg->m_aTimestamp);
+	str_copy(pMsg->m_aSystem, sys);
+	pMsg->m_SystemLength = str_length(pMsg->m_aSystem);
+
+	// TODO: Add level?
+	str_format(pMsg->m_aLine, sizeof(pMsg->m_aLine), "%s %c %s: ", pMsg->m_aTimestamp, "EWIDT"[level], pMsg->m_aSystem);
+	pMsg->m_LineMessageOffset = str_length(pMsg->m_aLine);
+
+	char *pMessage = pMsg->m_aLine + pMsg->m_LineMessageOffset;
+	int MessageSize = sizeof(pMsg->m_aLine) - pMsg->m_LineMessageOffset;
+	str_format_v(pMessage, MessageSize, fmt, args);
+	pMsg->m_LineLength = str_length(pMsg->m_aLine);
+}
+
+static void log_message_format(CLogMessage *pMsg, LEVEL level, const char *sys, const char *fmt, ...)
+	GNUC_ATTRIBUTE((format(printf, 4, 5)));
+
+static void log_message_format(CLogMessage *pMsg, LEVEL level, const char *sys, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	log_message_format(pMsg, level, false, LOG_COLOR{0, 0, 0}, sys, fmt, args);
+	va_end(args);
+}
+
 // Separate declaration, as attributes are not allowed on function definitions
 void log_log_impl(LEVEL level, bool have_color, LOG_COLOR color, const char *sys, const char *fmt, va_list args)
 	GNUC_ATTRIBUTE((format(printf, 5, 0)));
@@ -99,22 +140,7 @@ void log_log_impl(LEVEL level, bool have_color, LOG_COLOR color, const char *sys
 	}
 
 	CLogMessage Msg;
-	Msg.m_Level = level;
-	Msg.m_HaveColor = have_color;
-	Msg.m_Color = color;
-	str_timestamp_format(Msg.m_aTimestamp, sizeof(Msg.m_aTimestamp), FORMAT_SPACE);
-	Msg.m_TimestampLength = str_length(Msg.m_aTimestamp);
-	str_copy(Msg.m_aSystem, sys);
-	Msg.m_SystemLength = str_length(Msg.m_aSystem);
-
-	// TODO: Add level?
-	str_format(Msg.m_aLine, sizeof(Msg.m_aLine), "%s %c %s: ", Msg.m_aTimestamp, "EWIDT"[level], Msg.m_aSystem);
-	Msg.m_LineMessageOffset = str_length(Msg.m_aLine);
-
-	char *pMessage = Msg.m_aLine + Msg.m_LineMessageOffset;
-	int MessageSize = sizeof(Msg.m_aLine) - Msg.m_LineMessageOffset;
-	str_format_v(pMessage, MessageSize, fmt, args);
-	Msg.m_LineLength = str_length(Msg.m_aLine);
+	log_message_format(&Msg, level, have_color, color, sys, fmt, args);
 	scope_logger->Log(&Msg);
 	in_logger = false;
 }
@@ -191,6 +217,13 @@ public:
 			pLogger->Log(pMessage);
 		}
 	}
+	void LogBatch(const CLogMessage *const *ppMessages, int NumMessages) override
+	{
+		for(auto &pLogger : m_vpLoggers)
+		{
+			pLogger->LogBatch(ppMessages, NumMessages);
+		}
+	}
 	void GlobalFinish() override
 	{
 		for(auto &pLogger : m_vpLoggers)
@@ -205,22 +238,297 @@ std::unique_ptr<ILogger> log_logger_collection(std::vector<std::shared_ptr<ILogg
 	return std::make_unique<CLoggerCollection>(std::move(vpLoggers));
 }
 
-class CLoggerAsync : public ILogger
+class CLoggerAsyncQueue : public ILogger
 {
-	ASYNCIO *m_pAio;
-	bool m_AnsiTruecolor;
-	bool m_Close;
+	struct CRecord
+	{
+		uint64_t m_Sequence;
+		CLogMessage m_Message;
+	};
+
+	// Single producer, single consumer queue of one logging thread. When
+	// the thread exits, the queue is handed to the next thread that starts
+	// logging. The queues are only freed with the logger, so the writer
+	// thread can walk their list without locking.
+	struct CQueue
+	{
+		CQueue *m_pNext;
+		uint64_t m_LoggerID;
+		// cleared by the owning thread when it exits
+		std::atomic<bool> m_InUse{true};
+		std::unique_ptr<CRecord[]> m_pRecords;
+		// only written by the logging thread
+		std::atomic<uint64_t> m_Head{0};
+		// only written by the writer thread
+		std::atomic<uint64_t> m_Tail{0};
+	};
+
+	// The queues owned by the current thread, one per logger it used. The
+	// references keep a queue alive if its logger is destroyed before the
+	// thread exits.
+	struct CThreadQueues
+	{
+		std::vector<std::shared_ptr<CQueue>> m_vpQueues;
+		// the queue of the logger used last, so that the queues are only
+		// searched when switching loggers
+		uint64_t m_LoggerID = 0;
+		CQueue *m_pQueue = nullptr;
+
+		~CThreadQueues()
+		{
+			for(auto &pQueue : m_vpQueues)
+				pQueue->m_InUse.store(false, std::memory_order_release);
+		}
+	};
+	static thread_local CThreadQueues ms_ThreadQueues;
+	static std::atomic<uint64_t> ms_NextLoggerID;
+
+	std::vector<std::shared_ptr<ILogger>> m_vpLoggers;
+	const uint64_t m_LoggerID;
+	const int m_QueueSize;
+	std::atomic<CQueue *> m_pFirstQueue{nullptr};
+	// owns the queues, only locked when a thread takes a queue
+	std::mutex m_QueuesLock;
+	std::vector<std::shared_ptr<CQueue>> m_vpQueues;
+	std::atomic<uint64_t> m_NextSequence{0};
+	std::atomic<int> m_Dropped{0};
+
+	void *m_pThread;
+	std::atomic<std::thread::id> m_WriterThread;
+	CSemaphore m_Wakeup;
+	std::atomic<bool> m_WriterSleeping{false};
+	std::atomic<bool> m_Stop{false};
+	std::atomic<bool> m_Finished{false};
+
+	// only used by the writer thread
+	std::vector<const CRecord *> m_vpBatch;
+	std::vector<const CLogMessage *> m_vpBatchMessages;
+	std::vector<std::pair<CQueue *, uint64_t>> m_vBatchHeads;
+	int64_t m_TotalDropped = 0;
+
+	CQueue *ThreadQueue()
+	{
+		CThreadQueues &Queues = ms_ThreadQueues;
+		if(Queues.m_LoggerID == m_LoggerID)
+			return Queues.m_pQueue;
+
+		// forget the queues of destroyed loggers
+		Queues.m_vpQueues.erase(std::remove_if(Queues.m_vpQueues.begin(), Queues.m_vpQueues.end(), [](const std::shared_ptr<CQueue> &pQueue) {
+			return pQueue.use_count() == 1;
+		}),
+			Queues.m_vpQueues.end());
+
+		CQueue *pQueue = nullptr;
+		for(auto &pOwned : Queues.m_vpQueues)
+		{
+			if(pOwned->m_LoggerID == m_LoggerID)
+				pQueue = pOwned.get();
+		}
+		if(!pQueue)
+		{
+			std::shared_ptr<CQueue> pNew;
+			{
+				// take over the queue of an exited thread, the messages it
+				// left are still written in order
+				std::lock_guard<std::mutex> Lock(m_QueuesLock);
+				for(auto &pFree : m_vpQueues)
+				{
+					bool InUse = false;
+					if(pFree->m_InUse.compare_exchange_strong(InUse, true, std::memory_order_acquire))
+					{
+						pNew = pFree;
+						break;
+					}
+				}
+				if(!pNew)
+				{
+					pNew = std::make_shared<CQueue>();
+					pNew->m_LoggerID = m_LoggerID;
+					pNew->m_pRecords = std::make_unique<CRecord[]>(m_QueueSize);
+					m_vpQueues.push_back(pNew);
+					pNew->m_pNext = m_pFirstQueue.load(std::memory_order_relaxed);
+					m_pFirstQueue.store(pNew.get(), std::memory_order_release);
+				}
+			}
+			Queues.m_vpQueues.push_back(pNew);
+			pQueue = pNew.get();
+		}
+		Queues.m_LoggerID = m_LoggerID;
+		Queues.m_pQueue = pQueue;
+		return pQueue;
+	}
+
+	void Wakeup()
+	{
+		if(m_WriterSleeping.exchange(false))
+			m_Wakeup.Signal();
+	}
+
+	bool Pending() const
+	{
+		for(CQueue *pQueue = m_pFirstQueue.load(std::memory_order_acquire); pQueue; pQueue = pQueue->m_pNext)
+		{
+			if(pQueue->m_Head.load() != pQueue->m_Tail.load(std::memory_order_relaxed))
+				return true;
+		}
+		return m_Dropped.load() != 0;
+	}
+
+	// passes everything queued so far to the loggers, returns the number
+	// of messages
+	int WriteBatch()
+	{
+		m_vpBatch.clear();
+		m_vBatchHeads.clear();
+		for(CQueue *pQueue = m_pFirstQueue.load(std::memory_order_acquire); pQueue; pQueue = pQueue->m_pNext)
+		{
+			uint64_t Head = pQueue->m_Head.load(std::memory_order_acquire);
+			uint64_t Tail = pQueue->m_Tail.load(std::memory_order_relaxed);
+			if(Head == Tail)
+				continue;
+			for(uint64_t i = Tail; i < Head; i++)
+				m_vpBatch.push_back(&pQueue->m_pRecords[i % m_QueueSize]);
+			m_vBatchHeads.emplace_back(pQueue, Head);
+		}
+
+		int Dropped = m_Dropped.exchange(0);
+		if(m_vpBatch.empty() && !Dropped)
+			return 0;
+
+		// restore the order between the threads
+		std::sort(m_vpBatch.begin(), m_vpBatch.end(), [](const CRecord *pA, const CRecord *pB) {
+			return pA->m_Sequence < pB->m_Sequence;
+		});
+		m_vpBatchMessages.clear();
+		for(const CRecord *pRecord : m_vpBatch)
+			m_vpBatchMessages.push_back(&pRecord->m_Message);
+
+		CLogMessage DroppedMsg;
+		if(Dropped)
+		{
+			m_TotalDropped += Dropped;
+			log_message_format(&DroppedMsg, LEVEL_WARN, "log", "dropped %d messages because the queue was full (%lld in total)", Dropped, (long long)m_TotalDropped);
+			m_vpBatchMessages.push_back(&DroppedMsg);
+		}
+
+		for(auto &pLogger : m_vpLoggers)
+			pLogger->LogBatch(m_vpBatchMessages.data(), m_vpBatchMessages.size());
+
+		// only reuse the records after the loggers are done with them
+		for(const auto &[pQueue, Head] : m_vBatchHeads)
+			pQueue->m_Tail.store(Head, std::memory_order_release);
+		return m_vpBatchMessages.size();
+	}
+
+	static void WriterThread(void *pUser)
+	{
+		CLoggerAsyncQueue *pSelf = static_cast<CLoggerAsyncQueue *>(pUser);
+		pSelf->m_WriterThread.store(std::this_thread::get_id());
+		while(true)
+		{
+			if(pSelf->WriteBatch())
+				continue;
+			if(pSelf->m_Stop.load())
+				break;
+
+			pSelf->m_WriterSleeping.store(true);
+			// something might have been queued before the flag was set
+			if((pSelf->Pending() || pSelf->m_Stop.load()) && pSelf->m_WriterSleeping.exchange(false))
+				continue;
+			pSelf->m_Wakeup.Wait();
+		}
+	}
+
+	void StopWriter()
+	{
+		if(m_Finished.exchange(true))
+			return;
+		m_Stop.store(true);
+		Wakeup();
+		thread_wait(m_pThread);
+	}
 
 public:
-	CLoggerAsync(IOHANDLE File, bool AnsiTruecolor, bool Close) :
-		m_pAio(aio_new(File)),
-		m_AnsiTruecolor(AnsiTruecolor),
-		m_Close(Close)
+	CLoggerAsyncQueue(std::vector<std::shared_ptr<ILogger>> &&vpLoggers, int QueueSize) :
+		m_vpLoggers(std::move(vpLoggers)),
+		m_LoggerID(ms_NextLoggerID.fetch_add(1) + 1),
+		m_QueueSize(QueueSize)
+	{
+		dbg_assert(QueueSize > 0, "log queue size must be positive");
+		m_pThread = thread_init(WriterThread, this, "log");
+	}
+	~CLoggerAsyncQueue()
 	{
+		StopWriter();
 	}
 	void Log(const CLogMessage *pMessage) override
 	{
-		aio_lock(m_pAio);
+		if(m_Finished.load(std::memory_order_relaxed))
+			return;
+
+		CQueue *pQueue = ThreadQueue();
+		uint64_t Head = pQueue->m_Head.load(std::memory_order_relaxed);
+		while(Head - pQueue->m_Tail.load(std::memory_order_acquire) >= (uint64_t)m_QueueSize)
+		{
+			// warnings and errors wait, unless a logger of the writer thread
+			// itself logs
+			if(pMessage->m_Level > LEVEL_WARN || m_Finished.load(std::memory_order_relaxed) || std::this_thread::get_id() == m_WriterThread.load())
+			{
+				m_Dropped.fetch_add(1);
+				Wakeup();
+				return;
+			}
+			Wakeup();
+			thread_yield();
+		}
+
+		// only copy the used part of the line
+		CRecord &Record = pQueue->m_pRecords[Head % m_QueueSize];
+		CLogMessage &Msg = Record.m_Message;
+		Msg.m_Level = pMessage->m_Level;
+		Msg.m_HaveColor = pMessage->m_HaveColor;
+		Msg.m_Color = pMessage->m_Color;
+		str_copy(Msg.m_aTimestamp, pMessage->m_aTimestamp);
+		str_copy(Msg.m_aSystem, pMessage->m_aSystem);
+		mem_copy(Msg.m_aLine, pMessage->m_aLine, pMessage->m_LineLength + 1);
+		Msg.m_TimestampLength = pMessage->m_TimestampLength;
+		Msg.m_SystemLength = pMessage->m_SystemLength;
+		Msg.m_LineLength = pMessage->m_LineLength;
+		Msg.m_LineMessageOffset = pMessage->m_LineMessageOffset;
+		Record.m_Sequence = m_NextSequence.fetch_add(1, std::memory_order_relaxed);
+
+		pQueue->m_Head.store(Head + 1);
+		Wakeup();
+	}
+	void GlobalFinish() override
+	{
+		// the writer thread can't wait for itself, e.g. on an assertion in
+		// one of the loggers
+		if(std::this_thread::get_id() != m_WriterThread.load())
+			StopWriter();
+		else
+			m_Finished.store(true);
+		for(auto &pLogger : m_vpLoggers)
+			pLogger->GlobalFinish();
+	}
+};
+
+thread_local CLoggerAsyncQueue::CThreadQueues CLoggerAsyncQueue::ms_ThreadQueues;
+std::atomic<uint64_t> CLoggerAsyncQueue::ms_NextLoggerID{0};
+
+std::unique_ptr<ILogger> log_logger_async(std::vector<std::shared_ptr<ILogger>> &&vpLoggers, int QueueSize)
+{
+	return std::make_unique<CLoggerAsyncQueue>(std::move(vpLoggers), QueueSize);
+}
+
+class CLoggerAsync : public ILogger
+{
+	ASYNCIO *m_pAio;
+	bool m_AnsiTruecolor;
+	bool m_Close;
+
+	void WriteUnlocked(const CLogMessage *pMessage)
+	{
 		if(m_AnsiTruecolor)
 		{
 			// https://en.wikipedia.org/w/index.php?title=ANSI_escape_code&oldid=1077146479#24-bit
@@ -242,6 +550,26 @@ public:
 			aio_write_unlocked(m_pAio, aResetColor, str_length(aResetColor)); // reset
 		}
 		aio_write_newline_unlocked(m_pAio);
+	}
+
+public:
+	CLoggerAsync(IOHANDLE File, bool AnsiTruecolor, bool Close) :
+		m_pAio(aio_new(File)),
+		m_AnsiTruecolor(AnsiTruecolor),
+		m_Close(Close)
+	{
+	}
+	void Log(const CLogMessage *pMessage) override
+	{
+		aio_lock(m_pAio);
+		WriteUnlocked(pMessage);
+		aio_unlock(m_pAio);
+	}
+	void LogBatch(const CLogMessage *const *ppMessages, int NumMessages) override
+	{
+		aio_lock(m_pAio);
+		for(int i = 0; i < NumMessages; i++)
+			WriteUnlocked(ppMessages[i]);
 		aio_unlock(m_pAio);
 	}
 	~CLoggerAsync()
@@ -464,6 +792,20 @@ void CFutureLogger::Log(const CLogMessage *pMessage)
 	m_PendingLock.unlock();
 }
 
+void CFutureLogger::LogBatch(const CLogMessage *const *ppMessages, int NumMessages)
+{
+	ILogger *pLogger = m_pLogger.load(std::memory_order_acquire);
+	if(pLogger)
+	{
+		pLogger->LogBatch(ppMessages, NumMessages);
+		return;
+	}
+	m_PendingLock.lock();
+	for(int i = 0; i < NumMessages; i++)
+		m_vPending.push_back(*ppMessages[i]);
+	m_PendingLock.unlock();
+}
+
 void CFutureLogger::GlobalFinish()
 {
 	ILogger *pLogger = m_pLogger.load(std::memory_order_acquire);
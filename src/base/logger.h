@@ -61,6 +61,20 @@ public:
 	 * @param pMessage Struct describing the log message.
 	 */
 	virtual void Log(const CLogMessage *pMessage) = 0;
+	/**
+	 * Send several messages to the logging backend at once, in order.
+	 *
+	 * Loggers that need to lock or write for every message can override
+	 * this to do so only once for the whole batch.
+	 *
+	 * @param ppMessages The messages.
+	 * @param NumMessages Number of messages.
+	 */
+	virtual void LogBatch(const CLogMessage *const *ppMessages, int NumMessages)
+	{
+		for(int i = 0; i < NumMessages; i++)
+			Log(ppMessages[i]);
+	}
 	/**
 	 * Flushes output buffers and shuts down.
 	 * Global loggers cannot be destroyed because they might be accessed
@@ -158,6 +172,28 @@ void log_set_scope_logger(ILogger *logger);
  */
 std::unique_ptr<ILogger> log_logger_android();
 
+/**
+ * @ingroup Log
+ *
+ * Logger passing the messages to other loggers from a background thread.
+ *
+ * Every logging thread gets its own lock-free queue of `QueueSize` messages,
+ * so logging only copies the message. If the queue of a thread is full,
+ * warnings and errors wait for the background thread, less severe messages
+ * are dropped. The number of dropped messages is logged as a warning. The
+ * queue of a thread is reused by another thread once it exits.
+ *
+ * The messages of one thread are always passed on in order. Messages of
+ * different threads are ordered by when they were queued among the
+ * messages the background thread takes at once. A message queued while the
+ * previous ones are being written can still come after a later message of
+ * another thread.
+ *
+ * @param vpLoggers The loggers to pass the messages to.
+ * @param QueueSize Number of messages each thread can queue.
+ */
+std::unique_ptr<ILogger> log_logger_async(std::vector<std::shared_ptr<ILogger>> &&vpLoggers, int QueueSize = 256);
+
 /**
  * @ingroup Log
  *
@@ -213,6 +249,7 @@ public:
 	 */
 	void Set(std::unique_ptr<ILogger> &&pLogger);
 	void Log(const CLogMessage *pMessage) override;
+	void LogBatch(const CLogMessage *const *ppMessages, int NumMessages) override;
 	void GlobalFinish() override;
 };
 
@@ -562,6 +562,9 @@ void CCommandProcessorFragment_OpenGL3_3::TextureUpdate(int Slot, int X, int Y,
 
 	glTexSubImage2D(GL_TEXTURE_2D, 0, X, Y, Width, Height, GLFormat, GL_UNSIGNED_BYTE, pTexData);
 	free(pTexData);
+
+	if(m_vTextures[Slot].m_MipMapped)
+		glGenerateMipmap(GL_TEXTURE_2D);
 }
 
 void CCommandProcessorFragment_OpenGL3_3::Cmd_Texture_Update(const CCommandBuffer::SCommand_Texture_Update *pCommand)
@@ -603,6 +606,7 @@ void CCommandProcessorFragment_OpenGL3_3::TextureCreate(int Slot, int Width, int
 	m_vTextures[Slot].m_Width = Width;
 	m_vTextures[Slot].m_Height = Height;
 	m_vTextures[Slot].m_RescaleCount = RescaleCount;
+	m_vTextures[Slot].m_MipMapped = (Flags & (CCommandBuffer::TEXFLAG_NOMIPMAPS | CCommandBuffer::TEXFLAG_NO_2D_TEXTURE)) == 0;
 
 	int Oglformat = GLFormat;
 	int StoreOglformat = GLStoreFormat;
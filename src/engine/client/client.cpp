@@ -70,7 +70,9 @@
 #endif
 
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -401,6 +403,7 @@ CClient::CClient() :
 	m_FrameTimeAvg = 0.0001f;
 	m_BenchmarkFile = 0;
 	m_BenchmarkStopTime = 0;
+	m_aBenchmarkProfileFile[0] = '\0';
 
 	mem_zero(&m_Checksum, sizeof(m_Checksum));
 }
@@ -1051,12 +1054,15 @@ void CClient::DebugRender()
 		total = 42
 	*/
 	FrameTimeAvg = FrameTimeAvg * 0.9f + m_RenderFrameTime * 0.1f;
-	str_format(aBuffer, sizeof(aBuffer), "ticks: %8d %8d gfx mem(tex/buff/stream/staging): (%" PRIu64 "k/%" PRIu64 "k/%" PRIu64 "k/%" PRIu64 "k) fps: %3d",
+	str_format(aBuffer, sizeof(aBuffer), "ticks: %8d %8d gfx mem(tex/buff/stream/staging): (%" PRIu64 "k/%" PRIu64 "k/%" PRIu64 "k/%" PRIu64 "k) cmds: %5d (%5d merged) binds: %4d fps: %3d",
 		m_aCurGameTick[g_Config.m_ClDummy], m_aPredTick[g_Config.m_ClDummy],
 		(Graphics()->TextureMemoryUsage() / 1024),
 		(Graphics()->BufferMemoryUsage() / 1024),
 		(Graphics()->StreamedMemoryUsage() / 1024),
 		(Graphics()->StagingMemoryUsage() / 1024),
+		Graphics()->NumCommandsLastFrame(),
+		Graphics()->NumMergedCommandsLastFrame(),
+		Graphics()->NumTextureBindsLastFrame(),
 		(int)(1.0f / FrameTimeAvg + 0.5f));
 	Graphics()->QuadsText(2, 2, 16, aBuffer);
 
@@ -2885,10 +2891,18 @@ void CClient::Update()
 			if(e->Status() == IJob::STATE_DONE)
 			{
 				char aBuf[256];
-				str_format(aBuf, sizeof(aBuf), "Successfully saved the replay to %s!", e->Destination());
-				m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+				if(e->Success())
+				{
+					str_format(aBuf, sizeof(aBuf), "Successfully saved the replay to %s!", e->Destination());
+					m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
 
-				GameClient()->Echo(Localize("Successfully saved the replay!"));
+					GameClient()->Echo(Localize("Successfully saved the replay!"));
+				}
+				else
+				{
+					str_format(aBuf, sizeof(aBuf), "ERROR: failed to save the replay to %s", e->Destination());
+					m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", aBuf);
+				}
 
 				m_lpEditJobs.pop_front();
 			}
@@ -2933,6 +2947,7 @@ void CClient::RegisterInterfaces()
 	Kernel()->RegisterInterface(static_cast<IUpdater *>(&m_Updater), false);
 #endif
 	Kernel()->RegisterInterface(static_cast<IFriends *>(&m_Friends), false);
+	Kernel()->RegisterInterface(&m_Profiler, false);
 	Kernel()->ReregisterInterface(static_cast<IFriends *>(&m_Foes));
 }
 
@@ -3243,8 +3258,14 @@ void CClient::Run()
 				m_EditorActive = false;
 			}
 
-			Update();
+			m_Profiler.SetEnabled(g_Config.m_DbgProfiler);
+			m_Profiler.BeginFrame();
+			{
+				CProfiler::CScope Profile(&m_Profiler, "Update");
+				Update();
+			}
 			int64_t Now = time_get();
+			bool Rendered = false;
 
 			bool IsRenderActive = (g_Config.m_GfxBackgroundRender || m_pGraphics->WindowOpen());
 
@@ -3284,6 +3305,8 @@ void CClient::Run()
 					{
 						io_close(m_BenchmarkFile);
 						m_BenchmarkFile = 0;
+						if(m_Profiler.IsEnabled())
+							ProfilerExport("csv", m_aBenchmarkProfileFile, IStorage::TYPE_ABSOLUTE);
 						Quit();
 					}
 				}
@@ -3316,21 +3339,32 @@ void CClient::Run()
 				else
 #endif
 				{
-					if(!m_EditorActive)
-						Render();
-					else
 					{
-						m_pEditor->OnRender();
-						DebugRender();
+						CProfiler::CScope Profile(&m_Profiler, "Render");
+						if(!m_EditorActive)
+							Render();
+						else
+						{
+							m_pEditor->OnRender();
+							DebugRender();
+						}
 					}
+					CProfiler::CScope Profile(&m_Profiler, "Swap");
 					m_pGraphics->Swap();
 				}
+				Rendered = true;
 			}
 			else if(!IsRenderActive)
 			{
 				// if the client does not render, it should reset its render time to a time where it would render the first frame, when it wakes up again
 				LastRenderTime = g_Config.m_GfxRefreshRate ? (Now - (time_freq() / (int64_t)g_Config.m_GfxRefreshRate)) : Now;
 			}
+
+			// only keep the frames that were rendered
+			if(Rendered)
+				m_Profiler.EndFrame();
+			else
+				m_Profiler.DiscardFrame();
 		}
 
 		AutoScreenshot_Cleanup();
@@ -3776,9 +3810,6 @@ void CClient::SaveReplay(const int Length, const char *pFilename)
 		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", "ERROR: demorecorder isn't recording for at least 1 second.");
 	else
 	{
-		// First we stop the recorder to slice correctly the demo after
-		DemoRecorder_Stop(RECORDER_REPLAYS);
-
 		char aDate[64];
 		str_timestamp(aDate, sizeof(aDate));
 
@@ -3788,6 +3819,23 @@ void CClient::SaveReplay(const int Length, const char *pFilename)
 		else
 			str_format(aFilename, sizeof(aFilename), "demos/replays/%s.demo", pFilename);
 
+		if(m_aDemoRecorder[RECORDER_REPLAYS].IsRecordingToMemory())
+		{
+			// The recorder keeps running, a copy of the kept chunks is written in background
+			auto pReplay = std::make_unique<CDemoRecorder::CMemoryReplay>();
+			if(m_aDemoRecorder[RECORDER_REPLAYS].CopyMemory(Length, pReplay.get()) == 0)
+			{
+				m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "replay", "Saving replay...");
+				std::shared_ptr<CDemoEdit> pDemoEditTask = std::make_shared<CDemoEdit>(m_pStorage, std::move(pReplay), m_aCurrentMapPath, aFilename);
+				Engine()->AddJob(pDemoEditTask);
+				m_lpEditJobs.push_back(pDemoEditTask);
+			}
+			return;
+		}
+
+		// First we stop the recorder to slice correctly the demo after
+		DemoRecorder_Stop(RECORDER_REPLAYS);
+
 		char *pSrc = m_aDemoRecorder[RECORDER_REPLAYS].GetCurrentFilename();
 
 		// Slice the demo to get only the last cl_replay_length seconds
@@ -3974,6 +4022,14 @@ void CClient::DemoRecorder_StartReplayRecorder()
 	if(g_Config.m_ClReplays)
 	{
 		DemoRecorder_Stop(RECORDER_REPLAYS);
+		if(g_Config.m_ClReplayMemory)
+		{
+			if(State() != IClient::STATE_ONLINE)
+				return;
+			SHA256_DIGEST Sha256 = m_pMap->Sha256();
+			m_aDemoRecorder[RECORDER_REPLAYS].StartMemory(m_pConsole, GameClient()->NetVersion(), m_aCurrentMap, Sha256, m_pMap->Crc(), "client", g_Config.m_ClReplayLength);
+			return;
+		}
 		char aBuf[512];
 		str_format(aBuf, sizeof(aBuf), "replays/replay_tmp-%s", m_aCurrentMap);
 		DemoRecorder_Start(aBuf, true, RECORDER_REPLAYS);
@@ -4039,6 +4095,113 @@ void CClient::BenchmarkQuit(int Seconds, const char *pFilename)
 	char aBuf[IO_MAX_PATH_LENGTH];
 	m_BenchmarkFile = Storage()->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_ABSOLUTE, aBuf, sizeof(aBuf));
 	m_BenchmarkStopTime = time_get() + time_freq() * Seconds;
+	str_format(m_aBenchmarkProfileFile, sizeof(m_aBenchmarkProfileFile), "%s.profile.csv", pFilename);
+}
+
+void CClient::Con_TextBench(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pSelf->TextBench(pResult->NumArguments() ? pResult->GetInteger(0) : 10000);
+}
+
+void CClient::TextBench(int NumLines)
+{
+	static const char *s_apNames[] = {"nameless tee", "brainless tee", "Ninjed", "ΣΑΜΑΡΙ", "Teeeee", "deen"};
+	static const char *s_apWords[] = {"hi", "gg", "where", "is", "the", "finish", "hook", "me", "please", "wait", "for", "part", "two", "lol", "freeze", "unfreeze", "again", "this", "map", "hard"};
+
+	// chat like lines, the same generator for every run. Every frame shows
+	// the newest lines, which scroll up by a fraction of a line per frame.
+	const int LINES_PER_FRAME = 20;
+	const int NumFrames = maximum(NumLines / LINES_PER_FRAME, 1);
+	NumLines = NumFrames * LINES_PER_FRAME;
+	std::vector<std::string> vLines;
+	vLines.reserve(NumFrames + LINES_PER_FRAME);
+	unsigned Seed = 1;
+	auto &&Random = [&Seed]() {
+		Seed = Seed * 1103515245 + 12345;
+		return (Seed >> 16) & 0x7fff;
+	};
+	for(int i = 0; i < NumFrames + LINES_PER_FRAME; i++)
+	{
+		std::string Line = s_apNames[Random() % std::size(s_apNames)];
+		Line += ":";
+		const int NumWords = 2 + Random() % 24;
+		for(int w = 0; w < NumWords; w++)
+		{
+			Line += " ";
+			Line += s_apWords[Random() % std::size(s_apWords)];
+		}
+		vLines.push_back(std::move(Line));
+	}
+
+	ITextRender *pTextRender = Kernel()->RequestInterface<ITextRender>();
+	float aPoints[4];
+	Graphics()->GetScreen(&aPoints[0], &aPoints[1], &aPoints[2], &aPoints[3]);
+	Graphics()->MapScreen(0.0f, 0.0f, 300.0f * Graphics()->ScreenAspect(), 300.0f);
+
+	const int LayoutCache = g_Config.m_GfxTextLayoutCache;
+	auto &&Run = [&](const char *pName, bool Cache) {
+		g_Config.m_GfxTextLayoutCache = Cache;
+		const STextLayoutCacheStats Before = pTextRender->LayoutCacheStats();
+		const int64_t Start = time_get_nanoseconds().count();
+		for(int Frame = 0; Frame < NumFrames; Frame++)
+		{
+			const float Scroll = (Frame * 7 % 80) / 10.0f;
+			for(int i = 0; i < LINES_PER_FRAME; i++)
+			{
+				const float y = 290.0f - (LINES_PER_FRAME - i) * 8.0f - Scroll;
+				pTextRender->Text(5.0f, y, 6.0f, vLines[Frame + i].c_str(), 200.0f);
+			}
+		}
+		const int64_t Duration = time_get_nanoseconds().count() - Start;
+		const STextLayoutCacheStats After = pTextRender->LayoutCacheStats();
+		log_info("text_bench", "%-8s %8.2f ms, %.3f us per line, %lld hits, %lld misses", pName, Duration / 1000000.0, Duration / 1000.0 / NumLines,
+			(long long)(After.m_Hits - Before.m_Hits), (long long)(After.m_Misses - Before.m_Misses));
+	};
+	// load the glyphs first
+	Run("warmup", false);
+	Run("uncached", false);
+	Run("fill", true);
+	Run("cached", true);
+	g_Config.m_GfxTextLayoutCache = LayoutCache;
+
+	Graphics()->MapScreen(aPoints[0], aPoints[1], aPoints[2], aPoints[3]);
+}
+
+void CClient::Con_ProfilerExport(IConsole::IResult *pResult, void *pUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pSelf->ProfilerExport(pResult->GetString(0), pResult->GetString(1), IStorage::TYPE_SAVE);
+}
+
+bool CClient::ProfilerExport(const char *pFormat, const char *pFilename, int StorageType)
+{
+	const bool Trace = str_comp(pFormat, "trace") == 0;
+	if(!Trace && str_comp(pFormat, "csv") != 0)
+	{
+		log_error("profiler", "unknown format '%s', use csv or trace", pFormat);
+		return true;
+	}
+	if(!m_Profiler.NumFrames())
+	{
+		log_error("profiler", "no frames recorded, enable dbg_profiler first");
+		return true;
+	}
+
+	char aPath[IO_MAX_PATH_LENGTH];
+	IOHANDLE File = Storage()->OpenFile(pFilename, IOFLAG_WRITE, StorageType, aPath, sizeof(aPath));
+	if(!File)
+	{
+		log_error("profiler", "failed to open '%s' for writing", pFilename);
+		return true;
+	}
+	if(Trace)
+		m_Profiler.ExportTrace(File);
+	else
+		m_Profiler.ExportCsv(File);
+	io_close(File);
+	log_info("profiler", "wrote %d frames to '%s'", m_Profiler.NumFrames(), aPath);
+	return false;
 }
 
 void CClient::UpdateAndSwap()
@@ -4367,6 +4530,18 @@ void CClient::ConchainReplays(IConsole::IResult *pResult, void *pUserData, ICons
 	}
 }
 
+void CClient::ConchainReplayMemory(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+{
+	CClient *pSelf = (CClient *)pUserData;
+	pfnCallback(pResult, pCallbackUserData);
+	if(pResult->NumArguments() && pSelf->m_aDemoRecorder[RECORDER_REPLAYS].IsRecording())
+	{
+		// restart recording with the new mode
+		pSelf->DemoRecorder_Stop(RECORDER_REPLAYS, true);
+		pSelf->DemoRecorder_StartReplayRecorder();
+	}
+}
+
 void CClient::RegisterCommands()
 {
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
@@ -4416,11 +4591,14 @@ void CClient::RegisterCommands()
 
 	m_pConsole->Register("save_replay", "?i[length] s[filename]", CFGFLAG_CLIENT, Con_SaveReplay, this, "Save a replay of the last defined amount of seconds");
 	m_pConsole->Register("benchmark_quit", "i[seconds] r[file]", CFGFLAG_CLIENT | CFGFLAG_STORE, Con_BenchmarkQuit, this, "Benchmark frame times for number of seconds to file, then quit");
+	m_pConsole->Register("dbg_text_bench", "?i[lines]", CFGFLAG_CLIENT, Con_TextBench, this, "Render scrolling chat lines with and without the text layout cache and log the times");
+	m_pConsole->Register("profiler_export", "s['csv'|'trace'] r[file]", CFGFLAG_CLIENT, Con_ProfilerExport, this, "Write the frames recorded with dbg_profiler to a file");
 
 	RustVersionRegister(*m_pConsole);
 
 	m_pConsole->Chain("cl_timeout_seed", ConchainTimeoutSeed, this);
 	m_pConsole->Chain("cl_replays", ConchainReplays, this);
+	m_pConsole->Chain("cl_replay_memory", ConchainReplayMemory, this);
 
 	m_pConsole->Chain("loglevel", ConchainLoglevel, this);
 	m_pConsole->Chain("password", ConchainPassword, this);
@@ -21,6 +21,7 @@
 #include <engine/shared/fifo.h>
 #include <engine/shared/http.h>
 #include <engine/shared/network.h>
+#include <engine/shared/profiler.h>
 #include <engine/warning.h>
 
 class CDemoEdit;
@@ -133,6 +134,7 @@ class CClient : public IClient, public CDemoPlayer::IListener
 	CUpdater m_Updater;
 	CFriends m_Friends;
 	CFriends m_Foes;
+	CProfiler m_Profiler;
 
 	char m_aConnectAddressStr[MAX_SERVER_ADDRESSES * NETADDR_MAXSTRSIZE];
 
@@ -286,6 +288,7 @@ class CClient : public IClient, public CDemoPlayer::IListener
 
 	IOHANDLE m_BenchmarkFile;
 	int64_t m_BenchmarkStopTime;
+	char m_aBenchmarkProfileFile[IO_MAX_PATH_LENGTH];
 
 	CChecksum m_Checksum;
 	int m_OwnExecutableSize = 0;
@@ -460,6 +463,8 @@ public:
 	static void Con_StopRecord(IConsole::IResult *pResult, void *pUserData);
 	static void Con_AddDemoMarker(IConsole::IResult *pResult, void *pUserData);
 	static void Con_BenchmarkQuit(IConsole::IResult *pResult, void *pUserData);
+	static void Con_ProfilerExport(IConsole::IResult *pResult, void *pUserData);
+	static void Con_TextBench(IConsole::IResult *pResult, void *pUserData);
 	static void ConchainServerBrowserUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainFullscreen(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainWindowBordered(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -469,6 +474,7 @@ public:
 	static void ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainPassword(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainReplays(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
+	static void ConchainReplayMemory(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 
 	static void Con_DemoSlice(IConsole::IResult *pResult, void *pUserData);
 	static void Con_DemoSliceBegin(IConsole::IResult *pResult, void *pUserData);
@@ -510,6 +516,8 @@ public:
 	void LoadFont() override;
 	void Notify(const char *pTitle, const char *pMessage) override;
 	void BenchmarkQuit(int Seconds, const char *pFilename);
+	bool ProfilerExport(const char *pFormat, const char *pFilename, int StorageType);
+	void TextBench(int NumLines);
 
 	void UpdateAndSwap() override;
 
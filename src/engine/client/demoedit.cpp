@@ -17,8 +17,30 @@ CDemoEdit::CDemoEdit(const char *pNetVersion, class CSnapshotDelta *pSnapshotDel
 	m_DemoEditor.Init(pNetVersion, &m_SnapshotDelta, NULL, pStorage);
 }
 
+CDemoEdit::CDemoEdit(IStorage *pStorage, std::unique_ptr<CDemoRecorder::CMemoryReplay> pReplay, const char *pMap, const char *pDst) :
+	m_pStorage(pStorage),
+	m_pReplay(std::move(pReplay))
+{
+	m_aDemo[0] = '\0';
+	str_copy(m_aDst, pDst);
+	str_copy(m_aMap, pMap);
+	m_StartTick = -1;
+	m_EndTick = -1;
+}
+
 void CDemoEdit::Run()
 {
+	if(m_pReplay)
+	{
+		// Open the map separately, the client's handle belongs to the main thread
+		IOHANDLE MapFile = m_pStorage->OpenFile(m_aMap, IOFLAG_READ, IStorage::TYPE_ALL);
+		m_Success = MapFile && CDemoRecorder::SaveMemoryReplay(m_pStorage, nullptr, m_aDst, *m_pReplay, MapFile) == 0;
+		if(MapFile)
+			io_close(MapFile);
+		m_pReplay = nullptr;
+		return;
+	}
+
 	// Slice the current demo
 	m_DemoEditor.Slice(m_aDemo, m_aDst, m_StartTick, m_EndTick, NULL, 0);
 	// We remove the temporary demo file
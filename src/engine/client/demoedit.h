@@ -5,6 +5,8 @@
 #include <engine/shared/jobs.h>
 #include <engine/shared/snapshot.h>
 
+#include <memory>
+
 class IStorage;
 
 class CDemoEdit : public IJob
@@ -19,9 +21,16 @@ class CDemoEdit : public IJob
 	int m_StartTick;
 	int m_EndTick;
 
+	// set when writing a replay kept in memory instead of slicing a demo
+	std::unique_ptr<CDemoRecorder::CMemoryReplay> m_pReplay;
+	char m_aMap[IO_MAX_PATH_LENGTH];
+	bool m_Success = true;
+
 public:
 	CDemoEdit(const char *pNetVersion, CSnapshotDelta *pSnapshotDelta, IStorage *pStorage, const char *pDemo, const char *pDst, int StartTick, int EndTick);
+	CDemoEdit(IStorage *pStorage, std::unique_ptr<CDemoRecorder::CMemoryReplay> pReplay, const char *pMap, const char *pDst);
 	void Run() override;
 	char *Destination() { return m_aDst; }
+	bool Success() const { return m_Success; }
 };
 #endif
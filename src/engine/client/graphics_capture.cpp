@@ -0,0 +1,323 @@
+#include "graphics_capture.h"
+
+#include "graphics_threaded.h"
+
+#include <type_traits>
+#include <utility>
+
+static const unsigned char CAPTURE_MAGIC[8] = {'D', 'D', 'G', 'F', 'X', 'C', 'A', 'P'};
+// increase when a command struct changes
+static const uint32_t CAPTURE_VERSION = 1;
+
+// Calls `Visit(pPtr, ExternalSize)` for every pointer of the command that
+// points into the data buffer or to memory owned by the command.
+// `ExternalSize` is the size of the owned memory, 0 if the pointer always
+// points into the data buffer.
+template<typename F>
+static void VisitPointers(CCommandBuffer::SCommand *pBaseCommand, F &&Visit)
+{
+	switch(pBaseCommand->m_Cmd)
+	{
+	case CCommandBuffer::CMD_TEXTURE_CREATE:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_Texture_Create *>(pBaseCommand);
+		Visit(pCommand->m_pData, (size_t)pCommand->m_Width * pCommand->m_Height * pCommand->m_PixelSize);
+		break;
+	}
+	case CCommandBuffer::CMD_TEXTURE_UPDATE:
+	{
+		// always converted to RGBA
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_Texture_Update *>(pBaseCommand);
+		Visit(pCommand->m_pData, (size_t)pCommand->m_Width * pCommand->m_Height * 4);
+		break;
+	}
+	case CCommandBuffer::CMD_TEXT_TEXTURES_CREATE:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_TextTextures_Create *>(pBaseCommand);
+		Visit(pCommand->m_pTextData, (size_t)pCommand->m_Width * pCommand->m_Height);
+		Visit(pCommand->m_pTextOutlineData, (size_t)pCommand->m_Width * pCommand->m_Height);
+		break;
+	}
+	case CCommandBuffer::CMD_TEXT_TEXTURE_UPDATE:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_TextTexture_Update *>(pBaseCommand);
+		Visit(pCommand->m_pData, (size_t)pCommand->m_Width * pCommand->m_Height);
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER:
+		Visit(static_cast<CCommandBuffer::SCommand_Render *>(pBaseCommand)->m_pVertices, 0);
+		break;
+	case CCommandBuffer::CMD_RENDER_TEX3D:
+		Visit(static_cast<CCommandBuffer::SCommand_RenderTex3D *>(pBaseCommand)->m_pVertices, 0);
+		break;
+	case CCommandBuffer::CMD_CREATE_BUFFER_OBJECT:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_CreateBufferObject *>(pBaseCommand);
+		Visit(pCommand->m_pUploadData, pCommand->m_DataSize);
+		break;
+	}
+	case CCommandBuffer::CMD_RECREATE_BUFFER_OBJECT:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_RecreateBufferObject *>(pBaseCommand);
+		Visit(pCommand->m_pUploadData, pCommand->m_DataSize);
+		break;
+	}
+	case CCommandBuffer::CMD_UPDATE_BUFFER_OBJECT:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_UpdateBufferObject *>(pBaseCommand);
+		Visit(pCommand->m_pUploadData, pCommand->m_DataSize);
+		break;
+	}
+	case CCommandBuffer::CMD_CREATE_BUFFER_CONTAINER:
+		Visit(static_cast<CCommandBuffer::SCommand_CreateBufferContainer *>(pBaseCommand)->m_pAttributes, 0);
+		break;
+	case CCommandBuffer::CMD_UPDATE_BUFFER_CONTAINER:
+		Visit(static_cast<CCommandBuffer::SCommand_UpdateBufferContainer *>(pBaseCommand)->m_pAttributes, 0);
+		break;
+	case CCommandBuffer::CMD_RENDER_TILE_LAYER:
+	{
+		auto *pCommand = static_cast<CCommandBuffer::SCommand_RenderTileLayer *>(pBaseCommand);
+		Visit(pCommand->m_pIndicesOffsets, 0);
+		Visit(pCommand->m_pDrawCount, 0);
+		break;
+	}
+	case CCommandBuffer::CMD_RENDER_QUAD_LAYER:
+		Visit(static_cast<CCommandBuffer::SCommand_RenderQuadLayer *>(pBaseCommand)->m_pQuadInfo, 0);
+		break;
+	case CCommandBuffer::CMD_RENDER_QUAD_CONTAINER_SPRITE_MULTIPLE:
+		Visit(static_cast<CCommandBuffer::SCommand_RenderQuadContainerAsSpriteMultiple *>(pBaseCommand)->m_pRenderInfo, 0);
+		break;
+	}
+}
+
+static bool IsSwap(unsigned Cmd)
+{
+	return Cmd == CCommandBuffer::CMD_SWAP || Cmd == CCommandBuffer::CMD_TRY_SWAP_AND_SCREENSHOT;
+}
+
+// also accepts the end for empty allocations
+static bool InRange(uint64_t Address, uint64_t Base, size_t Size)
+{
+	return Address >= Base && Address - Base <= Size;
+}
+
+template<typename T>
+static uint64_t Address(T *pPtr)
+{
+	return (uint64_t)(uintptr_t)pPtr;
+}
+
+static void WriteValue(IOHANDLE File, uint32_t Value)
+{
+	io_write(File, &Value, sizeof(Value));
+}
+
+static void WriteValue(IOHANDLE File, uint64_t Value)
+{
+	io_write(File, &Value, sizeof(Value));
+}
+
+template<typename T>
+static bool ReadValue(IOHANDLE File, T &Value)
+{
+	return io_read(File, &Value, sizeof(Value)) == sizeof(Value);
+}
+
+bool CGraphicsCaptureWriter::Open(IOHANDLE File)
+{
+	Close();
+	if(!File)
+		return false;
+	m_File = File;
+	m_NumBuffers = 0;
+	m_NumFrames = 0;
+	io_write(m_File, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+	WriteValue(m_File, CAPTURE_VERSION);
+	WriteValue(m_File, (uint32_t)sizeof(void *));
+	return true;
+}
+
+void CGraphicsCaptureWriter::Close()
+{
+	if(!m_File)
+		return;
+	io_close(m_File);
+	m_File = nullptr;
+}
+
+void CGraphicsCaptureWriter::Write(CCommandBuffer *pBuffer)
+{
+	if(!m_File)
+		return;
+
+	const uint64_t DataBase = Address(pBuffer->m_DataBuffer.DataPtr());
+	const size_t DataUsed = pBuffer->m_DataBuffer.DataUsed();
+	std::vector<std::pair<const void *, size_t>> vExternal;
+	bool Swapped = false;
+	for(CCommandBuffer::SCommand *pCommand = pBuffer->Head(); pCommand; pCommand = pCommand->m_pNext)
+	{
+		VisitPointers(pCommand, [&](auto *&pPtr, size_t ExternalSize) {
+			if(pPtr && !InRange(Address(pPtr), DataBase, DataUsed))
+				vExternal.emplace_back(pPtr, ExternalSize);
+		});
+		Swapped |= IsSwap(pCommand->m_Cmd);
+	}
+
+	WriteValue(m_File, (uint32_t)pBuffer->m_CommandCount);
+	WriteValue(m_File, (uint32_t)pBuffer->m_RenderCallCount);
+	WriteValue(m_File, (uint32_t)pBuffer->m_CmdBuffer.DataUsed());
+	WriteValue(m_File, (uint32_t)DataUsed);
+	WriteValue(m_File, (uint32_t)vExternal.size());
+	WriteValue(m_File, Address(pBuffer->m_CmdBuffer.DataPtr()));
+	WriteValue(m_File, DataBase);
+	WriteValue(m_File, Address(pBuffer->Head()));
+	io_write(m_File, pBuffer->m_CmdBuffer.DataPtr(), pBuffer->m_CmdBuffer.DataUsed());
+	io_write(m_File, pBuffer->m_DataBuffer.DataPtr(), DataUsed);
+	for(const auto &[pData, Size] : vExternal)
+	{
+		WriteValue(m_File, (uint64_t)Size);
+		io_write(m_File, pData, Size);
+	}
+
+	m_NumBuffers++;
+	if(Swapped)
+		m_NumFrames++;
+}
+
+bool CGraphicsCaptureReader::Load(IOHANDLE File, unsigned CmdBufferSize, unsigned DataBufferSize)
+{
+	m_vBuffers.clear();
+	m_NumFrames = 0;
+	m_NumCommands = 0;
+	m_NumRenderCalls = 0;
+
+	// seeks to the start
+	const uint64_t Length = io_length(File);
+	unsigned char aMagic[sizeof(CAPTURE_MAGIC)];
+	uint32_t Version, PointerSize;
+	if(io_read(File, aMagic, sizeof(aMagic)) != sizeof(aMagic) || mem_comp(aMagic, CAPTURE_MAGIC, sizeof(aMagic)) != 0 ||
+		!ReadValue(File, Version) || Version != CAPTURE_VERSION ||
+		!ReadValue(File, PointerSize) || PointerSize != sizeof(void *))
+		return false;
+
+	while(true)
+	{
+		CBuffer Buffer;
+		uint32_t CmdSize, DataSize, NumExternal;
+		if(!ReadValue(File, Buffer.m_CommandCount))
+			break;
+		if(!ReadValue(File, Buffer.m_RenderCallCount) || !ReadValue(File, CmdSize) || !ReadValue(File, DataSize) || !ReadValue(File, NumExternal) ||
+			!ReadValue(File, Buffer.m_CmdBase) || !ReadValue(File, Buffer.m_DataBase) || !ReadValue(File, Buffer.m_Head) ||
+			CmdSize > CmdBufferSize || DataSize > DataBufferSize)
+			return false;
+		Buffer.m_vCmd.resize(CmdSize);
+		Buffer.m_vData.resize(DataSize);
+		if(io_read(File, Buffer.m_vCmd.data(), CmdSize) != CmdSize || io_read(File, Buffer.m_vData.data(), DataSize) != DataSize)
+			return false;
+		for(uint32_t i = 0; i < NumExternal; i++)
+		{
+			uint64_t Size;
+			if(!ReadValue(File, Size) || Size > Length)
+				return false;
+			std::vector<unsigned char> &vExternal = Buffer.m_vvExternal.emplace_back(Size);
+			if(io_read(File, vExternal.data(), Size) != Size)
+				return false;
+		}
+
+		// make sure the commands can be replayed without further checks
+		uint64_t Command = Buffer.m_Head;
+		uint32_t NumCommands = 0;
+		size_t NumExternalUsed = 0;
+		bool Valid = true;
+		bool Swapped = false;
+		while(Command && Valid)
+		{
+			if(++NumCommands > Buffer.m_CommandCount || !InRange(Command, Buffer.m_CmdBase, CmdSize) ||
+				Command - Buffer.m_CmdBase + sizeof(CCommandBuffer::SCommand) > CmdSize)
+				return false;
+			// the buffers keep the alignment of the recorded ones
+			auto *pCommand = (CCommandBuffer::SCommand *)&Buffer.m_vCmd[Command - Buffer.m_CmdBase];
+			VisitPointers(pCommand, [&](auto *&pPtr, size_t ExternalSize) {
+				if((unsigned char *)&pPtr + sizeof(pPtr) > Buffer.m_vCmd.data() + CmdSize)
+					Valid = false;
+				else if(!pPtr || InRange(Address(pPtr), Buffer.m_DataBase, DataSize))
+					return;
+				else if(ExternalSize == 0 || NumExternalUsed >= Buffer.m_vvExternal.size() || Buffer.m_vvExternal[NumExternalUsed].size() != ExternalSize)
+					Valid = false;
+				else
+					NumExternalUsed++;
+			});
+			Swapped |= IsSwap(pCommand->m_Cmd);
+			Command = Address(pCommand->m_pNext);
+		}
+		if(!Valid || NumExternalUsed != Buffer.m_vvExternal.size())
+			return false;
+
+		m_NumCommands += Buffer.m_CommandCount;
+		m_NumRenderCalls += Buffer.m_RenderCallCount;
+		if(Swapped)
+			m_NumFrames++;
+		m_vBuffers.emplace_back(std::move(Buffer));
+	}
+	return true;
+}
+
+void CGraphicsCaptureReader::Fill(int Index, CCommandBuffer *pBuffer) const
+{
+	const CBuffer &Buffer = m_vBuffers[Index];
+	pBuffer->Reset();
+	auto *pCmd = (unsigned char *)pBuffer->m_CmdBuffer.Alloc(Buffer.m_vCmd.size(), 1);
+	auto *pData = (unsigned char *)pBuffer->m_DataBuffer.Alloc(Buffer.m_vData.size(), 1);
+	dbg_assert(pCmd && pData, "capture buffer does not fit into the command buffer");
+	mem_copy(pCmd, Buffer.m_vCmd.data(), Buffer.m_vCmd.size());
+	mem_copy(pData, Buffer.m_vData.data(), Buffer.m_vData.size());
+
+	auto Relocate = [](auto *&pPtr, uint64_t Base, unsigned char *pNewBase) {
+		pPtr = (std::remove_reference_t<decltype(pPtr)>)(pNewBase + (Address(pPtr) - Base));
+	};
+
+	CCommandBuffer::SCommand *pHead = (CCommandBuffer::SCommand *)(uintptr_t)Buffer.m_Head;
+	if(pHead)
+		Relocate(pHead, Buffer.m_CmdBase, pCmd);
+	size_t NumExternalUsed = 0;
+	for(CCommandBuffer::SCommand *pCommand = pHead; pCommand; pCommand = pCommand->m_pNext)
+	{
+		if(pCommand->m_pNext)
+			Relocate(pCommand->m_pNext, Buffer.m_CmdBase, pCmd);
+		else
+			pBuffer->m_pCmdBufferTail = pCommand;
+
+		VisitPointers(pCommand, [&](auto *&pPtr, size_t ExternalSize) {
+			if(!pPtr)
+				return;
+			if(InRange(Address(pPtr), Buffer.m_DataBase, Buffer.m_vData.size()))
+			{
+				Relocate(pPtr, Buffer.m_DataBase, pData);
+				return;
+			}
+			// the command processor frees it
+			const std::vector<unsigned char> &vExternal = Buffer.m_vvExternal[NumExternalUsed++];
+			void *pCopy = malloc(vExternal.size());
+			mem_copy(pCopy, vExternal.data(), vExternal.size());
+			pPtr = (std::remove_reference_t<decltype(pPtr)>)pCopy;
+		});
+
+		switch(pCommand->m_Cmd)
+		{
+		case CCommandBuffer::CMD_TRY_SWAP_AND_SCREENSHOT:
+			pCommand->m_Cmd = CCommandBuffer::CMD_SWAP;
+			break;
+		case CCommandBuffer::CMD_RUNBUFFER:
+		case CCommandBuffer::CMD_SIGNAL:
+		case CCommandBuffer::CMD_VSYNC:
+		case CCommandBuffer::CMD_MULTISAMPLING:
+		case CCommandBuffer::CMD_WINDOW_CREATE_NTF:
+		case CCommandBuffer::CMD_WINDOW_DESTROY_NTF:
+			pCommand->m_Cmd = CCommandBuffer::CMD_NOP;
+			break;
+		}
+	}
+	pBuffer->m_pCmdBufferHead = pHead;
+	pBuffer->m_CommandCount = Buffer.m_CommandCount;
+	pBuffer->m_RenderCallCount = Buffer.m_RenderCallCount;
+}
@@ -0,0 +1,75 @@
+#ifndef ENGINE_CLIENT_GRAPHICS_CAPTURE_H
+#define ENGINE_CLIENT_GRAPHICS_CAPTURE_H
+
+#include <base/system.h>
+
+#include <cstdint>
+#include <vector>
+
+class CCommandBuffer;
+
+// Records the command buffers that the frontend kicks to the backend.
+//
+// Every buffer is written as it is, with the addresses of the command and
+// data buffer so the pointers between them can be fixed up on replay.
+// Memory owned by the commands that lies outside of the data buffer, e.g.
+// texture data, is appended to the buffer. The file can only be replayed
+// by a build with the same command structs.
+class CGraphicsCaptureWriter
+{
+	IOHANDLE m_File = nullptr;
+	int m_NumBuffers = 0;
+	int m_NumFrames = 0;
+
+public:
+	~CGraphicsCaptureWriter() { Close(); }
+
+	bool Open(IOHANDLE File);
+	void Close();
+	bool IsOpen() const { return m_File != nullptr; }
+
+	// call before the buffer is run, the backend frees the texture data
+	void Write(CCommandBuffer *pBuffer);
+
+	int NumBuffers() const { return m_NumBuffers; }
+	// buffers that ended with a swap
+	int NumFrames() const { return m_NumFrames; }
+};
+
+// Loads a capture and turns its buffers back into command buffers.
+//
+// Commands that point to variables of the recording frontend, like
+// signals and vsync changes, become no-ops, a screenshot becomes a swap.
+class CGraphicsCaptureReader
+{
+	struct CBuffer
+	{
+		uint32_t m_CommandCount;
+		uint32_t m_RenderCallCount;
+		uint64_t m_CmdBase;
+		uint64_t m_DataBase;
+		uint64_t m_Head;
+		std::vector<unsigned char> m_vCmd;
+		std::vector<unsigned char> m_vData;
+		std::vector<std::vector<unsigned char>> m_vvExternal;
+	};
+	std::vector<CBuffer> m_vBuffers;
+	int m_NumFrames = 0;
+	size_t m_NumCommands = 0;
+	size_t m_NumRenderCalls = 0;
+
+public:
+	// returns false if the file is not a valid capture of this build or a
+	// buffer does not fit into the given command buffer sizes
+	bool Load(IOHANDLE File, unsigned CmdBufferSize, unsigned DataBufferSize);
+
+	int NumBuffers() const { return m_vBuffers.size(); }
+	int NumFrames() const { return m_NumFrames; }
+	size_t NumCommands() const { return m_NumCommands; }
+	size_t NumRenderCalls() const { return m_NumRenderCalls; }
+
+	// resets the command buffer and fills it with the recorded buffer
+	void Fill(int Index, CCommandBuffer *pBuffer) const;
+};
+
+#endif
@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 
 #include <base/detect.h>
+#include <base/logger.h>
 #include <base/math.h>
 
 #if defined(CONF_FAMILY_UNIX)
@@ -17,6 +18,7 @@
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
 #include <engine/shared/jobs.h>
+#include <engine/shared/profiler.h>
 #include <engine/storage.h>
 
 #include <game/generated/client_data.h>
@@ -795,6 +797,14 @@ void CGraphics_Threaded::CopyTextureFromTextureBufferSub(uint8_t *pDestBuffer, i
 
 void CGraphics_Threaded::KickCommandBuffer()
 {
+	CProfiler::CCounterScope Profile(m_pProfiler, "KickCommandBuffer");
+	m_FrameCommands += m_pCommandBuffer->m_CommandCount;
+	if(m_Capture.IsOpen() && !m_Replaying)
+	{
+		m_Capture.Write(m_pCommandBuffer);
+		if(m_CaptureFrames > 0 && m_Capture.NumFrames() >= m_CaptureFrames)
+			StopCapture();
+	}
 	m_pBackend->RunBuffer(m_pCommandBuffer);
 
 	std::vector<std::string> WarningStrings;
@@ -814,6 +824,104 @@ void CGraphics_Threaded::KickCommandBuffer()
 	m_pCommandBuffer->Reset();
 }
 
+bool CGraphics_Threaded::MergeRenderQuadContainer(const CCommandBuffer::SCommand_RenderQuadContainer &Command)
+{
+	CCommandBuffer::SCommand *pTail = m_pCommandBuffer->Tail();
+	if(!g_Config.m_GfxBatchRender || !pTail || pTail->m_Cmd != CCommandBuffer::CMD_RENDER_QUAD_CONTAINER)
+		return false;
+
+	// the quads must follow each other in the container
+	auto *pLast = static_cast<CCommandBuffer::SCommand_RenderQuadContainer *>(pTail);
+	if(pLast->m_BufferContainerIndex != Command.m_BufferContainerIndex || !IsSameState(pLast->m_State, Command.m_State) ||
+		(uintptr_t)pLast->m_pOffset + pLast->m_DrawNum * sizeof(unsigned int) != (uintptr_t)Command.m_pOffset)
+		return false;
+
+	pLast->m_DrawNum += Command.m_DrawNum;
+	m_FrameMergedCommands++;
+	return true;
+}
+
+void CGraphics_Threaded::StopCapture()
+{
+	if(!m_Capture.IsOpen())
+		return;
+	log_info("gfx", "captured %d frames in %d command buffers", m_Capture.NumFrames(), m_Capture.NumBuffers());
+	m_Capture.Close();
+}
+
+void CGraphics_Threaded::Con_Capture(IConsole::IResult *pResult, void *pUserData)
+{
+	CGraphics_Threaded *pSelf = (CGraphics_Threaded *)pUserData;
+	pSelf->StopCapture();
+
+	const char *pFilename = pResult->GetString(0);
+	char aPath[IO_MAX_PATH_LENGTH];
+	if(!pSelf->m_Capture.Open(pSelf->m_pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE, aPath, sizeof(aPath))))
+	{
+		log_error("gfx", "failed to open '%s' for writing", pFilename);
+		return;
+	}
+	pSelf->m_CaptureFrames = pResult->NumArguments() > 1 ? maximum(pResult->GetInteger(1), 0) : 0;
+	log_info("gfx", "capturing command buffers to '%s'", aPath);
+}
+
+void CGraphics_Threaded::Con_CaptureStop(IConsole::IResult *pResult, void *pUserData)
+{
+	((CGraphics_Threaded *)pUserData)->StopCapture();
+}
+
+void CGraphics_Threaded::Con_Replay(IConsole::IResult *pResult, void *pUserData)
+{
+#if defined(CONF_HEADLESS_CLIENT)
+	CGraphics_Threaded *pSelf = (CGraphics_Threaded *)pUserData;
+	const char *pFilename = pResult->GetString(0);
+	const int Repeat = pResult->NumArguments() > 1 ? maximum(pResult->GetInteger(1), 1) : 1;
+
+	IOHANDLE File = pSelf->m_pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		log_error("gfx", "failed to open '%s'", pFilename);
+		return;
+	}
+	CGraphicsCaptureReader Reader;
+	const bool Loaded = Reader.Load(File, CMD_BUFFER_CMD_BUFFER_SIZE, CMD_BUFFER_DATA_BUFFER_SIZE);
+	io_close(File);
+	if(!Loaded)
+	{
+		log_error("gfx", "'%s' is not a capture of this build", pFilename);
+		return;
+	}
+
+	pSelf->KickCommandBuffer();
+	pSelf->WaitForIdle();
+	pSelf->m_Replaying = true;
+	int64_t FillDuration = 0;
+	const int64_t Start = time_get_nanoseconds().count();
+	for(int r = 0; r < Repeat; r++)
+	{
+		for(int i = 0; i < Reader.NumBuffers(); i++)
+		{
+			// filled while the backend runs the previous buffer
+			const int64_t FillStart = time_get_nanoseconds().count();
+			Reader.Fill(i, pSelf->m_pCommandBuffer);
+			FillDuration += time_get_nanoseconds().count() - FillStart;
+			pSelf->KickCommandBuffer();
+		}
+	}
+	pSelf->WaitForIdle();
+	const int64_t Duration = time_get_nanoseconds().count() - Start;
+	pSelf->m_Replaying = false;
+
+	log_info("gfx", "replayed %d frames in %d buffers with %" PRIzu " commands and %" PRIzu " render calls %d times",
+		Reader.NumFrames(), Reader.NumBuffers(), Reader.NumCommands(), Reader.NumRenderCalls(), Repeat);
+	log_info("gfx", "took %.2fms, %.3fms per buffer, %.3fms per frame, %.2fms to fill the buffers",
+		Duration / 1000000.0, Duration / 1000000.0 / maximum(Reader.NumBuffers() * Repeat, 1),
+		Duration / 1000000.0 / maximum(Reader.NumFrames() * Repeat, 1), FillDuration / 1000000.0);
+#else
+	log_error("gfx", "replaying a capture is only supported by the headless client, it would overwrite the textures and buffers in use");
+#endif
+}
+
 class CScreenshotSaveJob : public IJob
 {
 	IStorage *m_pStorage;
@@ -893,6 +1001,8 @@ void CGraphics_Threaded::TextureSet(CTextureHandle TextureID)
 {
 	dbg_assert(m_Drawing == 0, "called Graphics()->TextureSet within begin");
 	dbg_assert(!TextureID.IsValid() || m_vTextureIndices[TextureID.Id()] == -1, "Texture handle was not invalid, but also did not correlate to an existing texture.");
+	if(m_State.m_Texture != TextureID.Id())
+		m_FrameTextureBinds++;
 	m_State.m_Texture = TextureID.Id();
 }
 
@@ -2030,13 +2140,16 @@ void CGraphics_Threaded::RenderQuadContainer(int ContainerIndex, int QuadOffset,
 		Cmd.m_pOffset = (void *)(QuadOffset * 6 * sizeof(unsigned int));
 		Cmd.m_BufferContainerIndex = Container.m_QuadBufferContainerIndex;
 
-		if(!AddCmd(
-			   Cmd, [] { return true; }, "failed to allocate memory for render quad container"))
+		if(!MergeRenderQuadContainer(Cmd))
 		{
-			return;
-		}
+			if(!AddCmd(
+				   Cmd, [] { return true; }, "failed to allocate memory for render quad container"))
+			{
+				return;
+			}
 
-		m_pCommandBuffer->AddRenderCalls(1);
+			m_pCommandBuffer->AddRenderCalls(1);
+		}
 	}
 	else
 	{
@@ -2868,6 +2981,7 @@ int CGraphics_Threaded::Init()
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 	m_pEngine = Kernel()->RequestInterface<IEngine>();
+	m_pProfiler = Kernel()->RequestInterface<CProfiler>();
 
 	// init textures
 	m_FirstFreeTexture = 0;
@@ -2919,11 +3033,17 @@ int CGraphics_Threaded::Init()
 
 	AdjustViewport(true);
 
+	m_pConsole->Register("gfx_capture", "s[file] ?i[frames]", CFGFLAG_CLIENT, Con_Capture, this, "Write the command buffers sent to the graphics backend to a file, stop after the given number of frames");
+	m_pConsole->Register("gfx_capture_stop", "", CFGFLAG_CLIENT, Con_CaptureStop, this, "Stop writing the command buffers to a file");
+	m_pConsole->Register("gfx_replay", "s[file] ?i[repeat]", CFGFLAG_CLIENT, Con_Replay, this, "Run the command buffers of a capture through the graphics backend and print how long it took");
+
 	return 0;
 }
 
 void CGraphics_Threaded::Shutdown()
 {
+	StopCapture();
+
 	// shutdown the backend
 	m_pBackend->Shutdown();
 	delete m_pBackend;
@@ -3191,6 +3311,20 @@ void CGraphics_Threaded::Swap()
 
 	// kick the command buffer
 	KickCommandBuffer();
+
+	m_LastFrameCommands = m_FrameCommands;
+	m_LastFrameMergedCommands = m_FrameMergedCommands;
+	m_LastFrameTextureBinds = m_FrameTextureBinds;
+	m_FrameCommands = 0;
+	m_FrameMergedCommands = 0;
+	m_FrameTextureBinds = 0;
+	if(m_pProfiler)
+	{
+		m_pProfiler->AddCounter("gfx commands", 0, m_LastFrameCommands);
+		m_pProfiler->AddCounter("gfx commands merged", 0, m_LastFrameMergedCommands);
+		m_pProfiler->AddCounter("gfx texture binds", 0, m_LastFrameTextureBinds);
+	}
+
 	// TODO: Remove when https://github.com/libsdl-org/SDL/issues/5203 is fixed
 #ifdef CONF_PLATFORM_MACOS
 	if(str_find(GetVersionString(), "Metal"))
@@ -1,11 +1,15 @@
 #ifndef ENGINE_CLIENT_GRAPHICS_THREADED_H
 #define ENGINE_CLIENT_GRAPHICS_THREADED_H
 
+#include <engine/console.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
 
+#include "graphics_capture.h"
+
 #include <cstddef>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 constexpr int CMD_BUFFER_DATA_BUFFER_SIZE = 1024 * 1024 * 2;
@@ -637,9 +641,15 @@ public:
 	{
 	}
 
-	void *AllocData(unsigned WantedSize)
+	void *AllocData(unsigned WantedSize, unsigned Alignment = alignof(std::max_align_t))
+	{
+		return m_DataBuffer.Alloc(WantedSize, Alignment);
+	}
+
+	// where the next allocation starts if it doesn't need padding
+	const unsigned char *DataEnd()
 	{
-		return m_DataBuffer.Alloc(WantedSize);
+		return m_DataBuffer.DataPtr() + m_DataBuffer.DataUsed();
 	}
 
 	template<class T>
@@ -671,6 +681,11 @@ public:
 		return m_pCmdBufferHead;
 	}
 
+	SCommand *Tail()
+	{
+		return m_pCmdBufferTail;
+	}
+
 	void Reset()
 	{
 		m_pCmdBufferHead = m_pCmdBufferTail = nullptr;
@@ -803,6 +818,19 @@ class CGraphics_Threaded : public IEngineGraphics
 	class IStorage *m_pStorage;
 	class IConsole *m_pConsole;
 	class IEngine *m_pEngine;
+	class CProfiler *m_pProfiler;
+
+	int m_FrameCommands = 0;
+	int m_FrameMergedCommands = 0;
+	int m_LastFrameCommands = 0;
+	int m_LastFrameMergedCommands = 0;
+	int m_FrameTextureBinds = 0;
+	int m_LastFrameTextureBinds = 0;
+
+	CGraphicsCaptureWriter m_Capture;
+	// 0 to capture until gfx_capture_stop
+	int m_CaptureFrames = 0;
+	bool m_Replaying = false;
 
 	int m_CurIndex;
 
@@ -927,6 +955,12 @@ class CGraphics_Threaded : public IEngineGraphics
 	}
 
 	void KickCommandBuffer();
+	bool MergeRenderQuadContainer(const CCommandBuffer::SCommand_RenderQuadContainer &Command);
+
+	void StopCapture();
+	static void Con_Capture(IConsole::IResult *pResult, void *pUserData);
+	static void Con_CaptureStop(IConsole::IResult *pResult, void *pUserData);
+	static void Con_Replay(IConsole::IResult *pResult, void *pUserData);
 
 	void AddBackEndWarningIfExists();
 
@@ -953,6 +987,10 @@ public:
 	uint64_t StreamedMemoryUsage() const override;
 	uint64_t StagingMemoryUsage() const override;
 
+	int NumCommandsLastFrame() const override { return m_LastFrameCommands; }
+	int NumMergedCommandsLastFrame() const override { return m_LastFrameMergedCommands; }
+	int NumTextureBindsLastFrame() const override { return m_LastFrameTextureBinds; }
+
 	const TTWGraphicsGPUList &GetGPUs() const override;
 
 	void MapScreen(float TopLeftX, float TopLeftY, float BottomRightX, float BottomRightY) override;
@@ -1155,6 +1193,41 @@ public:
 	void RenderQuadContainerAsSprite(int ContainerIndex, int QuadOffset, float X, float Y, float ScaleX = 1.f, float ScaleY = 1.f) override;
 	void RenderQuadContainerAsSpriteMultiple(int ContainerIndex, int QuadOffset, int DrawCount, SRenderSpriteInfo *pRenderInfo) override;
 
+	static bool IsSameState(const CCommandBuffer::SState &State, const CCommandBuffer::SState &Other)
+	{
+		return State.m_BlendMode == Other.m_BlendMode && State.m_WrapMode == Other.m_WrapMode && State.m_Texture == Other.m_Texture &&
+			       State.m_ScreenTL == Other.m_ScreenTL && State.m_ScreenBR == Other.m_ScreenBR &&
+			       State.m_ClipEnable == Other.m_ClipEnable && State.m_ClipX == Other.m_ClipX && State.m_ClipY == Other.m_ClipY &&
+			       State.m_ClipW == Other.m_ClipW && State.m_ClipH == Other.m_ClipH;
+	}
+
+	// Appends the vertices to the last command if it draws the same
+	// primitives with the same state and its vertices end where the new
+	// ones start.
+	template<typename TName>
+	bool MergeVertices(TName &Command, int PrimType, int PrimCount, int NumVerts, size_t VertSize)
+	{
+		CCommandBuffer::SCommand *pTail = m_pCommandBuffer->Tail();
+		if(!g_Config.m_GfxBatchRender || !pTail || pTail->m_Cmd != Command.m_Cmd || PrimCount == 0)
+			return false;
+
+		TName *pLast = static_cast<TName *>(pTail);
+		const size_t LastNumVerts = (size_t)pLast->m_PrimCount * (NumVerts / PrimCount);
+		if(pLast->m_PrimType != (unsigned)PrimType || !IsSameState(pLast->m_State, m_State) ||
+			LastNumVerts + NumVerts > CCommandBuffer::MAX_VERTICES ||
+			(const unsigned char *)pLast->m_pVertices + LastNumVerts * VertSize != m_pCommandBuffer->DataEnd())
+			return false;
+
+		using TVertex = std::remove_pointer_t<decltype(Command.m_pVertices)>;
+		Command.m_pVertices = (TVertex *)m_pCommandBuffer->AllocData(VertSize * NumVerts, alignof(TVertex));
+		if(Command.m_pVertices == NULL)
+			return false;
+
+		pLast->m_PrimCount += PrimCount;
+		m_FrameMergedCommands++;
+		return true;
+	}
+
 	template<typename TName>
 	void FlushVerticesImpl(bool KeepVertices, int &PrimType, int &PrimCount, int &NumVerts, TName &Command, size_t VertSize)
 	{
@@ -1193,6 +1266,9 @@ public:
 		else
 			return;
 
+		if(MergeVertices(Command, PrimType, PrimCount, NumVerts, VertSize))
+			return;
+
 		Command.m_pVertices = (decltype(Command.m_pVertices))m_pCommandBuffer->AllocData(VertSize * NumVerts);
 		if(Command.m_pVertices == NULL)
 		{
@@ -815,12 +815,19 @@ void CServerBrowser::Refresh(int Type)
 		m_pHttp->Refresh();
 		m_pPingCache->Load();
 		m_RefreshingHttp = true;
+		m_NumHttpStreamedServers = -1;
+		m_NumHttpStreamedLegacyServers = -1;
 
 		if(ServerListTypeChanged && m_pHttp->NumServers() > 0)
 		{
 			CleanUp();
 			UpdateFromHttp();
 			Sort();
+			if(m_pHttp->IsStreaming())
+			{
+				m_NumHttpStreamedServers = m_pHttp->NumServers();
+				m_NumHttpStreamedLegacyServers = m_pHttp->NumLegacyServers();
+			}
 		}
 	}
 }
@@ -890,7 +897,7 @@ void CServerBrowser::SetCurrentServerPing(const NETADDR &Addr, int Ping)
 	SetLatency(Addr, minimum(Ping, 999));
 }
 
-void CServerBrowser::UpdateFromHttp()
+void CServerBrowser::UpdateFromHttp(int FirstServer, int FirstLegacyServer)
 {
 	int OwnLocation;
 	if(str_comp(g_Config.m_BrLocation, "auto") == 0)
@@ -979,7 +986,7 @@ void CServerBrowser::UpdateFromHttp()
 			};
 		}
 	}
-	for(int i = 0; i < NumServers; i++)
+	for(int i = FirstServer; i < NumServers; i++)
 	{
 		CServerInfo Info = m_pHttp->Server(i);
 		if(!Want(Info.m_aAddresses, Info.m_NumAddresses))
@@ -1001,7 +1008,7 @@ void CServerBrowser::UpdateFromHttp()
 		SetInfo(pEntry, Info);
 		pEntry->m_RequestIgnoreInfo = true;
 	}
-	for(int i = 0; i < NumLegacyServers; i++)
+	for(int i = FirstLegacyServer; i < NumLegacyServers; i++)
 	{
 		NETADDR Addr = m_pHttp->LegacyServer(i);
 		if(!Want(&Addr, 1))
@@ -1011,7 +1018,9 @@ void CServerBrowser::UpdateFromHttp()
 		QueueRequest(Add(&Addr, 1));
 	}
 
-	if(m_ServerlistType == IServerBrowser::TYPE_FAVORITES)
+	// Favorites missing from a partial list might still be in the part
+	// that hasn't been downloaded yet.
+	if(m_ServerlistType == IServerBrowser::TYPE_FAVORITES && !m_pHttp->IsStreaming())
 	{
 		const IFavorites::CEntry *pFavorites;
 		int NumFavorites;
@@ -1073,12 +1082,31 @@ void CServerBrowser::Update()
 	if(m_ServerlistType != TYPE_LAN && m_RefreshingHttp && !m_pHttp->IsRefreshing())
 	{
 		m_RefreshingHttp = false;
+		m_NumHttpStreamedServers = -1;
+		m_NumHttpStreamedLegacyServers = -1;
 		CleanUp();
 		UpdateFromHttp();
 		// TODO: move this somewhere else
 		Sort();
 		return;
 	}
+	else if(m_ServerlistType != TYPE_LAN && m_RefreshingHttp && m_pHttp->IsStreaming())
+	{
+		// Show the servers downloaded so far, they are re-added from
+		// scratch once the complete list is there.
+		if(m_NumHttpStreamedServers == -1)
+		{
+			CleanUp();
+			m_NumHttpStreamedServers = 0;
+			m_NumHttpStreamedLegacyServers = 0;
+		}
+		if(m_pHttp->NumServers() > m_NumHttpStreamedServers || m_pHttp->NumLegacyServers() > m_NumHttpStreamedLegacyServers)
+		{
+			UpdateFromHttp(m_NumHttpStreamedServers, m_NumHttpStreamedLegacyServers);
+			m_NumHttpStreamedServers = m_pHttp->NumServers();
+			m_NumHttpStreamedLegacyServers = m_pHttp->NumLegacyServers();
+		}
+	}
 
 	CServerEntry *pEntry = m_pFirstReqServer;
 	int Count = 0;
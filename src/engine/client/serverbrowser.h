@@ -146,6 +146,10 @@ private:
 	char m_aNetVersion[128];
 
 	bool m_RefreshingHttp = false;
+	// Number of servers already added from the partial HTTP server list,
+	// -1 if the current refresh hasn't delivered any yet.
+	int m_NumHttpStreamedServers = -1;
+	int m_NumHttpStreamedLegacyServers = -1;
 	IServerBrowserHttp *m_pHttp = nullptr;
 	IServerBrowserPingCache *m_pPingCache = nullptr;
 	const char *m_pHttpPrevBestUrl = nullptr;
@@ -202,7 +206,7 @@ private:
 
 	void CleanUp();
 
-	void UpdateFromHttp();
+	void UpdateFromHttp(int FirstServer = 0, int FirstLegacyServer = 0);
 	CServerEntry *Add(const NETADDR *pAddrs, int NumAddrs);
 
 	void RemoveRequest(CServerEntry *pEntry);
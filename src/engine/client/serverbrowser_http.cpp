@@ -6,6 +6,7 @@
 #include <engine/serverbrowser.h>
 #include <engine/shared/http.h>
 #include <engine/shared/jobs.h>
+#include <engine/shared/json.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/serverinfo.h>
 #include <engine/storage.h>
@@ -246,6 +247,125 @@ void CChooseMaster::CJob::Run()
 	m_pData->m_BestIndex.store(BestIndex);
 }
 
+static bool ParseServer(const json_value &Server, CServerInfo *pOut, bool *pValid);
+static bool ParseLegacyServer(const json_value &Address, NETADDR *pOut);
+
+// Parses the server list while it is being downloaded. The parsed servers
+// are collected in batches that can be fetched from the main thread using
+// `TakeBatch` before the download has finished.
+class CServerListRequest : public CHttpRequest, private CJsonStreamParser
+{
+	LOCK m_BatchLock;
+	std::vector<CServerInfo> m_vBatchServers GUARDED_BY(m_BatchLock);
+	std::vector<NETADDR> m_vBatchLegacyServers GUARDED_BY(m_BatchLock);
+
+	// Only accessed from the download thread.
+	std::vector<CServerInfo> m_vPendingServers;
+	std::vector<NETADDR> m_vPendingLegacyServers;
+	bool m_SeenServers = false;
+
+	void FlushPending() REQUIRES(!m_BatchLock);
+
+	size_t OnData(char *pData, size_t DataSize) override REQUIRES(!m_BatchLock);
+	int OnCompletion(int State) override REQUIRES(!m_BatchLock);
+
+	bool OnMember(const char *pKey, bool IsArray) override;
+	bool OnArrayElement(const char *pKey, const json_value *pValue) override;
+
+public:
+	CServerListRequest(const char *pUrl) :
+		CHttpRequest(pUrl) { m_BatchLock = lock_create(); }
+	~CServerListRequest() { lock_destroy(m_BatchLock); }
+
+	// Appends the servers parsed since the last call.
+	void TakeBatch(std::vector<CServerInfo> *pvServers, std::vector<NETADDR> *pvLegacyServers) REQUIRES(!m_BatchLock);
+};
+
+void CServerListRequest::FlushPending()
+{
+	if(m_vPendingServers.empty() && m_vPendingLegacyServers.empty())
+	{
+		return;
+	}
+	CLockScope ls(m_BatchLock);
+	m_vBatchServers.insert(m_vBatchServers.end(), m_vPendingServers.begin(), m_vPendingServers.end());
+	m_vBatchLegacyServers.insert(m_vBatchLegacyServers.end(), m_vPendingLegacyServers.begin(), m_vPendingLegacyServers.end());
+	m_vPendingServers.clear();
+	m_vPendingLegacyServers.clear();
+}
+
+size_t CServerListRequest::OnData(char *pData, size_t DataSize)
+{
+	if(Feed(pData, DataSize))
+	{
+		return 0;
+	}
+	FlushPending();
+	return DataSize;
+}
+
+int CServerListRequest::OnCompletion(int State)
+{
+	State = CHttpRequest::OnCompletion(State);
+	if(State == HTTP_DONE && (Finish() || !m_SeenServers))
+	{
+		dbg_msg("serverbrowse_http", "invalid serverlist");
+		State = HTTP_ERROR;
+	}
+	FlushPending();
+	return State;
+}
+
+bool CServerListRequest::OnMember(const char *pKey, bool IsArray)
+{
+	if(str_comp(pKey, "servers") == 0)
+	{
+		m_SeenServers = true;
+		return !IsArray;
+	}
+	else if(str_comp(pKey, "servers_legacy") == 0)
+	{
+		return !IsArray;
+	}
+	return false;
+}
+
+bool CServerListRequest::OnArrayElement(const char *pKey, const json_value *pValue)
+{
+	if(str_comp(pKey, "servers") == 0)
+	{
+		CServerInfo Info;
+		bool Valid;
+		if(ParseServer(*pValue, &Info, &Valid))
+		{
+			return true;
+		}
+		if(Valid)
+		{
+			m_vPendingServers.push_back(Info);
+		}
+	}
+	else if(str_comp(pKey, "servers_legacy") == 0)
+	{
+		NETADDR Addr;
+		if(ParseLegacyServer(*pValue, &Addr))
+		{
+			return true;
+		}
+		m_vPendingLegacyServers.push_back(Addr);
+	}
+	return false;
+}
+
+void CServerListRequest::TakeBatch(std::vector<CServerInfo> *pvServers, std::vector<NETADDR> *pvLegacyServers)
+{
+	CLockScope ls(m_BatchLock);
+	pvServers->insert(pvServers->end(), m_vBatchServers.begin(), m_vBatchServers.end());
+	pvLegacyServers->insert(pvLegacyServers->end(), m_vBatchLegacyServers.begin(), m_vBatchLegacyServers.end());
+	m_vBatchServers.clear();
+	m_vBatchLegacyServers.clear();
+}
+
 class CServerBrowserHttp : public IServerBrowserHttp
 {
 public:
@@ -253,6 +373,7 @@ public:
 	virtual ~CServerBrowserHttp();
 	void Update() override;
 	bool IsRefreshing() override { return m_State != STATE_DONE; }
+	bool IsStreaming() const override { return m_Streaming; }
 	void Refresh() override;
 	bool GetBestUrl(const char **pBestUrl) const override { return m_pChooseMaster->GetBestUrl(pBestUrl); }
 
@@ -288,12 +409,21 @@ private:
 	IEngine *m_pEngine;
 	IConsole *m_pConsole;
 
+	void TakeBatch();
+
 	int m_State = STATE_DONE;
-	std::shared_ptr<CHttpRequest> m_pGetServers;
+	std::shared_ptr<CServerListRequest> m_pGetServers;
 	std::unique_ptr<CChooseMaster> m_pChooseMaster;
 
 	std::vector<CServerInfo> m_vServers;
 	std::vector<NETADDR> m_vLegacyServers;
+
+	// While streaming, `m_vServers` and `m_vLegacyServers` hold the
+	// partial result of the current refresh and the previous result is
+	// kept here in case the refresh fails.
+	bool m_Streaming = false;
+	std::vector<CServerInfo> m_vPreviousServers;
+	std::vector<NETADDR> m_vPreviousLegacyServers;
 };
 
 CServerBrowserHttp::CServerBrowserHttp(IEngine *pEngine, IConsole *pConsole, const char **ppUrls, int NumUrls, int PreviousBestIndex) :
@@ -326,7 +456,7 @@ void CServerBrowserHttp::Update()
 			}
 			return;
 		}
-		m_pGetServers = HttpGet(pBestUrl);
+		m_pGetServers = std::make_shared<CServerListRequest>(pBestUrl);
 		// 10 seconds connection timeout, lower than 8KB/s for 10 seconds to fail.
 		m_pGetServers->Timeout(CTimeout{10000, 0, 8000, 10});
 		m_pEngine->AddJob(m_pGetServers);
@@ -334,19 +464,30 @@ void CServerBrowserHttp::Update()
 	}
 	else if(m_State == STATE_REFRESHING)
 	{
-		if(m_pGetServers->State() == HTTP_QUEUED || m_pGetServers->State() == HTTP_RUNNING)
+		int State = m_pGetServers->State();
+		TakeBatch();
+		if(State == HTTP_QUEUED || State == HTTP_RUNNING)
 		{
 			return;
 		}
 		m_State = STATE_DONE;
-		std::shared_ptr<CHttpRequest> pGetServers = nullptr;
-		std::swap(m_pGetServers, pGetServers);
+		m_pGetServers = nullptr;
 
-		bool Success = true;
-		json_value *pJson = pGetServers->ResultJson();
-		Success = Success && pJson;
-		Success = Success && !Parse(pJson, &m_vServers, &m_vLegacyServers);
-		json_value_free(pJson);
+		bool Success = State == HTTP_DONE;
+		if(Success && !m_Streaming)
+		{
+			// The new list is empty.
+			m_vServers.clear();
+			m_vLegacyServers.clear();
+		}
+		else if(!Success && m_Streaming)
+		{
+			m_vServers = std::move(m_vPreviousServers);
+			m_vLegacyServers = std::move(m_vPreviousLegacyServers);
+		}
+		m_Streaming = false;
+		m_vPreviousServers.clear();
+		m_vPreviousLegacyServers.clear();
 		if(!Success)
 		{
 			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "serverbrowse_http", "failed getting serverlist, trying to find best URL");
@@ -355,6 +496,26 @@ void CServerBrowserHttp::Update()
 		}
 	}
 }
+void CServerBrowserHttp::TakeBatch()
+{
+	std::vector<CServerInfo> vServers;
+	std::vector<NETADDR> vLegacyServers;
+	m_pGetServers->TakeBatch(&vServers, &vLegacyServers);
+	if(vServers.empty() && vLegacyServers.empty())
+	{
+		return;
+	}
+	if(!m_Streaming)
+	{
+		m_Streaming = true;
+		m_vPreviousServers = std::move(m_vServers);
+		m_vPreviousLegacyServers = std::move(m_vLegacyServers);
+		m_vServers.clear();
+		m_vLegacyServers.clear();
+	}
+	m_vServers.insert(m_vServers.end(), vServers.begin(), vServers.end());
+	m_vLegacyServers.insert(m_vLegacyServers.end(), vLegacyServers.begin(), vLegacyServers.end());
+}
 void CServerBrowserHttp::Refresh()
 {
 	if(m_State == STATE_WANTREFRESH || m_State == STATE_REFRESHING || m_State == STATE_NO_MASTER)
@@ -404,6 +565,68 @@ bool CServerBrowserHttp::Validate(json_value *pJson)
 	std::vector<NETADDR> vLegacyServers;
 	return Parse(pJson, &vServers, &vLegacyServers);
 }
+static bool ParseServer(const json_value &Server, CServerInfo *pOut, bool *pValid)
+{
+	*pValid = false;
+	const json_value &Addresses = Server["addresses"];
+	const json_value &Info = Server["info"];
+	const json_value &Location = Server["location"];
+	int ParsedLocation = CServerInfo::LOC_UNKNOWN;
+	CServerInfo2 ParsedInfo;
+	if(Addresses.type != json_array || (Location.type != json_string && Location.type != json_none))
+	{
+		return true;
+	}
+	if(Location.type == json_string)
+	{
+		if(CServerInfo::ParseLocation(&ParsedLocation, Location))
+		{
+			return true;
+		}
+	}
+	if(CServerInfo2::FromJson(&ParsedInfo, &Info))
+	{
+		//dbg_msg("dbg/serverbrowser", "skipped due to info");
+		// Only skip the current server on parsing
+		// failure; the server info is "user input" by
+		// the game server and can be set to arbitrary
+		// values.
+		return false;
+	}
+	CServerInfo SetInfo = ParsedInfo;
+	SetInfo.m_Location = ParsedLocation;
+	SetInfo.m_NumAddresses = 0;
+	for(unsigned int a = 0; a < Addresses.u.array.length; a++)
+	{
+		const json_value &Address = Addresses[a];
+		if(Address.type != json_string)
+		{
+			return true;
+		}
+		NETADDR ParsedAddr;
+		if(ServerbrowserParseUrl(&ParsedAddr, Addresses[a]))
+		{
+			//dbg_msg("dbg/serverbrowser", "unknown address, a=%d", a);
+			// Skip unknown addresses.
+			continue;
+		}
+		if(SetInfo.m_NumAddresses < (int)std::size(SetInfo.m_aAddresses))
+		{
+			SetInfo.m_aAddresses[SetInfo.m_NumAddresses] = ParsedAddr;
+			SetInfo.m_NumAddresses += 1;
+		}
+	}
+	if(SetInfo.m_NumAddresses > 0)
+	{
+		*pOut = SetInfo;
+		*pValid = true;
+	}
+	return false;
+}
+static bool ParseLegacyServer(const json_value &Address, NETADDR *pOut)
+{
+	return Address.type != json_string || net_addr_from_str(pOut, Address);
+}
 bool CServerBrowserHttp::Parse(json_value *pJson, std::vector<CServerInfo> *pvServers, std::vector<NETADDR> *pvLegacyServers)
 {
 	std::vector<CServerInfo> vServers;
@@ -418,67 +641,23 @@ bool CServerBrowserHttp::Parse(json_value *pJson, std::vector<CServerInfo> *pvSe
 	}
 	for(unsigned int i = 0; i < Servers.u.array.length; i++)
 	{
-		const json_value &Server = Servers[i];
-		const json_value &Addresses = Server["addresses"];
-		const json_value &Info = Server["info"];
-		const json_value &Location = Server["location"];
-		int ParsedLocation = CServerInfo::LOC_UNKNOWN;
-		CServerInfo2 ParsedInfo;
-		if(Addresses.type != json_array || (Location.type != json_string && Location.type != json_none))
+		CServerInfo ParsedServer;
+		bool Valid;
+		if(ParseServer(Servers[i], &ParsedServer, &Valid))
 		{
 			return true;
 		}
-		if(Location.type == json_string)
-		{
-			if(CServerInfo::ParseLocation(&ParsedLocation, Location))
-			{
-				return true;
-			}
-		}
-		if(CServerInfo2::FromJson(&ParsedInfo, &Info))
-		{
-			//dbg_msg("dbg/serverbrowser", "skipped due to info, i=%d", i);
-			// Only skip the current server on parsing
-			// failure; the server info is "user input" by
-			// the game server and can be set to arbitrary
-			// values.
-			continue;
-		}
-		CServerInfo SetInfo = ParsedInfo;
-		SetInfo.m_Location = ParsedLocation;
-		SetInfo.m_NumAddresses = 0;
-		for(unsigned int a = 0; a < Addresses.u.array.length; a++)
-		{
-			const json_value &Address = Addresses[a];
-			if(Address.type != json_string)
-			{
-				return true;
-			}
-			NETADDR ParsedAddr;
-			if(ServerbrowserParseUrl(&ParsedAddr, Addresses[a]))
-			{
-				//dbg_msg("dbg/serverbrowser", "unknown address, i=%d a=%d", i, a);
-				// Skip unknown addresses.
-				continue;
-			}
-			if(SetInfo.m_NumAddresses < (int)std::size(SetInfo.m_aAddresses))
-			{
-				SetInfo.m_aAddresses[SetInfo.m_NumAddresses] = ParsedAddr;
-				SetInfo.m_NumAddresses += 1;
-			}
-		}
-		if(SetInfo.m_NumAddresses > 0)
+		if(Valid)
 		{
-			vServers.push_back(SetInfo);
+			vServers.push_back(ParsedServer);
 		}
 	}
 	if(LegacyServers.type == json_array)
 	{
 		for(unsigned int i = 0; i < LegacyServers.u.array.length; i++)
 		{
-			const json_value &Address = LegacyServers[i];
 			NETADDR ParsedAddr;
-			if(Address.type != json_string || net_addr_from_str(&ParsedAddr, Address))
+			if(ParseLegacyServer(LegacyServers[i], &ParsedAddr))
 			{
 				return true;
 			}
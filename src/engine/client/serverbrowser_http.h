@@ -15,6 +15,9 @@ public:
 	virtual void Update() = 0;
 
 	virtual bool IsRefreshing() = 0;
+	// Whether the servers returned are the partial result of an ongoing
+	// refresh. They grow in batches while the server list is downloaded.
+	virtual bool IsStreaming() const = 0;
 	virtual void Refresh() = 0;
 
 	virtual bool GetBestUrl(const char **pBestUrl) const = 0;
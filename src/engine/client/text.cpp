@@ -4,6 +4,8 @@
 #include <base/system.h>
 
 #include <engine/graphics.h>
+#include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
@@ -14,7 +16,11 @@
 #include <chrono>
 #include <cstddef>
 #include <limits>
+#include <list>
 #include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 using namespace std::chrono_literals;
@@ -68,6 +74,8 @@ struct SFontSizeData
 	FT_Face *m_pFace;
 
 	std::map<int, SFontSizeChar> m_Chars;
+	// kerning of glyph index pairs, left index in the upper bits
+	std::unordered_map<uint64_t, int> m_Kernings;
 };
 
 constexpr int MIN_FONT_SIZE = 6;
@@ -95,6 +103,7 @@ public:
 			m_aFontSizes[i].m_FontSize = i + MIN_FONT_SIZE;
 			m_aFontSizes[i].m_pFace = &this->m_FtFace;
 			m_aFontSizes[i].m_Chars.clear();
+			m_aFontSizes[i].m_Kernings.clear();
 		}
 	}
 
@@ -200,10 +209,88 @@ struct STextContainer
 	}
 };
 
+// Results of laying out texts without cursor or selection, keyed by
+// everything the layout depends on. The least recently used entries are
+// removed if there are too many of them or they hold too many quads.
+class CTextLayoutCache
+{
+public:
+	enum
+	{
+		MAX_ENTRIES = 16 * 1024,
+		MAX_QUADS = 64 * 1024,
+		MAX_TEXT_LENGTH = 1024,
+	};
+
+	struct SEntry
+	{
+		std::string m_Key;
+		std::vector<STextCharQuad> m_vQuads;
+		float m_X;
+		float m_Y;
+		float m_LongestLineWidth;
+		float m_MaxCharacterHeight;
+		int m_LineCount;
+		int m_GlyphCount;
+		int m_CharCount;
+		int m_Flags;
+	};
+
+	const SEntry *Find(std::string_view Key)
+	{
+		auto It = m_Index.find(Key);
+		if(It == m_Index.end())
+		{
+			m_Misses++;
+			return nullptr;
+		}
+		m_Hits++;
+		m_lEntries.splice(m_lEntries.begin(), m_lEntries, It->second);
+		return &*It->second;
+	}
+
+	void Add(SEntry &&Entry)
+	{
+		if(Entry.m_vQuads.size() > MAX_QUADS / 4 || m_Index.count(Entry.m_Key))
+			return;
+		m_NumQuads += Entry.m_vQuads.size();
+		m_lEntries.push_front(std::move(Entry));
+		m_Index.emplace(m_lEntries.front().m_Key, m_lEntries.begin());
+		while(m_lEntries.size() > MAX_ENTRIES || m_NumQuads > MAX_QUADS)
+		{
+			m_NumQuads -= m_lEntries.back().m_vQuads.size();
+			m_Index.erase(m_lEntries.back().m_Key);
+			m_lEntries.pop_back();
+		}
+	}
+
+	void Clear()
+	{
+		m_Index.clear();
+		m_lEntries.clear();
+		m_NumQuads = 0;
+	}
+
+	STextLayoutCacheStats Stats() const
+	{
+		return {m_Hits, m_Misses, (int)m_lEntries.size(), (int)m_NumQuads};
+	}
+
+private:
+	// most recently used first
+	std::list<SEntry> m_lEntries;
+	// the keys point into the entries
+	std::unordered_map<std::string_view, std::list<SEntry>::iterator> m_Index;
+	size_t m_NumQuads = 0;
+	int64_t m_Hits = 0;
+	int64_t m_Misses = 0;
+};
+
 class CTextRender : public IEngineTextRender
 {
 	IGraphics *m_pGraphics;
 	IGraphics *Graphics() { return m_pGraphics; }
+	CProfiler *m_pProfiler;
 
 	unsigned m_RenderFlags;
 
@@ -218,6 +305,32 @@ class CTextRender : public IEngineTextRender
 
 	std::chrono::nanoseconds m_CursorRenderTime;
 
+	CTextLayoutCache m_LayoutCache;
+	std::string m_LayoutKey;
+	// nested layouts, e.g. for word wrapping, are not cached
+	int m_LayoutDepth = 0;
+
+	// everything besides the text that the layout depends on, the layout
+	// is stored relative to the aligned cursor position
+	struct SLayoutKeyHeader
+	{
+		const CFont *m_pFont;
+		int m_ContainerFontSize;
+		unsigned m_RenderFlags;
+		float m_FontSize;
+		float m_FakeToScreenX;
+		float m_FakeToScreenY;
+		// where new lines start relative to the cursor, in pixels if the
+		// text is aligned to them
+		float m_StartOffsetX;
+		float m_LineWidth;
+		int m_Flags;
+		int m_MaxLines;
+		int m_LineCount;
+		int m_FirstGlyph;
+		float m_aColor[4];
+	};
+
 	int GetFreeTextContainerIndex()
 	{
 		if(m_FirstFreeTextContainerIndex == -1)
@@ -594,10 +707,21 @@ class CTextRender : public IEngineTextRender
 		}
 	}
 
-	float Kerning(CFont *pFont, FT_UInt GlyphIndexLeft, FT_UInt GlyphIndexRight) const
+	float Kerning(CFont *pFont, SFontSizeData *pSizeData, FT_UInt GlyphIndexLeft, FT_UInt GlyphIndexRight) const
 	{
+		if(GlyphIndexLeft == 0 || GlyphIndexRight == 0)
+			return 0.0f;
+
+		const uint64_t Pair = ((uint64_t)GlyphIndexLeft << 32) | GlyphIndexRight;
+		const auto It = pSizeData->m_Kernings.find(Pair);
+		if(It != pSizeData->m_Kernings.end())
+			return It->second;
+
+		// the kerning is scaled to the current size of the face
+		FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, pSizeData->m_FontSize);
 		FT_Vector Kerning = {0, 0};
 		FT_Get_Kerning(pFont->m_FtFace, GlyphIndexLeft, GlyphIndexRight, FT_KERNING_DEFAULT, &Kerning);
+		pSizeData->m_Kernings.emplace(Pair, Kerning.x >> 6);
 		return (Kerning.x >> 6);
 	}
 
@@ -605,6 +729,7 @@ public:
 	CTextRender()
 	{
 		m_pGraphics = nullptr;
+		m_pProfiler = nullptr;
 
 		m_Color = DefaultTextColor();
 		m_OutlineColor = DefaultTextOutlineColor();
@@ -646,6 +771,7 @@ public:
 	void Init() override
 	{
 		m_pGraphics = Kernel()->RequestInterface<IGraphics>();
+		m_pProfiler = Kernel()->RequestInterface<CProfiler>();
 		FT_Init_FreeType(&m_FTLibrary);
 		// print freetype version
 		{
@@ -1019,8 +1145,26 @@ public:
 		}
 	}
 
+	void UpdateTextContainerQuads(STextContainer &TextContainer)
+	{
+		TextContainer.m_StringInfo.m_QuadNum = TextContainer.m_StringInfo.m_vCharacterQuads.size();
+		// setup the buffers
+		if(Graphics()->IsTextBufferingEnabled())
+		{
+			size_t DataSize = TextContainer.m_StringInfo.m_vCharacterQuads.size() * sizeof(STextCharQuad);
+			void *pUploadData = TextContainer.m_StringInfo.m_vCharacterQuads.data();
+
+			if(TextContainer.m_StringInfo.m_QuadBufferObjectIndex != -1 && (TextContainer.m_RenderFlags & TEXT_RENDER_FLAG_NO_AUTOMATIC_QUAD_UPLOAD) == 0)
+			{
+				Graphics()->RecreateBufferObject(TextContainer.m_StringInfo.m_QuadBufferObjectIndex, DataSize, pUploadData, TextContainer.m_SingleTimeUse ? IGraphics::EBufferObjectCreateFlags::BUFFER_OBJECT_CREATE_FLAGS_ONE_TIME_USE_BIT : 0);
+				Graphics()->IndicesNumRequiredNotify(TextContainer.m_StringInfo.m_QuadNum * 6);
+			}
+		}
+	}
+
 	void AppendTextContainer(int TextContainerIndex, CTextCursor *pCursor, const char *pText, int Length = -1) override
 	{
+		CProfiler::CCounterScope Profile(m_pProfiler, "text layout");
 		STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
 
 		// calculate the font size of the displayed glyphs
@@ -1049,6 +1193,79 @@ public:
 		else
 			Length = minimum(Length, str_length(pText));
 
+		// look up the layout if there is no cursor or selection to calculate,
+		// the ellipsis depends on the width of the whole text
+		const bool Cacheable = g_Config.m_GfxTextLayoutCache && m_LayoutDepth == 0 &&
+				       pCursor->m_CalculateSelectionMode == TEXT_CURSOR_SELECTION_MODE_NONE && pCursor->m_CursorMode == TEXT_CURSOR_CURSOR_MODE_NONE &&
+				       Length <= CTextLayoutCache::MAX_TEXT_LENGTH && ((pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END) == 0 || pText[Length] == '\0');
+		const size_t FirstQuad = TextContainer.m_StringInfo.m_vCharacterQuads.size();
+		const int FirstGlyphCount = pCursor->m_GlyphCount;
+		const int FirstCharCount = pCursor->m_CharCount;
+		const float FirstLongestLineWidth = pCursor->m_LongestLineWidth;
+		const float FirstMaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+		const bool PixelAligned = (TextContainer.m_RenderFlags & TEXT_RENDER_FLAG_NO_PIXEL_ALIGMENT) == 0;
+		const float OriginX = PixelAligned ? CursorX : pCursor->m_X;
+		const float OriginY = PixelAligned ? CursorY : pCursor->m_Y;
+		if(Cacheable)
+		{
+			SLayoutKeyHeader Header;
+			mem_zero(&Header, sizeof(Header));
+			Header.m_pFont = TextContainer.m_pFont;
+			Header.m_ContainerFontSize = TextContainer.m_FontSize;
+			Header.m_RenderFlags = TextContainer.m_RenderFlags;
+			Header.m_FontSize = pCursor->m_FontSize;
+			Header.m_FakeToScreenX = FakeToScreenX;
+			Header.m_FakeToScreenY = FakeToScreenY;
+			Header.m_StartOffsetX = PixelAligned ? (float)(round_to_int(pCursor->m_StartX * FakeToScreenX) - ActualX) : pCursor->m_StartX - pCursor->m_X;
+			Header.m_LineWidth = pCursor->m_LineWidth;
+			Header.m_Flags = pCursor->m_Flags;
+			Header.m_MaxLines = pCursor->m_MaxLines;
+			Header.m_LineCount = pCursor->m_LineCount;
+			Header.m_FirstGlyph = pCursor->m_GlyphCount == 0;
+			if(pCursor->m_Flags & TEXTFLAG_RENDER)
+			{
+				// the color is part of the quads
+				Header.m_aColor[0] = m_Color.r;
+				Header.m_aColor[1] = m_Color.g;
+				Header.m_aColor[2] = m_Color.b;
+				Header.m_aColor[3] = m_Color.a;
+			}
+			m_LayoutKey.assign((const char *)&Header, sizeof(Header));
+			m_LayoutKey.append(pText, Length);
+
+			const CTextLayoutCache::SEntry *pEntry = m_LayoutCache.Find(m_LayoutKey);
+			if(pEntry != nullptr)
+			{
+				std::vector<STextCharQuad> &vQuads = TextContainer.m_StringInfo.m_vCharacterQuads;
+				vQuads.insert(vQuads.end(), pEntry->m_vQuads.begin(), pEntry->m_vQuads.end());
+				for(size_t i = FirstQuad; i < vQuads.size(); i++)
+				{
+					for(STextCharQuadVertex &Vertex : vQuads[i].m_aVertices)
+					{
+						Vertex.m_X += OriginX;
+						Vertex.m_Y += OriginY;
+					}
+				}
+				if(!vQuads.empty() && (pCursor->m_Flags & TEXTFLAG_RENDER) != 0)
+					UpdateTextContainerQuads(TextContainer);
+				pCursor->m_X = OriginX + pEntry->m_X;
+				pCursor->m_Y = OriginY + pEntry->m_Y;
+				pCursor->m_LineCount = pEntry->m_LineCount;
+				pCursor->m_GlyphCount += pEntry->m_GlyphCount;
+				pCursor->m_CharCount += pEntry->m_CharCount;
+				pCursor->m_LongestLineWidth = maximum(pCursor->m_LongestLineWidth, pEntry->m_LongestLineWidth);
+				pCursor->m_MaxCharacterHeight = maximum(pCursor->m_MaxCharacterHeight, pEntry->m_MaxCharacterHeight);
+				pCursor->m_Flags = pEntry->m_Flags;
+				TextContainer.m_BoundingBox = pCursor->BoundingBox();
+				return;
+			}
+
+			// the cached values must not depend on the previous text
+			pCursor->m_LongestLineWidth = 0.0f;
+			pCursor->m_MaxCharacterHeight = 0.0f;
+		}
+		m_LayoutDepth++;
+
 		const float Scale = 1.0f / pSizeData->m_FontSize;
 
 		const char *pCurrent = pText;
@@ -1255,7 +1472,7 @@ public:
 
 					float CharKerning = 0.f;
 					if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
-						CharKerning = Kerning(TextContainer.m_pFont, LastCharGlyphIndex, pChr->m_GlyphIndex) * Scale * Size;
+						CharKerning = Kerning(TextContainer.m_pFont, pSizeData, LastCharGlyphIndex, pChr->m_GlyphIndex) * Scale * Size;
 					LastCharGlyphIndex = pChr->m_GlyphIndex;
 
 					if(pEllipsisChr != nullptr && pCursor->m_Flags & TEXTFLAG_ELLIPSIS_AT_END && pCurrent < pBatchEnd && pCurrent != pEllipsis)
@@ -1264,7 +1481,7 @@ public:
 						float CharKerningEllipsis = 0.f;
 						if((RenderFlags & TEXT_RENDER_FLAG_KERNING) != 0)
 						{
-							CharKerningEllipsis = Kerning(TextContainer.m_pFont, pChr->m_GlyphIndex, pEllipsisChr->m_GlyphIndex) * Scale * Size;
+							CharKerningEllipsis = Kerning(TextContainer.m_pFont, pSizeData, pChr->m_GlyphIndex, pEllipsisChr->m_GlyphIndex) * Scale * Size;
 						}
 						if(DrawX + CharKerning + Advance + CharKerningEllipsis + AdvanceEllipsis - pCursor->m_StartX > pCursor->m_LineWidth)
 						{
@@ -1432,21 +1649,7 @@ public:
 		}
 
 		if(!TextContainer.m_StringInfo.m_vCharacterQuads.empty() && IsRendered)
-		{
-			TextContainer.m_StringInfo.m_QuadNum = TextContainer.m_StringInfo.m_vCharacterQuads.size();
-			// setup the buffers
-			if(Graphics()->IsTextBufferingEnabled())
-			{
-				size_t DataSize = TextContainer.m_StringInfo.m_vCharacterQuads.size() * sizeof(STextCharQuad);
-				void *pUploadData = TextContainer.m_StringInfo.m_vCharacterQuads.data();
-
-				if(TextContainer.m_StringInfo.m_QuadBufferObjectIndex != -1 && (TextContainer.m_RenderFlags & TEXT_RENDER_FLAG_NO_AUTOMATIC_QUAD_UPLOAD) == 0)
-				{
-					Graphics()->RecreateBufferObject(TextContainer.m_StringInfo.m_QuadBufferObjectIndex, DataSize, pUploadData, TextContainer.m_SingleTimeUse ? IGraphics::EBufferObjectCreateFlags::BUFFER_OBJECT_CREATE_FLAGS_ONE_TIME_USE_BIT : 0);
-					Graphics()->IndicesNumRequiredNotify(TextContainer.m_StringInfo.m_QuadNum * 6);
-				}
-			}
-		}
+			UpdateTextContainerQuads(TextContainer);
 
 		if(pCursor->m_CalculateSelectionMode == TEXT_CURSOR_SELECTION_MODE_CALCULATE)
 		{
@@ -1524,6 +1727,37 @@ public:
 		if(GotNewLine)
 			pCursor->m_Y = DrawY;
 
+		m_LayoutDepth--;
+		if(Cacheable)
+		{
+			CTextLayoutCache::SEntry Entry;
+			Entry.m_Key = m_LayoutKey;
+			if(IsRendered)
+			{
+				Entry.m_vQuads.assign(TextContainer.m_StringInfo.m_vCharacterQuads.begin() + FirstQuad, TextContainer.m_StringInfo.m_vCharacterQuads.end());
+				for(STextCharQuad &Quad : Entry.m_vQuads)
+				{
+					for(STextCharQuadVertex &Vertex : Quad.m_aVertices)
+					{
+						Vertex.m_X -= OriginX;
+						Vertex.m_Y -= OriginY;
+					}
+				}
+			}
+			Entry.m_X = pCursor->m_X - OriginX;
+			Entry.m_Y = pCursor->m_Y - OriginY;
+			Entry.m_LongestLineWidth = pCursor->m_LongestLineWidth;
+			Entry.m_MaxCharacterHeight = pCursor->m_MaxCharacterHeight;
+			Entry.m_LineCount = pCursor->m_LineCount;
+			Entry.m_GlyphCount = pCursor->m_GlyphCount - FirstGlyphCount;
+			Entry.m_CharCount = pCursor->m_CharCount - FirstCharCount;
+			Entry.m_Flags = pCursor->m_Flags;
+			m_LayoutCache.Add(std::move(Entry));
+
+			pCursor->m_LongestLineWidth = maximum(pCursor->m_LongestLineWidth, FirstLongestLineWidth);
+			pCursor->m_MaxCharacterHeight = maximum(pCursor->m_MaxCharacterHeight, FirstMaxCharacterHeight);
+		}
+
 		TextContainer.m_BoundingBox = pCursor->BoundingBox();
 	}
 
@@ -1586,6 +1820,7 @@ public:
 
 	void RenderTextContainer(int TextContainerIndex, const ColorRGBA &TextColor, const ColorRGBA &TextOutlineColor) override
 	{
+		CProfiler::CCounterScope Profile(m_pProfiler, "text render");
 		const STextContainer &TextContainer = GetTextContainer(TextContainerIndex);
 		const CFont *pFont = TextContainer.m_pFont;
 
@@ -1970,6 +2205,12 @@ public:
 
 			pFont->InitFontSizes();
 		}
+		m_LayoutCache.Clear();
+	}
+
+	STextLayoutCacheStats LayoutCacheStats() const override
+	{
+		return m_LayoutCache.Stats();
 	}
 };
 
@@ -298,6 +298,13 @@ public:
 	virtual uint64_t StreamedMemoryUsage() const = 0;
 	virtual uint64_t StagingMemoryUsage() const = 0;
 
+	// commands sent to the backend in the last frame and how many were
+	// merged into previous ones
+	virtual int NumCommandsLastFrame() const = 0;
+	virtual int NumMergedCommandsLastFrame() const = 0;
+	// changes of the texture in the last frame
+	virtual int NumTextureBindsLastFrame() const = 0;
+
 	virtual const TTWGraphicsGPUList &GetGPUs() const = 0;
 
 	virtual int LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType) = 0;
@@ -16,6 +16,7 @@
 #include <game/generated/protocolglue.h>
 
 struct CAntibotRoundData;
+class CTickTimings;
 
 // When recording a demo on the server, the ClientID -1 is used
 enum
@@ -268,6 +269,9 @@ public:
 	virtual const char *GetMapName() const = 0;
 
 	virtual bool IsSixup(int ClientID) const = 0;
+
+	// for timing the phases of the game tick
+	virtual CTickTimings *TickTimings() = 0;
 };
 
 class IGameServer : public IInterface
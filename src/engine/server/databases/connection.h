@@ -50,6 +50,14 @@ public:
 	// has to be called to return the connection back to the pool
 	virtual void Disconnect() = 0;
 
+	// groups the following statements until commit or rollback, connection
+	// has to be established
+	//
+	// returns true on failure
+	virtual bool BeginTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool CommitTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool RollbackTransaction(char *pError, int ErrorSize) = 0;
+
 	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements
 	//
 	// returns true on failure
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <engine/console.h>
 
+#include <algorithm>
 #include <chrono>
 #include <iterator>
 #include <memory>
@@ -64,6 +65,12 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	// used for the latency statistics
+	int64_t m_QueueTime = time_get();
+	// reads are executed once this many queries from `m_aQueries` are done
+	int64_t m_WaitForDone = 0;
+	// writes that may be executed in one transaction with their neighbours
+	bool m_Batchable = false;
 };
 
 CSqlExecData::CSqlExecData(
@@ -119,53 +126,147 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 
 CDbConnectionPool::~CDbConnectionPool() = default;
 
-void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+void CDbConnectionPool::AddQuery(std::unique_ptr<CSqlExecData> pQuery)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
+	m_pShared->m_aQueries[m_InsertIdx++] = std::move(pQuery);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
+	m_NumQueued++;
 	m_pShared->m_NumBackup.Signal();
 }
 
+void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
+{
+	if(DatabaseMode == Mode::READ)
+	{
+		// the read databases are only changed by the main thread
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		for(auto &pReadConnection : m_pShared->m_vpReadConnections)
+			if(pReadConnection)
+				pReadConnection->Print(pConsole, "Read");
+		if(m_pShared->m_vpReadConnections.empty())
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFileName[64])
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFileName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		// read workers copy the connection before executing their next query
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadConnections.push_back(CreateSqliteConnection(aFileName, true));
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, aFileName));
 }
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	if(DatabaseMode == Mode::READ)
+	{
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadConnections.push_back(CreateMysqlConnection(*pMysqlConfig));
+		return;
+	}
+	AddQuery(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
 }
 
 void CDbConnectionPool::Execute(
 	FRead pFunc,
 	std::unique_ptr<const ISqlData> pSqlRequestData,
-	const char *pName)
+	const char *pName,
+	const std::vector<const char *> &vpPlayers)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	auto pData = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
+	const int64_t NumDone = m_pShared->m_NumDone.load();
+	for(const char *pPlayer : vpPlayers)
+	{
+		auto It = m_PlayerWrites.find(pPlayer);
+		if(It == m_PlayerWrites.end())
+			continue;
+		if(It->second <= NumDone)
+			m_PlayerWrites.erase(It);
+		else
+			pData->m_WaitForDone = maximum(pData->m_WaitForDone, It->second);
+	}
+	{
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		m_pShared->m_vpReadQueue.push_back(std::move(pData));
+	}
+	m_pShared->m_NumRead.Signal();
 }
 
 void CDbConnectionPool::ExecuteWrite(
 	FWrite pFunc,
 	std::unique_ptr<const ISqlData> pSqlRequestData,
-	const char *pName)
+	const char *pName,
+	const std::vector<const char *> &vpPlayers)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddWrite(pFunc, std::move(pSqlRequestData), pName, vpPlayers, false);
+}
+
+void CDbConnectionPool::ExecuteBatchableWrite(
+	FWrite pFunc,
+	std::unique_ptr<const ISqlData> pSqlRequestData,
+	const char *pName,
+	const std::vector<const char *> &vpPlayers)
+{
+	AddWrite(pFunc, std::move(pSqlRequestData), pName, vpPlayers, true);
+}
+
+void CDbConnectionPool::AddWrite(
+	FWrite pFunc,
+	std::unique_ptr<const ISqlData> pSqlRequestData,
+	const char *pName,
+	const std::vector<const char *> &vpPlayers,
+	bool Batchable)
+{
+	// forget players without pending writes once in a while
+	if(m_PlayerWrites.size() >= 1024)
+	{
+		const int64_t NumDone = m_pShared->m_NumDone.load();
+		for(auto It = m_PlayerWrites.begin(); It != m_PlayerWrites.end();)
+		{
+			if(It->second <= NumDone)
+				It = m_PlayerWrites.erase(It);
+			else
+				++It;
+		}
+	}
+	// the names might be part of the request data, which is owned by the
+	// worker once queued
+	for(const char *pPlayer : vpPlayers)
+		m_PlayerWrites[pPlayer] = m_NumQueued + 1;
+	auto pQuery = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
+	pQuery->m_Batchable = Batchable;
+	AddQuery(std::move(pQuery));
 }
 
 void CDbConnectionPool::OnShutdown()
 {
+	// read requests are dismissed during shutdown, wake up every read
+	// worker with an empty job to let them exit
+	{
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		for(auto &pThreadData : m_pShared->m_vpReadQueue)
+		{
+			dbg_msg("sql", "%s dismissed read request during shutdown", pThreadData->m_pName);
+			m_pShared->Complete(pThreadData.get(), false);
+		}
+		m_pShared->m_vpReadQueue.clear();
+		for(int i = 0; i < m_NumReadWorkers; i++)
+			m_pShared->m_vpReadQueue.push_back(nullptr);
+	}
+	for(int i = 0; i < m_NumReadWorkers; i++)
+		m_pShared->m_NumRead.Signal();
+
 	m_pShared->m_Shutdown.store(true);
+	m_pShared->NotifyDone();
 	m_pShared->m_NumBackup.Signal();
 	int i = 0;
-	while(m_pShared->m_Shutdown.load())
+	while(m_pShared->m_Shutdown.load() || m_pShared->m_NumReadWorkersRunning.load() > 0)
 	{
 		// print a log about every two seconds
 		if(i % 20 == 0 && i > 0)
@@ -177,6 +278,105 @@ void CDbConnectionPool::OnShutdown()
 	}
 }
 
+void CDbConnectionPool::CLatencies::Add(int64_t Latency)
+{
+	m_aSamples[m_Next] = Latency;
+	m_Next = (m_Next + 1) % NUM_SAMPLES;
+	m_NumSamples = minimum(m_NumSamples + 1, (int)NUM_SAMPLES);
+}
+
+void CDbConnectionPool::CLatencies::Percentiles(float *pPercentiles)
+{
+	if(m_NumSamples == 0)
+	{
+		for(int i = 0; i < NUM_PERCENTILES; i++)
+			pPercentiles[i] = 0.0f;
+		return;
+	}
+	int64_t aSorted[NUM_SAMPLES];
+	std::copy(m_aSamples, m_aSamples + m_NumSamples, aSorted);
+	std::sort(aSorted, aSorted + m_NumSamples);
+	static const float s_aFractions[NUM_PERCENTILES] = {0.5f, 0.9f, 0.99f, 1.0f};
+	for(int i = 0; i < NUM_PERCENTILES; i++)
+	{
+		int Index = (int)((m_NumSamples - 1) * s_aFractions[i]);
+		pPercentiles[i] = aSorted[Index] * 1000.0f / time_freq();
+	}
+}
+
+void CDbConnectionPool::CSharedData::Complete(CSqlExecData *pData, bool Success)
+{
+	if(pData->m_Mode == CSqlExecData::READ_ACCESS || pData->m_Mode == CSqlExecData::WRITE_ACCESS)
+	{
+		int64_t Latency = time_get() - pData->m_QueueTime;
+		std::lock_guard<std::mutex> Lock(m_StatsMutex);
+		if(pData->m_Mode == CSqlExecData::READ_ACCESS)
+		{
+			m_ReadLatencies.Add(Latency);
+			m_NumReads++;
+		}
+		else
+		{
+			m_WriteLatencies.Add(Latency);
+			m_NumWrites++;
+		}
+	}
+	if(pData->m_pThreadData != nullptr && pData->m_pThreadData->m_pResult != nullptr)
+	{
+		pData->m_pThreadData->m_pResult->m_Success = Success;
+		pData->m_pThreadData->m_pResult->m_Completed.store(true);
+	}
+}
+
+void CDbConnectionPool::CSharedData::NotifyDone()
+{
+	// the lock makes sure a read worker isn't between checking and waiting
+	{
+		std::lock_guard<std::mutex> Lock(m_DoneMutex);
+	}
+	m_DoneCond.notify_all();
+}
+
+void CDbConnectionPool::GetStats(CStats *pStats)
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+		pStats->m_ReadQueueDepth = 0;
+		for(auto &pThreadData : m_pShared->m_vpReadQueue)
+			if(pThreadData)
+				pStats->m_ReadQueueDepth++;
+	}
+	pStats->m_WriteQueueDepth = m_NumQueued - m_pShared->m_NumDone.load();
+
+	std::lock_guard<std::mutex> Lock(m_pShared->m_StatsMutex);
+	pStats->m_NumReads = m_pShared->m_NumReads;
+	pStats->m_NumWrites = m_pShared->m_NumWrites;
+	pStats->m_NumWriteBatches = m_pShared->m_NumWriteBatches;
+	pStats->m_NumBatchedWrites = m_pShared->m_NumBatchedWrites;
+	m_pShared->m_ReadLatencies.Percentiles(pStats->m_aReadLatency);
+	m_pShared->m_WriteLatencies.Percentiles(pStats->m_aWriteLatency);
+}
+
+void CDbConnectionPool::PrintStats(IConsole *pConsole)
+{
+	CStats Stats;
+	GetStats(&Stats);
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "read: %d queued, %d workers, %lld done, latency p50=%.1fms p90=%.1fms p99=%.1fms max=%.1fms",
+		Stats.m_ReadQueueDepth, m_NumReadWorkers, (long long)Stats.m_NumReads,
+		Stats.m_aReadLatency[PERCENTILE_50], Stats.m_aReadLatency[PERCENTILE_90],
+		Stats.m_aReadLatency[PERCENTILE_99], Stats.m_aReadLatency[PERCENTILE_MAX]);
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "sql", aBuf);
+	str_format(aBuf, sizeof(aBuf), "write: %d queued, %lld done, latency p50=%.1fms p90=%.1fms p99=%.1fms max=%.1fms",
+		Stats.m_WriteQueueDepth, (long long)Stats.m_NumWrites,
+		Stats.m_aWriteLatency[PERCENTILE_50], Stats.m_aWriteLatency[PERCENTILE_90],
+		Stats.m_aWriteLatency[PERCENTILE_99], Stats.m_aWriteLatency[PERCENTILE_MAX]);
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "sql", aBuf);
+	str_format(aBuf, sizeof(aBuf), "write: %lld transactions with %lld batched writes",
+		(long long)Stats.m_NumWriteBatches, (long long)Stats.m_NumBatchedWrites);
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "sql", aBuf);
+}
+
 // The backup worker thread looks at write queries and stores them
 // in the sqilte database (WRITE_BACKUP). It skips over read queries.
 // After processing the query, it gets passed on to the Worker thread.
@@ -247,6 +447,8 @@ public:
 
 private:
 	void Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode);
+	void CollectBatch(int *pJobNum, std::vector<std::unique_ptr<CSqlExecData>> &vpBatch);
+	bool ProcessWrite(int JobNum, CSqlExecData *pThreadData, bool Written, bool *pFailMode);
 
 	// There are two possible configurations
 	//  * sqlite mode: There exists exactly one READ and the same WRITE server
@@ -255,8 +457,7 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
-	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+	// The READ servers are handled by the read workers.
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -271,12 +472,65 @@ void CWorker::Start(void *pUser)
 	delete pThis;
 }
 
+// Takes the queries following the first one in the batch out of the queue,
+// as long as they are batchable writes of the same kind which the backup
+// thread already processed.
+void CWorker::CollectBatch(int *pJobNum, std::vector<std::unique_ptr<CSqlExecData>> &vpBatch)
+{
+	if(!vpBatch.front()->m_Batchable)
+	{
+		return;
+	}
+	const CDbConnectionPool::FWrite pFunc = vpBatch.front()->m_Ptr.m_pWriteFunc;
+	while(vpBatch.size() < (size_t)CDbConnectionPool::MAX_WRITE_BATCH && m_pShared->m_NumWorker.GetApproximateValue() > 0)
+	{
+		auto &pNext = m_pShared->m_aQueries[(*pJobNum + 1) % std::size(m_pShared->m_aQueries)];
+		if(pNext == nullptr || pNext->m_Mode != CSqlExecData::WRITE_ACCESS || !pNext->m_Batchable || pNext->m_Ptr.m_pWriteFunc != pFunc)
+		{
+			break;
+		}
+		// doesn't block, the backup thread already signaled this query
+		m_pShared->m_NumWorker.Wait();
+		vpBatch.push_back(std::move(pNext));
+		(*pJobNum)++;
+	}
+}
+
+bool CWorker::ProcessWrite(int JobNum, CSqlExecData *pThreadData, bool Written, bool *pFailMode)
+{
+	bool Success = Written;
+	if(Written)
+	{
+		dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
+	}
+	else if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
+	{
+		dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
+	}
+	else if(*pFailMode && m_pWriteBackup != nullptr)
+	{
+		dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
+	}
+	else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData, Write::NORMAL))
+	{
+		dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
+		Success = true;
+	}
+	// enter fail mode if not successful
+	*pFailMode = *pFailMode || !Success;
+	const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
+	if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData, w))
+	{
+		dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
+		Success = true;
+	}
+	return Success;
+}
+
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup
+	// database until all requests are handled
 	bool FailMode = false;
 	for(int JobNum = 0;; JobNum++)
 	{
@@ -292,81 +546,63 @@ void CWorker::ProcessQueries()
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
-		bool Success = false;
-		switch(pThreadData->m_Mode)
-		{
-		case CSqlExecData::READ_ACCESS:
+
+		if(pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS)
 		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+			const int FirstJob = JobNum;
+			std::vector<std::unique_ptr<CSqlExecData>> vpBatch;
+			vpBatch.push_back(std::move(pThreadData));
+			if(!m_pShared->m_Shutdown && !FailMode && m_pWriteConnection != nullptr)
 			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
+				CollectBatch(&JobNum, vpBatch);
+			}
+
+			// execute consecutive writes in one transaction, retry them one
+			// by one if it fails
+			bool Written = false;
+			if(vpBatch.size() > 1)
+			{
+				Written = CDbConnectionPool::ExecSqlBatch(m_pWriteConnection.get(), vpBatch);
+				if(Written)
 				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
-					break;
+					std::lock_guard<std::mutex> Lock(m_pShared->m_StatsMutex);
+					m_pShared->m_NumWriteBatches++;
+					m_pShared->m_NumBatchedWrites += vpBatch.size();
 				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+				else
 				{
-					ReadServer = CurServer;
-					dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
+					dbg_msg("sql", "[%i] batch of %d writes failed, executing them separately", FirstJob, (int)vpBatch.size());
 				}
 			}
-			if(!Success)
+			for(size_t i = 0; i < vpBatch.size(); i++)
 			{
-				FailMode = true;
+				bool Success = ProcessWrite(FirstJob + i, vpBatch[i].get(), Written, &FailMode);
+				if(!Success)
+					dbg_msg("sql", "[%i] %s failed on all databases", (int)(FirstJob + i), vpBatch[i]->m_pName);
+				m_pShared->Complete(vpBatch[i].get(), Success);
+				m_pShared->m_NumDone.fetch_add(1);
 			}
+			m_pShared->NotifyDone();
+			continue;
 		}
-		break;
-		case CSqlExecData::WRITE_ACCESS:
+
+		switch(pThreadData->m_Mode)
 		{
-			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
-			}
-			else if(FailMode && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
-			}
-			else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData.get(), Write::NORMAL))
-			{
-				dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
-				Success = true;
-			}
-			// enter fail mode if not successful
-			FailMode = FailMode || !Success;
-			const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
-			if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData.get(), w))
-			{
-				dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
-				Success = true;
-			}
-		}
-		break;
 		case CSqlExecData::ADD_MYSQL:
 		{
 			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_MySql.m_Config);
 			switch(pThreadData->m_Ptr.m_MySql.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pMysql);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pMysql);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
-			Success = true;
 			break;
 		}
 		case CSqlExecData::ADD_SQLITE:
@@ -374,46 +610,33 @@ void CWorker::ProcessQueries()
 			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_FileName, true);
 			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
 			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
 			case CDbConnectionPool::Mode::WRITE:
 				m_pWriteConnection = std::move(pSqlite);
 				break;
 			case CDbConnectionPool::Mode::WRITE_BACKUP:
 				m_pWriteBackup = std::move(pSqlite);
 				break;
+			case CDbConnectionPool::Mode::READ:
 			case CDbConnectionPool::Mode::NUM_MODES:
 				break;
 			}
-			Success = true;
 			break;
 		}
 		case CSqlExecData::PRINT:
 			Print(pThreadData->m_Ptr.m_Print.m_pConsole, pThreadData->m_Ptr.m_Print.m_Mode);
-			Success = true;
 			break;
+		default:
+			dbg_assert(false, "unreachable");
 		}
-		if(!Success)
-			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
-		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
-		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
-		}
+		m_pShared->Complete(pThreadData.get(), true);
+		m_pShared->m_NumDone.fetch_add(1);
+		m_pShared->NotifyDone();
 	}
 }
 
 void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
@@ -429,6 +652,88 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// The read workers execute read queries in parallel. Each of them has its
+// own connections to all read servers, reads don't depend on each other.
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, int Id) :
+		m_pShared(std::move(pShared)), m_Id(Id) {}
+	static void Start(void *pUser);
+	void ProcessQueries();
+
+private:
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+	int m_Id;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	for(int JobNum = 0;; JobNum++)
+	{
+		m_pShared->m_NumRead.Wait();
+		std::unique_ptr<CSqlExecData> pThreadData;
+		{
+			std::lock_guard<std::mutex> Lock(m_pShared->m_ReadMutex);
+			pThreadData = std::move(m_pShared->m_vpReadQueue.front());
+			m_pShared->m_vpReadQueue.pop_front();
+			// pick up servers added since the last query
+			for(size_t i = m_vpReadConnections.size(); i < m_pShared->m_vpReadConnections.size(); i++)
+			{
+				IDbConnection *pConnection = m_pShared->m_vpReadConnections[i].get();
+				m_vpReadConnections.emplace_back(pConnection ? pConnection->Copy() : nullptr);
+			}
+		}
+		// the main thread dismissed all remaining read queries in OnShutdown
+		if(pThreadData == nullptr)
+		{
+			m_pShared->m_NumReadWorkersRunning.fetch_sub(1);
+			return;
+		}
+
+		// wait for the writes of the same players queued before the read
+		{
+			std::unique_lock<std::mutex> Lock(m_pShared->m_DoneMutex);
+			m_pShared->m_DoneCond.wait(Lock, [&]() {
+				return m_pShared->m_NumDone.load() >= pThreadData->m_WaitForDone || m_pShared->m_Shutdown.load();
+			});
+		}
+
+		bool Success = false;
+		for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+		{
+			if(m_pShared->m_Shutdown)
+			{
+				dbg_msg("sql", "[%i:%i] %s dismissed read request during shutdown", m_Id, JobNum, pThreadData->m_pName);
+				break;
+			}
+			int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+			if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+			{
+				ReadServer = CurServer;
+				dbg_msg("sql", "[%i:%i] %s done on read database %d", m_Id, JobNum, pThreadData->m_pName, CurServer);
+				Success = true;
+				break;
+			}
+		}
+		if(!Success)
+			dbg_msg("sql", "[%i:%i] %s failed on all databases", m_Id, JobNum, pThreadData->m_pName);
+		m_pShared->Complete(pThreadData.get(), Success);
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -463,10 +768,52 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 	return Success;
 }
 
-CDbConnectionPool::CDbConnectionPool()
+/* static */
+bool CDbConnectionPool::ExecSqlBatch(IDbConnection *pConnection, std::vector<std::unique_ptr<CSqlExecData>> &vpBatch)
+{
+	if(pConnection == nullptr)
+	{
+		dbg_msg("sql", "No database given");
+		return false;
+	}
+	char aError[256] = "unknown error";
+	if(pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed connecting to db: %s", aError);
+		return false;
+	}
+	bool Success = !pConnection->BeginTransaction(aError, sizeof(aError));
+	for(size_t i = 0; i < vpBatch.size() && Success; i++)
+	{
+		CSqlExecData *pData = vpBatch[i].get();
+		Success = !pData->m_Ptr.m_pWriteFunc(pConnection, pData->m_pThreadData.get(), Write::NORMAL, aError, sizeof(aError));
+	}
+	if(Success)
+	{
+		Success = !pConnection->CommitTransaction(aError, sizeof(aError));
+	}
+	if(!Success)
+	{
+		dbg_msg("sql", "%s batch failed: %s", vpBatch.front()->m_pName, aError);
+		if(pConnection->RollbackTransaction(aError, sizeof(aError)))
+		{
+			dbg_msg("sql", "rollback failed: %s", aError);
+		}
+	}
+	pConnection->Disconnect();
+	return Success;
+}
+
+CDbConnectionPool::CDbConnectionPool(int NumReadWorkers) :
+	m_NumReadWorkers(NumReadWorkers)
 {
 	m_pShared = std::make_shared<CSharedData>();
 
 	thread_init_and_detach(CWorker::Start, new CWorker(m_pShared), "database worker thread");
 	thread_init_and_detach(CBackup::Start, new CBackup(m_pShared), "database backup worker thread");
+	m_pShared->m_NumReadWorkersRunning.store(m_NumReadWorkers);
+	for(int i = 0; i < m_NumReadWorkers; i++)
+	{
+		thread_init_and_detach(CReadWorker::Start, new CReadWorker(m_pShared, i), "database read worker thread");
+	}
 }
@@ -3,7 +3,12 @@
 
 #include <atomic>
 #include <base/tl/threading.h>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class IDbConnection;
@@ -60,7 +65,17 @@ struct CMysqlConfig
 class CDbConnectionPool
 {
 public:
-	CDbConnectionPool();
+	enum
+	{
+		// Read queries are executed in parallel by this many threads, each
+		// with their own connections to the read databases.
+		DEFAULT_READ_WORKERS = 4,
+		// Consecutive batchable writes of the same kind are executed in one
+		// transaction, up to this many at once.
+		MAX_WRITE_BATCH = 32,
+	};
+
+	CDbConnectionPool(int NumReadWorkers = DEFAULT_READ_WORKERS);
 	~CDbConnectionPool();
 	CDbConnectionPool &operator=(const CDbConnectionPool &) = delete;
 
@@ -81,28 +96,98 @@ public:
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char FileName[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
 
+	// Reads run in parallel to the writes. A read concerning the given
+	// players waits until the writes concerning them that were queued
+	// before it are done.
 	void Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
-		const char *pName);
+		const char *pName,
+		const std::vector<const char *> &vpPlayers = {});
 	// writes to WRITE_BACKUP first and removes it from there when successfully
 	// executed on WRITE server
 	void ExecuteWrite(
 		FWrite pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
-		const char *pName);
+		const char *pName,
+		const std::vector<const char *> &vpPlayers = {});
+	// Like ExecuteWrite, but consecutive writes with the same function may
+	// share one transaction. If it fails, it is rolled back and the writes
+	// are executed again one by one, so `pFunc` must not leave anything in
+	// the result that a repeated execution doesn't overwrite.
+	void ExecuteBatchableWrite(
+		FWrite pFunc,
+		std::unique_ptr<const ISqlData> pSqlRequestData,
+		const char *pName,
+		const std::vector<const char *> &vpPlayers = {});
 
 	void OnShutdown();
 
+	enum
+	{
+		PERCENTILE_50,
+		PERCENTILE_90,
+		PERCENTILE_99,
+		PERCENTILE_MAX,
+		NUM_PERCENTILES,
+	};
+
+	struct CStats
+	{
+		int m_ReadQueueDepth;
+		int m_WriteQueueDepth;
+		int64_t m_NumReads;
+		int64_t m_NumWrites;
+		// number of transactions that grouped more than one write
+		int64_t m_NumWriteBatches;
+		int64_t m_NumBatchedWrites;
+		// time from queuing to completion in milliseconds, over the most
+		// recent queries
+		float m_aReadLatency[NUM_PERCENTILES];
+		float m_aWriteLatency[NUM_PERCENTILES];
+	};
+	void GetStats(CStats *pStats);
+	void PrintStats(IConsole *pConsole);
+
 	friend class CWorker;
 	friend class CBackup;
+	friend class CReadWorker;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
+	static bool ExecSqlBatch(IDbConnection *pConnection, std::vector<std::unique_ptr<struct CSqlExecData>> &vpBatch);
+
+	void AddQuery(std::unique_ptr<struct CSqlExecData> pQuery);
+	void AddWrite(
+		FWrite pFunc,
+		std::unique_ptr<const ISqlData> pSqlRequestData,
+		const char *pName,
+		const std::vector<const char *> &vpPlayers,
+		bool Batchable);
 
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
 	int m_InsertIdx = 0;
+	int64_t m_NumQueued = 0;
+	int m_NumReadWorkers;
+	// Only the main thread accesses this map. It holds the value of
+	// `m_NumQueued` after the last write of each player, reads of the
+	// player wait until `m_NumDone` reached it.
+	std::unordered_map<std::string, int64_t> m_PlayerWrites;
+
+	struct CLatencies
+	{
+		enum
+		{
+			NUM_SAMPLES = 1024,
+		};
+		int64_t m_aSamples[NUM_SAMPLES];
+		int m_NumSamples = 0;
+		int m_Next = 0;
+
+		void Add(int64_t Latency);
+		void Percentiles(float *pPercentiles);
+	};
 
 	struct CSharedData
 	{
@@ -120,7 +205,34 @@ private:
 		CSemaphore m_NumWorker;
 
 		// spsc queue with additional backup worker to look at queries first.
+		// Contains all queries except reads.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+		// Number of queries in `m_aQueries` the worker thread completed.
+		std::atomic<int64_t> m_NumDone{0};
+		// Signals read workers waiting for a write about `m_NumDone`
+		// growing or the shutdown.
+		std::mutex m_DoneMutex;
+		std::condition_variable m_DoneCond;
+
+		// mpmc queue for the read workers. The read databases are
+		// registered here as well, every read worker copies them to get
+		// its own connections.
+		std::mutex m_ReadMutex;
+		CSemaphore m_NumRead;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_vpReadQueue;
+		std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+		std::atomic_int m_NumReadWorkersRunning{0};
+
+		std::mutex m_StatsMutex;
+		CLatencies m_ReadLatencies;
+		CLatencies m_WriteLatencies;
+		int64_t m_NumReads = 0;
+		int64_t m_NumWrites = 0;
+		int64_t m_NumWriteBatches = 0;
+		int64_t m_NumBatchedWrites = 0;
+
+		void Complete(struct CSqlExecData *pData, bool Success);
+		void NotifyDone();
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
@@ -66,17 +66,22 @@ int main(int argc, const char **argv)
 	CWindowsComLifecycle WindowsComLifecycle(false);
 #endif
 
-	std::vector<std::shared_ptr<ILogger>> vpLoggers;
+	// stdout and the log file are written from a background thread, the
+	// console logger sends to the rcon and econ clients from the main thread
+	std::vector<std::shared_ptr<ILogger>> vpAsyncLoggers;
 #if defined(CONF_PLATFORM_ANDROID)
-	vpLoggers.push_back(std::shared_ptr<ILogger>(log_logger_android()));
+	vpAsyncLoggers.push_back(std::shared_ptr<ILogger>(log_logger_android()));
 #else
 	if(!Silent)
 	{
-		vpLoggers.push_back(std::shared_ptr<ILogger>(log_logger_stdout()));
+		vpAsyncLoggers.push_back(std::shared_ptr<ILogger>(log_logger_stdout()));
 	}
 #endif
 	std::shared_ptr<CFutureLogger> pFutureFileLogger = std::make_shared<CFutureLogger>();
-	vpLoggers.push_back(pFutureFileLogger);
+	vpAsyncLoggers.push_back(pFutureFileLogger);
+
+	std::vector<std::shared_ptr<ILogger>> vpLoggers;
+	vpLoggers.push_back(std::shared_ptr<ILogger>(log_logger_async(std::move(vpAsyncLoggers))));
 	std::shared_ptr<CFutureLogger> pFutureConsoleLogger = std::make_shared<CFutureLogger>();
 	vpLoggers.push_back(pFutureConsoleLogger);
 	std::shared_ptr<CFutureLogger> pFutureAssertionLogger = std::make_shared<CFutureLogger>();
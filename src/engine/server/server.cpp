@@ -3,6 +3,7 @@
 
 #include "server.h"
 
+#include <base/log.h>
 #include <base/logger.h>
 #include <base/math.h>
 #include <base/system.h>
@@ -201,9 +202,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 
 		if(NetMatch(&Data, Server()->m_NetServer.ClientAddr(i)))
 		{
-			CNetHash NetHash(&Data);
 			char aBuf[256];
-			MakeBanInfo(pBanPool->Find(&Data, &NetHash), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
+			MakeBanInfo(pBanPool->Find(&Data), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
 			Server()->m_NetServer.Drop(i, aBuf);
 		}
 	}
@@ -346,6 +346,10 @@ CServer::CServer()
 
 	m_aErrorShutdownReason[0] = 0;
 
+	m_NextMetricsWrite = 0;
+	m_LastSlowTickLog = 0;
+	m_NumSlowTicksNotLogged = 0;
+
 	Init();
 }
 
@@ -883,6 +887,7 @@ void CServer::SendMsgRaw(int ClientID, const void *pData, int Size, int Flags)
 
 void CServer::DoSnapshot()
 {
+	CTickTimings::CScope Scope(&m_TickTimings, CTickTimings::PHASE_SNAPSHOT);
 	GameServer()->OnPreSnap();
 
 	// create snapshot for demo recording
@@ -1789,13 +1794,15 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 bool CServer::RateLimitServerInfoConnless()
 {
+	std::lock_guard<std::mutex> Lock(m_ServerInfoMutex);
 	bool SendClients = true;
 	if(Config()->m_SvServerInfoPerSecond)
 	{
 		SendClients = m_ServerInfoNumRequests <= Config()->m_SvServerInfoPerSecond;
-		const int64_t Now = Tick();
+		// not using the game tick, this is also called on the network thread
+		const int64_t Now = time_get();
 
-		if(Now <= m_ServerInfoFirstRequest + TickSpeed())
+		if(Now <= m_ServerInfoFirstRequest + time_freq())
 		{
 			m_ServerInfoNumRequests++;
 		}
@@ -1811,7 +1818,9 @@ bool CServer::RateLimitServerInfoConnless()
 
 void CServer::SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type)
 {
-	SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
+	const int64_t Start = time_get();
+	int Bytes = SendServerInfo(pAddr, Token, Type, RateLimitServerInfoConnless());
+	CountServerInfoRequest(Type, Bytes, Start);
 }
 
 static inline int GetCacheIndex(int Type, bool SendClient)
@@ -1849,6 +1858,29 @@ void CServer::CCache::Clear()
 	m_Cache.clear();
 }
 
+void CServer::CCache::PrepareDatagrams(int Type)
+{
+	for(auto &Chunk : m_Cache)
+	{
+		const unsigned char *pMagic;
+		if(Type == SERVERINFO_EXTENDED)
+			pMagic = &Chunk == &m_Cache.front() ? SERVERBROWSE_INFO_EXTENDED : SERVERBROWSE_INFO_EXTENDED_MORE;
+		else if(Type == SERVERINFO_64_LEGACY)
+			pMagic = SERVERBROWSE_INFO_64_LEGACY;
+		else
+		{
+			dbg_assert(Type == SERVERINFO_VANILLA, "unknown serverinfo type");
+			pMagic = SERVERBROWSE_INFO;
+		}
+
+		// connless packet header, see `CNetBase::SendPacketConnless`
+		Chunk.m_vDatagram.assign(6, 0xff);
+		Chunk.m_vDatagram.insert(Chunk.m_vDatagram.end(), pMagic, pMagic + SERVERBROWSE_SIZE);
+		Chunk.m_TokenOffset = Chunk.m_vDatagram.size();
+		Chunk.m_vDatagram.insert(Chunk.m_vDatagram.end(), Chunk.m_vData.begin(), Chunk.m_vData.end());
+	}
+}
+
 void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 {
 	pCache->Clear();
@@ -2040,6 +2072,7 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 	}
 
 	SAVE(q.Size());
+	pCache->PrepareDatagrams(Type);
 #undef SAVE
 #undef RESET
 #undef ADD_RAW
@@ -2108,58 +2141,62 @@ void CServer::CacheServerInfoSixup(CCache *pCache, bool SendClients)
 	pCache->AddChunk(Packer.Data(), Packer.Size());
 }
 
-void CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
+int CServer::SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients)
 {
-	CPacker p;
-	char aBuf[128];
-	p.Reset();
+	const CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
 
-	CCache *pCache = &m_aServerInfoCache[GetCacheIndex(Type, SendClients)];
-
-#define ADD_RAW(p, x) (p).AddRaw(x, sizeof(x))
-#define ADD_INT(p, x) \
-	do \
-	{ \
-		str_format(aBuf, sizeof(aBuf), "%d", x); \
-		(p).AddString(aBuf, 0); \
-	} while(0)
-
-	CNetChunk Packet;
-	Packet.m_ClientID = -1;
-	Packet.m_Address = *pAddr;
-	Packet.m_Flags = NETSENDFLAG_CONNLESS;
+	char aToken[16];
+	const int TokenSize = str_format(aToken, sizeof(aToken), "%d", Token) + 1;
 
+	int Bytes = 0;
+	unsigned char aBuffer[NET_MAX_PACKETSIZE];
 	for(const auto &Chunk : pCache->m_Cache)
 	{
-		p.Reset();
-		if(Type == SERVERINFO_EXTENDED)
-		{
-			if(&Chunk == &pCache->m_Cache.front())
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED, sizeof(SERVERBROWSE_INFO_EXTENDED));
-			else
-				p.AddRaw(SERVERBROWSE_INFO_EXTENDED_MORE, sizeof(SERVERBROWSE_INFO_EXTENDED_MORE));
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_64_LEGACY)
+		const int Size = Chunk.m_vDatagram.size() + TokenSize;
+		if(Size >= NET_MAX_PACKETSIZE)
 		{
-			ADD_RAW(p, SERVERBROWSE_INFO_64_LEGACY);
-			ADD_INT(p, Token);
-		}
-		else if(Type == SERVERINFO_VANILLA || Type == SERVERINFO_INGAME)
-		{
-			ADD_RAW(p, SERVERBROWSE_INFO);
-			ADD_INT(p, Token);
-		}
-		else
-		{
-			dbg_assert(false, "unknown serverinfo type");
+			dbg_msg("server", "server info too big. %d. dropping packet", Size);
+			continue;
 		}
-
-		p.AddRaw(Chunk.m_vData.data(), Chunk.m_vData.size());
-		Packet.m_pData = p.Data();
-		Packet.m_DataSize = p.Size();
-		m_NetServer.Send(&Packet);
+		mem_copy(aBuffer, Chunk.m_vDatagram.data(), Chunk.m_TokenOffset);
+		mem_copy(aBuffer + Chunk.m_TokenOffset, aToken, TokenSize);
+		mem_copy(aBuffer + Chunk.m_TokenOffset + TokenSize, Chunk.m_vDatagram.data() + Chunk.m_TokenOffset, Chunk.m_vDatagram.size() - Chunk.m_TokenOffset);
+		net_udp_send(m_NetServer.Socket(), pAddr, aBuffer, Size);
+		Bytes += Size;
 	}
+	return Bytes;
+}
+
+int CServer::SendServerInfoSixupConnless(const NETADDR *pAddr, SECURITY_TOKEN ResponseToken, int Token, bool SendClients)
+{
+	SendClients = SendClients && Token != -1;
+	const CCache::CCacheChunk &Chunk = m_aSixupServerInfoCache[SendClients].m_Cache.front();
+
+	unsigned char aBuffer[NET_MAX_PACKETSIZE];
+	mem_copy(aBuffer, SERVERBROWSE_INFO, sizeof(SERVERBROWSE_INFO));
+	unsigned char *pData = CVariableInt::Pack(aBuffer + sizeof(SERVERBROWSE_INFO), Token, sizeof(aBuffer) - sizeof(SERVERBROWSE_INFO));
+	if(!pData)
+		return 0;
+	const int Size = pData - aBuffer + Chunk.m_vData.size();
+	if(Size > NET_MAX_PACKETSIZE - 9)
+		return 0;
+	mem_copy(pData, Chunk.m_vData.data(), Chunk.m_vData.size());
+
+	CNetChunk Response;
+	Response.m_ClientID = -1;
+	Response.m_Address = *pAddr;
+	Response.m_Flags = NETSENDFLAG_CONNLESS;
+	Response.m_pData = aBuffer;
+	Response.m_DataSize = Size;
+	m_NetServer.SendConnlessSixup(&Response, ResponseToken);
+	return Size + 9;
+}
+
+void CServer::CountServerInfoRequest(int Stat, int Bytes, int64_t Start)
+{
+	m_aServerInfoStats[Stat].m_Requests++;
+	m_aServerInfoStats[Stat].m_Bytes += Bytes;
+	m_aServerInfoStats[Stat].m_Time += time_get() - Start;
 }
 
 void CServer::GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients)
@@ -2286,9 +2323,12 @@ void CServer::UpdateServerInfo(bool Resend)
 
 	UpdateRegisterServerInfo();
 
-	for(int i = 0; i < 3; i++)
-		for(int j = 0; j < 2; j++)
-			CacheServerInfo(&m_aServerInfoCache[i * 2 + j], i, j);
+	{
+		std::lock_guard<std::mutex> Lock(m_ServerInfoMutex);
+		for(int i = 0; i < 3; i++)
+			for(int j = 0; j < 2; j++)
+				CacheServerInfo(&m_aServerInfoCache[i * 2 + j], i, j);
+	}
 
 	for(int i = 0; i < 2; i++)
 		CacheServerInfoSixup(&m_aSixupServerInfoCache[i], i);
@@ -2314,8 +2354,60 @@ void CServer::UpdateServerInfo(bool Resend)
 	m_ServerInfoNeedsUpdate = false;
 }
 
+// Returns -1 if the packet isn't a server info request.
+static int ServerInfoRequestType(const CNetChunk *pPacket, int *pToken)
+{
+	int ExtraToken = 0;
+	int Type = -1;
+	if(pPacket->m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO) + 1 &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
+	{
+		if(pPacket->m_Flags & NETSENDFLAG_EXTENDED)
+		{
+			Type = SERVERINFO_EXTENDED;
+			ExtraToken = (pPacket->m_aExtraData[0] << 8) | pPacket->m_aExtraData[1];
+		}
+		else
+			Type = SERVERINFO_VANILLA;
+	}
+	else if(pPacket->m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO_64_LEGACY) + 1 &&
+		mem_comp(pPacket->m_pData, SERVERBROWSE_GETINFO_64_LEGACY, sizeof(SERVERBROWSE_GETINFO_64_LEGACY)) == 0)
+	{
+		Type = SERVERINFO_64_LEGACY;
+	}
+	if(Type != -1)
+	{
+		*pToken = ((const unsigned char *)pPacket->m_pData)[sizeof(SERVERBROWSE_GETINFO)];
+		*pToken |= ExtraToken << 8;
+	}
+	return Type;
+}
+
+bool CServer::ConnlessCallback(const CNetChunk *pPacket, SECURITY_TOKEN ResponseToken, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+
+	// 0.7 requests are answered by the main thread, they need the sixup
+	// server info
+	int Token;
+	int Type = ServerInfoRequestType(pPacket, &Token);
+	if(Type == -1 || (Type == SERVERINFO_VANILLA && ResponseToken != NET_SECURITY_TOKEN_UNKNOWN && pThis->Config()->m_SvSixup))
+		return false;
+
+	const int64_t Start = time_get();
+	bool SendClients = pThis->RateLimitServerInfoConnless();
+	int Bytes;
+	{
+		std::lock_guard<std::mutex> Lock(pThis->m_ServerInfoMutex);
+		Bytes = pThis->SendServerInfo(&pPacket->m_Address, Token, Type, SendClients);
+	}
+	pThis->CountServerInfoRequest(Type, Bytes, Start);
+	return true;
+}
+
 void CServer::PumpNetwork(bool PacketWaiting)
 {
+	CTickTimings::CScope Scope(&m_TickTimings, CTickTimings::PHASE_NETWORK);
 	CNetChunk Packet;
 	SECURITY_TOKEN ResponseToken;
 
@@ -2332,48 +2424,22 @@ void CServer::PumpNetwork(bool PacketWaiting)
 					continue;
 
 				{
-					int ExtraToken = 0;
-					int Type = -1;
-					if(Packet.m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO) + 1 &&
-						mem_comp(Packet.m_pData, SERVERBROWSE_GETINFO, sizeof(SERVERBROWSE_GETINFO)) == 0)
-					{
-						if(Packet.m_Flags & NETSENDFLAG_EXTENDED)
-						{
-							Type = SERVERINFO_EXTENDED;
-							ExtraToken = (Packet.m_aExtraData[0] << 8) | Packet.m_aExtraData[1];
-						}
-						else
-							Type = SERVERINFO_VANILLA;
-					}
-					else if(Packet.m_DataSize >= (int)sizeof(SERVERBROWSE_GETINFO_64_LEGACY) + 1 &&
-						mem_comp(Packet.m_pData, SERVERBROWSE_GETINFO_64_LEGACY, sizeof(SERVERBROWSE_GETINFO_64_LEGACY)) == 0)
-					{
-						Type = SERVERINFO_64_LEGACY;
-					}
+					int Token;
+					int Type = ServerInfoRequestType(&Packet, &Token);
 					if(Type == SERVERINFO_VANILLA && ResponseToken != NET_SECURITY_TOKEN_UNKNOWN && Config()->m_SvSixup)
 					{
+						const int64_t Start = time_get();
 						CUnpacker Unpacker;
 						Unpacker.Reset((unsigned char *)Packet.m_pData + sizeof(SERVERBROWSE_GETINFO), Packet.m_DataSize - sizeof(SERVERBROWSE_GETINFO));
 						int SrvBrwsToken = Unpacker.GetInt();
 						if(Unpacker.Error())
 							continue;
 
-						CPacker Packer;
-						CNetChunk Response;
-
-						GetServerInfoSixup(&Packer, SrvBrwsToken, RateLimitServerInfoConnless());
-
-						Response.m_ClientID = -1;
-						Response.m_Address = Packet.m_Address;
-						Response.m_Flags = NETSENDFLAG_CONNLESS;
-						Response.m_pData = Packer.Data();
-						Response.m_DataSize = Packer.Size();
-						m_NetServer.SendConnlessSixup(&Response, ResponseToken);
+						int Bytes = SendServerInfoSixupConnless(&Packet.m_Address, ResponseToken, SrvBrwsToken, RateLimitServerInfoConnless());
+						CountServerInfoRequest(NUM_SERVERINFO_STATS - 1, Bytes, Start);
 					}
 					else if(Type != -1)
 					{
-						int Token = ((unsigned char *)Packet.m_pData)[sizeof(SERVERBROWSE_GETINFO)];
-						Token |= ExtraToken << 8;
 						SendServerInfoConnless(&Packet.m_Address, Token, Type);
 					}
 				}
@@ -2600,6 +2666,8 @@ int CServer::Run()
 	m_pRegister = CreateRegister(&g_Config, m_pConsole, pEngine, this->Port(), m_NetServer.GetGlobalToken());
 
 	m_NetServer.SetCallbacks(NewClientCallback, NewClientNoAuthCallback, ClientRejoinCallback, DelClientCallback, this);
+	if(Config()->m_SvNetThread && !m_NetServer.StartRecvThread(ConnlessCallback, this))
+		dbg_msg("server", "couldn't start the network thread, receiving on the main thread");
 
 	m_Econ.Init(Config(), Console(), &m_ServerBan);
 
@@ -2643,6 +2711,7 @@ int CServer::Run()
 		UpdateServerInfo();
 		while(m_RunServer < STOPPING)
 		{
+			int64_t BusyStart = CTickTimings::Now();
 			if(NonActive)
 				PumpNetwork(PacketWaiting);
 
@@ -2654,6 +2723,7 @@ int CServer::Run()
 			// load new map
 			if(m_MapReload || m_CurrentGameTick >= MAX_TICK) // force reload to make sure the ticks stay within a valid range
 			{
+				CTickTimings::CScope Scope(&m_TickTimings, CTickTimings::PHASE_MAP);
 				// load map
 				if(LoadMap(Config()->m_SvMap))
 				{
@@ -2684,7 +2754,10 @@ int CServer::Run()
 
 					m_GameStartTime = time_get();
 					m_CurrentGameTick = MIN_TICK;
-					m_ServerInfoFirstRequest = 0;
+					{
+						std::lock_guard<std::mutex> Lock(m_ServerInfoMutex);
+						m_ServerInfoFirstRequest = 0;
+					}
 					Kernel()->ReregisterInterface(GameServer());
 					GameServer()->OnInit();
 					if(ErrorShutdown())
@@ -2704,6 +2777,7 @@ int CServer::Run()
 			// handle dnsbl
 			if(Config()->m_SvDnsbl)
 			{
+				CTickTimings::CScope Scope(&m_TickTimings, CTickTimings::PHASE_DNSBL);
 				for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
 				{
 					if(m_aClients[ClientID].m_State == CClient::STATE_EMPTY)
@@ -2746,6 +2820,7 @@ int CServer::Run()
 			while(t > TickStartTime(m_CurrentGameTick + 1))
 			{
 				GameServer()->OnPreTickTeehistorian();
+				int64_t InputStart = CTickTimings::Now();
 
 				for(int c = 0; c < MAX_CLIENTS; c++)
 				{
@@ -2785,6 +2860,7 @@ int CServer::Run()
 					if(!ClientHadInput)
 						GameServer()->OnClientPredictedInput(c, nullptr);
 				}
+				m_TickTimings.Add(CTickTimings::PHASE_INPUT, CTickTimings::Now() - InputStart);
 
 				GameServer()->OnTick();
 				if(ErrorShutdown())
@@ -2805,16 +2881,24 @@ int CServer::Run()
 			}
 
 			// master server stuff
+			int64_t OtherStart = CTickTimings::Now();
 			m_pRegister->Update();
 
 			if(m_ServerInfoNeedsUpdate)
 				UpdateServerInfo();
 
 			Antibot()->OnEngineTick();
+			m_TickTimings.Add(CTickTimings::PHASE_OTHER, CTickTimings::Now() - OtherStart);
 
 			if(!NonActive)
 				PumpNetwork(PacketWaiting);
 
+			// a tick is everything since the last one, if the server was
+			// woken up by packets in between
+			m_TickTimings.Add(CTickTimings::PHASE_TICK, CTickTimings::Now() - BusyStart);
+			if(NewTicks)
+				EndTick();
+
 			NonActive = true;
 
 			for(const auto &Client : m_aClients)
@@ -2843,7 +2927,7 @@ int CServer::Run()
 				if(Config()->m_SvShutdownWhenEmpty)
 					m_RunServer = STOPPING;
 				else
-					PacketWaiting = net_socket_read_wait(m_NetServer.Socket(), 1000000);
+					PacketWaiting = m_NetServer.WaitForPackets(1000000);
 			}
 			else
 			{
@@ -2853,7 +2937,7 @@ int CServer::Run()
 				t = time_get();
 				int x = (TickStartTime(m_CurrentGameTick + 1) - t) * 1000000 / time_freq() + 1;
 
-				PacketWaiting = x > 0 ? net_socket_read_wait(m_NetServer.Socket(), x) : true;
+				PacketWaiting = x > 0 ? m_NetServer.WaitForPackets(x) : true;
 			}
 			if(IsInterrupted())
 			{
@@ -2981,6 +3065,18 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 		}
 		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
 	}
+
+	if(pResult->NumArguments() == 0)
+	{
+		static const char *s_apTypes[NUM_SERVERINFO_STATS] = {"vanilla", "64legacy", "extended", "0.7"};
+		for(int i = 0; i < NUM_SERVERINFO_STATS; i++)
+		{
+			const CServerInfoStats &Stats = pThis->m_aServerInfoStats[i];
+			str_format(aBuf, sizeof(aBuf), "serverinfo type=%s requests=%lld bytes=%lld time=%.3fms",
+				s_apTypes[i], (long long)Stats.m_Requests.load(), (long long)Stats.m_Bytes.load(), Stats.m_Time.load() * 1000.0 / time_freq());
+			pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		}
+	}
 }
 
 static int GetAuthLevel(const char *pLevel)
@@ -3449,6 +3545,78 @@ void CServer::ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData)
 	}
 }
 
+void CServer::ConSqlStats(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	pSelf->DbPool()->PrintStats(pSelf->Console());
+}
+
+void CServer::ConPerf(IConsole::IResult *pResult, void *pUserData)
+{
+	CServer *pSelf = (CServer *)pUserData;
+	const CTickTimings &Timings = pSelf->m_TickTimings;
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "%s: %lld ticks, %lld slow",
+		Timings.HaveCompleteWindow() ? "last minute" : "current minute",
+		(long long)Timings.Window(CTickTimings::PHASE_TICK).Count(), (long long)Timings.WindowSlowTicks());
+	pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "perf", aBuf);
+	for(int i = 0; i < CTickTimings::NUM_PHASES; i++)
+	{
+		const CTickTimings::CHistogram &Histogram = Timings.Window(i);
+		if(Histogram.Count() == 0)
+			continue;
+		str_format(aBuf, sizeof(aBuf), "%*s%-*s %6lld runs, p50=%.2fms p99=%.2fms max=%.2fms",
+			2 * CTickTimings::PhaseDepth(i), "", 16 - 2 * CTickTimings::PhaseDepth(i), CTickTimings::PhaseName(i),
+			(long long)Histogram.Count(), Histogram.Percentile(0.5f) / 1000000.0f,
+			Histogram.Percentile(0.99f) / 1000000.0f, Histogram.Max() / 1000000.0f);
+		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "perf", aBuf);
+	}
+}
+
+void CServer::EndTick()
+{
+	m_TickTimings.SetSlowTickBudget(Config()->m_SvSlowTick * (int64_t)1000000);
+	if(m_TickTimings.EndTick(CTickTimings::Now()))
+	{
+		// at most one line per second on an overloaded server
+		if(time_get() - m_LastSlowTickLog >= time_freq())
+		{
+			char aBreakdown[512];
+			m_TickTimings.FormatLastTick(aBreakdown, sizeof(aBreakdown));
+			if(m_NumSlowTicksNotLogged)
+				log_warn("server", "slow tick %d: %s (%d more slow ticks since the last report)", m_CurrentGameTick, aBreakdown, m_NumSlowTicksNotLogged);
+			else
+				log_warn("server", "slow tick %d: %s", m_CurrentGameTick, aBreakdown);
+			m_LastSlowTickLog = time_get();
+			m_NumSlowTicksNotLogged = 0;
+		}
+		else
+			m_NumSlowTicksNotLogged++;
+	}
+
+	if(Config()->m_SvMetricsFile[0] && time_get() >= m_NextMetricsWrite)
+	{
+		WriteMetrics();
+		m_NextMetricsWrite = time_get() + Config()->m_SvMetricsInterval * time_freq();
+	}
+}
+
+void CServer::WriteMetrics()
+{
+	// write to a temporary file first so scrapers never see a partial one
+	char aTmpFile[IO_MAX_PATH_LENGTH];
+	str_format(aTmpFile, sizeof(aTmpFile), "%s.tmp", Config()->m_SvMetricsFile);
+	IOHANDLE File = Storage()->OpenFile(aTmpFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		log_error("server", "failed to open metrics file '%s'", aTmpFile);
+		return;
+	}
+	m_TickTimings.WriteMetrics(File);
+	io_close(File);
+	Storage()->RenameFile(aTmpFile, Config()->m_SvMetricsFile, IStorage::TYPE_SAVE);
+}
+
 void CServer::ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	pfnCallback(pResult, pCallbackUserData);
@@ -3671,6 +3839,8 @@ void CServer::RegisterCommands()
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
+	Console()->Register("sql_stats", "", CFGFLAG_SERVER, ConSqlStats, this, "shows the sql queue depths and query latencies");
+	Console()->Register("perf", "", CFGFLAG_SERVER, ConPerf, this, "Show the time of the tick phases over the last minute");
 
 	Console()->Register("auth_add", "s[ident] s[level] r[pw]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAdd, this, "Add a rcon key");
 	Console()->Register("auth_add_p", "s[ident] s[level] s[hash] s[salt]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAuthAddHashed, this, "Add a prehashed rcon key");
@@ -11,14 +11,18 @@
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
+#include <engine/shared/masterserver.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/ticktimings.h>
 #include <engine/shared/uuid_manager.h>
 
+#include <atomic>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "antibot.h"
@@ -261,11 +265,36 @@ public:
 	CDemoRecorder m_aDemoRecorder[MAX_CLIENTS + 1];
 	CAuthManager m_AuthManager;
 
+	// protects the server info rate limit and the non-sixup server info
+	// caches, which are also used by the network thread
+	std::mutex m_ServerInfoMutex;
 	int64_t m_ServerInfoFirstRequest;
 	int m_ServerInfoNumRequests;
 
+	// answered server info requests by type, the last one is 0.7, shown
+	// in `status`
+	enum
+	{
+		NUM_SERVERINFO_STATS = SERVERINFO_EXTENDED + 2,
+	};
+	struct CServerInfoStats
+	{
+		std::atomic<int64_t> m_Requests{0};
+		std::atomic<int64_t> m_Bytes{0};
+		std::atomic<int64_t> m_Time{0};
+	};
+	CServerInfoStats m_aServerInfoStats[NUM_SERVERINFO_STATS];
+	void CountServerInfoRequest(int Stat, int Bytes, int64_t Start);
+
 	char m_aErrorShutdownReason[128];
 
+	CTickTimings m_TickTimings;
+	int64_t m_NextMetricsWrite;
+	int64_t m_LastSlowTickLog;
+	int m_NumSlowTicksNotLogged;
+	void EndTick();
+	void WriteMetrics();
+
 	std::vector<CNameBan> m_vNameBans;
 
 	size_t m_AnnouncementLastLine;
@@ -324,6 +353,7 @@ public:
 	static int DelClientCallback(int ClientID, const char *pReason, void *pUser);
 
 	static int ClientRejoinCallback(int ClientID, void *pUser);
+	static bool ConnlessCallback(const CNetChunk *pPacket, SECURITY_TOKEN ResponseToken, void *pUser);
 
 	void SendRconType(int ClientID, bool UsernameReq);
 	void SendCapabilities(int ClientID);
@@ -350,6 +380,10 @@ public:
 			CCacheChunk(const CCacheChunk &) = delete;
 
 			std::vector<uint8_t> m_vData;
+			// the whole connless reply, except for the token of the
+			// request which goes at `m_TokenOffset`
+			std::vector<uint8_t> m_vDatagram;
+			int m_TokenOffset;
 		};
 
 		std::list<CCacheChunk> m_Cache;
@@ -359,6 +393,7 @@ public:
 
 		void AddChunk(const void *pData, int Size);
 		void Clear();
+		void PrepareDatagrams(int Type);
 	};
 	CCache m_aServerInfoCache[3 * 2];
 	CCache m_aSixupServerInfoCache[2];
@@ -369,7 +404,8 @@ public:
 	void ExpireServerInfo() override;
 	void CacheServerInfo(CCache *pCache, int Type, bool SendClients);
 	void CacheServerInfoSixup(CCache *pCache, bool SendClients);
-	void SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
+	int SendServerInfo(const NETADDR *pAddr, int Token, int Type, bool SendClients);
+	int SendServerInfoSixupConnless(const NETADDR *pAddr, SECURITY_TOKEN ResponseToken, int Token, bool SendClients);
 	void GetServerInfoSixup(CPacker *pPacker, int Token, bool SendClients);
 	bool RateLimitServerInfoConnless();
 	void SendServerInfoConnless(const NETADDR *pAddr, int Token, int Type);
@@ -414,6 +450,8 @@ public:
 	// console commands for sqlmasters
 	static void ConAddSqlServer(IConsole::IResult *pResult, void *pUserData);
 	static void ConDumpSqlServers(IConsole::IResult *pResult, void *pUserData);
+	static void ConSqlStats(IConsole::IResult *pResult, void *pUserData);
+	static void ConPerf(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConchainLoglevel(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -478,6 +516,8 @@ public:
 
 	bool IsSixup(int ClientID) const override { return ClientID != SERVER_DEMO_CLIENT && m_aClients[ClientID].m_Sixup; }
 
+	CTickTimings *TickTimings() override { return &m_TickTimings; }
+
 #ifdef CONF_FAMILY_UNIX
 	enum CONN_LOGGING_CMD
 	{
@@ -0,0 +1,417 @@
+#include "blockfile.h"
+
+#include <base/lock_scope.h>
+#include <base/math.h>
+
+#include <zlib.h>
+
+static const char BLOCKFILE_MAGIC[8] = {'T', 'W', 'B', 'L', 'K', 'S', '0', '1'};
+static const char BLOCKFILE_INDEX_MAGIC[8] = {'T', 'W', 'B', 'L', 'K', 'I', 'D', 'X'};
+static const char BLOCKFILE_END_MAGIC[8] = {'T', 'W', 'B', 'L', 'K', 'E', 'N', 'D'};
+
+enum
+{
+	BLOCK_HEADER_SIZE = 16,
+	TRAILER_SIZE = 16,
+	INDEX_ENTRY_SIZE = 12,
+
+	// Upper bound for the uncompressed size of a block, larger sizes are
+	// treated as a corrupt header instead of being allocated. Twice the
+	// maximum of sv_tee_historian_block_size, blocks overshoot it a bit.
+	MAX_BLOCK_SIZE = 128 * 1024 * 1024,
+};
+
+CBlockFileWriter::CBlockFileWriter() :
+	m_File(0),
+	m_pThread(nullptr),
+	m_Key(0),
+	m_Closing(false),
+	m_Error(0),
+	m_Offset(0)
+{
+	m_Lock = lock_create();
+	sphore_init(&m_Semaphore);
+}
+
+CBlockFileWriter::~CBlockFileWriter()
+{
+	dbg_assert(m_pThread == nullptr, "block file writer must be closed before destruction");
+	sphore_destroy(&m_Semaphore);
+	lock_destroy(m_Lock);
+}
+
+void CBlockFileWriter::Open(IOHANDLE File)
+{
+	dbg_assert(m_pThread == nullptr, "block file writer already open");
+	m_File = File;
+	m_Key = 0;
+	m_vKeyframe.clear();
+	m_vData.clear();
+	m_Closing = false;
+	m_Error = 0;
+	m_Offset = 0;
+	m_vIndexKeys.clear();
+	m_vIndexOffsets.clear();
+	m_pThread = thread_init(ThreadFunc, this, "blockfile");
+}
+
+void CBlockFileWriter::Write(const void *pData, int DataSize)
+{
+	const unsigned char *pBytes = (const unsigned char *)pData;
+	m_vData.insert(m_vData.end(), pBytes, pBytes + DataSize);
+}
+
+void CBlockFileWriter::QueueCurrentBlock()
+{
+	CBlock Block;
+	Block.m_Key = m_Key;
+	std::swap(Block.m_vKeyframe, m_vKeyframe);
+	std::swap(Block.m_vData, m_vData);
+	{
+		CLockScope ls(m_Lock);
+		m_vQueue.push_back(std::move(Block));
+	}
+	sphore_signal(&m_Semaphore);
+	m_vKeyframe.clear();
+	m_vData.clear();
+}
+
+void CBlockFileWriter::BeginBlock(int Key, const void *pKeyframe, int KeyframeSize)
+{
+	QueueCurrentBlock();
+	m_Key = Key;
+	const unsigned char *pBytes = (const unsigned char *)pKeyframe;
+	m_vKeyframe.assign(pBytes, pBytes + KeyframeSize);
+}
+
+int CBlockFileWriter::Close()
+{
+	dbg_assert(m_pThread != nullptr, "block file writer not open");
+	QueueCurrentBlock();
+	{
+		CLockScope ls(m_Lock);
+		m_Closing = true;
+	}
+	sphore_signal(&m_Semaphore);
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+	return Error();
+}
+
+int CBlockFileWriter::Error()
+{
+	CLockScope ls(m_Lock);
+	return m_Error;
+}
+
+void CBlockFileWriter::ThreadFunc(void *pUser)
+{
+	((CBlockFileWriter *)pUser)->Run();
+}
+
+void CBlockFileWriter::Run()
+{
+	std::vector<CBlock> vBlocks;
+	while(true)
+	{
+		sphore_wait(&m_Semaphore);
+		bool Closing;
+		{
+			CLockScope ls(m_Lock);
+			std::swap(vBlocks, m_vQueue);
+			Closing = m_Closing;
+		}
+		for(const CBlock &Block : vBlocks)
+		{
+			WriteBlock(Block);
+		}
+		vBlocks.clear();
+		if(Closing)
+		{
+			// Blocks queued before closing are guaranteed to be in
+			// `vBlocks` as both happen under the same lock.
+			WriteIndex();
+			int Error = io_error(m_File);
+			if(io_close(m_File) != 0)
+			{
+				Error = 1;
+			}
+			m_File = 0;
+			if(Error)
+			{
+				CLockScope ls(m_Lock);
+				m_Error = Error;
+			}
+			break;
+		}
+	}
+}
+
+void CBlockFileWriter::WriteBlock(const CBlock &Block)
+{
+	if(m_Offset == 0)
+	{
+		io_write(m_File, BLOCKFILE_MAGIC, sizeof(BLOCKFILE_MAGIC));
+		m_Offset += sizeof(BLOCKFILE_MAGIC);
+	}
+
+	// Compress keyframe and data as one zlib stream.
+	const unsigned UncompressedSize = Block.m_vKeyframe.size() + Block.m_vData.size();
+	m_vCompressed.resize(BLOCK_HEADER_SIZE + compressBound(UncompressedSize));
+	z_stream Stream;
+	mem_zero(&Stream, sizeof(Stream));
+	int Result = deflateInit(&Stream, Z_DEFAULT_COMPRESSION);
+	Stream.next_out = m_vCompressed.data() + BLOCK_HEADER_SIZE;
+	Stream.avail_out = m_vCompressed.size() - BLOCK_HEADER_SIZE;
+	if(Result == Z_OK)
+	{
+		Stream.next_in = (Bytef *)Block.m_vKeyframe.data();
+		Stream.avail_in = Block.m_vKeyframe.size();
+		Result = deflate(&Stream, Z_NO_FLUSH);
+	}
+	if(Result == Z_OK)
+	{
+		Stream.next_in = (Bytef *)Block.m_vData.data();
+		Stream.avail_in = Block.m_vData.size();
+		Result = deflate(&Stream, Z_FINISH);
+	}
+	const unsigned CompressedSize = Stream.total_out;
+	deflateEnd(&Stream);
+	if(Result != Z_STREAM_END)
+	{
+		dbg_msg("blockfile", "compression failed, err=%d", Result);
+		CLockScope ls(m_Lock);
+		m_Error = 1;
+		return;
+	}
+
+	unsigned char *pHeader = m_vCompressed.data();
+	uint_to_bytes_be(pHeader + 0, Block.m_Key);
+	uint_to_bytes_be(pHeader + 4, Block.m_vKeyframe.size());
+	uint_to_bytes_be(pHeader + 8, Block.m_vData.size());
+	uint_to_bytes_be(pHeader + 12, CompressedSize);
+	io_write(m_File, m_vCompressed.data(), BLOCK_HEADER_SIZE + CompressedSize);
+	io_flush(m_File);
+
+	m_vIndexKeys.push_back(Block.m_Key);
+	m_vIndexOffsets.push_back(m_Offset);
+	m_Offset += BLOCK_HEADER_SIZE + CompressedSize;
+}
+
+void CBlockFileWriter::WriteIndex()
+{
+	const uint64_t IndexOffset = m_Offset;
+	unsigned char aBuf[INDEX_ENTRY_SIZE];
+	io_write(m_File, BLOCKFILE_INDEX_MAGIC, sizeof(BLOCKFILE_INDEX_MAGIC));
+	uint_to_bytes_be(aBuf, m_vIndexKeys.size());
+	io_write(m_File, aBuf, 4);
+	for(size_t i = 0; i < m_vIndexKeys.size(); i++)
+	{
+		uint_to_bytes_be(aBuf + 0, m_vIndexKeys[i]);
+		uint_to_bytes_be(aBuf + 4, m_vIndexOffsets[i] >> 32);
+		uint_to_bytes_be(aBuf + 8, m_vIndexOffsets[i] & 0xffffffff);
+		io_write(m_File, aBuf, INDEX_ENTRY_SIZE);
+	}
+	uint_to_bytes_be(aBuf + 0, IndexOffset >> 32);
+	uint_to_bytes_be(aBuf + 4, IndexOffset & 0xffffffff);
+	io_write(m_File, aBuf, 8);
+	io_write(m_File, BLOCKFILE_END_MAGIC, sizeof(BLOCKFILE_END_MAGIC));
+	io_flush(m_File);
+}
+
+CBlockFileReader::CBlockFileReader() :
+	m_File(0),
+	m_BlocksEnd(0)
+{
+}
+
+CBlockFileReader::~CBlockFileReader()
+{
+	Close();
+}
+
+bool CBlockFileReader::IsBlockFile(const void *pData, int DataSize)
+{
+	return DataSize >= (int)sizeof(BLOCKFILE_MAGIC) && mem_comp(pData, BLOCKFILE_MAGIC, sizeof(BLOCKFILE_MAGIC)) == 0;
+}
+
+bool CBlockFileReader::Open(IOHANDLE File)
+{
+	Close();
+	m_File = File;
+	char aMagic[sizeof(BLOCKFILE_MAGIC)];
+	if(io_read(m_File, aMagic, sizeof(aMagic)) != sizeof(aMagic) || !IsBlockFile(aMagic, sizeof(aMagic)))
+	{
+		Close();
+		return true;
+	}
+	if(ReadIndex() && ScanBlocks())
+	{
+		Close();
+		return true;
+	}
+	return false;
+}
+
+void CBlockFileReader::Close()
+{
+	if(m_File)
+	{
+		io_close(m_File);
+		m_File = 0;
+	}
+	m_vKeys.clear();
+	m_vOffsets.clear();
+	m_BlocksEnd = 0;
+}
+
+bool CBlockFileReader::ReadIndex()
+{
+	m_vKeys.clear();
+	m_vOffsets.clear();
+
+	const long int Length = io_length(m_File);
+	unsigned char aTrailer[TRAILER_SIZE];
+	if(Length < (long int)(sizeof(BLOCKFILE_MAGIC) + TRAILER_SIZE) ||
+		io_seek(m_File, Length - TRAILER_SIZE, IOSEEK_START) != 0 ||
+		io_read(m_File, aTrailer, sizeof(aTrailer)) != sizeof(aTrailer) ||
+		mem_comp(aTrailer + 8, BLOCKFILE_END_MAGIC, sizeof(BLOCKFILE_END_MAGIC)) != 0)
+	{
+		return true;
+	}
+	const uint64_t IndexOffset = ((uint64_t)bytes_be_to_uint(aTrailer) << 32) | bytes_be_to_uint(aTrailer + 4);
+	unsigned char aHeader[sizeof(BLOCKFILE_INDEX_MAGIC) + 4];
+	if(IndexOffset >= (uint64_t)Length ||
+		io_seek(m_File, IndexOffset, IOSEEK_START) != 0 ||
+		io_read(m_File, aHeader, sizeof(aHeader)) != sizeof(aHeader) ||
+		mem_comp(aHeader, BLOCKFILE_INDEX_MAGIC, sizeof(BLOCKFILE_INDEX_MAGIC)) != 0)
+	{
+		return true;
+	}
+	const unsigned NumBlocks = bytes_be_to_uint(aHeader + sizeof(BLOCKFILE_INDEX_MAGIC));
+	if(NumBlocks > (Length - IndexOffset) / INDEX_ENTRY_SIZE)
+	{
+		return true;
+	}
+	for(unsigned i = 0; i < NumBlocks; i++)
+	{
+		unsigned char aEntry[INDEX_ENTRY_SIZE];
+		if(io_read(m_File, aEntry, sizeof(aEntry)) != sizeof(aEntry))
+		{
+			return true;
+		}
+		m_vKeys.push_back(bytes_be_to_uint(aEntry));
+		m_vOffsets.push_back(((uint64_t)bytes_be_to_uint(aEntry + 4) << 32) | bytes_be_to_uint(aEntry + 8));
+	}
+	m_BlocksEnd = IndexOffset;
+	return false;
+}
+
+bool CBlockFileReader::ScanBlocks()
+{
+	m_vKeys.clear();
+	m_vOffsets.clear();
+
+	const long int Length = io_length(m_File);
+	uint64_t Offset = sizeof(BLOCKFILE_MAGIC);
+	if(Length < 0 || io_seek(m_File, Offset, IOSEEK_START) != 0)
+	{
+		return true;
+	}
+	while(true)
+	{
+		unsigned char aHeader[BLOCK_HEADER_SIZE];
+		if(io_read(m_File, aHeader, sizeof(aHeader)) != sizeof(aHeader) ||
+			mem_comp(aHeader, BLOCKFILE_INDEX_MAGIC, sizeof(BLOCKFILE_INDEX_MAGIC)) == 0)
+		{
+			// End of file, or the index that failed to be read.
+			break;
+		}
+		const unsigned CompressedSize = bytes_be_to_uint(aHeader + 12);
+		if(Offset + BLOCK_HEADER_SIZE + CompressedSize > (uint64_t)Length ||
+			io_seek(m_File, CompressedSize, IOSEEK_CUR) != 0)
+		{
+			// Truncated or corrupt block, the blocks before it are fine.
+			break;
+		}
+		m_vKeys.push_back(bytes_be_to_uint(aHeader));
+		m_vOffsets.push_back(Offset);
+		Offset += BLOCK_HEADER_SIZE + CompressedSize;
+	}
+	m_BlocksEnd = Offset;
+	return m_vKeys.empty();
+}
+
+int CBlockFileReader::FindBlock(int Key) const
+{
+	int Result = -1;
+	int Low = 0;
+	int High = NumBlocks() - 1;
+	while(Low <= High)
+	{
+		int Middle = Low + (High - Low) / 2;
+		if(m_vKeys[Middle] <= Key)
+		{
+			Result = Middle;
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle - 1;
+		}
+	}
+	return Result;
+}
+
+bool CBlockFileReader::ReadBlock(int Index, std::vector<unsigned char> *pvKeyframe, std::vector<unsigned char> *pvData)
+{
+	dbg_assert(0 <= Index && Index < NumBlocks(), "block index out of range");
+	unsigned char aHeader[BLOCK_HEADER_SIZE];
+	if(io_seek(m_File, m_vOffsets[Index], IOSEEK_START) != 0 ||
+		io_read(m_File, aHeader, sizeof(aHeader)) != sizeof(aHeader))
+	{
+		return true;
+	}
+	const unsigned KeyframeSize = bytes_be_to_uint(aHeader + 4);
+	const unsigned DataSize = bytes_be_to_uint(aHeader + 8);
+	const unsigned CompressedSize = bytes_be_to_uint(aHeader + 12);
+	// Validate the sizes before allocating anything, a corrupt header must
+	// not make us reserve gigabytes.
+	const uint64_t BlockEnd = Index + 1 < NumBlocks() ? m_vOffsets[Index + 1] : m_BlocksEnd;
+	if(m_vOffsets[Index] + BLOCK_HEADER_SIZE + CompressedSize > BlockEnd ||
+		KeyframeSize > MAX_BLOCK_SIZE || DataSize > MAX_BLOCK_SIZE - KeyframeSize)
+	{
+		return true;
+	}
+	m_vCompressed.resize(CompressedSize);
+	if(io_read(m_File, m_vCompressed.data(), CompressedSize) != CompressedSize)
+	{
+		return true;
+	}
+	// zlib refuses null output buffers, even empty ones.
+	pvKeyframe->resize(maximum(KeyframeSize, 1u));
+	pvData->resize(maximum(DataSize, 1u));
+
+	z_stream Stream;
+	mem_zero(&Stream, sizeof(Stream));
+	if(inflateInit(&Stream) != Z_OK)
+	{
+		return true;
+	}
+	Stream.next_in = m_vCompressed.data();
+	Stream.avail_in = CompressedSize;
+	Stream.next_out = pvKeyframe->data();
+	Stream.avail_out = KeyframeSize;
+	int Result = KeyframeSize > 0 ? inflate(&Stream, Z_SYNC_FLUSH) : Z_OK;
+	if((Result == Z_OK || Result == Z_STREAM_END) && Stream.avail_out == 0)
+	{
+		Stream.next_out = pvData->data();
+		Stream.avail_out = DataSize;
+		Result = inflate(&Stream, Z_FINISH);
+	}
+	const bool Error = Result != Z_STREAM_END || Stream.avail_out != 0;
+	inflateEnd(&Stream);
+	pvKeyframe->resize(KeyframeSize);
+	pvData->resize(DataSize);
+	return Error;
+}
@@ -0,0 +1,152 @@
+#ifndef ENGINE_SHARED_BLOCKFILE_H
+#define ENGINE_SHARED_BLOCKFILE_H
+
+#include <base/system.h>
+
+#include <vector>
+
+/*
+	Seekable, zlib-compressed stream format.
+
+	The stream is split into blocks that are compressed independently. Each
+	block is tagged with an integer key (e.g. a tick) and can carry a
+	keyframe, the state a reader needs to decode the block's data without
+	having read the blocks before it. An index of all block keys and offsets
+	is appended when the file is closed. Files without index (e.g. after a
+	crash) can still be read, the blocks are found by scanning the file.
+
+	File layout, all integers big-endian:
+
+		header:  "TWBLKS01"
+		block:   i32 key, u32 keyframe size, u32 data size, u32 compressed size,
+		         zlib(keyframe || data)
+		index:   "TWBLKIDX", u32 number of blocks,
+		         for each block: i32 key, u32 offset high, u32 offset low
+		trailer: u32 index offset high, u32 index offset low, "TWBLKEND"
+*/
+
+class CBlockFileWriter
+{
+public:
+	CBlockFileWriter();
+	~CBlockFileWriter();
+
+	/**
+	 * Takes ownership of `File` and starts the compression thread. The
+	 * first block has key 0 and no keyframe.
+	 */
+	void Open(IOHANDLE File);
+
+	/**
+	 * Appends data to the current block. Only call from the thread that
+	 * opened the writer.
+	 */
+	void Write(const void *pData, int DataSize);
+
+	/**
+	 * Hands the current block to the compression thread and starts a new
+	 * one. Data written afterwards must be decodable given `pKeyframe`.
+	 */
+	void BeginBlock(int Key, const void *pKeyframe, int KeyframeSize);
+
+	/**
+	 * Size of the uncompressed data in the current block.
+	 */
+	int BlockSize() const { return m_vData.size(); }
+
+	/**
+	 * Flushes the last block, writes the index and closes the file. Blocks
+	 * until everything is written.
+	 *
+	 * @return Same as @link Error @endlink.
+	 */
+	int Close();
+
+	/**
+	 * @return Non-zero if compressing or writing failed.
+	 */
+	int Error();
+
+private:
+	struct CBlock
+	{
+		int m_Key;
+		std::vector<unsigned char> m_vKeyframe;
+		std::vector<unsigned char> m_vData;
+	};
+
+	static void ThreadFunc(void *pUser);
+	void Run();
+	void WriteBlock(const CBlock &Block);
+	void WriteIndex();
+	void QueueCurrentBlock();
+
+	IOHANDLE m_File;
+	void *m_pThread;
+
+	// Only accessed from the thread that opened the writer.
+	int m_Key;
+	std::vector<unsigned char> m_vKeyframe;
+	std::vector<unsigned char> m_vData;
+
+	LOCK m_Lock;
+	SEMAPHORE m_Semaphore;
+	std::vector<CBlock> m_vQueue GUARDED_BY(m_Lock);
+	bool m_Closing GUARDED_BY(m_Lock);
+	int m_Error GUARDED_BY(m_Lock);
+
+	// Only accessed from the compression thread.
+	uint64_t m_Offset;
+	std::vector<int> m_vIndexKeys;
+	std::vector<uint64_t> m_vIndexOffsets;
+	std::vector<unsigned char> m_vCompressed;
+};
+
+class CBlockFileReader
+{
+public:
+	CBlockFileReader();
+	~CBlockFileReader();
+
+	/**
+	 * Checks whether the data starts like a block file.
+	 */
+	static bool IsBlockFile(const void *pData, int DataSize);
+
+	/**
+	 * Takes ownership of `File` and reads the block index.
+	 *
+	 * @return `true` on error.
+	 */
+	bool Open(IOHANDLE File);
+	void Close();
+
+	int NumBlocks() const { return m_vKeys.size(); }
+	int BlockKey(int Index) const { return m_vKeys[Index]; }
+
+	/**
+	 * @return Index of the last block with a key smaller or equal to
+	 *         `Key`, -1 if there is none.
+	 */
+	int FindBlock(int Key) const;
+
+	/**
+	 * Decompresses a block.
+	 *
+	 * @return `true` on error.
+	 */
+	bool ReadBlock(int Index, std::vector<unsigned char> *pvKeyframe, std::vector<unsigned char> *pvData);
+
+private:
+	bool ReadIndex();
+	bool ScanBlocks();
+
+	IOHANDLE m_File;
+	std::vector<int> m_vKeys;
+	std::vector<uint64_t> m_vOffsets;
+	// Offset of the index, or of the end of the last complete block.
+	uint64_t m_BlocksEnd;
+	std::vector<unsigned char> m_vCompressed;
+};
+
+#endif // ENGINE_SHARED_BLOCKFILE_H
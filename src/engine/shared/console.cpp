@@ -166,9 +166,9 @@ int CConsole::ParseStart(CResult *pResult, const char *pString, int Length)
 	return 0;
 }
 
-int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
+int CConsole::ParseArgs(CResult *pResult, const char *pParamTypes)
 {
-	char Command = *pFormat;
+	char Command = *pParamTypes;
 	char *pStr;
 	int Optional = 0;
 	int Error = 0;
@@ -203,7 +203,7 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 						pResult->SetVictim(CResult::VICTIM_ME);
 						break;
 					}
-					Command = NextParam(pFormat);
+					Command = *++pParamTypes;
 				}
 				break;
 			}
@@ -274,7 +274,7 @@ int CConsole::ParseArgs(CResult *pResult, const char *pFormat)
 			}
 		}
 		// fetch next command
-		Command = NextParam(pFormat);
+		Command = *++pParamTypes;
 	}
 
 	return Error;
@@ -306,6 +306,20 @@ char CConsole::NextParam(const char *&pFormat)
 	return *pFormat;
 }
 
+void CConsole::SetParams(CCommand *pCommand, const char *pParams)
+{
+	pCommand->m_pParams = pParams;
+
+	// the parameter types in the order `NextParam` returns them
+	int NumTypes = 0;
+	for(char Type = *pParams; Type; Type = NextParam(pParams))
+	{
+		dbg_assert(NumTypes < (int)sizeof(pCommand->m_aParamTypes) - 1, "too many command parameters");
+		pCommand->m_aParamTypes[NumTypes++] = Type;
+	}
+	pCommand->m_aParamTypes[NumTypes] = 0;
+}
+
 char *CConsole::Format(char *pBuf, int Size, const char *pFrom, const char *pStr)
 {
 	char aTimeBuf[80];
@@ -421,7 +435,7 @@ bool CConsole::LineIsValid(const char *pStr)
 			return false;
 
 		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
-		if(!pCommand || ParseArgs(&Result, pCommand->m_pParams))
+		if(!pCommand || ParseArgs(&Result, pCommand->m_aParamTypes))
 			return false;
 
 		pStr = pNextPart;
@@ -511,7 +525,7 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientID, bo
 
 				if(Stroke || IsStrokeCommand)
 				{
-					if(ParseArgs(&Result, pCommand->m_pParams))
+					if(ParseArgs(&Result, pCommand->m_aParamTypes))
 					{
 						char aBuf[256];
 						str_format(aBuf, sizeof(aBuf), "Invalid arguments... Usage: %s %s", pCommand->m_pName, pCommand->m_pParams);
@@ -594,9 +608,23 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+unsigned CConsole::CommandBucket(const char *pName)
+{
+	// FNV-1a over the lowercase name, like `str_comp_nocase` compares
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		unsigned char c = *pName;
+		if(c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		Hash = (Hash ^ c) * 16777619u;
+	}
+	return Hash % NUM_COMMAND_BUCKETS;
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandBuckets[CommandBucket(pName)]; pCommand; pCommand = pCommand->m_pNextInBucket)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -989,6 +1017,7 @@ CConsole::CConsole(int FlagMask)
 	m_apStrokeStr[1] = "1";
 	m_ExecutionQueue.Reset();
 	m_pFirstCommand = 0;
+	mem_zero(m_apCommandBuckets, sizeof(m_apCommandBuckets));
 	m_pFirstExec = 0;
 	m_pfnTeeHistorianCommandCallback = 0;
 	m_pTeeHistorianCommandUserdata = 0;
@@ -1098,12 +1127,17 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 
 void CConsole::AddCommandSorted(CCommand *pCommand)
 {
+	// keep the bucket in the order of the command list so that
+	// `FindCommand` returns the same command as walking the list would
+	CCommand **ppBucket = &m_apCommandBuckets[CommandBucket(pCommand->m_pName)];
+	while(*ppBucket && str_comp(pCommand->m_pName, (*ppBucket)->m_pName) > 0)
+		ppBucket = &(*ppBucket)->m_pNextInBucket;
+	pCommand->m_pNextInBucket = *ppBucket;
+	*ppBucket = pCommand;
+
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->m_pNext)
-			pCommand->m_pNext = m_pFirstCommand;
-		else
-			pCommand->m_pNext = 0;
+		pCommand->m_pNext = m_pFirstCommand;
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -1135,7 +1169,7 @@ void CConsole::Register(const char *pName, const char *pParams,
 
 	pCommand->m_pName = pName;
 	pCommand->m_pHelp = pHelp;
-	pCommand->m_pParams = pParams;
+	SetParams(pCommand, pParams);
 
 	pCommand->m_Flags = Flags;
 	pCommand->m_Temp = false;
@@ -1156,6 +1190,7 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams, int Flags, c
 		str_copy(const_cast<char *>(pCommand->m_pName), pName, TEMPCMD_NAME_LENGTH);
 		str_copy(const_cast<char *>(pCommand->m_pHelp), pHelp, TEMPCMD_HELP_LENGTH);
 		str_copy(const_cast<char *>(pCommand->m_pParams), pParams, TEMPCMD_PARAMS_LENGTH);
+		SetParams(pCommand, pCommand->m_pParams);
 
 		m_pRecycleList = m_pRecycleList->m_pNext;
 	}
@@ -1170,7 +1205,7 @@ void CConsole::RegisterTemp(const char *pName, const char *pParams, int Flags, c
 		pCommand->m_pHelp = pMem;
 		pMem = static_cast<char *>(m_TempCommands.Allocate(TEMPCMD_PARAMS_LENGTH));
 		str_copy(pMem, pParams, TEMPCMD_PARAMS_LENGTH);
-		pCommand->m_pParams = pMem;
+		SetParams(pCommand, pMem);
 	}
 
 	pCommand->m_pfnCallback = 0;
@@ -1208,13 +1243,34 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveCommandFromIndex(pRemoved);
 		pRemoved->m_pNext = m_pRecycleList;
 		m_pRecycleList = pRemoved;
 	}
 }
 
+void CConsole::RemoveCommandFromIndex(CCommand *pCommand)
+{
+	CCommand **ppBucket = &m_apCommandBuckets[CommandBucket(pCommand->m_pName)];
+	while(*ppBucket != pCommand)
+		ppBucket = &(*ppBucket)->m_pNextInBucket;
+	*ppBucket = pCommand->m_pNextInBucket;
+}
+
 void CConsole::DeregisterTempAll()
 {
+	for(auto &pBucket : m_apCommandBuckets)
+	{
+		CCommand **ppBucket = &pBucket;
+		while(*ppBucket)
+		{
+			if((*ppBucket)->m_Temp)
+				*ppBucket = (*ppBucket)->m_pNextInBucket;
+			else
+				ppBucket = &(*ppBucket)->m_pNextInBucket;
+		}
+	}
+
 	// set non temp as first one
 	for(; m_pFirstCommand && m_pFirstCommand->m_Temp; m_pFirstCommand = m_pFirstCommand->m_pNext)
 		;
@@ -1279,7 +1335,7 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::CCommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->m_pNext)
+	for(CCommand *pCommand = m_apCommandBuckets[CommandBucket(pName)]; pCommand; pCommand = pCommand->m_pNextInBucket)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -14,10 +14,15 @@ class CConsole : public IConsole
 	{
 	public:
 		CCommand *m_pNext;
+		// next command in the same bucket of the name index
+		CCommand *m_pNextInBucket;
 		int m_Flags;
 		bool m_Temp;
 		FCommandCallback m_pfnCallback;
 		void *m_pUserData;
+		// the parameter types of `m_pParams` without the descriptions as
+		// `ParseArgs` wants them, e.g. "s?ir" for "s[a] ?i[b] r[c]"
+		char m_aParamTypes[TEMPCMD_PARAMS_LENGTH];
 
 		const CCommandInfo *NextCommandInfo(int AccessLevel, int FlagMask) const override;
 
@@ -38,6 +43,16 @@ class CConsole : public IConsole
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
 
+	enum
+	{
+		NUM_COMMAND_BUCKETS = 1024,
+	};
+	// case-insensitive hash index of the commands by name, each bucket is
+	// in the order of the command list
+	CCommand *m_apCommandBuckets[NUM_COMMAND_BUCKETS];
+	static unsigned CommandBucket(const char *pName);
+	void RemoveCommandFromIndex(CCommand *pCommand);
+
 	class CExecFile
 	{
 	public:
@@ -88,13 +103,13 @@ class CConsole : public IConsole
 		const char *m_pCommand;
 		const char *m_apArgs[MAX_PARTS];
 
+		// Only the first `m_NumArgs` arguments are ever read, so the storage
+		// isn't cleared, that would be 40KiB for every executed command.
 		CResult()
-
 		{
-			mem_zero(m_aStringStorage, sizeof(m_aStringStorage));
+			m_aStringStorage[0] = 0;
 			m_pArgsStart = 0;
 			m_pCommand = 0;
-			mem_zero(m_apArgs, sizeof(m_apArgs));
 		}
 
 		CResult &operator=(const CResult &Other)
@@ -148,7 +163,9 @@ class CConsole : public IConsole
 	};
 
 	int ParseStart(CResult *pResult, const char *pString, int Length);
-	int ParseArgs(CResult *pResult, const char *pFormat);
+	// `pParamTypes` is `CCommand::m_aParamTypes`
+	int ParseArgs(CResult *pResult, const char *pParamTypes);
+	void SetParams(CCommand *pCommand, const char *pParams);
 
 	/*
 	this function will set pFormat to the next parameter (i,s,r,v,?) it contains and
@@ -18,6 +18,8 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <memory>
+
 const double g_aSpeeds[g_DemoSpeeds] = {0.1, 0.25, 0.5, 0.75, 1.0, 1.25, 1.5, 2.0, 3.0, 4.0, 6.0, 8.0, 12.0, 16.0, 20.0, 24.0, 28.0, 32.0, 40.0, 48.0, 56.0, 64.0};
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
@@ -33,6 +35,72 @@ static const int gs_NumMarkersOffset = 176;
 
 static const ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 
+static void WriteHeader(IOHANDLE File, const char *pNetVersion, const char *pMap, const SHA256_DIGEST *pSha256, unsigned Crc, const char *pType, unsigned MapSize, const unsigned char *pMapData, IOHANDLE MapFile)
+{
+	// write header
+	CDemoHeader Header;
+	mem_zero(&Header, sizeof(Header));
+	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
+	Header.m_Version = gs_CurVersion;
+	str_copy(Header.m_aNetversion, pNetVersion);
+	str_copy(Header.m_aMapName, pMap);
+	uint_to_bytes_be(Header.m_aMapSize, MapSize);
+	uint_to_bytes_be(Header.m_aMapCrc, Crc);
+	str_copy(Header.m_aType, pType);
+	// Header.m_Length - add this on stop
+	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
+	io_write(File, &Header, sizeof(Header));
+
+	CTimelineMarkers TimelineMarkers;
+	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
+	io_write(File, &TimelineMarkers, sizeof(TimelineMarkers)); // fill this on stop
+
+	//Write Sha256
+	io_write(File, SHA256_EXTENSION.m_aData, sizeof(SHA256_EXTENSION.m_aData));
+	io_write(File, pSha256, sizeof(SHA256_DIGEST));
+
+	if(pMapData)
+	{
+		io_write(File, pMapData, MapSize);
+	}
+	else if(MapFile)
+	{
+		// write map data
+		io_seek(MapFile, 0, IOSEEK_START);
+		while(true)
+		{
+			unsigned char aChunk[1024 * 64];
+			mem_zero(aChunk, sizeof(aChunk));
+			int Bytes = io_read(MapFile, &aChunk, sizeof(aChunk));
+			if(Bytes <= 0)
+				break;
+			io_write(File, &aChunk, Bytes);
+		}
+		io_seek(MapFile, 0, IOSEEK_START);
+	}
+}
+
+static void WriteLengthAndMarkers(IOHANDLE File, int Length, const int *pTimelineMarkers, int NumTimelineMarkers)
+{
+	// add the demo length to the header
+	io_seek(File, gs_LengthOffset, IOSEEK_START);
+	unsigned char aLength[sizeof(int32_t)];
+	uint_to_bytes_be(aLength, Length);
+	io_write(File, aLength, sizeof(aLength));
+
+	// add the timeline markers to the header
+	io_seek(File, gs_NumMarkersOffset, IOSEEK_START);
+	unsigned char aNumMarkers[sizeof(int32_t)];
+	uint_to_bytes_be(aNumMarkers, NumTimelineMarkers);
+	io_write(File, aNumMarkers, sizeof(aNumMarkers));
+	for(int i = 0; i < NumTimelineMarkers; i++)
+	{
+		unsigned char aMarker[sizeof(int32_t)];
+		uint_to_bytes_be(aMarker, pTimelineMarkers[i]);
+		io_write(File, aMarker, sizeof(aMarker));
+	}
+}
+
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
 {
 	m_File = 0;
@@ -127,52 +195,9 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	else if(MapFile)
 		MapSize = io_length(MapFile);
 
-	// write header
-	CDemoHeader Header;
-	mem_zero(&Header, sizeof(Header));
-	mem_copy(Header.m_aMarker, gs_aHeaderMarker, sizeof(Header.m_aMarker));
-	Header.m_Version = gs_CurVersion;
-	str_copy(Header.m_aNetversion, pNetVersion);
-	str_copy(Header.m_aMapName, pMap);
-	uint_to_bytes_be(Header.m_aMapSize, MapSize);
-	uint_to_bytes_be(Header.m_aMapCrc, Crc);
-	str_copy(Header.m_aType, pType);
-	// Header.m_Length - add this on stop
-	str_timestamp(Header.m_aTimestamp, sizeof(Header.m_aTimestamp));
-	io_write(DemoFile, &Header, sizeof(Header));
-
-	CTimelineMarkers TimelineMarkers;
-	mem_zero(&TimelineMarkers, sizeof(TimelineMarkers));
-	io_write(DemoFile, &TimelineMarkers, sizeof(TimelineMarkers)); // fill this on stop
-
-	//Write Sha256
-	io_write(DemoFile, SHA256_EXTENSION.m_aData, sizeof(SHA256_EXTENSION.m_aData));
-	io_write(DemoFile, pSha256, sizeof(SHA256_DIGEST));
-
-	if(m_NoMapData)
-	{
-	}
-	else if(pMapData)
-	{
-		io_write(DemoFile, pMapData, MapSize);
-	}
-	else
-	{
-		// write map data
-		while(true)
-		{
-			unsigned char aChunk[1024 * 64];
-			mem_zero(aChunk, sizeof(aChunk));
-			int Bytes = io_read(MapFile, &aChunk, sizeof(aChunk));
-			if(Bytes <= 0)
-				break;
-			io_write(DemoFile, &aChunk, Bytes);
-		}
-		if(CloseMapFile)
-			io_close(MapFile);
-		else
-			io_seek(MapFile, 0, IOSEEK_START);
-	}
+	WriteHeader(DemoFile, pNetVersion, pMap, pSha256, Crc, pType, MapSize, m_NoMapData ? nullptr : pMapData, m_NoMapData ? nullptr : MapFile);
+	if(CloseMapFile)
+		io_close(MapFile);
 
 	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
@@ -191,6 +216,81 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	return 0;
 }
 
+int CDemoRecorder::StartMemory(IConsole *pConsole, const char *pNetVersion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, int MaxSeconds)
+{
+	if(IsRecording())
+		return -1;
+
+	m_pConsole = pConsole;
+	m_pfnFilter = nullptr;
+	m_pUser = nullptr;
+
+	m_pMemory = std::make_unique<CMemory>();
+	str_copy(m_pMemory->m_aNetVersion, pNetVersion);
+	str_copy(m_pMemory->m_aMap, pMap);
+	m_pMemory->m_Sha256 = Sha256;
+	m_pMemory->m_Crc = MapCrc;
+	str_copy(m_pMemory->m_aType, pType);
+	m_pMemory->m_MaxTicks = MaxSeconds * SERVER_TICK_SPEED;
+
+	m_LastKeyFrame = -1;
+	m_LastTickMarker = -1;
+	m_FirstTick = -1;
+	m_NumTimelineMarkers = 0;
+	m_aCurrentFilename[0] = '\0';
+
+	if(m_pConsole)
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Recording to memory", gs_DemoPrintColor);
+	return 0;
+}
+
+void CDemoRecorder::StartMemorySegment(int Tick)
+{
+	// the oldest segment is not needed anymore once the next one covers
+	// the whole time
+	std::deque<CMemorySegment> &Segments = m_pMemory->m_Segments;
+	while(Segments.size() >= 2 && Tick - Segments[1].m_FirstTick >= m_pMemory->m_MaxTicks)
+	{
+		m_pMemory->m_vSpareData.push_back(std::move(Segments.front().m_vData));
+		Segments.pop_front();
+	}
+
+	CMemorySegment &Segment = Segments.emplace_back();
+	Segment.m_FirstTick = Tick;
+	if(!m_pMemory->m_vSpareData.empty())
+	{
+		Segment.m_vData = std::move(m_pMemory->m_vSpareData.back());
+		Segment.m_vData.clear();
+		m_pMemory->m_vSpareData.pop_back();
+	}
+	m_FirstTick = Segments.front().m_FirstTick;
+
+	// timeline markers of dropped segments
+	int NumDropped = 0;
+	while(NumDropped < m_NumTimelineMarkers && m_aTimelineMarkers[NumDropped] < m_FirstTick)
+		NumDropped++;
+	if(NumDropped)
+	{
+		m_NumTimelineMarkers -= NumDropped;
+		mem_move(m_aTimelineMarkers, m_aTimelineMarkers + NumDropped, m_NumTimelineMarkers * sizeof(m_aTimelineMarkers[0]));
+	}
+}
+
+void CDemoRecorder::WriteData(const void *pData, int Size)
+{
+	if(!m_pMemory)
+	{
+		io_write(m_File, pData, Size);
+		return;
+	}
+
+	// nothing is kept before the first key frame
+	if(m_pMemory->m_Segments.empty())
+		return;
+	std::vector<unsigned char> &vData = m_pMemory->m_Segments.back().m_vData;
+	vData.insert(vData.end(), (const unsigned char *)pData, (const unsigned char *)pData + Size);
+}
+
 /*
 	Tickmarker
 		7	= Always set
@@ -230,15 +330,19 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 		uint_to_bytes_be(aChunk + 1, Tick);
 
 		if(Keyframe)
+		{
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
+			if(m_pMemory)
+				StartMemorySegment(Tick);
+		}
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteData(aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteData(aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -248,7 +352,7 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
 {
-	if(!m_File)
+	if(!IsRecording())
 		return;
 
 	if(Size > 64 * 1024)
@@ -269,12 +373,18 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 	if(Size < 0)
 		return;
 
+	WriteChunkHeader(Type, Size);
+	WriteData(aBuffer2, Size);
+}
+
+void CDemoRecorder::WriteChunkHeader(int Type, int Size)
+{
 	unsigned char aChunk[3];
 	aChunk[0] = ((Type & 0x3) << 5);
 	if(Size < 30)
 	{
 		aChunk[0] |= Size;
-		io_write(m_File, aChunk, 1);
+		WriteData(aChunk, 1);
 	}
 	else
 	{
@@ -282,18 +392,16 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		{
 			aChunk[0] |= 30;
 			aChunk[1] = Size & 0xff;
-			io_write(m_File, aChunk, 2);
+			WriteData(aChunk, 2);
 		}
 		else
 		{
 			aChunk[0] |= 31;
 			aChunk[1] = Size & 0xff;
 			aChunk[2] = Size >> 8;
-			io_write(m_File, aChunk, 3);
+			WriteData(aChunk, 3);
 		}
 	}
-
-	io_write(m_File, aBuffer2, Size);
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
@@ -340,28 +448,34 @@ void CDemoRecorder::RecordMessage(const void *pData, int Size)
 	Write(CHUNKTYPE_MESSAGE, pData, Size);
 }
 
-int CDemoRecorder::Stop()
+void CDemoRecorder::RecordTickMarker(int Tick, bool KeyFrame)
 {
-	if(!m_File)
-		return -1;
+	if(!IsRecording())
+		return;
+	WriteTickMarker(Tick, KeyFrame);
+}
 
-	// add the demo length to the header
-	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
-	unsigned char aLength[sizeof(int32_t)];
-	uint_to_bytes_be(aLength, Length());
-	io_write(m_File, aLength, sizeof(aLength));
+void CDemoRecorder::RecordChunk(int Type, const void *pData, int Size)
+{
+	if(!IsRecording())
+		return;
+	WriteChunkHeader(Type, Size);
+	WriteData(pData, Size);
+}
 
-	// add the timeline markers to the header
-	io_seek(m_File, gs_NumMarkersOffset, IOSEEK_START);
-	unsigned char aNumMarkers[sizeof(int32_t)];
-	uint_to_bytes_be(aNumMarkers, m_NumTimelineMarkers);
-	io_write(m_File, aNumMarkers, sizeof(aNumMarkers));
-	for(int i = 0; i < m_NumTimelineMarkers; i++)
+int CDemoRecorder::Stop()
+{
+	if(m_pMemory)
 	{
-		unsigned char aMarker[sizeof(int32_t)];
-		uint_to_bytes_be(aMarker, m_aTimelineMarkers[i]);
-		io_write(m_File, aMarker, sizeof(aMarker));
+		m_pMemory = nullptr;
+		if(m_pConsole)
+			m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Stopped recording", gs_DemoPrintColor);
+		return 0;
 	}
+	if(!m_File)
+		return -1;
+
+	WriteLengthAndMarkers(m_File, Length(), m_aTimelineMarkers, m_NumTimelineMarkers);
 
 	io_close(m_File);
 	m_File = 0;
@@ -371,6 +485,70 @@ int CDemoRecorder::Stop()
 	return 0;
 }
 
+int CDemoRecorder::SaveMemory(IStorage *pStorage, const char *pFilename, int Seconds, IOHANDLE MapFile)
+{
+	CMemoryReplay Replay;
+	if(CopyMemory(Seconds, &Replay) != 0)
+		return -1;
+	return SaveMemoryReplay(pStorage, m_pConsole, pFilename, Replay, MapFile);
+}
+
+int CDemoRecorder::CopyMemory(int Seconds, CMemoryReplay *pReplay) const
+{
+	if(!m_pMemory || m_pMemory->m_Segments.empty())
+		return -1;
+
+	// the last key frame at or before the start
+	const std::deque<CMemorySegment> &Segments = m_pMemory->m_Segments;
+	const int StartTick = m_LastTickMarker - Seconds * SERVER_TICK_SPEED;
+	size_t First = 0;
+	while(First + 1 < Segments.size() && Segments[First + 1].m_FirstTick <= StartTick)
+		First++;
+
+	str_copy(pReplay->m_aNetVersion, m_pMemory->m_aNetVersion);
+	str_copy(pReplay->m_aMap, m_pMemory->m_aMap);
+	pReplay->m_Sha256 = m_pMemory->m_Sha256;
+	pReplay->m_Crc = m_pMemory->m_Crc;
+	str_copy(pReplay->m_aType, m_pMemory->m_aType);
+
+	size_t Size = 0;
+	for(size_t i = First; i < Segments.size(); i++)
+		Size += Segments[i].m_vData.size();
+	pReplay->m_vData.clear();
+	pReplay->m_vData.reserve(Size);
+	for(size_t i = First; i < Segments.size(); i++)
+		pReplay->m_vData.insert(pReplay->m_vData.end(), Segments[i].m_vData.begin(), Segments[i].m_vData.end());
+
+	const int FirstTick = Segments[First].m_FirstTick;
+	int FirstMarker = 0;
+	while(FirstMarker < m_NumTimelineMarkers && m_aTimelineMarkers[FirstMarker] < FirstTick)
+		FirstMarker++;
+	pReplay->m_vTimelineMarkers.assign(m_aTimelineMarkers + FirstMarker, m_aTimelineMarkers + m_NumTimelineMarkers);
+	pReplay->m_Length = (m_LastTickMarker - FirstTick) / SERVER_TICK_SPEED;
+	return 0;
+}
+
+int CDemoRecorder::SaveMemoryReplay(IStorage *pStorage, IConsole *pConsole, const char *pFilename, const CMemoryReplay &Replay, IOHANDLE MapFile)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		if(pConsole)
+		{
+			char aBuf[256];
+			str_format(aBuf, sizeof(aBuf), "Unable to open '%s' for recording", pFilename);
+			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf, gs_DemoPrintColor);
+		}
+		return -1;
+	}
+
+	WriteHeader(File, Replay.m_aNetVersion, Replay.m_aMap, &Replay.m_Sha256, Replay.m_Crc, Replay.m_aType, MapFile ? io_length(MapFile) : 0, nullptr, MapFile);
+	io_write(File, Replay.m_vData.data(), Replay.m_vData.size());
+	WriteLengthAndMarkers(File, Replay.m_Length, Replay.m_vTimelineMarkers.data(), Replay.m_vTimelineMarkers.size());
+	io_close(File);
+	return 0;
+}
+
 void CDemoRecorder::AddDemoMarker()
 {
 	if(m_LastTickMarker < 0)
@@ -485,6 +663,35 @@ int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
 	return 0;
 }
 
+int CDemoPlayer::SeekKeyFrame(int Tick)
+{
+	if(!m_File || !m_Info.m_SeekablePoints || m_pKeyFrames[0].m_Tick > Tick)
+		return -1;
+
+	// the last key frame at or before the tick
+	int Low = 0;
+	int High = m_Info.m_SeekablePoints - 1;
+	while(Low < High)
+	{
+		int Mid = (Low + High + 1) / 2;
+		if(m_pKeyFrames[Mid].m_Tick <= Tick)
+			Low = Mid;
+		else
+			High = Mid - 1;
+	}
+	io_seek(m_File, m_pKeyFrames[Low].m_Filepos, IOSEEK_START);
+	return m_pKeyFrames[Low].m_Tick;
+}
+
+int CDemoPlayer::ReadChunk(int *pType, int *pTick, void *pData, int *pSize)
+{
+	if(ReadChunkHeader(pType, pSize, pTick))
+		return -1;
+	if(*pSize && io_read(m_File, pData, *pSize) != (unsigned)*pSize)
+		return -1;
+	return 0;
+}
+
 void CDemoPlayer::ScanFile()
 {
 	CHeap Heap;
@@ -1161,76 +1368,143 @@ void CDemoEditor::Init(const char *pNetVersion, class CSnapshotDelta *pSnapshotD
 
 void CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int EndTick, DEMOFUNC_FILTER pfnFilter, void *pUser)
 {
-	class CDemoPlayer DemoPlayer(m_pSnapshotDelta);
-	class CDemoRecorder DemoRecorder(m_pSnapshotDelta);
-
-	m_pDemoPlayer = &DemoPlayer;
-	m_pDemoRecorder = &DemoRecorder;
+	CDemoPlayer DemoPlayer(m_pSnapshotDelta);
+	CDemoRecorder DemoRecorder(m_pSnapshotDelta);
 
-	m_pDemoPlayer->SetListener(this);
-
-	m_SliceFrom = StartTick;
-	m_SliceTo = EndTick;
-	m_Stop = false;
-
-	if(m_pDemoPlayer->Load(m_pStorage, m_pConsole, pDemo, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
+	if(DemoPlayer.Load(m_pStorage, m_pConsole, pDemo, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
 		return;
 
-	const CMapInfo *pMapInfo = m_pDemoPlayer->GetMapInfo();
-	const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
+	const CMapInfo *pMapInfo = DemoPlayer.GetMapInfo();
+	const CDemoPlayer::CPlaybackInfo *pInfo = DemoPlayer.Info();
 
 	SHA256_DIGEST Sha256 = pMapInfo->m_Sha256;
 	if(pInfo->m_Header.m_Version < gs_Sha256Version)
 	{
-		if(m_pDemoPlayer->ExtractMap(m_pStorage))
+		if(DemoPlayer.ExtractMap(m_pStorage))
 			Sha256 = pMapInfo->m_Sha256;
 	}
 
-	unsigned char *pMapData = m_pDemoPlayer->GetMapData(m_pStorage);
-	const int Result = m_pDemoRecorder->Start(m_pStorage, m_pConsole, pDst, m_pNetVersion, pMapInfo->m_aName, &Sha256, pMapInfo->m_Crc, "client", pMapInfo->m_Size, pMapData, NULL, pfnFilter, pUser) == -1;
+	unsigned char *pMapData = DemoPlayer.GetMapData(m_pStorage);
+	const int Result = DemoRecorder.Start(m_pStorage, m_pConsole, pDst, m_pNetVersion, pMapInfo->m_aName, &Sha256, pMapInfo->m_Crc, "client", pMapInfo->m_Size, pMapData, NULL, pfnFilter, pUser) == -1;
 	free(pMapData);
 	if(Result != 0)
+	{
+		DemoPlayer.Stop();
 		return;
+	}
 
-	m_pDemoPlayer->Play();
+	// Only the snapshots from the key frame before the start are decoded,
+	// the first tick is written as a key frame, everything after that is
+	// copied without decoding it.
+	if(StartTick != -1)
+		DemoPlayer.SeekKeyFrame(StartTick);
 
-	while(m_pDemoPlayer->IsPlaying() && !m_Stop)
+	// slicing runs in jobs, so no static buffers
+	struct CBuffers
 	{
-		m_pDemoPlayer->Update(false);
+		char m_aChunk[CSnapshot::MAX_SIZE];
+		char m_aDecompressed[CSnapshot::MAX_SIZE];
+		char m_aData[CSnapshot::MAX_SIZE];
+		char m_aSnapshot[CSnapshot::MAX_SIZE];
+		char m_aNewSnapshot[CSnapshot::MAX_SIZE];
+	};
+	std::unique_ptr<CBuffers> pBuffers = std::make_unique<CBuffers>();
+	char *pChunk = pBuffers->m_aChunk;
+	char *pData = pBuffers->m_aData;
+	char *pSnapshot = pBuffers->m_aSnapshot;
+	int SnapshotSize = -1;
+	int Tick = -1;
+	bool Started = false;
+
+	// writes the first tick, the last snapshot becomes a key frame
+	auto StartSlice = [&](int FirstTick) {
+		if(SnapshotSize >= 0)
+			DemoRecorder.RecordSnapshot(FirstTick, pSnapshot, SnapshotSize);
+		else
+			DemoRecorder.RecordTickMarker(FirstTick, false);
+		Started = true;
+	};
+	auto Decompress = [&](int ChunkSize) -> int {
+		int DataSize = CNetBase::Decompress(pChunk, ChunkSize, pBuffers->m_aDecompressed, sizeof(pBuffers->m_aDecompressed));
+		if(DataSize < 0)
+			return DataSize;
+		return CVariableInt::Decompress(pBuffers->m_aDecompressed, DataSize, pData, sizeof(pBuffers->m_aData));
+	};
 
-		if(pInfo->m_Info.m_Paused)
+	while(true)
+	{
+		int ChunkType, ChunkSize;
+		int PrevTick = Tick;
+		if(DemoPlayer.ReadChunk(&ChunkType, &Tick, pChunk, &ChunkSize))
 			break;
+
+		if(ChunkType & CHUNKTYPEFLAG_TICKMARKER)
+		{
+			// the first tick of the slice has no chunks
+			if(!Started && PrevTick != -1 && PrevTick != Tick && (StartTick == -1 || PrevTick >= StartTick))
+				StartSlice(PrevTick);
+			if(EndTick != -1 && Tick > EndTick)
+				break;
+			if(Started)
+				DemoRecorder.RecordTickMarker(Tick, ChunkType & CHUNKTICKFLAG_KEYFRAME);
+			continue;
+		}
+
+		bool InSlice = StartTick == -1 || Tick >= StartTick;
+		if(ChunkType == CHUNKTYPE_SNAPSHOT || ChunkType == CHUNKTYPE_DELTA)
+		{
+			if(Started)
+			{
+				DemoRecorder.RecordChunk(ChunkType, pChunk, ChunkSize);
+				continue;
+			}
+
+			int DataSize = Decompress(ChunkSize);
+			if(DataSize < 0)
+				continue;
+			if(ChunkType == CHUNKTYPE_DELTA)
+			{
+				if(SnapshotSize < 0)
+					continue;
+				CSnapshot *pNewSnapshot = (CSnapshot *)pBuffers->m_aNewSnapshot;
+				DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot *)pSnapshot, pNewSnapshot, pData, DataSize);
+				if(DataSize < 0 || !pNewSnapshot->IsValid(DataSize))
+					continue;
+				mem_copy(pSnapshot, pNewSnapshot, DataSize);
+			}
+			else
+			{
+				if(!((CSnapshot *)pData)->IsValid(DataSize))
+					continue;
+				mem_copy(pSnapshot, pData, DataSize);
+			}
+			SnapshotSize = DataSize;
+			if(InSlice)
+				StartSlice(Tick);
+		}
+		else if(ChunkType == CHUNKTYPE_MESSAGE && InSlice)
+		{
+			if(!Started)
+				StartSlice(Tick);
+			if(pfnFilter)
+			{
+				int DataSize = Decompress(ChunkSize);
+				if(DataSize < 0 || pfnFilter(pData, DataSize, pUser))
+					continue;
+			}
+			DemoRecorder.RecordChunk(ChunkType, pChunk, ChunkSize);
+		}
 	}
 
 	// Copy timeline markers to sliced demo
 	for(int i = 0; i < pInfo->m_Info.m_NumTimelineMarkers; i++)
 	{
-		if((m_SliceFrom == -1 || pInfo->m_Info.m_aTimelineMarkers[i] >= m_SliceFrom) && (m_SliceTo == -1 || pInfo->m_Info.m_aTimelineMarkers[i] <= m_SliceTo))
+		if((StartTick == -1 || pInfo->m_Info.m_aTimelineMarkers[i] >= StartTick) && (EndTick == -1 || pInfo->m_Info.m_aTimelineMarkers[i] <= EndTick))
 		{
-			m_pDemoRecorder->AddDemoMarker(pInfo->m_Info.m_aTimelineMarkers[i]);
+			DemoRecorder.AddDemoMarker(pInfo->m_Info.m_aTimelineMarkers[i]);
 		}
 	}
 
-	m_pDemoPlayer->Stop();
-	m_pDemoRecorder->Stop();
+	DemoPlayer.Stop();
+	DemoRecorder.Stop();
 } // NOLINT(clang-analyzer-unix.Malloc)
-
-void CDemoEditor::OnDemoPlayerSnapshot(void *pData, int Size)
-{
-	const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
-
-	if(m_SliceTo != -1 && pInfo->m_Info.m_CurrentTick > m_SliceTo)
-		m_Stop = true;
-	else if(m_SliceFrom == -1 || pInfo->m_Info.m_CurrentTick >= m_SliceFrom)
-		m_pDemoRecorder->RecordSnapshot(pInfo->m_Info.m_CurrentTick, pData, Size);
-}
-
-void CDemoEditor::OnDemoPlayerMessage(void *pData, int Size)
-{
-	const CDemoPlayer::CPlaybackInfo *pInfo = m_pDemoPlayer->Info();
-
-	if(m_SliceTo != -1 && pInfo->m_Info.m_CurrentTick > m_SliceTo)
-		m_Stop = true;
-	else if(m_SliceFrom == -1 || pInfo->m_Info.m_CurrentTick >= m_SliceFrom)
-		m_pDemoRecorder->RecordMessage(pData, Size);
-}
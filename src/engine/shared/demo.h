@@ -7,7 +7,10 @@
 
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include "snapshot.h"
 
@@ -31,23 +34,78 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
+	// Recording started with `StartMemory`, the chunks are kept in one
+	// segment per key frame.
+	struct CMemorySegment
+	{
+		int m_FirstTick;
+		std::vector<unsigned char> m_vData;
+	};
+	struct CMemory
+	{
+		char m_aNetVersion[64];
+		char m_aMap[64];
+		SHA256_DIGEST m_Sha256;
+		unsigned m_Crc;
+		char m_aType[8];
+		int m_MaxTicks;
+		std::deque<CMemorySegment> m_Segments;
+		// buffers of dropped segments for reuse
+		std::vector<std::vector<unsigned char>> m_vSpareData;
+	};
+	std::unique_ptr<CMemory> m_pMemory;
+
+	void StartMemorySegment(int Tick);
+	void WriteData(const void *pData, int Size);
 	void WriteTickMarker(int Tick, int Keyframe);
+	void WriteChunkHeader(int Type, int Size);
 	void Write(int Type, const void *pData, int Size);
 
 public:
+	// Copy of the kept chunks, so that they can be written to a demo while
+	// the recording goes on.
+	struct CMemoryReplay
+	{
+		char m_aNetVersion[64];
+		char m_aMap[64];
+		SHA256_DIGEST m_Sha256;
+		unsigned m_Crc;
+		char m_aType[8];
+		int m_Length;
+		std::vector<unsigned char> m_vData;
+		std::vector<int> m_vTimelineMarkers;
+	};
+
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
 	CDemoRecorder() {}
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST *pSha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile = nullptr, DEMOFUNC_FILTER pfnFilter = nullptr, void *pUser = nullptr);
 	int Stop() override;
 
+	// Keeps at least the last `MaxSeconds` seconds in memory instead of
+	// writing a file, `SaveMemory` writes them to a demo.
+	int StartMemory(class IConsole *pConsole, const char *pNetVersion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, int MaxSeconds);
+	// Writes the key frames from at least `Seconds` seconds ago on, `MapFile`
+	// is copied into the demo.
+	int SaveMemory(class IStorage *pStorage, const char *pFilename, int Seconds, IOHANDLE MapFile);
+	// Copies what `SaveMemory` would write, `SaveMemoryReplay` writes the
+	// copy from any thread.
+	int CopyMemory(int Seconds, CMemoryReplay *pReplay) const;
+	static int SaveMemoryReplay(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const CMemoryReplay &Replay, IOHANDLE MapFile);
+
 	void AddDemoMarker();
 	void AddDemoMarker(int Tick);
 
 	void RecordSnapshot(int Tick, const void *pData, int Size);
 	void RecordMessage(const void *pData, int Size);
-
-	bool IsRecording() const override { return m_File != nullptr; }
+	// Writes chunks read with `CDemoPlayer::ReadChunk` as they are. Deltas
+	// refer to the previous snapshot of the demo, not to the ones recorded
+	// with `RecordSnapshot`.
+	void RecordTickMarker(int Tick, bool KeyFrame);
+	void RecordChunk(int Type, const void *pData, int Size);
+
+	bool IsRecording() const override { return m_File != nullptr || m_pMemory != nullptr; }
+	bool IsRecordingToMemory() const { return m_pMemory != nullptr; }
 	char *GetCurrentFilename() override { return m_aCurrentFilename; }
 	void ClearCurrentFilename() { m_aCurrentFilename[0] = '\0'; }
 
@@ -152,30 +210,28 @@ public:
 
 	int Update(bool RealTime = true);
 
+	// Seeks to the last key frame at or before the tick for reading the
+	// chunks with `ReadChunk`, returns the tick of the key frame or -1.
+	int SeekKeyFrame(int Tick);
+	// Reads the next chunk without decompressing it, `pData` must hold
+	// `CSnapshot::MAX_SIZE` bytes. Tick markers update `*pTick`.
+	int ReadChunk(int *pType, int *pTick, void *pData, int *pSize);
+
 	const CPlaybackInfo *Info() const { return &m_Info; }
 	bool IsPlaying() const override { return m_File != nullptr; }
 	const CMapInfo *GetMapInfo() const { return &m_MapInfo; }
 };
 
-class CDemoEditor : public IDemoEditor, public CDemoPlayer::IListener
+class CDemoEditor : public IDemoEditor
 {
-	CDemoPlayer *m_pDemoPlayer;
-	CDemoRecorder *m_pDemoRecorder;
 	IConsole *m_pConsole;
 	IStorage *m_pStorage;
 	class CSnapshotDelta *m_pSnapshotDelta;
 	const char *m_pNetVersion;
 
-	bool m_Stop;
-	int m_SliceFrom;
-	int m_SliceTo;
-
 public:
 	virtual void Init(const char *pNetVersion, class CSnapshotDelta *pSnapshotDelta, class IConsole *pConsole, class IStorage *pStorage);
 	void Slice(const char *pDemo, const char *pDst, int StartTick, int EndTick, DEMOFUNC_FILTER pfnFilter, void *pUser) override;
-
-	void OnDemoPlayerSnapshot(void *pData, int Size) override;
-	void OnDemoPlayerMessage(void *pData, int Size) override;
 };
 
 #endif
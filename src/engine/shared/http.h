@@ -85,14 +85,13 @@ class CHttpRequest : public IJob
 	bool BeforeInit();
 	int RunImpl(void *pUser);
 
-	// Abort the request if `OnData()` returns something other than
-	// `DataSize`.
-	size_t OnData(char *pData, size_t DataSize);
-
 	static int ProgressCallback(void *pUser, double DlTotal, double DlCurr, double UlTotal, double UlCurr);
 	static size_t WriteCallback(char *pData, size_t Size, size_t Number, void *pUser);
 
 protected:
+	// Abort the request if `OnData()` returns something other than
+	// `DataSize`.
+	virtual size_t OnData(char *pData, size_t DataSize);
 	virtual void OnProgress() {}
 	virtual int OnCompletion(int State);
 
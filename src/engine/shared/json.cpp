@@ -113,3 +113,312 @@ const char *JsonBool(bool Bool)
 		return "false";
 	}
 }
+
+static bool IsJsonWhitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool CJsonStreamParser::Feed(const char *pData, size_t DataSize)
+{
+	for(size_t i = 0; i < DataSize && !m_Error;)
+	{
+		if(m_State == STATE_ELEMENT_VALUE)
+		{
+			// Most of the document is inside of elements, collect them
+			// in one go instead of character by character.
+			size_t End = i;
+			int Scan = SCAN_CONTINUE;
+			while(End < DataSize && (Scan = ScanValue(pData[End])) == SCAN_CONTINUE)
+			{
+				End++;
+			}
+			if(Scan == SCAN_DONE_INCLUSIVE)
+			{
+				End++;
+			}
+			m_vElement.insert(m_vElement.end(), pData + i, pData + End);
+			i = End;
+			if(Scan != SCAN_CONTINUE)
+			{
+				m_State = STATE_ELEMENT_COMMA_OR_END;
+				m_Error = EmitElement();
+			}
+			continue;
+		}
+		// A scalar value is only terminated by the following character,
+		// which has to be looked at again in the new state.
+		if(Step(pData[i]))
+		{
+			i++;
+		}
+	}
+	return m_Error;
+}
+
+bool CJsonStreamParser::Finish()
+{
+	if(m_State != STATE_END)
+	{
+		m_Error = true;
+	}
+	return m_Error;
+}
+
+void CJsonStreamParser::BeginValue(char c)
+{
+	m_ValueDepth = 0;
+	m_ValueString = false;
+	m_ValueEscape = false;
+	m_ValueScalar = false;
+	if(c == '{' || c == '[')
+	{
+		m_ValueDepth = 1;
+	}
+	else if(c == '"')
+	{
+		m_ValueString = true;
+	}
+	else
+	{
+		m_ValueScalar = true;
+	}
+}
+
+int CJsonStreamParser::ScanValue(char c)
+{
+	if(m_ValueString)
+	{
+		if(m_ValueEscape)
+		{
+			m_ValueEscape = false;
+		}
+		else if(c == '\\')
+		{
+			m_ValueEscape = true;
+		}
+		else if(c == '"')
+		{
+			m_ValueString = false;
+			if(m_ValueDepth == 0)
+			{
+				return SCAN_DONE_INCLUSIVE;
+			}
+		}
+		return SCAN_CONTINUE;
+	}
+	if(m_ValueScalar)
+	{
+		if(c == ',' || c == ']' || c == '}' || IsJsonWhitespace(c))
+		{
+			return SCAN_DONE_EXCLUSIVE;
+		}
+		return SCAN_CONTINUE;
+	}
+	if(c == '"')
+	{
+		m_ValueString = true;
+	}
+	else if(c == '{' || c == '[')
+	{
+		m_ValueDepth++;
+	}
+	else if(c == '}' || c == ']')
+	{
+		m_ValueDepth--;
+		if(m_ValueDepth == 0)
+		{
+			return SCAN_DONE_INCLUSIVE;
+		}
+	}
+	return SCAN_CONTINUE;
+}
+
+bool CJsonStreamParser::EmitElement()
+{
+	json_value *pValue = json_parse_ex(&m_Settings, m_vElement.data(), m_vElement.size(), nullptr);
+	m_vElement.clear();
+	if(!pValue)
+	{
+		return true;
+	}
+	bool Error = OnArrayElement(m_aKey, pValue);
+	// `json_value_free_ex` doesn't fall back to `free`.
+	if(m_Settings.mem_free)
+	{
+		json_value_free_ex(&m_Settings, pValue);
+	}
+	else
+	{
+		json_value_free(pValue);
+	}
+	return Error;
+}
+
+bool CJsonStreamParser::Step(char c)
+{
+	switch(m_State)
+	{
+	case STATE_START:
+		if(c == '{')
+		{
+			m_State = STATE_KEY_OR_END;
+		}
+		else if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	case STATE_KEY_OR_END:
+	case STATE_KEY:
+		if(c == '"')
+		{
+			m_KeyLength = 0;
+			m_KeyEscape = false;
+			m_State = STATE_KEY_STRING;
+		}
+		else if(c == '}' && m_State == STATE_KEY_OR_END)
+		{
+			m_State = STATE_END;
+		}
+		else if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	case STATE_KEY_STRING:
+		// Escape sequences are kept verbatim, keys are only compared
+		// against plain ASCII names.
+		if(!m_KeyEscape && c == '"')
+		{
+			m_aKey[m_KeyLength] = 0;
+			m_State = STATE_COLON;
+			return true;
+		}
+		m_KeyEscape = !m_KeyEscape && c == '\\';
+		if(m_KeyLength < MAX_KEY_LENGTH - 1)
+		{
+			m_aKey[m_KeyLength++] = c;
+		}
+		return true;
+	case STATE_COLON:
+		if(c == ':')
+		{
+			m_State = STATE_MEMBER;
+		}
+		else if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	case STATE_MEMBER:
+		if(IsJsonWhitespace(c))
+		{
+			return true;
+		}
+		if(c == ',' || c == '}' || c == ']' || c == ':')
+		{
+			m_Error = true;
+			return true;
+		}
+		if(OnMember(m_aKey, c == '['))
+		{
+			m_Error = true;
+			return true;
+		}
+		if(c == '[')
+		{
+			m_State = STATE_ELEMENT_OR_END;
+		}
+		else
+		{
+			BeginValue(c);
+			m_State = STATE_MEMBER_SKIP;
+		}
+		return true;
+	case STATE_MEMBER_SKIP:
+		switch(ScanValue(c))
+		{
+		case SCAN_DONE_INCLUSIVE:
+			m_State = STATE_MEMBER_COMMA_OR_END;
+			return true;
+		case SCAN_DONE_EXCLUSIVE:
+			m_State = STATE_MEMBER_COMMA_OR_END;
+			return false;
+		}
+		return true;
+	case STATE_MEMBER_COMMA_OR_END:
+		if(c == ',')
+		{
+			m_State = STATE_KEY;
+		}
+		else if(c == '}')
+		{
+			m_State = STATE_END;
+		}
+		else if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	case STATE_ELEMENT_OR_END:
+	case STATE_ELEMENT:
+		if(IsJsonWhitespace(c))
+		{
+			return true;
+		}
+		if(c == ']' && m_State == STATE_ELEMENT_OR_END)
+		{
+			m_State = STATE_MEMBER_COMMA_OR_END;
+			return true;
+		}
+		if(c == ',' || c == '}' || c == ']' || c == ':')
+		{
+			m_Error = true;
+			return true;
+		}
+		BeginValue(c);
+		m_vElement.push_back(c);
+		m_State = STATE_ELEMENT_VALUE;
+		return true;
+	case STATE_ELEMENT_VALUE:
+		switch(ScanValue(c))
+		{
+		case SCAN_CONTINUE:
+			m_vElement.push_back(c);
+			return true;
+		case SCAN_DONE_INCLUSIVE:
+			m_vElement.push_back(c);
+			m_State = STATE_ELEMENT_COMMA_OR_END;
+			m_Error = EmitElement();
+			return true;
+		case SCAN_DONE_EXCLUSIVE:
+			m_State = STATE_ELEMENT_COMMA_OR_END;
+			m_Error = EmitElement();
+			return false;
+		}
+		return true;
+	case STATE_ELEMENT_COMMA_OR_END:
+		if(c == ',')
+		{
+			m_State = STATE_ELEMENT;
+		}
+		else if(c == ']')
+		{
+			m_State = STATE_MEMBER_COMMA_OR_END;
+		}
+		else if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	case STATE_END:
+		if(!IsJsonWhitespace(c))
+		{
+			m_Error = true;
+		}
+		return true;
+	}
+	dbg_assert(false, "invalid json stream parser state");
+	return true;
+}
@@ -3,6 +3,8 @@
 
 #include <engine/external/json-parser/json.h>
 
+#include <vector>
+
 const struct _json_value *json_object_get(const json_value *object, const char *index);
 const struct _json_value *json_array_get(const json_value *array, int index);
 int json_array_length(const json_value *array);
@@ -13,4 +15,101 @@ int json_boolean_get(const json_value *boolean);
 char *EscapeJson(char *pBuffer, int BufferSize, const char *pString);
 const char *JsonBool(bool Bool);
 
+/**
+ * Incremental parser for documents of the form `{"key": [elem, elem, ...], ...}`.
+ *
+ * The input can be fed in arbitrarily sized pieces, e.g. while it is still
+ * being downloaded. Only the top-level object is tracked by the parser
+ * itself, each element of an array that is a member of the top-level object
+ * is parsed on its own as soon as it is complete and handed to
+ * `OnArrayElement`. This way, only a single element is ever held as a
+ * `json_value` tree instead of the whole document.
+ *
+ * Members that are not arrays are skipped.
+ */
+class CJsonStreamParser
+{
+public:
+	virtual ~CJsonStreamParser() = default;
+
+	/**
+	 * Feeds the next piece of the document to the parser.
+	 *
+	 * @return `true` on error. All further calls fail after an error.
+	 */
+	bool Feed(const char *pData, size_t DataSize);
+
+	/**
+	 * Signals the end of the document.
+	 *
+	 * @return `true` if the document was invalid or incomplete.
+	 */
+	bool Finish();
+
+	bool Error() const { return m_Error; }
+
+protected:
+	/**
+	 * Called when the value of a member of the top-level object starts.
+	 *
+	 * @return `true` to abort parsing with an error.
+	 */
+	virtual bool OnMember(const char *pKey, bool IsArray) { return false; }
+
+	/**
+	 * Called for every complete element of an array that is a member of
+	 * the top-level object. `pValue` is freed after the call.
+	 *
+	 * @return `true` to abort parsing with an error.
+	 */
+	virtual bool OnArrayElement(const char *pKey, const json_value *pValue) = 0;
+
+	// Settings for parsing the array elements, e.g. a custom allocator.
+	json_settings m_Settings = {};
+
+private:
+	enum
+	{
+		STATE_START,
+		STATE_KEY_OR_END,
+		STATE_KEY,
+		STATE_KEY_STRING,
+		STATE_COLON,
+		STATE_MEMBER,
+		STATE_MEMBER_SKIP,
+		STATE_MEMBER_COMMA_OR_END,
+		STATE_ELEMENT_OR_END,
+		STATE_ELEMENT,
+		STATE_ELEMENT_VALUE,
+		STATE_ELEMENT_COMMA_OR_END,
+		STATE_END,
+
+		SCAN_CONTINUE = 0,
+		SCAN_DONE_INCLUSIVE,
+		SCAN_DONE_EXCLUSIVE,
+
+		MAX_KEY_LENGTH = 64,
+	};
+
+	// Returns `true` if the character was consumed.
+	bool Step(char c);
+	void BeginValue(char c);
+	int ScanValue(char c);
+	bool EmitElement();
+
+	int m_State = STATE_START;
+	bool m_Error = false;
+
+	char m_aKey[MAX_KEY_LENGTH] = {0};
+	int m_KeyLength = 0;
+	bool m_KeyEscape = false;
+
+	// State of the value currently being skipped or collected.
+	int m_ValueDepth = 0;
+	bool m_ValueString = false;
+	bool m_ValueEscape = false;
+	bool m_ValueScalar = false;
+	std::vector<char> m_vElement;
+};
+
 #endif // ENGINE_SHARED_JSON_H
@@ -6,91 +6,316 @@
 
 #include "netban.h"
 
-CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
+#include <algorithm>
+
+static int RootNode(int Type)
+{
+	return Type == NETTYPE_IPV6 ? 1 : 0;
+}
+
+static int AddrBits(int Type)
 {
-	if(pAddr->type == NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3]) & 0xFF;
+	return Type == NETTYPE_IPV6 ? 128 : 32;
+}
+
+static int GetBit(const unsigned char *pKey, int Bit)
+{
+	return (pKey[Bit / 8] >> (7 - Bit % 8)) & 1;
+}
+
+static void SetBit(unsigned char *pKey, int Bit, int Value)
+{
+	if(Value)
+		pKey[Bit / 8] |= 1 << (7 - Bit % 8);
 	else
-		m_Hash = (pAddr->ip[0] + pAddr->ip[1] + pAddr->ip[2] + pAddr->ip[3] + pAddr->ip[4] + pAddr->ip[5] + pAddr->ip[6] + pAddr->ip[7] +
-				 pAddr->ip[8] + pAddr->ip[9] + pAddr->ip[10] + pAddr->ip[11] + pAddr->ip[12] + pAddr->ip[13] + pAddr->ip[14] + pAddr->ip[15]) &
-			 0xFF;
-	m_HashIndex = 0;
+		pKey[Bit / 8] &= ~(1 << (7 - Bit % 8));
+}
+
+// number of leading bits that are the same in both keys, at most `MaxBits`
+static int CommonBits(const unsigned char *pKey1, const unsigned char *pKey2, int MaxBits)
+{
+	int Bits = 0;
+	while(Bits + 8 <= MaxBits && pKey1[Bits / 8] == pKey2[Bits / 8])
+		Bits += 8;
+	while(Bits < MaxBits && GetBit(pKey1, Bits) == GetBit(pKey2, Bits))
+		Bits++;
+	return Bits;
 }
 
-CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
+// Calls `Visit(pKey, Length)` in order for the fewest prefixes that together
+// contain exactly the addresses from `pLB` to `pUB`, until it returns false.
+// The bits of `pPrefix` from `Length` on must be zero.
+template<typename F>
+static bool VisitRangePrefixes(const unsigned char *pLB, const unsigned char *pUB, int Bytes, unsigned char *pPrefix, int Length, F &&Visit)
 {
-	m_Hash = 0;
-	m_HashIndex = 0;
-	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
+	// the first and the last address with the prefix
+	unsigned char aLast[16];
+	mem_copy(aLast, pPrefix, Bytes);
+	for(int Bit = Length; Bit < Bytes * 8; Bit++)
+		SetBit(aLast, Bit, 1);
+
+	if(mem_comp(aLast, pLB, Bytes) < 0 || mem_comp(pPrefix, pUB, Bytes) > 0)
+		return true;
+	if(mem_comp(pPrefix, pLB, Bytes) >= 0 && mem_comp(aLast, pUB, Bytes) <= 0)
+		return Visit(pPrefix, Length);
+
+	bool Continue = VisitRangePrefixes(pLB, pUB, Bytes, pPrefix, Length + 1, Visit);
+	if(Continue)
 	{
-		m_Hash += pRange->m_LB.ip[i];
-		++m_HashIndex;
+		SetBit(pPrefix, Length, 1);
+		Continue = VisitRangePrefixes(pLB, pUB, Bytes, pPrefix, Length + 1, Visit);
+		SetBit(pPrefix, Length, 0);
 	}
-	m_Hash &= 0xFF;
+	return Continue;
+}
+
+template<typename F>
+static void VisitPrefixes(const NETADDR *pAddr, F &&Visit)
+{
+	Visit(pAddr->ip, AddrBits(pAddr->type));
+}
+
+template<typename F>
+static void VisitPrefixes(const CNetRange *pRange, F &&Visit)
+{
+	unsigned char aPrefix[16] = {0};
+	VisitRangePrefixes(pRange->m_LB.ip, pRange->m_UB.ip, AddrBits(pRange->m_LB.type) / 8, aPrefix, 0, Visit);
 }
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
+static int NetType(const NETADDR *pAddr)
 {
-	int Length = pAddr->type == NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
+	return pAddr->type;
+}
+
+static int NetType(const CNetRange *pRange)
+{
+	return pRange->m_LB.type;
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Clear()
+{
+	m_vNodes.clear();
+	m_vFreeNodes.clear();
+	const unsigned char aZero[16] = {0};
+	NewNode(aZero, 0, -1);
+	NewNode(aZero, 0, -1);
+}
+
+template<class T>
+int CNetBan::CBanTrie<T>::NewNode(const unsigned char *pKey, int Length, int Parent)
+{
+	int Node;
+	if(!m_vFreeNodes.empty())
 	{
-		Sum += pAddr->ip[i - 1];
-		aHash[i].m_Hash = Sum & 0xFF;
-		aHash[i].m_HashIndex = i % Length;
+		Node = m_vFreeNodes.back();
+		m_vFreeNodes.pop_back();
 	}
-	return Length;
+	else
+	{
+		Node = m_vNodes.size();
+		m_vNodes.emplace_back();
+	}
+
+	CNode &New = m_vNodes[Node];
+	mem_zero(New.m_aKey, sizeof(New.m_aKey));
+	mem_copy(New.m_aKey, pKey, (Length + 7) / 8);
+	if(Length % 8)
+		New.m_aKey[Length / 8] &= 0xff << (8 - Length % 8);
+	New.m_Length = Length;
+	New.m_Parent = Parent;
+	New.m_aChildren[0] = New.m_aChildren[1] = -1;
+	New.m_vpBans.clear();
+	return Node;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::InsertUsed(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanTrie<T>::FindNode(int Root, const unsigned char *pKey, int Length) const
 {
-	if(m_pFirstUsed)
+	int Node = Root;
+	while(m_vNodes[Node].m_Length < Length)
 	{
-		for(CBan<T> *p = m_pFirstUsed;; p = p->m_pNext)
+		const CNode &Parent = m_vNodes[Node];
+		Node = Parent.m_aChildren[GetBit(pKey, Parent.m_Length)];
+		if(Node == -1 || m_vNodes[Node].m_Length > Length || CommonBits(pKey, m_vNodes[Node].m_aKey, m_vNodes[Node].m_Length) < m_vNodes[Node].m_Length)
+			return -1;
+	}
+	return Node;
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Insert(const T *pData, CBan<T> *pBan)
+{
+	int Root = RootNode(NetType(pData));
+	VisitPrefixes(pData, [&](const unsigned char *pKey, int Length) {
+		int Node = Root;
+		while(m_vNodes[Node].m_Length < Length)
 		{
-			if(p->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pBan->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && pBan->m_Info.m_Expires <= p->m_Info.m_Expires))
+			int Bit = GetBit(pKey, m_vNodes[Node].m_Length);
+			int Child = m_vNodes[Node].m_aChildren[Bit];
+			if(Child == -1)
+			{
+				Child = NewNode(pKey, Length, Node);
+				m_vNodes[Node].m_aChildren[Bit] = Child;
+			}
+			else
 			{
-				// insert before
-				pBan->m_pNext = p;
-				pBan->m_pPrev = p->m_pPrev;
-				if(p->m_pPrev)
-					p->m_pPrev->m_pNext = pBan;
-				else
-					m_pFirstUsed = pBan;
-				p->m_pPrev = pBan;
-				break;
+				int Common = CommonBits(pKey, m_vNodes[Child].m_aKey, minimum(Length, m_vNodes[Child].m_Length));
+				if(Common < m_vNodes[Child].m_Length)
+				{
+					// split the edge to the child where the keys differ
+					int Split = NewNode(pKey, Common, Node);
+					m_vNodes[Node].m_aChildren[Bit] = Split;
+					m_vNodes[Split].m_aChildren[GetBit(m_vNodes[Child].m_aKey, Common)] = Child;
+					m_vNodes[Child].m_Parent = Split;
+					Child = Split;
+				}
 			}
+			Node = Child;
+		}
+		m_vNodes[Node].m_vpBans.push_back(pBan);
+		return true;
+	});
+}
+
+template<class T>
+void CNetBan::CBanTrie<T>::Remove(const T *pData, CBan<T> *pBan)
+{
+	int Root = RootNode(NetType(pData));
+	VisitPrefixes(pData, [&](const unsigned char *pKey, int Length) {
+		int Node = FindNode(Root, pKey, Length);
+		dbg_assert(Node != -1, "ban missing in trie");
+		std::vector<CBan<T> *> &vpBans = m_vNodes[Node].m_vpBans;
+		vpBans.erase(std::find(vpBans.begin(), vpBans.end(), pBan));
+		Prune(Node);
+		return true;
+	});
+}
 
-			if(!p->m_pNext)
+// removes the node if it's not needed anymore, and its parents as well
+template<class T>
+void CNetBan::CBanTrie<T>::Prune(int Node)
+{
+	while(m_vNodes[Node].m_Parent != -1 && m_vNodes[Node].m_vpBans.empty())
+	{
+		const CNode &Current = m_vNodes[Node];
+		if(Current.m_aChildren[0] != -1 && Current.m_aChildren[1] != -1)
+			return;
+
+		int Parent = Current.m_Parent;
+		int Child = Current.m_aChildren[0] != -1 ? Current.m_aChildren[0] : Current.m_aChildren[1];
+		m_vNodes[Parent].m_aChildren[m_vNodes[Parent].m_aChildren[0] == Node ? 0 : 1] = Child;
+		m_vFreeNodes.push_back(Node);
+		if(Child != -1)
+		{
+			m_vNodes[Child].m_Parent = Parent;
+			return;
+		}
+		Node = Parent;
+	}
+}
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanTrie<T>::Find(const T *pData) const
+{
+	// every prefix of a ban has it, so checking the first one is enough
+	CBan<T> *pFound = nullptr;
+	int Root = RootNode(NetType(pData));
+	VisitPrefixes(pData, [&](const unsigned char *pKey, int Length) {
+		int Node = FindNode(Root, pKey, Length);
+		if(Node != -1)
+		{
+			for(CBan<T> *pBan : m_vNodes[Node].m_vpBans)
 			{
-				// last entry
-				p->m_pNext = pBan;
-				pBan->m_pPrev = p;
-				pBan->m_pNext = 0;
-				break;
+				if(NetComp(&pBan->m_Data, pData) == 0)
+				{
+					pFound = pBan;
+					break;
+				}
 			}
 		}
+		return false;
+	});
+	return pFound;
+}
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanTrie<T>::Match(const NETADDR *pAddr) const
+{
+	int Bits = AddrBits(pAddr->type);
+	int Node = RootNode(pAddr->type);
+	while(true)
+	{
+		const CNode &Current = m_vNodes[Node];
+		if(!Current.m_vpBans.empty())
+			return Current.m_vpBans.front();
+		if(Current.m_Length == Bits)
+			return nullptr;
+		Node = Current.m_aChildren[GetBit(pAddr->ip, Current.m_Length)];
+		if(Node == -1 || CommonBits(pAddr->ip, m_vNodes[Node].m_aKey, m_vNodes[Node].m_Length) < m_vNodes[Node].m_Length)
+			return nullptr;
 	}
-	else
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::InsertUsed(CBan<T> *pBan)
+{
+	// the used list is sorted by expiry, look for the place from the end as
+	// bans are mostly added with the latest expiry, e.g. permanent ones
+	CBan<T> *pBefore = m_pLastUsed;
+	while(pBefore && pBefore->m_Info.m_Expires != pBan->m_Info.m_Expires &&
+		(pBefore->m_Info.m_Expires == CBanInfo::EXPIRES_NEVER || (pBan->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && pBan->m_Info.m_Expires < pBefore->m_Info.m_Expires)))
 	{
-		m_pFirstUsed = pBan;
-		pBan->m_pNext = pBan->m_pPrev = 0;
+		pBefore = pBefore->m_pPrev;
 	}
+
+	pBan->m_pPrev = pBefore;
+	pBan->m_pNext = pBefore ? pBefore->m_pNext : m_pFirstUsed;
+	if(pBan->m_pNext)
+		pBan->m_pNext->m_pPrev = pBan;
+	else
+		m_pLastUsed = pBan;
+	if(pBefore)
+		pBefore->m_pNext = pBan;
+	else
+		m_pFirstUsed = pBan;
+}
+
+template<class T>
+void CNetBan::CBanPool<T>::RemoveUsed(CBan<T> *pBan)
+{
+	if(pBan->m_pNext)
+		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
+	else
+		m_pLastUsed = pBan->m_pPrev;
+	if(pBan->m_pPrev)
+		pBan->m_pPrev->m_pNext = pBan->m_pNext;
+	else
+		m_pFirstUsed = pBan->m_pNext;
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo, const CNetHash *pNetHash)
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Add(const T *pData, const CBanInfo *pInfo)
 {
 	if(!m_pFirstFree)
-		return 0;
+	{
+		if(IsFull())
+			return 0;
+
+		m_vpBlocks.push_back(std::make_unique<CBan<T>[]>(BLOCK_SIZE));
+		CBan<T> *pBlock = m_vpBlocks.back().get();
+		for(int i = 0; i < BLOCK_SIZE; ++i)
+		{
+			pBlock[i].m_pPrev = i > 0 ? &pBlock[i - 1] : 0;
+			pBlock[i].m_pNext = i < BLOCK_SIZE - 1 ? &pBlock[i + 1] : 0;
+		}
+		m_pFirstFree = pBlock;
+	}
 
 	// create new ban
 	CBan<T> *pBan = m_pFirstFree;
 	pBan->m_Data = *pData;
 	pBan->m_Info = *pInfo;
-	pBan->m_NetHash = *pNetHash;
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
 	if(pBan->m_pPrev)
@@ -98,12 +323,8 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	else
 		m_pFirstFree = pBan->m_pNext;
 
-	// add it to the hash list
-	if(m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = 0;
-	pBan->m_pHashNext = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
+	// add it to the trie
+	m_Trie.Insert(pData, pBan);
 
 	// insert it into the used list
 	InsertUsed(pBan);
@@ -114,28 +335,17 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	return pBan;
 }
 
-template<class T, int HashCount>
-int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanPool<T>::Remove(CBan<T> *pBan)
 {
 	if(pBan == 0)
 		return -1;
 
-	// remove from hash list
-	if(pBan->m_pHashNext)
-		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
-	if(pBan->m_pHashPrev)
-		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
-	else
-		m_aapHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
-	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
+	// remove from trie
+	m_Trie.Remove(&pBan->m_Data, pBan);
 
 	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
+	RemoveUsed(pBan);
 
 	// add to recycle list
 	if(m_pFirstFree)
@@ -150,50 +360,37 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
+template<class T>
+void CNetBan::CBanPool<T>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
 	pBan->m_Info = *pInfo;
 
-	// remove from used list
-	if(pBan->m_pNext)
-		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
-	if(pBan->m_pPrev)
-		pBan->m_pPrev->m_pNext = pBan->m_pNext;
-	else
-		m_pFirstUsed = pBan->m_pNext;
-
-	// insert it into the used list
+	// move it to its new place in the used list
+	RemoveUsed(pBan);
 	InsertUsed(pBan);
 }
 
 void CNetBan::UnbanAll()
 {
+	std::lock_guard<std::mutex> Lock(m_Mutex);
 	m_BanAddrPool.Reset();
 	m_BanRangePool.Reset();
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Reset()
+template<class T>
+void CNetBan::CBanPool<T>::Reset()
 {
-	mem_zero(m_aapHashList, sizeof(m_aapHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
+	m_vpBlocks.clear();
+	m_pFirstFree = 0;
 	m_pFirstUsed = 0;
+	m_pLastUsed = 0;
 	m_CountUsed = 0;
-
-	for(int i = 1; i < MAX_BANS - 1; ++i)
-	{
-		m_aBans[i].m_pNext = &m_aBans[i + 1];
-		m_aBans[i].m_pPrev = &m_aBans[i - 1];
-	}
-
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS - 1].m_pPrev = &m_aBans[MAX_BANS - 2];
-	m_pFirstFree = &m_aBans[0];
+	m_Trie.Clear();
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Get(int Index) const
+
 {
 	if(Index < 0 || Index >= Num())
 		return 0;
@@ -210,6 +407,8 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
 template<class T>
 int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason)
 {
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
 	// do not ban localhost
 	if(NetMatch(pData, &m_LocalhostIPV4) || NetMatch(pData, &m_LocalhostIPV6))
 	{
@@ -225,8 +424,7 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	str_copy(Info.m_aReason, pReason);
 
 	// check if it already exists
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		// adjust the ban
@@ -238,7 +436,7 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	}
 
 	// add ban and print result
-	pBan = pBanPool->Add(pData, &Info, &NetHash);
+	pBan = pBanPool->Add(pData, &Info);
 	if(pBan)
 	{
 		char aBuf[128];
@@ -254,8 +452,8 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 template<class T>
 int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 {
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		char aBuf[256];
@@ -286,10 +484,12 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "?i[page]", CFGFLAG_SERVER | CFGFLAG_MASTER, ConBans, this, "Show banlist (page 0 by default, 20 entries per page)");
 	Console()->Register("bans_save", "s[file]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_load", "s[file]", CFGFLAG_SERVER | CFGFLAG_MASTER | CFGFLAG_STORE, ConBansLoad, this, "Load banlist saved by bans_save, faster than executing it");
 }
 
 void CNetBan::Update()
 {
+	std::lock_guard<std::mutex> Lock(m_Mutex);
 	int Now = time_timestamp();
 
 	// remove expired bans
@@ -338,6 +538,7 @@ int CNetBan::UnbanByRange(const CNetRange *pRange)
 
 int CNetBan::UnbanByIndex(int Index)
 {
+	std::lock_guard<std::mutex> Lock(m_Mutex);
 	int Result;
 	char aBuf[256];
 	CBanAddr *pBan = m_BanAddrPool.Get(Index);
@@ -369,6 +570,7 @@ int CNetBan::UnbanByIndex(int Index)
 
 bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize) const
 {
+	std::lock_guard<std::mutex> Lock(m_Mutex);
 	NETADDR Addr;
 	const NETADDR *pAddr = pOrigAddr;
 	if(pOrigAddr->type == NETTYPE_WEBSOCKET_IPV4)
@@ -377,11 +579,9 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 		pAddr = &Addr;
 		Addr.type = NETTYPE_IPV4;
 	}
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
 
 	// check ban addresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Match(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER);
@@ -389,19 +589,109 @@ bool CNetBan::IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize
 	}
 
 	// check ban ranges
-	for(int i = Length - 1; i >= 0; --i)
+	CBanRange *pBanRange = m_BanRangePool.Match(pAddr);
+	if(pBanRange)
+	{
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
+		return true;
+	}
+
+	return false;
+}
+
+template<class T>
+bool CNetBan::ImportBan(T *pBanPool, const typename T::CDataType *pData, const CBanInfo *pInfo)
+{
+	// do not ban localhost
+	if(NetMatch(pData, &m_LocalhostIPV4) || NetMatch(pData, &m_LocalhostIPV6))
+		return false;
+
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
+	if(pBan)
+	{
+		pBanPool->Update(pBan, pInfo);
+		return true;
+	}
+	return pBanPool->Add(pData, pInfo) != 0;
+}
+
+int CNetBan::ImportBans(const char *pBanlist)
+{
+	struct CImportedBan
 	{
-		for(CBanRange *pBanRange = m_BanRangePool.First(&aHash[i]); pBanRange; pBanRange = pBanRange->m_pHashNext)
+		bool m_IsRange;
+		// only `m_LB` for addresses
+		CNetRange m_Range;
+		CBanInfo m_Info;
+	};
+	std::vector<CImportedBan> vBans;
+
+	int Now = time_timestamp();
+	int NumInvalid = 0;
+	char aLine[512];
+	while(*pBanlist)
+	{
+		const char *pLineEnd = str_find(pBanlist, "\n");
+		if(!pLineEnd)
+			pLineEnd = pBanlist + str_length(pBanlist);
+		str_truncate(aLine, sizeof(aLine), pBanlist, pLineEnd - pBanlist);
+		pBanlist = *pLineEnd ? pLineEnd + 1 : pLineEnd;
+		int Length = str_length(aLine);
+		if(Length > 0 && aLine[Length - 1] == '\r')
+			aLine[Length - 1] = 0;
+		if(!aLine[0])
+			continue;
+
+		// same format as `bans_save` writes: "ban <ip> <minutes> <reason>"
+		// or "ban_range <first ip> <last ip> <minutes> <reason>"
+		CImportedBan Ban;
+		char aCommand[16], aLB[NETADDR_MAXSTRSIZE], aUB[NETADDR_MAXSTRSIZE], aMinutes[16];
+		const char *pRest = str_next_token(aLine, " ", aCommand, sizeof(aCommand));
+		Ban.m_IsRange = pRest && str_comp(aCommand, "ban_range") == 0;
+		if(!pRest || (!Ban.m_IsRange && str_comp(aCommand, "ban") != 0))
 		{
-			if(NetMatch(&pBanRange->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER);
-				return true;
-			}
+			NumInvalid++;
+			continue;
+		}
+		pRest = str_next_token(pRest, " ", aLB, sizeof(aLB));
+		if(pRest && Ban.m_IsRange)
+			pRest = str_next_token(pRest, " ", aUB, sizeof(aUB));
+		if(pRest)
+			pRest = str_next_token(pRest, " ", aMinutes, sizeof(aMinutes));
+		if(!pRest || net_addr_from_str(&Ban.m_Range.m_LB, aLB) != 0 ||
+			(Ban.m_IsRange && (net_addr_from_str(&Ban.m_Range.m_UB, aUB) != 0 || !Ban.m_Range.IsValid())))
+		{
+			NumInvalid++;
+			continue;
 		}
+
+		// like `ban` and `ban_range`, so -1 becomes permanent
+		int Minutes = clamp(str_toint(aMinutes), 0, 525600);
+		Ban.m_Info.m_Expires = Minutes > 0 ? Now + Minutes * 60 : CBanInfo::EXPIRES_NEVER;
+		pRest = str_utf8_skip_whitespaces(pRest);
+		str_copy(Ban.m_Info.m_aReason, pRest[0] ? pRest : "No reason given");
+		vBans.push_back(Ban);
 	}
 
-	return false;
+	// in the order of the used lists, so that each ban is inserted at the end
+	std::stable_sort(vBans.begin(), vBans.end(), [](const CImportedBan &Left, const CImportedBan &Right) {
+		return Right.m_Info.m_Expires == CBanInfo::EXPIRES_NEVER ? Left.m_Info.m_Expires != CBanInfo::EXPIRES_NEVER : (Left.m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && Left.m_Info.m_Expires < Right.m_Info.m_Expires);
+	});
+
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	int NumImported = 0;
+	for(const CImportedBan &Ban : vBans)
+	{
+		if(Ban.m_IsRange)
+			NumImported += ImportBan(&m_BanRangePool, &Ban.m_Range, &Ban.m_Info);
+		else
+			NumImported += ImportBan(&m_BanAddrPool, &Ban.m_Range.m_LB, &Ban.m_Info);
+	}
+
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "imported %d of %d bans, %d invalid lines", NumImported, (int)vBans.size(), NumInvalid);
+	Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+	return NumImported;
 }
 
 void CNetBan::ConBan(IConsole::IResult *pResult, void *pUser)
@@ -546,3 +836,19 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	str_format(aBuf, sizeof(aBuf), "saved banlist to '%s'", pResult->GetString(0));
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
+
+void CNetBan::ConBansLoad(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	char *pBanlist = pThis->Storage()->ReadFileStr(pResult->GetString(0), IStorage::TYPE_ALL);
+	if(!pBanlist)
+	{
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "failed to load banlist from '%s'", pResult->GetString(0));
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return;
+	}
+	pThis->ImportBans(pBanlist);
+	free(pBanlist);
+}
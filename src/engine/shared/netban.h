@@ -5,6 +5,10 @@
 
 #include <base/system.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
 	return mem_comp(pAddr1, pAddr2, pAddr1->type == NETTYPE_IPV4 ? 8 : 20);
@@ -60,19 +64,6 @@ protected:
 		return pBuffer;
 	}
 
-	class CNetHash
-	{
-	public:
-		int m_Hash;
-		int m_HashIndex; // matching parts for ranges, 0 for addr
-
-		CNetHash() {}
-		CNetHash(const NETADDR *pAddr);
-		CNetHash(const CNetRange *pRange);
-
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
-	};
-
 	struct CBanInfo
 	{
 		enum
@@ -89,24 +80,54 @@ protected:
 	{
 		T m_Data;
 		CBanInfo m_Info;
-		CNetHash m_NetHash;
-
-		// hash list
-		CBan *m_pHashNext;
-		CBan *m_pHashPrev;
 
 		// used or free list
 		CBan *m_pNext;
 		CBan *m_pPrev;
 	};
 
-	template<class T, int HashCount>
+	// Compressed binary trie over the address prefixes of the bans, so that
+	// lookups take O(address bits) however many bans there are. Ranges are
+	// stored as the fewest prefixes that make them up, addresses as prefixes
+	// of full length.
+	template<class T>
+	class CBanTrie
+	{
+	public:
+		void Clear();
+		void Insert(const T *pData, CBan<T> *pBan);
+		void Remove(const T *pData, CBan<T> *pBan);
+		CBan<T> *Find(const T *pData) const;
+		// returns any ban containing the address
+		CBan<T> *Match(const NETADDR *pAddr) const;
+
+	private:
+		struct CNode
+		{
+			// the bits after `m_Length` are zero
+			unsigned char m_aKey[16];
+			int m_Length;
+			int m_Parent;
+			int m_aChildren[2];
+			std::vector<CBan<T> *> m_vpBans;
+		};
+
+		// the first two nodes are the roots for IPv4 and IPv6
+		std::vector<CNode> m_vNodes;
+		std::vector<int> m_vFreeNodes;
+
+		int NewNode(const unsigned char *pKey, int Length, int Parent);
+		int FindNode(int Root, const unsigned char *pKey, int Length) const;
+		void Prune(int Node);
+	};
+
+	template<class T>
 	class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
-		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
+		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
@@ -115,36 +136,31 @@ protected:
 		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
-		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
-		{
-			for(CBan<CDataType> *pBan = m_aapHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
-			{
-				if(NetComp(&pBan->m_Data, pData) == 0)
-					return pBan;
-			}
-
-			return 0;
-		}
+		CBan<CDataType> *Find(const CDataType *pData) const { return m_Trie.Find(pData); }
+		CBan<CDataType> *Match(const NETADDR *pAddr) const { return m_Trie.Match(pAddr); }
 		CBan<CDataType> *Get(int Index) const;
 
 	private:
 		enum
 		{
-			MAX_BANS = 1024,
+			MAX_BANS = 1 << 18,
+			BLOCK_SIZE = 1024,
 		};
 
-		CBan<CDataType> *m_aapHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
+		// allocated block by block, the bans never move
+		std::vector<std::unique_ptr<CBan<CDataType>[]>> m_vpBlocks;
 		CBan<CDataType> *m_pFirstFree;
 		CBan<CDataType> *m_pFirstUsed;
+		CBan<CDataType> *m_pLastUsed;
 		int m_CountUsed;
+		CBanTrie<CDataType> m_Trie;
 
 		void InsertUsed(CBan<CDataType> *pBan);
+		void RemoveUsed(CBan<CDataType> *pBan);
 	};
 
-	typedef CBanPool<NETADDR, 1> CBanAddrPool;
-	typedef CBanPool<CNetRange, 16> CBanRangePool;
+	typedef CBanPool<NETADDR> CBanAddrPool;
+	typedef CBanPool<CNetRange> CBanRangePool;
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
 
@@ -154,6 +170,8 @@ protected:
 	int Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, const char *pReason);
 	template<class T>
 	int Unban(T *pBanPool, const typename T::CDataType *pData);
+	template<class T>
+	bool ImportBan(T *pBanPool, const typename T::CDataType *pData, const CBanInfo *pInfo);
 
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
@@ -161,6 +179,10 @@ protected:
 	CBanRangePool m_BanRangePool;
 	NETADDR m_LocalhostIPV4, m_LocalhostIPV6;
 
+	// The bans are only changed by the main thread, but the server's
+	// network thread checks them as well.
+	mutable std::mutex m_Mutex;
+
 public:
 	enum
 	{
@@ -184,6 +206,10 @@ public:
 	int UnbanByIndex(int Index);
 	void UnbanAll();
 	bool IsBanned(const NETADDR *pOrigAddr, char *pBuf, unsigned BufferSize) const;
+	// Adds the bans of a banlist written by `bans_save` at once, much
+	// faster than executing it for big lists. Connected clients aren't
+	// checked. Returns the number of added or updated bans.
+	int ImportBans(const char *pBanlist);
 
 	static void ConBan(class IConsole::IResult *pResult, void *pUser);
 	static void ConBanRange(class IConsole::IResult *pResult, void *pUser);
@@ -192,6 +218,7 @@ public:
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansLoad(class IConsole::IResult *pResult, void *pUser);
 };
 
 template<class T>
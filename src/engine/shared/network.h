@@ -5,6 +5,7 @@
 
 #include "ringbuffer.h"
 #include "stun.h"
+#include "timingwheel.h"
 
 #include <base/math.h>
 #include <base/system.h>
@@ -112,6 +113,8 @@ typedef int (*NETFUNC_NEWCLIENT_CON)(int ClientID, void *pUser);
 typedef int (*NETFUNC_NEWCLIENT)(int ClientID, void *pUser, bool Sixup);
 typedef int (*NETFUNC_NEWCLIENT_NOAUTH)(int ClientID, void *pUser);
 typedef int (*NETFUNC_CLIENTREJOIN)(int ClientID, void *pUser);
+// returns true if the packet was handled, called on the network thread
+typedef bool (*NETFUNC_CONNLESS)(const struct CNetChunk *pChunk, SECURITY_TOKEN ResponseToken, void *pUser);
 
 struct CNetChunk
 {
@@ -258,7 +261,12 @@ public:
 	void Disconnect(const char *pReason);
 
 	int Update();
+	// the time until which `Update` has nothing to do, at most half a
+	// second in the future so that config changes are picked up
+	int64_t NextUpdate();
 	int Flush();
+	// chunks waiting for the next flush
+	bool HasQueuedChunks() const { return m_Construct.m_NumChunks || m_Construct.m_Flags; }
 
 	int Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr, SECURITY_TOKEN SecurityToken = NET_SECURITY_TOKEN_UNSUPPORTED);
 	int QueueChunk(int Flags, int DataSize, const void *pData);
@@ -344,6 +352,39 @@ public:
 	int FetchChunk(CNetChunk *pChunk);
 };
 
+// open addressing hash map from client addresses to slots, every slot is
+// in the map at most once
+class CNetSlotMap
+{
+	enum
+	{
+		TABLE_SIZE = NET_MAX_CLIENTS * 4,
+	};
+
+	struct CEntry
+	{
+		NETADDR m_Addr;
+		int m_Slot; // -1 for empty entries
+	};
+
+	CEntry m_aEntries[TABLE_SIZE];
+	int m_aSlotEntries[NET_MAX_CLIENTS];
+
+	static unsigned Hash(const NETADDR &Addr);
+	void RemoveEntry(int Index);
+
+public:
+	CNetSlotMap() { Clear(); }
+	void Clear();
+
+	// replaces the previous address of the slot and any other slot
+	// with the same address
+	void Set(const NETADDR &Addr, int Slot);
+	void Remove(int Slot);
+	// returns -1 if no slot has the address
+	int Find(const NETADDR &Addr) const;
+};
+
 // server side
 class CNetServer
 {
@@ -364,6 +405,9 @@ class CNetServer
 	NETSOCKET m_Socket;
 	CNetBan *m_pNetBan;
 	CSlot m_aSlots[NET_MAX_CLIENTS];
+	CNetSlotMap m_SlotMap;
+	// when each slot's connection needs its next `Update`
+	CTimingWheel<NET_MAX_CLIENTS> m_SlotTimers;
 	int m_MaxClients;
 	int m_MaxClientsPerIP;
 
@@ -385,6 +429,9 @@ class CNetServer
 
 	CNetRecvUnpacker m_RecvUnpacker;
 
+	struct CRecvThread *m_pRecvThread;
+	static void RecvThread(void *pUser);
+
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
@@ -411,6 +458,13 @@ public:
 	int Send(CNetChunk *pChunk);
 	int Update();
 
+	// Moves receiving, ban checks and unpacking to a separate thread.
+	// Connectionless packets are passed to `pfnConnless` on that thread,
+	// everything else is queued for `Recv`. Returns false on failure.
+	bool StartRecvThread(NETFUNC_CONNLESS pfnConnless, void *pUser);
+	// returns true if packets arrived within the timeout
+	bool WaitForPackets(int TimeoutUs);
+
 	//
 	int Drop(int ClientID, const char *pReason);
 
@@ -500,6 +500,39 @@ int CNetConnection::Update()
 	return 0;
 }
 
+int64_t CNetConnection::NextUpdate()
+{
+	int64_t Now = time_get();
+	int64_t Next = Now + time_freq() / 2;
+
+	if(State() == NET_CONNSTATE_ERROR)
+	{
+		if(m_TimeoutSituation)
+			Next = minimum(Next, m_LastRecvTime + time_freq() * g_Config.m_ConnTimeoutProtection);
+		return Next;
+	}
+	if(State() == NET_CONNSTATE_OFFLINE)
+		return Next;
+
+	if(State() != NET_CONNSTATE_CONNECT)
+		Next = minimum(Next, m_LastRecvTime + time_freq() * g_Config.m_ConnTimeout);
+	if(m_Buffer.First())
+	{
+		CNetChunkResend *pResend = m_Buffer.First();
+		Next = minimum(Next, pResend->m_FirstSendTime + time_freq() * g_Config.m_ConnTimeout);
+		Next = minimum(Next, pResend->m_LastSendTime + time_freq());
+	}
+	if(State() == NET_CONNSTATE_ONLINE)
+	{
+		// flush buffered chunks, otherwise only keep the connection alive
+		if(HasQueuedChunks())
+			Next = minimum(Next, m_LastSendTime + time_freq() / 2);
+		return minimum(Next, m_LastSendTime + time_freq());
+	}
+	// resend the connect or accept
+	return minimum(Next, m_LastSendTime + time_freq() / 2);
+}
+
 void CNetConnection::SetTimedOut(const NETADDR *pAddr, int Sequence, int Ack, SECURITY_TOKEN SecurityToken, CStaticRingBuffer<CNetChunkResend, NET_CONN_BUFFERSIZE> *pResendBuffer, bool Sixup)
 {
 	int64_t Now = time_get();
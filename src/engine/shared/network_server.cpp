@@ -10,6 +10,10 @@
 #include <engine/shared/packer.h>
 #include <engine/shared/protocol.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 const int g_DummyMapCrc = 0xD6909B17;
 const unsigned char g_aDummyMapData[] = {
 	0x44, 0x41, 0x54, 0x41, 0x04, 0x00, 0x00, 0x00, 0xFA, 0x00, 0x00, 0x00,
@@ -41,6 +45,153 @@ static SECURITY_TOKEN ToSecurityToken(const unsigned char *pData)
 	return (int)pData[0] | (pData[1] << 8) | (pData[2] << 16) | (pData[3] << 24);
 }
 
+unsigned CNetSlotMap::Hash(const NETADDR &Addr)
+{
+	// FNV-1a
+	unsigned Hash = 2166136261u;
+	for(unsigned char Byte : Addr.ip)
+	{
+		Hash = (Hash ^ Byte) * 16777619u;
+	}
+	Hash = (Hash ^ Addr.port) * 16777619u;
+	Hash = (Hash ^ Addr.type) * 16777619u;
+	return Hash;
+}
+
+void CNetSlotMap::Clear()
+{
+	for(auto &Entry : m_aEntries)
+		Entry.m_Slot = -1;
+	for(auto &SlotEntry : m_aSlotEntries)
+		SlotEntry = -1;
+}
+
+void CNetSlotMap::RemoveEntry(int Index)
+{
+	m_aSlotEntries[m_aEntries[Index].m_Slot] = -1;
+	m_aEntries[Index].m_Slot = -1;
+
+	// move the following entries back into the hole if it's on their probe
+	// sequence, lookups would stop at it otherwise
+	int Hole = Index;
+	for(int i = (Index + 1) % TABLE_SIZE; m_aEntries[i].m_Slot != -1; i = (i + 1) % TABLE_SIZE)
+	{
+		int Home = Hash(m_aEntries[i].m_Addr) % TABLE_SIZE;
+		if((i - Home + TABLE_SIZE) % TABLE_SIZE >= (i - Hole + TABLE_SIZE) % TABLE_SIZE)
+		{
+			m_aEntries[Hole] = m_aEntries[i];
+			m_aSlotEntries[m_aEntries[Hole].m_Slot] = Hole;
+			m_aEntries[i].m_Slot = -1;
+			Hole = i;
+		}
+	}
+}
+
+void CNetSlotMap::Set(const NETADDR &Addr, int Slot)
+{
+	Remove(Slot);
+
+	// there are at most NET_MAX_CLIENTS entries, so there is always a free one
+	int i = Hash(Addr) % TABLE_SIZE;
+	while(m_aEntries[i].m_Slot != -1 && m_aEntries[i].m_Addr != Addr)
+		i = (i + 1) % TABLE_SIZE;
+
+	if(m_aEntries[i].m_Slot != -1)
+		m_aSlotEntries[m_aEntries[i].m_Slot] = -1;
+	m_aEntries[i].m_Addr = Addr;
+	m_aEntries[i].m_Slot = Slot;
+	m_aSlotEntries[Slot] = i;
+}
+
+void CNetSlotMap::Remove(int Slot)
+{
+	if(m_aSlotEntries[Slot] != -1)
+		RemoveEntry(m_aSlotEntries[Slot]);
+}
+
+int CNetSlotMap::Find(const NETADDR &Addr) const
+{
+	for(int i = Hash(Addr) % TABLE_SIZE; m_aEntries[i].m_Slot != -1; i = (i + 1) % TABLE_SIZE)
+	{
+		if(m_aEntries[i].m_Addr == Addr)
+			return m_aEntries[i].m_Slot;
+	}
+	return -1;
+}
+
+// Packets that passed the checks of the network thread are handed to the
+// main thread through a single producer single consumer ring buffer.
+struct CRecvThread
+{
+	enum
+	{
+		QUEUE_SIZE = 1024,
+	};
+
+	struct CPacket
+	{
+		NETADDR m_Addr;
+		int m_Size;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+	};
+
+	CPacket m_aQueue[QUEUE_SIZE];
+	// next packet to push, only written by the network thread
+	std::atomic<unsigned> m_Head{0};
+	// next packet to pop, only written by the main thread
+	std::atomic<unsigned> m_Tail{0};
+	// the main thread still uses the packet at `m_Tail`
+	bool m_Popped = false;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Cond;
+	std::atomic_bool m_Stop{false};
+	void *m_pThread = nullptr;
+
+	NETFUNC_CONNLESS m_pfnConnless;
+	void *m_pUser;
+
+	CNetPacketConstruct m_Packet;
+	int m_NumDropped = 0;
+	int64_t m_LastDropReport = 0;
+
+	bool Push(const NETADDR &Addr, const unsigned char *pData, int Size)
+	{
+		unsigned Head = m_Head.load(std::memory_order_relaxed);
+		if(Head - m_Tail.load(std::memory_order_acquire) == QUEUE_SIZE)
+			return false;
+		CPacket *pPacket = &m_aQueue[Head % QUEUE_SIZE];
+		pPacket->m_Addr = Addr;
+		pPacket->m_Size = Size;
+		mem_copy(pPacket->m_aData, pData, Size);
+		m_Head.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// the returned data stays valid until the next call
+	int Pop(NETADDR *pAddr, unsigned char **ppData)
+	{
+		unsigned Tail = m_Tail.load(std::memory_order_relaxed);
+		if(m_Popped)
+		{
+			m_Tail.store(++Tail, std::memory_order_release);
+			m_Popped = false;
+		}
+		if(Tail == m_Head.load(std::memory_order_acquire))
+			return 0;
+		CPacket *pPacket = &m_aQueue[Tail % QUEUE_SIZE];
+		m_Popped = true;
+		*pAddr = pPacket->m_Addr;
+		*ppData = pPacket->m_aData;
+		return pPacket->m_Size;
+	}
+
+	bool Empty() const
+	{
+		return m_Head.load(std::memory_order_acquire) - m_Tail.load(std::memory_order_relaxed) == (m_Popped ? 1u : 0u);
+	}
+};
+
 bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int MaxClientsPerIP)
 {
 	// zero out the whole structure
@@ -67,6 +218,8 @@ bool CNetServer::Open(NETADDR BindAddr, CNetBan *pNetBan, int MaxClients, int Ma
 
 	for(auto &Slot : m_aSlots)
 		Slot.m_Connection.Init(m_Socket, true);
+	m_SlotMap.Clear();
+	m_SlotTimers.Init(time_freq() / 100, time_get());
 
 	return true;
 }
@@ -93,9 +246,132 @@ int CNetServer::Close()
 {
 	if(!m_Socket)
 		return 0;
+	if(m_pRecvThread)
+	{
+		m_pRecvThread->m_Stop = true;
+		thread_wait(m_pRecvThread->m_pThread);
+		delete m_pRecvThread;
+		m_pRecvThread = nullptr;
+	}
 	return net_udp_close(m_Socket);
 }
 
+bool CNetServer::StartRecvThread(NETFUNC_CONNLESS pfnConnless, void *pUser)
+{
+#if defined(CONF_WEBSOCKETS)
+	// libwebsockets can't be used from two threads
+	if(net_socket_type(m_Socket) & NETTYPE_WEBSOCKET_IPV4)
+	{
+		dbg_msg("netserver", "network thread is not supported with websockets");
+		return false;
+	}
+#endif
+	if(m_pRecvThread)
+		return true;
+
+	m_pRecvThread = new CRecvThread();
+	m_pRecvThread->m_pfnConnless = pfnConnless;
+	m_pRecvThread->m_pUser = pUser;
+	m_pRecvThread->m_pThread = thread_init(RecvThread, this, "net recv");
+	if(!m_pRecvThread->m_pThread)
+	{
+		delete m_pRecvThread;
+		m_pRecvThread = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void CNetServer::RecvThread(void *pUser)
+{
+	CNetServer *pThis = static_cast<CNetServer *>(pUser);
+	CRecvThread *pThread = pThis->m_pRecvThread;
+	CNetPacketConstruct *pPacket = &pThread->m_Packet;
+
+	while(!pThread->m_Stop)
+	{
+		// wake up regularly to check whether the thread should stop
+		net_socket_read_wait(pThis->m_Socket, 100000);
+
+		bool Pushed = false;
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		while((Bytes = net_udp_recv(pThis->m_Socket, &Addr, &pData)) > 0)
+		{
+			char aBuf[128];
+			if(pThis->NetBan() && pThis->NetBan()->IsBanned(&Addr, aBuf, sizeof(aBuf)))
+			{
+				CNetBase::SendControlMsg(pThis->m_Socket, &Addr, 0, NET_CTRLMSG_CLOSE, aBuf, str_length(aBuf) + 1, NET_SECURITY_TOKEN_UNSUPPORTED);
+				continue;
+			}
+
+			// same checks as in `Recv`, which unpacks the packet again
+			SECURITY_TOKEN Token;
+			SECURITY_TOKEN ResponseToken = NET_SECURITY_TOKEN_UNKNOWN;
+			bool Sixup = false;
+			if(CNetBase::UnpackPacket(pData, Bytes, pPacket, Sixup, &Token, &ResponseToken) != 0)
+				continue;
+
+			if(pPacket->m_Flags & NET_PACKETFLAG_CONNLESS)
+			{
+				if(Sixup && Token != pThis->GetToken(Addr) && Token != pThis->GetGlobalToken())
+					continue;
+
+				if(pThread->m_pfnConnless)
+				{
+					CNetChunk Chunk;
+					Chunk.m_Flags = NETSENDFLAG_CONNLESS;
+					Chunk.m_ClientID = -1;
+					Chunk.m_Address = Addr;
+					Chunk.m_DataSize = pPacket->m_DataSize;
+					Chunk.m_pData = pPacket->m_aChunkData;
+					if(pPacket->m_Flags & NET_PACKETFLAG_EXTENDED)
+					{
+						Chunk.m_Flags |= NETSENDFLAG_EXTENDED;
+						mem_copy(Chunk.m_aExtraData, pPacket->m_aExtraData, sizeof(Chunk.m_aExtraData));
+					}
+					if(pThread->m_pfnConnless(&Chunk, ResponseToken, pThread->m_pUser))
+						continue;
+				}
+			}
+			else if(pPacket->m_Flags & NET_PACKETFLAG_CONTROL && pPacket->m_DataSize == 0)
+			{
+				continue;
+			}
+
+			if(pThread->Push(Addr, pData, Bytes))
+				Pushed = true;
+			else
+				pThread->m_NumDropped++;
+		}
+
+		if(Pushed)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(pThread->m_Mutex);
+			}
+			pThread->m_Cond.notify_one();
+		}
+
+		if(pThread->m_NumDropped && time_get() - pThread->m_LastDropReport > time_freq())
+		{
+			dbg_msg("netserver", "dropped %d packets, the main thread doesn't keep up", pThread->m_NumDropped);
+			pThread->m_NumDropped = 0;
+			pThread->m_LastDropReport = time_get();
+		}
+	}
+}
+
+bool CNetServer::WaitForPackets(int TimeoutUs)
+{
+	if(!m_pRecvThread)
+		return net_socket_read_wait(m_Socket, TimeoutUs) > 0;
+
+	std::unique_lock<std::mutex> Lock(m_pRecvThread->m_Mutex);
+	return m_pRecvThread->m_Cond.wait_for(Lock, std::chrono::microseconds(TimeoutUs), [this]() { return !m_pRecvThread->Empty(); });
+}
+
 int CNetServer::Drop(int ClientID, const char *pReason)
 {
 	// TODO: insert lots of checks here
@@ -104,22 +380,31 @@ int CNetServer::Drop(int ClientID, const char *pReason)
 		m_pfnDelClient(ClientID, pReason, m_pUser);
 
 	m_aSlots[ClientID].m_Connection.Disconnect(pReason);
+	m_SlotMap.Remove(ClientID);
+	m_SlotTimers.Cancel(ClientID);
 
 	return 0;
 }
 
 int CNetServer::Update()
 {
-	for(int i = 0; i < MaxClients(); i++)
-	{
-		m_aSlots[i].m_Connection.Update();
-		if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_ERROR &&
-			(!m_aSlots[i].m_Connection.m_TimeoutProtected ||
-				!m_aSlots[i].m_Connection.m_TimeoutSituation))
+	// only update the connections that have something to do, every
+	// connection is scheduled for when `NextUpdate` says so and whenever
+	// its state may have changed outside of `Update`
+	m_SlotTimers.Advance(time_get(), [this](int Slot) {
+		CNetConnection &Connection = m_aSlots[Slot].m_Connection;
+		Connection.Update();
+		if(Connection.State() == NET_CONNSTATE_ERROR &&
+			(!Connection.m_TimeoutProtected ||
+				!Connection.m_TimeoutSituation))
 		{
-			Drop(i, m_aSlots[i].m_Connection.ErrorString());
+			Drop(Slot, Connection.ErrorString());
 		}
-	}
+		else if(Connection.State() != NET_CONNSTATE_OFFLINE)
+		{
+			m_SlotTimers.Schedule(Slot, Connection.NextUpdate());
+		}
+	});
 
 	return 0;
 }
@@ -246,6 +531,8 @@ int CNetServer::TryAcceptClient(NETADDR &Addr, SECURITY_TOKEN SecurityToken, boo
 
 	// init connection slot
 	m_aSlots[Slot].m_Connection.DirectInit(Addr, SecurityToken, Token, Sixup);
+	m_SlotTimers.Schedule(Slot, 0);
+	m_SlotMap.Set(Addr, Slot);
 
 	if(VanillaAuth)
 	{
@@ -577,19 +864,15 @@ int CNetServer::OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg,
 
 int CNetServer::GetClientSlot(const NETADDR &Addr)
 {
-	int Slot = -1;
-
-	for(int i = 0; i < MaxClients(); i++)
+	// the map isn't updated when connections time out or get closed by
+	// the peer, those slots are only removed from it once they're dropped
+	int Slot = m_SlotMap.Find(Addr);
+	if(Slot == -1 ||
+		m_aSlots[Slot].m_Connection.State() == NET_CONNSTATE_OFFLINE ||
+		m_aSlots[Slot].m_Connection.State() == NET_CONNSTATE_ERROR)
 	{
-		if(m_aSlots[i].m_Connection.State() != NET_CONNSTATE_OFFLINE &&
-			m_aSlots[i].m_Connection.State() != NET_CONNSTATE_ERROR &&
-			net_addr_comp(m_aSlots[i].m_Connection.PeerAddress(), &Addr) == 0)
-
-		{
-			Slot = i;
-		}
+		return -1;
 	}
-
 	return Slot;
 }
 
@@ -627,15 +910,20 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 
 		// TODO: empty the recvinfo
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		int Bytes;
+		if(m_pRecvThread)
+			Bytes = m_pRecvThread->Pop(&Addr, &pData);
+		else
+			Bytes = net_udp_recv(m_Socket, &Addr, &pData);
 
 		// no more packets for now
 		if(Bytes <= 0)
 			break;
 
-		// check if we just should drop the packet
+		// check if we just should drop the packet, the network thread
+		// already did that
 		char aBuf[128];
-		if(NetBan() && NetBan()->IsBanned(&Addr, aBuf, sizeof(aBuf)))
+		if(!m_pRecvThread && NetBan() && NetBan()->IsBanned(&Addr, aBuf, sizeof(aBuf)))
 		{
 			// banned, reply with a message
 			CNetBase::SendControlMsg(m_Socket, &Addr, 0, NET_CTRLMSG_CLOSE, aBuf, str_length(aBuf) + 1, NET_SECURITY_TOKEN_UNSUPPORTED);
@@ -687,7 +975,11 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 
 					// control
 					if(m_RecvUnpacker.m_Data.m_Flags & NET_PACKETFLAG_CONTROL)
+					{
 						OnConnCtrlMsg(Addr, Slot, m_RecvUnpacker.m_Data.m_aChunkData[0], m_RecvUnpacker.m_Data);
+						// control messages may close or reset the connection
+						m_SlotTimers.Schedule(Slot, 0);
+					}
 
 					if(m_aSlots[Slot].m_Connection.Feed(&m_RecvUnpacker.m_Data, &Addr, Token))
 					{
@@ -745,10 +1037,15 @@ int CNetServer::Send(CNetChunk *pChunk)
 		if(pChunk->m_Flags & NETSENDFLAG_VITAL)
 			Flags = NET_CHUNKFLAG_VITAL;
 
-		if(m_aSlots[pChunk->m_ClientID].m_Connection.QueueChunk(Flags, pChunk->m_DataSize, pChunk->m_pData) == 0)
+		CNetConnection &Connection = m_aSlots[pChunk->m_ClientID].m_Connection;
+		const bool HadQueuedChunks = Connection.HasQueuedChunks();
+		if(Connection.QueueChunk(Flags, pChunk->m_DataSize, pChunk->m_pData) == 0)
 		{
 			if(pChunk->m_Flags & NETSENDFLAG_FLUSH)
-				m_aSlots[pChunk->m_ClientID].m_Connection.Flush();
+				Connection.Flush();
+			// the connection has to be flushed after half a second now
+			else if(!HadQueuedChunks && Connection.HasQueuedChunks())
+				m_SlotTimers.Schedule(pChunk->m_ClientID, Connection.NextUpdate());
 		}
 		else
 		{
@@ -801,6 +1098,8 @@ bool CNetServer::SetTimedOut(int ClientID, int OrigID)
 
 	m_aSlots[ClientID].m_Connection.SetTimedOut(ClientAddr(OrigID), m_aSlots[OrigID].m_Connection.SeqSequence(), m_aSlots[OrigID].m_Connection.AckSequence(), m_aSlots[OrigID].m_Connection.SecurityToken(), m_aSlots[OrigID].m_Connection.ResendBuffer(), m_aSlots[OrigID].m_Connection.m_Sixup);
 	m_aSlots[OrigID].m_Connection.Reset();
+	m_SlotMap.Set(*ClientAddr(ClientID), ClientID);
+	m_SlotTimers.Schedule(ClientID, 0);
 	return true;
 }
 
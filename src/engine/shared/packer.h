@@ -54,6 +54,7 @@ public:
 
 	int CompleteSize() const { return m_pEnd - m_pStart; }
 	const unsigned char *CompleteData() const { return m_pStart; }
+	int Position() const { return m_pCurrent - m_pStart; }
 };
 
 #endif
@@ -0,0 +1,198 @@
+#include "profiler.h"
+
+#include "csv.h"
+#include "json.h"
+
+#include <base/math.h>
+
+#include <iterator>
+
+void CProfiler::BeginFrame()
+{
+	dbg_assert(!m_pCurrent, "profiler frame already started");
+	if(!m_Enabled)
+	{
+		if(m_pFrames)
+		{
+			m_pFrames = nullptr;
+			m_NumFinished.store(0);
+		}
+		return;
+	}
+	if(!m_pFrames)
+		m_pFrames = std::make_unique<CFrame[]>(NUM_FRAMES);
+
+	int64_t Index = m_NumFinished.load(std::memory_order_relaxed);
+	m_pCurrent = &m_pFrames[Index % NUM_FRAMES];
+	m_pCurrent->m_Index = Index;
+	m_pCurrent->m_Start = Now();
+	m_pCurrent->m_Duration = 0;
+	m_pCurrent->m_NumZones = 0;
+	m_pCurrent->m_NumCounters = 0;
+	m_Depth = 0;
+}
+
+void CProfiler::EndFrame()
+{
+	if(!m_pCurrent)
+		return;
+	// zones still open end with the frame
+	while(m_Depth > 0)
+		EndZone(m_aStack[m_Depth - 1]);
+	m_pCurrent->m_Duration = Now() - m_pCurrent->m_Start;
+	m_pCurrent = nullptr;
+	m_NumFinished.fetch_add(1, std::memory_order_release);
+}
+
+void CProfiler::DiscardFrame()
+{
+	m_pCurrent = nullptr;
+	m_Depth = 0;
+}
+
+int CProfiler::BeginZone(const char *pName)
+{
+	if(!m_pCurrent || m_pCurrent->m_NumZones == MAX_ZONES || m_Depth == MAX_DEPTH)
+		return -1;
+	int Zone = m_pCurrent->m_NumZones++;
+	CZone &NewZone = m_pCurrent->m_aZones[Zone];
+	NewZone.m_pName = pName;
+	NewZone.m_Depth = m_Depth;
+	NewZone.m_Start = Now() - m_pCurrent->m_Start;
+	NewZone.m_Duration = 0;
+	m_aStack[m_Depth++] = Zone;
+	return Zone;
+}
+
+void CProfiler::EndZone(int Zone)
+{
+	// zones of a discarded frame
+	if(!m_pCurrent || m_Depth == 0)
+		return;
+	dbg_assert(m_aStack[m_Depth - 1] == Zone, "profiler zones must end in reverse order");
+	CZone &EndedZone = m_pCurrent->m_aZones[Zone];
+	EndedZone.m_Duration = Now() - m_pCurrent->m_Start - EndedZone.m_Start;
+	m_Depth--;
+}
+
+void CProfiler::AddCounter(const char *pName, int64_t Duration, int Count)
+{
+	if(!m_pCurrent)
+		return;
+	for(int i = 0; i < m_pCurrent->m_NumCounters; i++)
+	{
+		CCounter &Counter = m_pCurrent->m_aCounters[i];
+		if(Counter.m_pName == pName)
+		{
+			Counter.m_Duration += Duration;
+			Counter.m_Count += Count;
+			return;
+		}
+	}
+	if(m_pCurrent->m_NumCounters == MAX_COUNTERS)
+		return;
+	CCounter &Counter = m_pCurrent->m_aCounters[m_pCurrent->m_NumCounters++];
+	Counter.m_pName = pName;
+	Counter.m_Duration = Duration;
+	Counter.m_Count = Count;
+}
+
+int CProfiler::NumFrames() const
+{
+	if(!m_pFrames)
+		return 0;
+	// the slot of the next frame might be written already
+	return minimum(m_NumFinished.load(std::memory_order_acquire), (int64_t)NUM_FRAMES - 1);
+}
+
+const CProfiler::CFrame *CProfiler::Frame(int Age) const
+{
+	if(Age < 0 || Age >= NumFrames())
+		return nullptr;
+	return &m_pFrames[(m_NumFinished.load(std::memory_order_acquire) - 1 - Age) % NUM_FRAMES];
+}
+
+void CProfiler::ExportCsv(IOHANDLE File) const
+{
+	const char *apHeader[] = {"frame", "type", "name", "depth", "start_us", "duration_us", "count"};
+	CsvWrite(File, std::size(apHeader), apHeader);
+
+	char aFrame[16], aDepth[16], aStart[32], aDuration[32], aCount[16];
+	const char *apColumns[] = {aFrame, "", "", aDepth, aStart, aDuration, aCount};
+	for(int Age = NumFrames() - 1; Age >= 0; Age--)
+	{
+		const CFrame *pFrame = Frame(Age);
+		str_format(aFrame, sizeof(aFrame), "%lld", (long long)pFrame->m_Index);
+
+		apColumns[1] = "frame";
+		apColumns[2] = "";
+		str_copy(aDepth, "-1");
+		str_copy(aStart, "0");
+		str_format(aDuration, sizeof(aDuration), "%.3f", pFrame->m_Duration / 1000.0);
+		str_copy(aCount, "1");
+		CsvWrite(File, std::size(apColumns), apColumns);
+
+		apColumns[1] = "zone";
+		for(int i = 0; i < pFrame->m_NumZones; i++)
+		{
+			const CZone &Zone = pFrame->m_aZones[i];
+			apColumns[2] = Zone.m_pName;
+			str_format(aDepth, sizeof(aDepth), "%d", Zone.m_Depth);
+			str_format(aStart, sizeof(aStart), "%.3f", Zone.m_Start / 1000.0);
+			str_format(aDuration, sizeof(aDuration), "%.3f", Zone.m_Duration / 1000.0);
+			CsvWrite(File, std::size(apColumns), apColumns);
+		}
+
+		apColumns[1] = "counter";
+		str_copy(aDepth, "-1");
+		str_copy(aStart, "0");
+		for(int i = 0; i < pFrame->m_NumCounters; i++)
+		{
+			const CCounter &Counter = pFrame->m_aCounters[i];
+			apColumns[2] = Counter.m_pName;
+			str_format(aDuration, sizeof(aDuration), "%.3f", Counter.m_Duration / 1000.0);
+			str_format(aCount, sizeof(aCount), "%d", Counter.m_Count);
+			CsvWrite(File, std::size(apColumns), apColumns);
+		}
+	}
+}
+
+void CProfiler::ExportTrace(IOHANDLE File) const
+{
+	char aName[256];
+	char aBuf[512];
+	bool First = true;
+	auto WriteEvent = [&]() {
+		if(!First)
+			io_write(File, ",", 1);
+		io_write_newline(File);
+		io_write(File, aBuf, str_length(aBuf));
+		First = false;
+	};
+
+	io_write(File, "{\"traceEvents\":[", 16);
+	for(int Age = NumFrames() - 1; Age >= 0; Age--)
+	{
+		const CFrame *pFrame = Frame(Age);
+		str_format(aBuf, sizeof(aBuf), "{\"name\":\"frame %lld\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+			(long long)pFrame->m_Index, pFrame->m_Start / 1000.0, pFrame->m_Duration / 1000.0);
+		WriteEvent();
+		for(int i = 0; i < pFrame->m_NumZones; i++)
+		{
+			const CZone &Zone = pFrame->m_aZones[i];
+			str_format(aBuf, sizeof(aBuf), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+				EscapeJson(aName, sizeof(aName), Zone.m_pName), (pFrame->m_Start + Zone.m_Start) / 1000.0, Zone.m_Duration / 1000.0);
+			WriteEvent();
+		}
+		for(int i = 0; i < pFrame->m_NumCounters; i++)
+		{
+			const CCounter &Counter = pFrame->m_aCounters[i];
+			str_format(aBuf, sizeof(aBuf), "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"us\":%.3f,\"count\":%d}}",
+				EscapeJson(aName, sizeof(aName), Counter.m_pName), pFrame->m_Start / 1000.0, Counter.m_Duration / 1000.0, Counter.m_Count);
+			WriteEvent();
+		}
+	}
+	io_write_newline(File);
+	io_write(File, "]}", 2);
+	io_write_newline(File);
+}
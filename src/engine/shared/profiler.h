@@ -0,0 +1,129 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+
+#include <engine/kernel.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Records nested, named zones and summed up counters per frame into a ring
+// of the last `NUM_FRAMES` frames.
+//
+// Recording is done by one thread without locks. Finished frames can be
+// read from other threads, but a frame may be overwritten while it is read
+// once `NUM_FRAMES - 1` newer frames were finished.
+//
+// Names are not copied, they must outlive the profiler, e.g. string
+// literals.
+class CProfiler : public IInterface
+{
+	MACRO_INTERFACE("profiler", 0)
+public:
+	enum
+	{
+		MAX_ZONES = 256,
+		MAX_COUNTERS = 16,
+		MAX_DEPTH = 32,
+		NUM_FRAMES = 256,
+	};
+
+	struct CZone
+	{
+		const char *m_pName;
+		int m_Depth;
+		// nanoseconds since the start of the frame
+		int64_t m_Start;
+		int64_t m_Duration;
+	};
+
+	// for code that runs too often for zones, e.g. text rendering
+	struct CCounter
+	{
+		const char *m_pName;
+		int64_t m_Duration;
+		int m_Count;
+	};
+
+	struct CFrame
+	{
+		int64_t m_Index;
+		// nanoseconds
+		int64_t m_Start;
+		int64_t m_Duration;
+		int m_NumZones;
+		int m_NumCounters;
+		CZone m_aZones[MAX_ZONES];
+		CCounter m_aCounters[MAX_COUNTERS];
+	};
+
+	class CScope
+	{
+		CProfiler *m_pProfiler;
+		int m_Zone;
+
+	public:
+		CScope(CProfiler *pProfiler, const char *pName) :
+			m_pProfiler(pProfiler), m_Zone(pProfiler ? pProfiler->BeginZone(pName) : -1) {}
+		~CScope()
+		{
+			if(m_Zone >= 0)
+				m_pProfiler->EndZone(m_Zone);
+		}
+	};
+
+	class CCounterScope
+	{
+		CProfiler *m_pProfiler;
+		const char *m_pName;
+		int64_t m_Start;
+
+	public:
+		CCounterScope(CProfiler *pProfiler, const char *pName) :
+			m_pProfiler(pProfiler && pProfiler->IsRecording() ? pProfiler : nullptr), m_pName(pName), m_Start(m_pProfiler ? Now() : 0) {}
+		~CCounterScope()
+		{
+			if(m_pProfiler)
+				m_pProfiler->AddCounter(m_pName, Now() - m_Start);
+		}
+	};
+
+	static int64_t Now() { return time_get_nanoseconds().count(); }
+
+	// Takes effect with the next frame. Disabling frees the recorded frames.
+	void SetEnabled(bool Enabled) { m_Enabled = Enabled; }
+	bool IsEnabled() const { return m_Enabled; }
+	bool IsRecording() const { return m_pCurrent != nullptr; }
+
+	void BeginFrame();
+	void EndFrame();
+	// drops the current frame, e.g. if nothing was rendered
+	void DiscardFrame();
+
+	// returns the zone to pass to `EndZone` or -1 if nothing is recorded
+	int BeginZone(const char *pName);
+	void EndZone(int Zone);
+	// adds `Count` calls that took `Duration` together
+	void AddCounter(const char *pName, int64_t Duration, int Count = 1);
+
+	int NumFrames() const;
+	// `Age` 0 is the last finished frame
+	const CFrame *Frame(int Age) const;
+
+	// One line per frame, zone and counter, times in microseconds.
+	void ExportCsv(IOHANDLE File) const;
+	// Trace event format, can be opened in chrome://tracing or Perfetto.
+	void ExportTrace(IOHANDLE File) const;
+
+private:
+	bool m_Enabled = false;
+	std::unique_ptr<CFrame[]> m_pFrames;
+	std::atomic<int64_t> m_NumFinished{0};
+	CFrame *m_pCurrent = nullptr;
+	int m_aStack[MAX_DEPTH];
+	int m_Depth = 0;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "ticktimings.h"
+
+#include <base/math.h>
+
+static const struct
+{
+	const char *m_pName;
+	int m_Depth;
+} s_aPhases[CTickTimings::NUM_PHASES] = {
+	{"tick", 0},
+	{"network", 1},
+	{"map", 1},
+	{"dnsbl", 1},
+	{"input", 1},
+	{"game", 1},
+	{"teehistorian", 2},
+	{"world", 2},
+	{"controller", 2},
+	{"players", 2},
+	{"votes", 2},
+	{"snapshot", 1},
+	{"other", 1},
+};
+
+void CTickTimings::CHistogram::Reset()
+{
+	*this = CHistogram();
+}
+
+void CTickTimings::CHistogram::Add(int64_t Duration)
+{
+	m_aBuckets[Bucket(Duration)]++;
+	m_Count++;
+	m_Max = maximum(m_Max, Duration);
+}
+
+int64_t CTickTimings::CHistogram::Percentile(float Fraction) const
+{
+	if(m_Count == 0)
+		return 0;
+	int64_t Target = maximum((int64_t)1, (int64_t)(m_Count * Fraction + 0.999f));
+	int64_t Sum = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+	{
+		Sum += m_aBuckets[i];
+		if(Sum >= Target)
+			return minimum(BucketEnd(i), m_Max);
+	}
+	return m_Max;
+}
+
+int CTickTimings::CHistogram::Bucket(int64_t Duration)
+{
+	int64_t Micros = maximum(Duration, (int64_t)0) / 1000;
+	if(Micros < 4)
+		return Micros;
+	int Exponent = 0;
+	while(Micros >> (Exponent + 1))
+		Exponent++;
+	int SubBucket = (Micros >> (Exponent - 2)) & 3;
+	return minimum(4 * (Exponent - 1) + SubBucket, (int)NUM_BUCKETS - 1);
+}
+
+int64_t CTickTimings::CHistogram::BucketEnd(int Bucket)
+{
+	if(Bucket < 4)
+		return (Bucket + 1) * (int64_t)1000;
+	int Exponent = Bucket / 4 + 1;
+	int SubBucket = Bucket % 4;
+	return ((int64_t)(5 + SubBucket) << (Exponent - 2)) * 1000;
+}
+
+const char *CTickTimings::PhaseName(int Phase)
+{
+	return s_aPhases[Phase].m_pName;
+}
+
+int CTickTimings::PhaseDepth(int Phase)
+{
+	return s_aPhases[Phase].m_Depth;
+}
+
+CTickTimings::CTickTimings()
+{
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		m_aTick[i] = -1;
+		m_aLastTick[i] = -1;
+	}
+}
+
+void CTickTimings::Add(int Phase, int64_t Duration)
+{
+	m_aTick[Phase] = maximum(m_aTick[Phase], (int64_t)0) + Duration;
+}
+
+bool CTickTimings::EndTick(int64_t Now)
+{
+	if(m_WindowStart < 0)
+		m_WindowStart = Now;
+	else if(Now - m_WindowStart >= WINDOW_SECONDS * (int64_t)1000000000)
+	{
+		for(int i = 0; i < NUM_PHASES; i++)
+		{
+			m_aLast[i] = m_aCurrent[i];
+			m_aCurrent[i].Reset();
+		}
+		m_LastSlowTicks = m_CurrentSlowTicks;
+		m_CurrentSlowTicks = 0;
+		m_HaveLast = true;
+		m_WindowStart = Now;
+	}
+
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		m_aLastTick[i] = m_aTick[i];
+		m_aTick[i] = -1;
+		if(m_aLastTick[i] < 0)
+			continue;
+		m_aCurrent[i].Add(m_aLastTick[i]);
+		m_aTotalDuration[i] += m_aLastTick[i];
+		m_aTotalCount[i]++;
+	}
+
+	bool Slow = m_SlowTickBudget > 0 && m_aLastTick[PHASE_TICK] > m_SlowTickBudget;
+	if(Slow)
+	{
+		m_CurrentSlowTicks++;
+		m_TotalSlowTicks++;
+	}
+	return Slow;
+}
+
+void CTickTimings::FormatLastTick(char *pBuf, int BufSize) const
+{
+	pBuf[0] = '\0';
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		if(m_aLastTick[i] < 0)
+			continue;
+		char aPhase[64];
+		str_format(aPhase, sizeof(aPhase), "%s%s=%.2fms", pBuf[0] ? " " : "", PhaseName(i), m_aLastTick[i] / 1000000.0);
+		str_append(pBuf, aPhase, BufSize);
+	}
+}
+
+const CTickTimings::CHistogram &CTickTimings::Window(int Phase) const
+{
+	return m_HaveLast ? m_aLast[Phase] : m_aCurrent[Phase];
+}
+
+int64_t CTickTimings::WindowSlowTicks() const
+{
+	return m_HaveLast ? m_LastSlowTicks : m_CurrentSlowTicks;
+}
+
+void CTickTimings::WriteMetrics(IOHANDLE File) const
+{
+	char aBuf[256];
+	// the format requires \n line endings on every platform
+	auto WriteLine = [&]() {
+		io_write(File, aBuf, str_length(aBuf));
+		io_write(File, "\n", 1);
+	};
+
+	str_copy(aBuf, "# HELP ddnet_tick_phase_seconds Time spent in the server tick phases, quantiles over the last minute.");
+	WriteLine();
+	str_copy(aBuf, "# TYPE ddnet_tick_phase_seconds summary");
+	WriteLine();
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		const CHistogram &Histogram = Window(i);
+		for(float Quantile : {0.5f, 0.99f})
+		{
+			str_format(aBuf, sizeof(aBuf), "ddnet_tick_phase_seconds{phase=\"%s\",quantile=\"%g\"} %.6f", PhaseName(i), Quantile, Histogram.Percentile(Quantile) / 1000000000.0);
+			WriteLine();
+		}
+		str_format(aBuf, sizeof(aBuf), "ddnet_tick_phase_seconds_sum{phase=\"%s\"} %.6f", PhaseName(i), m_aTotalDuration[i] / 1000000000.0);
+		WriteLine();
+		str_format(aBuf, sizeof(aBuf), "ddnet_tick_phase_seconds_count{phase=\"%s\"} %lld", PhaseName(i), (long long)m_aTotalCount[i]);
+		WriteLine();
+	}
+
+	str_copy(aBuf, "# HELP ddnet_tick_phase_max_seconds Longest time spent in the server tick phases over the last minute.");
+	WriteLine();
+	str_copy(aBuf, "# TYPE ddnet_tick_phase_max_seconds gauge");
+	WriteLine();
+	for(int i = 0; i < NUM_PHASES; i++)
+	{
+		str_format(aBuf, sizeof(aBuf), "ddnet_tick_phase_max_seconds{phase=\"%s\"} %.6f", PhaseName(i), Window(i).Max() / 1000000000.0);
+		WriteLine();
+	}
+
+	str_copy(aBuf, "# HELP ddnet_slow_ticks_total Ticks that took longer than the budget.");
+	WriteLine();
+	str_copy(aBuf, "# TYPE ddnet_slow_ticks_total counter");
+	WriteLine();
+	str_format(aBuf, sizeof(aBuf), "ddnet_slow_ticks_total %lld", (long long)m_TotalSlowTicks);
+	WriteLine();
+}
@@ -0,0 +1,127 @@
+#ifndef ENGINE_SHARED_TICKTIMINGS_H
+#define ENGINE_SHARED_TICKTIMINGS_H
+
+#include <base/system.h>
+
+#include <cstdint>
+
+// Time spent in the phases of the server tick, summarized per minute.
+//
+// Durations are accumulated with `Add` or `CScope` until `EndTick` adds
+// them to the histograms of the current minute. A phase may run several
+// times per tick, e.g. the game tick when the server catches up, and
+// nested phases are included in their parents.
+class CTickTimings
+{
+public:
+	enum
+	{
+		// everything but waiting for packets
+		PHASE_TICK,
+		PHASE_NETWORK,
+		PHASE_MAP,
+		PHASE_DNSBL,
+		PHASE_INPUT,
+		PHASE_GAME,
+		PHASE_TEEHISTORIAN,
+		PHASE_WORLD,
+		PHASE_CONTROLLER,
+		PHASE_PLAYERS,
+		PHASE_VOTES,
+		PHASE_SNAPSHOT,
+		PHASE_OTHER,
+		NUM_PHASES,
+
+		WINDOW_SECONDS = 60,
+	};
+
+	// Logarithmic buckets with four sub-buckets per power of two
+	// microseconds, percentiles are off by at most 25%.
+	class CHistogram
+	{
+	public:
+		enum
+		{
+			NUM_BUCKETS = 120,
+		};
+
+		void Reset();
+		void Add(int64_t Duration);
+		int64_t Count() const { return m_Count; }
+		int64_t Max() const { return m_Max; }
+		// upper bound of the bucket, never above the maximum
+		int64_t Percentile(float Fraction) const;
+
+		static int Bucket(int64_t Duration);
+		static int64_t BucketEnd(int Bucket);
+
+	private:
+		int m_aBuckets[NUM_BUCKETS] = {0};
+		int64_t m_Count = 0;
+		int64_t m_Max = 0;
+	};
+
+	class CScope
+	{
+		CTickTimings *m_pTimings;
+		int m_Phase;
+		int64_t m_Start;
+
+	public:
+		CScope(CTickTimings *pTimings, int Phase) :
+			m_pTimings(pTimings), m_Phase(Phase), m_Start(pTimings ? Now() : 0) {}
+		~CScope()
+		{
+			if(m_pTimings)
+				m_pTimings->Add(m_Phase, Now() - m_Start);
+		}
+	};
+
+	// nanoseconds
+	static int64_t Now() { return time_get_nanoseconds().count(); }
+	static const char *PhaseName(int Phase);
+	static int PhaseDepth(int Phase);
+
+	CTickTimings();
+
+	// 0 to never report slow ticks
+	void SetSlowTickBudget(int64_t Budget) { m_SlowTickBudget = Budget; }
+	void Add(int Phase, int64_t Duration);
+	// Returns true if the tick took longer than the budget. Starts a new
+	// window if the current one is older than `WINDOW_SECONDS`.
+	bool EndTick(int64_t Now);
+
+	// -1 if the phase didn't run in the last tick
+	int64_t LastTick(int Phase) const { return m_aLastTick[Phase]; }
+	// "tick=25.10ms network=0.52ms ..." of the phases that ran
+	void FormatLastTick(char *pBuf, int BufSize) const;
+
+	bool HaveCompleteWindow() const { return m_HaveLast; }
+	// the last complete window or the current one if there is none yet
+	const CHistogram &Window(int Phase) const;
+	int64_t WindowSlowTicks() const;
+	const CHistogram &CurrentWindow(int Phase) const { return m_aCurrent[Phase]; }
+	int64_t CurrentSlowTicks() const { return m_CurrentSlowTicks; }
+
+	// Prometheus text exposition format.
+	void WriteMetrics(IOHANDLE File) const;
+
+private:
+	int64_t m_SlowTickBudget = 0;
+	int64_t m_aTick[NUM_PHASES];
+	int64_t m_aLastTick[NUM_PHASES];
+
+	int64_t m_WindowStart = -1;
+	bool m_HaveLast = false;
+	CHistogram m_aCurrent[NUM_PHASES];
+	CHistogram m_aLast[NUM_PHASES];
+	int64_t m_CurrentSlowTicks = 0;
+	int64_t m_LastSlowTicks = 0;
+
+	// since the start, for the metrics
+	int64_t m_aTotalDuration[NUM_PHASES] = {0};
+	int64_t m_aTotalCount[NUM_PHASES] = {0};
+	int64_t m_TotalSlowTicks = 0;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef ENGINE_SHARED_TIMINGWHEEL_H
+#define ENGINE_SHARED_TIMINGWHEEL_H
+
+#include <base/math.h>
+#include <base/system.h>
+
+#include <cstdint>
+
+// Hierarchical timing wheel for the timers `0` to `MaxTimers - 1`.
+//
+// Scheduling and cancelling a timer is O(1), and `Advance` only touches the
+// timers that expire, plus every timer of the coarser levels once whenever
+// their slot comes up. Times are in arbitrary units, e.g. from `time_get`.
+// Deadlines are rounded to the granularity, a timer fires in the first
+// `Advance` after the whole granularity step containing its deadline has
+// passed, so never early.
+//
+// The class holds no pointers, so it may live in structures that are reset
+// with `mem_zero`, as long as `Init` is called afterwards.
+template<int MaxTimers>
+class CTimingWheel
+{
+	enum
+	{
+		LEVEL_BITS = 6,
+		NUM_SLOTS = 1 << LEVEL_BITS,
+		NUM_LEVELS = 4,
+		// timers too far in the future for all levels
+		BUCKET_OVERFLOW = NUM_LEVELS * NUM_SLOTS,
+		// timers whose tick was already processed
+		BUCKET_DUE,
+		// the due timers that `Advance` is firing
+		BUCKET_FIRING,
+		NUM_BUCKETS,
+	};
+
+	struct CTimer
+	{
+		int64_t m_Tick;
+		int m_Prev;
+		int m_Next;
+		int m_Bucket;
+	};
+
+	CTimer m_aTimers[MaxTimers];
+	int m_aBuckets[NUM_BUCKETS];
+	int64_t m_Granularity;
+	// the next tick that is processed
+	int64_t m_CurrentTick;
+	int m_NumScheduled;
+
+	void Link(int ID)
+	{
+		CTimer &Timer = m_aTimers[ID];
+		int64_t Tick = Timer.m_Tick;
+		int Bucket = Tick < m_CurrentTick ? BUCKET_DUE : BUCKET_OVERFLOW;
+		for(int Level = 0; Level < NUM_LEVELS && Bucket == BUCKET_OVERFLOW; Level++)
+		{
+			if((Tick >> ((Level + 1) * LEVEL_BITS)) == (m_CurrentTick >> ((Level + 1) * LEVEL_BITS)))
+				Bucket = Level * NUM_SLOTS + ((Tick >> (Level * LEVEL_BITS)) & (NUM_SLOTS - 1));
+		}
+		Timer.m_Bucket = Bucket;
+		Timer.m_Prev = -1;
+		Timer.m_Next = m_aBuckets[Bucket];
+		if(Timer.m_Next != -1)
+			m_aTimers[Timer.m_Next].m_Prev = ID;
+		m_aBuckets[Bucket] = ID;
+	}
+
+	void Unlink(int ID)
+	{
+		CTimer &Timer = m_aTimers[ID];
+		if(Timer.m_Prev != -1)
+			m_aTimers[Timer.m_Prev].m_Next = Timer.m_Next;
+		else
+			m_aBuckets[Timer.m_Bucket] = Timer.m_Next;
+		if(Timer.m_Next != -1)
+			m_aTimers[Timer.m_Next].m_Prev = Timer.m_Prev;
+		Timer.m_Bucket = -1;
+	}
+
+	// moves the timers of a coarser slot to the finer levels
+	void Cascade(int Bucket)
+	{
+		int ID = m_aBuckets[Bucket];
+		m_aBuckets[Bucket] = -1;
+		while(ID != -1)
+		{
+			int Next = m_aTimers[ID].m_Next;
+			Link(ID);
+			ID = Next;
+		}
+	}
+
+	template<typename F>
+	void Fire(int Bucket, F &&Expired)
+	{
+		int &Head = m_aBuckets[Bucket];
+		while(Head != -1)
+		{
+			int ID = Head;
+			Unlink(ID);
+			m_NumScheduled--;
+			Expired(ID);
+		}
+	}
+
+public:
+	void Init(int64_t Granularity, int64_t Now)
+	{
+		dbg_assert(Granularity > 0, "timing wheel granularity must be positive");
+		m_Granularity = Granularity;
+		m_CurrentTick = Now / Granularity;
+		m_NumScheduled = 0;
+		for(auto &Bucket : m_aBuckets)
+			Bucket = -1;
+		for(auto &Timer : m_aTimers)
+			Timer.m_Bucket = -1;
+	}
+
+	// (re)schedules the timer, deadlines in the past fire in the next `Advance`
+	void Schedule(int ID, int64_t Deadline)
+	{
+		dbg_assert(ID >= 0 && ID < MaxTimers, "timer id out of range");
+		if(Scheduled(ID))
+			Unlink(ID);
+		else
+			m_NumScheduled++;
+		m_aTimers[ID].m_Tick = Deadline / m_Granularity;
+		Link(ID);
+	}
+
+	void Cancel(int ID)
+	{
+		dbg_assert(ID >= 0 && ID < MaxTimers, "timer id out of range");
+		if(!Scheduled(ID))
+			return;
+		Unlink(ID);
+		m_NumScheduled--;
+	}
+
+	bool Scheduled(int ID) const { return m_aTimers[ID].m_Bucket != -1; }
+	int NumScheduled() const { return m_NumScheduled; }
+
+	// Calls `Expired(ID)` for every timer whose deadline lies in a
+	// granularity step before `Now`. The timer is unscheduled before the
+	// call, so `Expired` may schedule it again.
+	template<typename F>
+	void Advance(int64_t Now, F &&Expired)
+	{
+		// timers scheduled for the past since the last call, the ones
+		// scheduled for the past from `Expired` wait for the next call
+		m_aBuckets[BUCKET_FIRING] = m_aBuckets[BUCKET_DUE];
+		m_aBuckets[BUCKET_DUE] = -1;
+		for(int ID = m_aBuckets[BUCKET_FIRING]; ID != -1; ID = m_aTimers[ID].m_Next)
+			m_aTimers[ID].m_Bucket = BUCKET_FIRING;
+		Fire(BUCKET_FIRING, Expired);
+
+		int64_t NowTick = Now / m_Granularity;
+		while(m_CurrentTick < NowTick)
+		{
+			if(!m_NumScheduled)
+			{
+				m_CurrentTick = NowTick;
+				break;
+			}
+
+			int64_t Tick = m_CurrentTick;
+			// coarsest level first, its timers may end up in the slots of
+			// the finer levels that start now as well
+			int NumCascade = 0;
+			while(NumCascade < NUM_LEVELS && !(Tick & ((int64_t(1) << ((NumCascade + 1) * LEVEL_BITS)) - 1)))
+				NumCascade++;
+			for(int Level = NumCascade; Level > 0; Level--)
+			{
+				if(Level == NUM_LEVELS)
+					Cascade(BUCKET_OVERFLOW);
+				else
+					Cascade(Level * NUM_SLOTS + ((Tick >> (Level * LEVEL_BITS)) & (NUM_SLOTS - 1)));
+			}
+
+			// timers scheduled from `Expired` mustn't land in this slot again
+			m_CurrentTick = Tick + 1;
+			Fire(Tick & (NUM_SLOTS - 1), Expired);
+		}
+	}
+};
+
+#endif
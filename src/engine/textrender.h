@@ -161,6 +161,14 @@ struct STextBoundingBox
 	}
 };
 
+struct STextLayoutCacheStats
+{
+	int64_t m_Hits;
+	int64_t m_Misses;
+	int m_NumEntries;
+	int m_NumQuads;
+};
+
 class CTextCursor
 {
 public:
@@ -277,6 +285,8 @@ public:
 	virtual ColorRGBA GetTextOutlineColor() const = 0;
 	virtual ColorRGBA GetTextSelectionColor() const = 0;
 
+	virtual STextLayoutCacheStats LayoutCacheStats() const = 0;
+
 	virtual void OnWindowResize() = 0;
 };
 
@@ -133,6 +133,10 @@ public:
 	 * Gets the size of the non-abstract component.
 	 */
 	virtual int Sizeof() const = 0;
+	/**
+	 * Gets the name of the component, e.g. for the profiler.
+	 */
+	virtual const char *Name() const = 0;
 	/**
 	 * Get a pointer to the game client.
 	 */
@@ -39,6 +39,7 @@ public:
 	CBackground(int MapType = CMapLayers::TYPE_BACKGROUND_FORCE, bool OnlineOnly = true);
 	virtual ~CBackground();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "background"; }
 
 	virtual void OnInit() override;
 	virtual void OnMapLoad() override;
@@ -26,12 +26,14 @@ public:
 	CBinds();
 	~CBinds();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "binds"; }
 
 	class CBindsSpecial : public CComponent
 	{
 	public:
 		CBinds *m_pBinds;
 		virtual int Sizeof() const override { return sizeof(*this); }
+		virtual const char *Name() const override { return "special binds"; }
 		virtual bool OnInput(const IInput::CEvent &Event) override;
 	};
 
@@ -13,6 +13,7 @@ class CBroadcast : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "broadcast"; }
 	virtual void OnReset() override;
 	virtual void OnRender() override;
 	virtual void OnMessage(int MsgType, void *pRawMsg) override;
@@ -45,6 +45,7 @@ public:
 
 	CCamera();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "camera"; }
 	virtual void OnRender() override;
 
 	// DDRace
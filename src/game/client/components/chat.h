@@ -139,6 +139,7 @@ class CChat : public CComponent
 public:
 	CChat();
 	int Sizeof() const override { return sizeof(*this); }
+	const char *Name() const override { return "chat"; }
 
 	static constexpr float MESSAGE_PADDING_X = 5.0f;
 	static constexpr float MESSAGE_TEE_SIZE = 7.0f;
@@ -128,6 +128,7 @@ public:
 	CGameConsole();
 	~CGameConsole();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "console"; }
 
 	void PrintLine(int Type, const char *pLine);
 	void RequireUsername(bool UsernameReq);
@@ -32,6 +32,7 @@ public:
 
 	CControls();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "controls"; }
 
 	virtual void OnReset() override;
 	virtual void OnRelease() override;
@@ -19,6 +19,7 @@ public:
 	};
 
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "country flags"; }
 	void OnInit() override;
 
 	size_t Num() const;
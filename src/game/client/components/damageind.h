@@ -32,6 +32,7 @@ class CDamageInd : public CComponent
 public:
 	CDamageInd();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "damage indicators"; }
 
 	void Create(vec2 Pos, vec2 Dir);
 	void Reset();
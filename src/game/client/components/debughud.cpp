@@ -2,6 +2,7 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/textrender.h>
 
 #include <game/generated/protocol.h>
@@ -210,9 +211,117 @@ void CDebugHud::RenderHint()
 	TextRender()->Text(5, 290, 5, Localize("Debug mode enabled. Press Ctrl+Shift+D to disable debug mode."), -1.0f);
 }
 
+void CDebugHud::RenderProfiler()
+{
+	const CProfiler *pProfiler = m_pClient->Profiler();
+	if(!g_Config.m_DbgProfiler || !pProfiler || !pProfiler->NumFrames())
+		return;
+
+	float Width = 300 * Graphics()->ScreenAspect();
+	Graphics()->MapScreen(0, 0, Width, 300);
+
+	// frame times of the recorded frames, 1/30 s is the full height,
+	// the slowest one is shown below
+	const int NumFrames = pProfiler->NumFrames();
+	const float GraphX = 10.0f, GraphY = 10.0f, GraphW = Width - 20.0f, GraphH = 30.0f;
+	const float BarW = GraphW / (CProfiler::NUM_FRAMES - 1);
+	const int64_t FullHeight = 1000000000 / 30;
+	const CProfiler::CFrame *pSlowest = pProfiler->Frame(0);
+	Graphics()->TextureClear();
+	Graphics()->QuadsBegin();
+	Graphics()->SetColor(0.0f, 0.0f, 0.0f, 0.5f);
+	IGraphics::CQuadItem Background(GraphX, GraphY, GraphW, GraphH);
+	Graphics()->QuadsDrawTL(&Background, 1);
+	for(int Age = 0; Age < NumFrames; Age++)
+	{
+		const CProfiler::CFrame *pFrame = pProfiler->Frame(Age);
+		if(pFrame->m_Duration > pSlowest->m_Duration)
+			pSlowest = pFrame;
+		const float h = minimum(pFrame->m_Duration / (float)FullHeight, 1.0f) * GraphH;
+		if(pFrame->m_Duration > FullHeight / 2)
+			Graphics()->SetColor(1.0f, 0.3f, 0.3f, 1.0f);
+		else
+			Graphics()->SetColor(0.3f, 1.0f, 0.3f, 1.0f);
+		IGraphics::CQuadItem Bar(GraphX + GraphW - (Age + 1) * BarW, GraphY + GraphH - h, BarW, h);
+		Graphics()->QuadsDrawTL(&Bar, 1);
+	}
+
+	// zones of the slowest frame, one row per depth
+	const float FlameY = GraphY + GraphH + 10.0f;
+	const float RowH = 6.0f;
+	const float Scale = GraphW / maximum(pSlowest->m_Duration, (int64_t)1);
+	int NumRows = 0;
+	for(int i = 0; i < pSlowest->m_NumZones; i++)
+	{
+		const CProfiler::CZone &Zone = pSlowest->m_aZones[i];
+		NumRows = maximum(NumRows, Zone.m_Depth + 1);
+		ColorRGBA Color = color_cast<ColorRGBA>(ColorHSLA((str_quickhash(Zone.m_pName) % 256) / 256.0f, 0.6f, 0.5f, 0.8f));
+		Graphics()->SetColor(Color);
+		IGraphics::CQuadItem Bar(GraphX + Zone.m_Start * Scale, FlameY + Zone.m_Depth * RowH, maximum(Zone.m_Duration * Scale, 0.5f), RowH - 0.5f);
+		Graphics()->QuadsDrawTL(&Bar, 1);
+	}
+	Graphics()->QuadsEnd();
+
+	char aBuf[128];
+	TextRender()->TextColor(1, 1, 1, 1);
+	str_format(aBuf, sizeof(aBuf), "slowest of %d frames: %.2f ms (frame %lld)", NumFrames, pSlowest->m_Duration / 1000000.0f, (long long)pSlowest->m_Index);
+	TextRender()->Text(GraphX, GraphY + GraphH + 2.0f, 5.0f, aBuf, -1.0f);
+	for(int i = 0; i < pSlowest->m_NumZones; i++)
+	{
+		const CProfiler::CZone &Zone = pSlowest->m_aZones[i];
+		const float w = Zone.m_Duration * Scale;
+		str_format(aBuf, sizeof(aBuf), "%s %.2f", Zone.m_pName, Zone.m_Duration / 1000000.0f);
+		if(TextRender()->TextWidth(4.0f, aBuf, -1, -1.0f) < w)
+			TextRender()->Text(GraphX + Zone.m_Start * Scale + 0.5f, FlameY + Zone.m_Depth * RowH + 0.5f, 4.0f, aBuf, w);
+	}
+
+	float y = FlameY + NumRows * RowH + 2.0f;
+	for(int i = 0; i < pSlowest->m_NumCounters; i++)
+	{
+		const CProfiler::CCounter &Counter = pSlowest->m_aCounters[i];
+		str_format(aBuf, sizeof(aBuf), "%s: %.2f ms in %d calls", Counter.m_pName, Counter.m_Duration / 1000000.0f, Counter.m_Count);
+		TextRender()->Text(GraphX, y, 5.0f, aBuf, -1.0f);
+		y += 6.0f;
+	}
+}
+
+void CDebugHud::RenderSkinAtlas()
+{
+	if(!g_Config.m_Debug)
+		return;
+
+	const CSkinAtlas &Atlas = m_pClient->m_Skins.Atlas();
+	float Width = 300 * Graphics()->ScreenAspect();
+	Graphics()->MapScreen(0, 0, Width, 300);
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "skin atlas: %d/%d slots in %d pages, %d skins, %d uploads, %lld evictions, %d texture binds",
+		Atlas.NumUsedSlots(), Atlas.NumSlots(), Atlas.NumPages(), Atlas.NumSkins(), Atlas.NumUploadsLastFrame(), (long long)Atlas.NumEvictions(), Graphics()->NumTextureBindsLastFrame());
+	TextRender()->TextColor(1, 1, 1, 1);
+	TextRender()->Text(5, 284, 5, aBuf, -1.0f);
+}
+
+void CDebugHud::RenderTextLayoutCache()
+{
+	if(!g_Config.m_Debug)
+		return;
+
+	const STextLayoutCacheStats Stats = TextRender()->LayoutCacheStats();
+	const int64_t Lookups = Stats.m_Hits + Stats.m_Misses;
+	float Width = 300 * Graphics()->ScreenAspect();
+	Graphics()->MapScreen(0, 0, Width, 300);
+	char aBuf[128];
+	str_format(aBuf, sizeof(aBuf), "text layout cache: %d entries, %d quads, %lld hits, %lld misses (%.1f%% hit rate)",
+		Stats.m_NumEntries, Stats.m_NumQuads, (long long)Stats.m_Hits, (long long)Stats.m_Misses, Lookups > 0 ? Stats.m_Hits * 100.0f / Lookups : 0.0f);
+	TextRender()->TextColor(1, 1, 1, 1);
+	TextRender()->Text(5, 278, 5, aBuf, -1.0f);
+}
+
 void CDebugHud::OnRender()
 {
 	RenderTuning();
 	RenderNetCorrections();
+	RenderProfiler();
+	RenderSkinAtlas();
+	RenderTextLayoutCache();
 	RenderHint();
 }
@@ -11,6 +11,9 @@ class CDebugHud : public CComponent
 	void RenderNetCorrections();
 	void RenderTuning();
 	void RenderHint();
+	void RenderProfiler();
+	void RenderSkinAtlas();
+	void RenderTextLayoutCache();
 
 	CGraph m_RampGraph;
 	CGraph m_ZoomedInGraph;
@@ -22,6 +25,7 @@ class CDebugHud : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "debug hud"; }
 	virtual void OnRender() override;
 };
 
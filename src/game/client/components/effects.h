@@ -13,6 +13,7 @@ class CEffects : public CComponent
 public:
 	CEffects();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "effects"; }
 
 	virtual void OnRender() override;
 
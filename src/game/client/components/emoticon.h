@@ -20,6 +20,7 @@ class CEmoticon : public CComponent
 public:
 	CEmoticon();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "emoticon"; }
 
 	virtual void OnReset() override;
 	virtual void OnConsoleInit() override;
@@ -23,6 +23,7 @@ class CFlow : public CComponent
 public:
 	CFlow();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "flow"; }
 
 	vec2 Get(vec2 Pos);
 	void Add(vec2 Pos, vec2 Vel, float Size);
@@ -10,6 +10,7 @@ class CFreezeBars : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "freeze bars"; }
 	virtual void OnRender() override;
 };
 
@@ -151,6 +151,7 @@ public:
 
 	CGhost();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "ghost"; }
 
 	virtual void OnRender() override;
 	virtual void OnConsoleInit() override;
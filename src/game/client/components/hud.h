@@ -70,6 +70,7 @@ class CHud : public CComponent
 public:
 	CHud();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "hud"; }
 
 	void ResetHudContainers();
 	virtual void OnWindowResize() override;
@@ -19,6 +19,7 @@ class CItems : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "items"; }
 	virtual void OnRender() override;
 	virtual void OnInit() override;
 
@@ -53,6 +53,7 @@ public:
 	int m_KillmsgCurrent;
 
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "kill messages"; }
 	virtual void OnWindowResize() override;
 	virtual void OnReset() override;
 	virtual void OnRender() override;
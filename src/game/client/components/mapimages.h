@@ -51,6 +51,7 @@ public:
 	CMapImages();
 	CMapImages(int TextureSize);
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "map images"; }
 
 	IGraphics::CTextureHandle Get(int Index) const { return m_aTextures[Index]; }
 	int Num() const { return m_Count; }
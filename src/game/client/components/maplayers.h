@@ -150,6 +150,7 @@ public:
 	CMapLayers(int Type, bool OnlineOnly = true);
 	virtual ~CMapLayers();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return m_Type == TYPE_FOREGROUND ? "map layers foreground" : "map layers background"; }
 	virtual void OnInit() override;
 	virtual void OnRender() override;
 	virtual void OnMapLoad() override;
@@ -31,6 +31,7 @@ class CMapSounds : public CComponent
 public:
 	CMapSounds();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "map sounds"; }
 
 	virtual void OnMapLoad() override;
 	virtual void OnRender() override;
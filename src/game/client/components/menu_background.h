@@ -102,6 +102,7 @@ public:
 	CMenuBackground();
 	~CMenuBackground() override {}
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "menu background"; }
 
 	void OnInit() override;
 	void OnMapLoad() override;
@@ -55,6 +55,7 @@ public:
 	int m_ModifierCombination;
 	CMenusKeyBinder();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "key binder"; }
 	virtual bool OnInput(const IInput::CEvent &Event) override;
 };
 
@@ -578,6 +579,7 @@ public:
 
 	CMenus();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "menus"; }
 
 	void RenderLoading(const char *pCaption, const char *pContent, int IncreaseCounter, bool RenderLoadingBar = true, bool RenderMenuBackgroundMap = true);
 
@@ -18,6 +18,7 @@ class CMotd : public CComponent
 public:
 	CMotd();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "motd"; }
 
 	const char *ServerMotd() const { return m_aServerMotd; }
 	int64_t ServerMotdUpdateTime() const { return m_ServerMotdUpdateTime; }
@@ -55,6 +55,7 @@ class CNamePlates : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "name plates"; }
 	virtual void OnWindowResize() override;
 	virtual void OnInit() override;
 	virtual void OnRender() override;
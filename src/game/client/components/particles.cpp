@@ -2,7 +2,9 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/math.h>
 #include <engine/demo.h>
+#include <engine/engine.h>
 #include <engine/graphics.h>
+#include <engine/shared/jobs.h>
 
 #include "particles.h"
 #include <game/client/render.h>
@@ -10,6 +12,120 @@
 
 #include <game/client/gameclient.h>
 
+#include <thread>
+
+class CParticles::CCollisionJob : public IJob
+{
+	std::shared_ptr<CCollisionWork> m_pWork;
+
+	void Run() override
+	{
+		m_pWork->MoveChunks();
+	}
+
+public:
+	CCollisionJob(std::shared_ptr<CCollisionWork> pWork) :
+		m_pWork(std::move(pWork))
+	{
+	}
+};
+
+void CParticles::CPool::Add(const CParticle *pPart, float Life)
+{
+	m_vPosX.push_back(pPart->m_Pos.x);
+	m_vPosY.push_back(pPart->m_Pos.y);
+	m_vVelX.push_back(pPart->m_Vel.x);
+	m_vVelY.push_back(pPart->m_Vel.y);
+	m_vRot.push_back(pPart->m_Rot);
+	m_vRotspeed.push_back(pPart->m_Rotspeed);
+	m_vLife.push_back(Life);
+	m_vLifeSpan.push_back(pPart->m_LifeSpan);
+	m_vGravity.push_back(pPart->m_Gravity);
+	m_vFriction.push_back(pPart->m_Friction);
+	m_vCollides.push_back(pPart->m_Collides);
+
+	CLook &Look = m_vLook.emplace_back();
+	Look.m_Spr = pPart->m_Spr;
+	Look.m_StartSize = pPart->m_StartSize;
+	Look.m_EndSize = pPart->m_EndSize;
+	Look.m_UseAlphaFading = pPart->m_UseAlphaFading;
+	Look.m_StartAlpha = pPart->m_StartAlpha;
+	Look.m_EndAlpha = pPart->m_EndAlpha;
+	Look.m_Color = pPart->m_Color;
+}
+
+int CParticles::CPool::RemoveDead()
+{
+	const int Num = Size();
+	int Alive = 0;
+	for(int i = 0; i < Num; i++)
+	{
+		if(m_vLife[i] > m_vLifeSpan[i])
+			continue;
+		if(Alive != i)
+		{
+			m_vPosX[Alive] = m_vPosX[i];
+			m_vPosY[Alive] = m_vPosY[i];
+			m_vVelX[Alive] = m_vVelX[i];
+			m_vVelY[Alive] = m_vVelY[i];
+			m_vRot[Alive] = m_vRot[i];
+			m_vRotspeed[Alive] = m_vRotspeed[i];
+			m_vLife[Alive] = m_vLife[i];
+			m_vLifeSpan[Alive] = m_vLifeSpan[i];
+			m_vGravity[Alive] = m_vGravity[i];
+			m_vFriction[Alive] = m_vFriction[i];
+			m_vCollides[Alive] = m_vCollides[i];
+			m_vLook[Alive] = m_vLook[i];
+		}
+		Alive++;
+	}
+	if(Alive == Num)
+		return 0;
+
+	m_vPosX.resize(Alive);
+	m_vPosY.resize(Alive);
+	m_vVelX.resize(Alive);
+	m_vVelY.resize(Alive);
+	m_vRot.resize(Alive);
+	m_vRotspeed.resize(Alive);
+	m_vLife.resize(Alive);
+	m_vLifeSpan.resize(Alive);
+	m_vGravity.resize(Alive);
+	m_vFriction.resize(Alive);
+	m_vCollides.resize(Alive);
+	m_vLook.resize(Alive);
+	return Num - Alive;
+}
+
+void CParticles::CPool::Clear()
+{
+	m_vPosX.clear();
+	m_vPosY.clear();
+	m_vVelX.clear();
+	m_vVelY.clear();
+	m_vRot.clear();
+	m_vRotspeed.clear();
+	m_vLife.clear();
+	m_vLifeSpan.clear();
+	m_vGravity.clear();
+	m_vFriction.clear();
+	m_vCollides.clear();
+	m_vLook.clear();
+	m_vColliding.clear();
+}
+
+void CParticles::CCollisionWork::MoveChunks()
+{
+	while(true)
+	{
+		const int Chunk = m_NextChunk.fetch_add(1);
+		if(Chunk >= (int)m_vChunks.size())
+			return;
+		MoveChunk(m_pCollision, m_vChunks[Chunk], m_TimePassed, m_Seed + Chunk);
+		m_NumDone.fetch_add(1);
+	}
+}
+
 CParticles::CParticles()
 {
 	OnReset();
@@ -17,23 +133,18 @@ CParticles::CParticles()
 	m_RenderExplosions.m_pParts = this;
 	m_RenderExtra.m_pParts = this;
 	m_RenderGeneral.m_pParts = this;
+	m_RenderTrail.m_pName = "particles trail";
+	m_RenderExplosions.m_pName = "particles explosions";
+	m_RenderExtra.m_pName = "particles extra";
+	m_RenderGeneral.m_pName = "particles general";
 }
 
 void CParticles::OnReset()
 {
 	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
-	{
-		m_aParticles[i].m_PrevPart = i - 1;
-		m_aParticles[i].m_NextPart = i + 1;
-	}
-
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES - 1].m_NextPart = -1;
-	m_FirstFree = 0;
-
-	for(int &FirstPart : m_aFirstPart)
-		FirstPart = -1;
+	for(CPool &Pool : m_aPools)
+		Pool.Clear();
+	m_NumParticles = 0;
 }
 
 void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
@@ -50,27 +161,70 @@ void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
 			return;
 	}
 
-	if(m_FirstFree == -1)
+	if(m_NumParticles >= MAX_PARTICLES)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
+	m_aPools[Group].Add(pPart, TimePassed);
+	m_NumParticles++;
+}
 
-	// copy data
-	m_aParticles[Id] = *pPart;
+void CParticles::MoveChunk(const CCollision *pCollision, const CCollisionChunk &Chunk, float TimePassed, unsigned Seed)
+{
+	// rand() is not meant to be used by several threads, every chunk
+	// draws the elasticities from its own generator
+	unsigned Random = Seed * 2654435761u + 1;
+	CPool *pPool = Chunk.m_pPool;
+	for(int c = Chunk.m_Begin; c < Chunk.m_End; c++)
+	{
+		const int i = pPool->m_vColliding[c];
+		Random ^= Random << 13;
+		Random ^= Random >> 17;
+		Random ^= Random << 5;
+		const float Elasticity = 0.1f + 0.9f * ((Random >> 8) / (float)(1 << 24));
+
+		vec2 Pos = vec2(pPool->m_vPosX[i], pPool->m_vPosY[i]);
+		vec2 Vel = vec2(pPool->m_vVelX[i], pPool->m_vVelY[i]) * TimePassed;
+		pCollision->MovePoint(&Pos, &Vel, Elasticity, NULL);
+		pPool->m_vPosX[i] = Pos.x;
+		pPool->m_vPosY[i] = Pos.y;
+		pPool->m_vVelX[i] = Vel.x * (1.0f / TimePassed);
+		pPool->m_vVelY[i] = Vel.y * (1.0f / TimePassed);
+	}
+}
+
+void CParticles::MoveCollidingParticles(float TimePassed)
+{
+	const unsigned Seed = rand();
+	int NumColliding = 0;
+	for(CPool &Pool : m_aPools)
+		NumColliding += Pool.m_vColliding.size();
+
+	if(NumColliding < MIN_PARALLEL_COLLISIONS)
+	{
+		for(CPool &Pool : m_aPools)
+			MoveChunk(Collision(), {&Pool, 0, (int)Pool.m_vColliding.size()}, TimePassed, Seed + (&Pool - m_aPools));
+		return;
+	}
+
+	// the main thread moves chunks as well, so it never waits for jobs
+	// that didn't start yet
+	std::shared_ptr<CCollisionWork> pWork = std::make_shared<CCollisionWork>();
+	pWork->m_pCollision = Collision();
+	pWork->m_TimePassed = TimePassed;
+	pWork->m_Seed = Seed;
+	for(CPool &Pool : m_aPools)
+	{
+		for(int Begin = 0; Begin < (int)Pool.m_vColliding.size(); Begin += COLLISION_CHUNK_SIZE)
+			pWork->m_vChunks.push_back({&Pool, Begin, minimum(Begin + COLLISION_CHUNK_SIZE, (int)Pool.m_vColliding.size())});
+	}
 
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
+	const int NumJobs = minimum((int)MAX_COLLISION_JOBS, (int)pWork->m_vChunks.size() - 1);
+	for(int i = 0; i < NumJobs; i++)
+		Engine()->AddJob(std::make_shared<CCollisionJob>(pWork));
 
-	// set some parameters
-	m_aParticles[Id].m_Life = TimePassed;
+	pWork->MoveChunks();
+	while(pWork->m_NumDone.load() < (int)pWork->m_vChunks.size())
+		std::this_thread::yield();
 }
 
 void CParticles::Update(float TimePassed)
@@ -91,56 +245,60 @@ void CParticles::Update(float TimePassed)
 		FrictionFraction -= 0.05f;
 	}
 
-	for(int &FirstPart : m_aFirstPart)
+	// plain loops over the arrays, so the compiler can vectorize them
+	for(CPool &Pool : m_aPools)
 	{
-		int i = FirstPart;
-		while(i != -1)
+		const int Num = Pool.Size();
+		float *pPosX = Pool.m_vPosX.data();
+		float *pPosY = Pool.m_vPosY.data();
+		float *pVelX = Pool.m_vVelX.data();
+		float *pVelY = Pool.m_vVelY.data();
+		float *pRot = Pool.m_vRot.data();
+		float *pLife = Pool.m_vLife.data();
+		const float *pRotspeed = Pool.m_vRotspeed.data();
+		const float *pGravity = Pool.m_vGravity.data();
+		const float *pFriction = Pool.m_vFriction.data();
+		const uint8_t *pCollides = Pool.m_vCollides.data();
+
+		for(int i = 0; i < Num; i++)
+			pVelY[i] += pGravity[i] * TimePassed;
+
+		for(int f = 0; f < FrictionCount; f++) // apply friction
 		{
-			int Next = m_aParticles[i].m_NextPart;
-			//m_aParticles[i].vel += flow_get(m_aParticles[i].pos)*time_passed * m_aParticles[i].flow_affected;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity * TimePassed;
-
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
-
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel * TimePassed;
-			if(m_aParticles[i].m_Collides)
-			{
-				Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, random_float(0.1f, 1.0f), NULL);
-			}
-			else
+			for(int i = 0; i < Num; i++)
 			{
-				m_aParticles[i].m_Pos += Vel;
+				pVelX[i] *= pFriction[i];
+				pVelY[i] *= pFriction[i];
 			}
-			m_aParticles[i].m_Vel = Vel * (1.0f / TimePassed);
+		}
 
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
+		// colliding particles are moved afterwards
+		for(int i = 0; i < Num; i++)
+		{
+			const float Move = pCollides[i] ? 0.0f : TimePassed;
+			pPosX[i] += pVelX[i] * Move;
+			pPosY[i] += pVelY[i] * Move;
+		}
 
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					FirstPart = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
+		for(int i = 0; i < Num; i++)
+		{
+			pLife[i] += TimePassed;
+			pRot[i] += TimePassed * pRotspeed[i];
+		}
 
-			i = Next;
+		Pool.m_vColliding.clear();
+		for(int i = 0; i < Num; i++)
+		{
+			if(pCollides[i])
+				Pool.m_vColliding.push_back(i);
 		}
 	}
+
+	MoveCollidingParticles(TimePassed);
+
+	// check particle death
+	for(CPool &Pool : m_aPools)
+		m_NumParticles -= Pool.RemoveDead();
 }
 
 void CParticles::OnRender()
@@ -216,12 +374,14 @@ void CParticles::RenderGroup(int Group)
 		ParticleQuadContainerIndex = m_ExtraParticleQuadContainerIndex;
 	}
 
+	// the newest particles are rendered first
+	const CPool &Pool = m_aPools[Group];
+	const int Num = Pool.Size();
+
 	// don't use the buffer methods here, else the old renderer gets many draw calls
 	if(Graphics()->IsQuadContainerBufferingEnabled())
 	{
-		int i = m_aFirstPart[Group];
-
-		static IGraphics::SRenderSpriteInfo s_aParticleRenderInfo[MAX_PARTICLES];
+		static IGraphics::SRenderSpriteInfo s_aParticleRenderInfo[gs_GraphicsMaxParticlesRenderCount];
 
 		int CurParticleRenderCount = 0;
 
@@ -229,44 +389,46 @@ void CParticles::RenderGroup(int Group)
 		ColorRGBA LastColor;
 		int LastQuadOffset = 0;
 
-		if(i != -1)
+		if(Num > 0)
 		{
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
+			const CPool::CLook &Look = Pool.m_vLook[Num - 1];
+			float Alpha = Look.m_Color.a;
+			if(Look.m_UseAlphaFading)
 			{
-				float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
+				float a = Pool.m_vLife[Num - 1] / Pool.m_vLifeSpan[Num - 1];
+				Alpha = mix(Look.m_StartAlpha, Look.m_EndAlpha, a);
 			}
-			LastColor.r = m_aParticles[i].m_Color.r;
-			LastColor.g = m_aParticles[i].m_Color.g;
-			LastColor.b = m_aParticles[i].m_Color.b;
+			LastColor.r = Look.m_Color.r;
+			LastColor.g = Look.m_Color.g;
+			LastColor.b = Look.m_Color.b;
 			LastColor.a = Alpha;
 
 			Graphics()->SetColor(
-				m_aParticles[i].m_Color.r,
-				m_aParticles[i].m_Color.g,
-				m_aParticles[i].m_Color.b,
+				Look.m_Color.r,
+				Look.m_Color.g,
+				Look.m_Color.b,
 				Alpha);
 
-			LastQuadOffset = m_aParticles[i].m_Spr;
+			LastQuadOffset = Look.m_Spr;
 		}
 
-		while(i != -1)
+		for(int i = Num - 1; i >= 0; i--)
 		{
-			int QuadOffset = m_aParticles[i].m_Spr;
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
+			const CPool::CLook &Look = Pool.m_vLook[i];
+			int QuadOffset = Look.m_Spr;
+			float a = Pool.m_vLife[i] / Pool.m_vLifeSpan[i];
+			vec2 p = vec2(Pool.m_vPosX[i], Pool.m_vPosY[i]);
+			float Size = mix(Look.m_StartSize, Look.m_EndSize, a);
+			float Alpha = Look.m_Color.a;
+			if(Look.m_UseAlphaFading)
 			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
+				Alpha = mix(Look.m_StartAlpha, Look.m_EndAlpha, a);
 			}
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
 			if(ParticleIsVisibleOnScreen(p, Size))
 			{
-				if((size_t)CurParticleRenderCount == gs_GraphicsMaxParticlesRenderCount || LastColor.r != m_aParticles[i].m_Color.r || LastColor.g != m_aParticles[i].m_Color.g || LastColor.b != m_aParticles[i].m_Color.b || LastColor.a != Alpha || LastQuadOffset != QuadOffset)
+				if((size_t)CurParticleRenderCount == gs_GraphicsMaxParticlesRenderCount || LastColor.r != Look.m_Color.r || LastColor.g != Look.m_Color.g || LastColor.b != Look.m_Color.b || LastColor.a != Alpha || LastQuadOffset != QuadOffset)
 				{
 					Graphics()->TextureSet(aParticles[LastQuadOffset - FirstParticleOffset]);
 					Graphics()->RenderQuadContainerAsSpriteMultiple(ParticleQuadContainerIndex, LastQuadOffset - FirstParticleOffset, CurParticleRenderCount, s_aParticleRenderInfo);
@@ -274,26 +436,24 @@ void CParticles::RenderGroup(int Group)
 					LastQuadOffset = QuadOffset;
 
 					Graphics()->SetColor(
-						m_aParticles[i].m_Color.r,
-						m_aParticles[i].m_Color.g,
-						m_aParticles[i].m_Color.b,
+						Look.m_Color.r,
+						Look.m_Color.g,
+						Look.m_Color.b,
 						Alpha);
 
-					LastColor.r = m_aParticles[i].m_Color.r;
-					LastColor.g = m_aParticles[i].m_Color.g;
-					LastColor.b = m_aParticles[i].m_Color.b;
+					LastColor.r = Look.m_Color.r;
+					LastColor.g = Look.m_Color.g;
+					LastColor.b = Look.m_Color.b;
 					LastColor.a = Alpha;
 				}
 
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[0] = p.x;
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[1] = p.y;
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Scale = Size;
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = m_aParticles[i].m_Rot;
+				s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = Pool.m_vRot[i];
 
 				++CurParticleRenderCount;
 			}
-
-			i = m_aParticles[i].m_NextPart;
 		}
 
 		Graphics()->TextureSet(aParticles[LastQuadOffset - FirstParticleOffset]);
@@ -301,42 +461,39 @@ void CParticles::RenderGroup(int Group)
 	}
 	else
 	{
-		int i = m_aFirstPart[Group];
-
 		Graphics()->BlendNormal();
 		Graphics()->WrapClamp();
 
-		while(i != -1)
+		for(int i = Num - 1; i >= 0; i--)
 		{
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
+			const CPool::CLook &Look = Pool.m_vLook[i];
+			float a = Pool.m_vLife[i] / Pool.m_vLifeSpan[i];
+			vec2 p = vec2(Pool.m_vPosX[i], Pool.m_vPosY[i]);
+			float Size = mix(Look.m_StartSize, Look.m_EndSize, a);
+			float Alpha = Look.m_Color.a;
+			if(Look.m_UseAlphaFading)
 			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
+				Alpha = mix(Look.m_StartAlpha, Look.m_EndAlpha, a);
 			}
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
 			if(ParticleIsVisibleOnScreen(p, Size))
 			{
-				Graphics()->TextureSet(aParticles[m_aParticles[i].m_Spr - FirstParticleOffset]);
+				Graphics()->TextureSet(aParticles[Look.m_Spr - FirstParticleOffset]);
 				Graphics()->QuadsBegin();
 
-				Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
+				Graphics()->QuadsSetRotation(Pool.m_vRot[i]);
 
 				Graphics()->SetColor(
-					m_aParticles[i].m_Color.r,
-					m_aParticles[i].m_Color.g,
-					m_aParticles[i].m_Color.b,
+					Look.m_Color.r,
+					Look.m_Color.g,
+					Look.m_Color.b,
 					Alpha);
 
 				IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
 				Graphics()->QuadsDraw(&QuadItem, 1);
 				Graphics()->QuadsEnd();
 			}
-
-			i = m_aParticles[i].m_NextPart;
 		}
 		Graphics()->WrapNormal();
 		Graphics()->BlendNormal();
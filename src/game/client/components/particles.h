@@ -2,9 +2,16 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef GAME_CLIENT_COMPONENTS_PARTICLES_H
 #define GAME_CLIENT_COMPONENTS_PARTICLES_H
+#include <base/color.h>
 #include <base/vmath.h>
 #include <game/client/component.h>
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class CCollision;
+
 // particles
 struct CParticle
 {
@@ -51,11 +58,6 @@ struct CParticle
 	ColorRGBA m_Color;
 
 	bool m_Collides;
-
-	// set by the particle system
-	float m_Life;
-	int m_PrevPart;
-	int m_NextPart;
 };
 
 class CParticles : public CComponent
@@ -74,6 +76,7 @@ public:
 
 	CParticles();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "particles"; }
 
 	void Add(int Group, CParticle *pPart, float TimePassed = 0.f);
 
@@ -88,21 +91,95 @@ private:
 	enum
 	{
 		MAX_PARTICLES = 1024 * 8,
+		// colliding particles per job
+		COLLISION_CHUNK_SIZE = 512,
+		// fewer colliding particles are moved on the main thread only
+		MIN_PARALLEL_COLLISIONS = 2048,
+		MAX_COLLISION_JOBS = 2,
+	};
+
+	// The particles of a group, one array per member so the integration
+	// runs over contiguous memory. Dead particles are removed by moving
+	// the following ones down, which keeps them in the order they were
+	// added in.
+	class CPool
+	{
+	public:
+		// simulated every frame
+		std::vector<float> m_vPosX;
+		std::vector<float> m_vPosY;
+		std::vector<float> m_vVelX;
+		std::vector<float> m_vVelY;
+		std::vector<float> m_vRot;
+		std::vector<float> m_vRotspeed;
+		std::vector<float> m_vLife;
+		std::vector<float> m_vLifeSpan;
+		std::vector<float> m_vGravity;
+		std::vector<float> m_vFriction;
+		std::vector<uint8_t> m_vCollides;
+
+		// only needed for rendering
+		struct CLook
+		{
+			int m_Spr;
+			float m_StartSize;
+			float m_EndSize;
+			bool m_UseAlphaFading;
+			float m_StartAlpha;
+			float m_EndAlpha;
+			ColorRGBA m_Color;
+		};
+		std::vector<CLook> m_vLook;
+
+		// indices of the colliding particles, rebuilt every update
+		std::vector<int> m_vColliding;
+
+		int Size() const { return m_vPosX.size(); }
+		void Add(const CParticle *pPart, float Life);
+		// removes the particles that outlived their life span, returns how many
+		int RemoveDead();
+		void Clear();
 	};
 
-	CParticle m_aParticles[MAX_PARTICLES];
-	int m_FirstFree;
-	int m_aFirstPart[NUM_GROUPS];
+	struct CCollisionChunk
+	{
+		CPool *m_pPool;
+		int m_Begin;
+		int m_End;
+	};
+
+	// shared with the jobs, which might only start after the update is done
+	struct CCollisionWork
+	{
+		const CCollision *m_pCollision;
+		float m_TimePassed;
+		unsigned m_Seed;
+		std::vector<CCollisionChunk> m_vChunks;
+		std::atomic<int> m_NextChunk{0};
+		std::atomic<int> m_NumDone{0};
+
+		// moves chunks until none is left
+		void MoveChunks();
+	};
+
+	class CCollisionJob;
+
+	CPool m_aPools[NUM_GROUPS];
+	int m_NumParticles;
 
 	void RenderGroup(int Group);
 	void Update(float TimePassed);
+	void MoveCollidingParticles(float TimePassed);
+	static void MoveChunk(const CCollision *pCollision, const CCollisionChunk &Chunk, float TimePassed, unsigned Seed);
 
 	template<int TGROUP>
 	class CRenderGroup : public CComponent
 	{
 	public:
 		CParticles *m_pParts;
+		const char *m_pName;
 		virtual int Sizeof() const override { return sizeof(*this); }
+		virtual const char *Name() const override { return m_pName; }
 		virtual void OnRender() override { m_pParts->RenderGroup(TGROUP); }
 	};
 
@@ -25,6 +25,8 @@
 #include <base/color.h>
 #include <base/math.h>
 
+#include <algorithm>
+
 void CPlayers::RenderHand(CTeeRenderInfo *pInfo, vec2 CenterPos, vec2 Dir, float AngleOffset, vec2 PostRotOffset, float Alpha)
 {
 	vec2 HandPos = CenterPos + Dir;
@@ -826,13 +828,28 @@ void CPlayers::OnRender()
 	}
 
 	// render everyone else's tee, then our own
+	// the others are grouped by the skin atlas page to switch textures less often
+	int aRenderOrder[MAX_CLIENTS];
+	int NumRender = 0;
 	for(int ClientID = 0; ClientID < MAX_CLIENTS; ClientID++)
 	{
 		if(ClientID == LocalClientID || !m_pClient->m_Snap.m_aCharacters[ClientID].m_Active || !IsPlayerInfoAvailable(ClientID))
 		{
 			continue;
 		}
-
+		aRenderOrder[NumRender++] = ClientID;
+	}
+	const CSkinAtlas &Atlas = m_pClient->m_Skins.Atlas();
+	auto AtlasPage = [&](int ClientID) {
+		const int Page = Atlas.PageOf(m_aRenderInfo[ClientID].m_OriginalRenderSkin.m_AtlasSkin);
+		return Page < 0 ? Atlas.NumPages() : Page;
+	};
+	std::stable_sort(aRenderOrder, aRenderOrder + NumRender, [&](int ClientID1, int ClientID2) {
+		return AtlasPage(ClientID1) < AtlasPage(ClientID2);
+	});
+	for(int i = 0; i < NumRender; i++)
+	{
+		const int ClientID = aRenderOrder[i];
 		RenderHookCollLine(&m_pClient->m_aClients[ClientID].m_RenderPrev, &m_pClient->m_aClients[ClientID].m_RenderCur, ClientID);
 
 		// don't render offscreen
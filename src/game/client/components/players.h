@@ -43,6 +43,7 @@ class CPlayers : public CComponent
 
 public:
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "players"; }
 	virtual void OnInit() override;
 	virtual void OnRender() override;
 };
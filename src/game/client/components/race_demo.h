@@ -40,6 +40,7 @@ public:
 
 	CRaceDemo();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "race demo"; }
 
 	virtual void OnReset() override;
 	virtual void OnStateChange(int NewState, int OldState) override;
@@ -23,6 +23,7 @@ class CScoreboard : public CComponent
 public:
 	CScoreboard();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "scoreboard"; }
 	virtual void OnReset() override;
 	virtual void OnConsoleInit() override;
 	virtual void OnRender() override;
@@ -110,12 +110,69 @@ static void CheckMetrics(CSkin::SSkinMetricVariable &Metrics, const uint8_t *pIm
 	Metrics.m_MaxHeight = CheckHeight;
 }
 
+// Turns the skin into the gray scale one that is colored by the tee colors.
+static void MakeColorable(CImageInfo &Info)
+{
+	unsigned char *pData = (unsigned char *)Info.m_pData;
+	const int PixelStep = 4;
+	int Pitch = Info.m_Width * PixelStep;
+	int BodyWidth = g_pData->m_aSprites[SPRITE_TEE_BODY].m_W * (Info.m_Width / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx); // body width
+	int BodyHeight = g_pData->m_aSprites[SPRITE_TEE_BODY].m_H * (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy); // body height
+
+	// make the texture gray scale
+	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
+	{
+		int v = (pData[i * PixelStep] + pData[i * PixelStep + 1] + pData[i * PixelStep + 2]) / 3;
+		pData[i * PixelStep] = v;
+		pData[i * PixelStep + 1] = v;
+		pData[i * PixelStep + 2] = v;
+	}
+
+	int aFreq[256] = {0};
+	int OrgWeight = 0;
+	int NewWeight = 192;
+
+	// find most common frequence
+	for(int y = 0; y < BodyHeight; y++)
+		for(int x = 0; x < BodyWidth; x++)
+		{
+			if(pData[y * Pitch + x * PixelStep + 3] > 128)
+				aFreq[pData[y * Pitch + x * PixelStep]]++;
+		}
+
+	for(int i = 1; i < 256; i++)
+	{
+		if(aFreq[OrgWeight] < aFreq[i])
+			OrgWeight = i;
+	}
+
+	// reorder
+	int InvOrgWeight = 255 - OrgWeight;
+	int InvNewWeight = 255 - NewWeight;
+	for(int y = 0; y < BodyHeight; y++)
+		for(int x = 0; x < BodyWidth; x++)
+		{
+			int v = pData[y * Pitch + x * PixelStep];
+			if(v <= OrgWeight && OrgWeight == 0)
+				v = 0;
+			else if(v <= OrgWeight)
+				v = (int)(((v / (float)OrgWeight) * NewWeight));
+			else if(InvOrgWeight == 0)
+				v = NewWeight;
+			else
+				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
+			pData[y * Pitch + x * PixelStep] = v;
+			pData[y * Pitch + x * PixelStep + 1] = v;
+			pData[y * Pitch + x * PixelStep + 2] = v;
+		}
+}
+
 const CSkin *CSkins::LoadSkin(const char *pName, const char *pPath, int DirType)
 {
 	CImageInfo Info;
 	if(!LoadSkinPNG(Info, pName, pPath, DirType))
 		return 0;
-	return LoadSkin(pName, Info);
+	return LoadSkin(pName, Info, pPath, DirType);
 }
 
 bool CSkins::LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath, int DirType)
@@ -130,7 +187,7 @@ bool CSkins::LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath,
 	return true;
 }
 
-const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
+const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info, const char *pPath, int DirType)
 {
 	char aBuf[512];
 
@@ -186,6 +243,14 @@ const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
 	int BodyHeight = g_pData->m_aSprites[SPRITE_TEE_BODY].m_H * (Info.m_Height / g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy); // body height
 	if(BodyWidth > Info.m_Width || BodyHeight > Info.m_Height)
 		return nullptr;
+
+	// a skin with the same name wouldn't be inserted
+	int AtlasSkin = -1;
+	if(m_Skins.find(Skin.GetName()) == m_Skins.end())
+		AtlasSkin = m_Atlas.AddSkin(Info, pPath, DirType);
+	Skin.m_OriginalSkin.m_AtlasSkin = AtlasSkin;
+	Skin.m_ColorableSkin.m_AtlasSkin = AtlasSkin;
+
 	unsigned char *pData = (unsigned char *)Info.m_pData;
 	const int PixelStep = 4;
 	int Pitch = Info.m_Width * PixelStep;
@@ -221,52 +286,7 @@ const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
 	// get feet outline size
 	CheckMetrics(Skin.m_Metrics.m_Feet, pData, Pitch, FeetOutlineOffsetX, FeetOutlineOffsetY, FeetOutlineWidth, FeetOutlineHeight);
 
-	// make the texture gray scale
-	for(int i = 0; i < Info.m_Width * Info.m_Height; i++)
-	{
-		int v = (pData[i * PixelStep] + pData[i * PixelStep + 1] + pData[i * PixelStep + 2]) / 3;
-		pData[i * PixelStep] = v;
-		pData[i * PixelStep + 1] = v;
-		pData[i * PixelStep + 2] = v;
-	}
-
-	int aFreq[256] = {0};
-	int OrgWeight = 0;
-	int NewWeight = 192;
-
-	// find most common frequence
-	for(int y = 0; y < BodyHeight; y++)
-		for(int x = 0; x < BodyWidth; x++)
-		{
-			if(pData[y * Pitch + x * PixelStep + 3] > 128)
-				aFreq[pData[y * Pitch + x * PixelStep]]++;
-		}
-
-	for(int i = 1; i < 256; i++)
-	{
-		if(aFreq[OrgWeight] < aFreq[i])
-			OrgWeight = i;
-	}
-
-	// reorder
-	int InvOrgWeight = 255 - OrgWeight;
-	int InvNewWeight = 255 - NewWeight;
-	for(int y = 0; y < BodyHeight; y++)
-		for(int x = 0; x < BodyWidth; x++)
-		{
-			int v = pData[y * Pitch + x * PixelStep];
-			if(v <= OrgWeight && OrgWeight == 0)
-				v = 0;
-			else if(v <= OrgWeight)
-				v = (int)(((v / (float)OrgWeight) * NewWeight));
-			else if(InvOrgWeight == 0)
-				v = NewWeight;
-			else
-				v = (int)(((v - OrgWeight) / (float)InvOrgWeight) * InvNewWeight + NewWeight);
-			pData[y * Pitch + x * PixelStep] = v;
-			pData[y * Pitch + x * PixelStep + 1] = v;
-			pData[y * Pitch + x * PixelStep + 2] = v;
-		}
+	MakeColorable(Info);
 
 	Skin.m_ColorableSkin.m_Body = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
 	Skin.m_ColorableSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
@@ -278,6 +298,9 @@ const CSkin *CSkins::LoadSkin(const char *pName, CImageInfo &Info)
 	for(int i = 0; i < 6; ++i)
 		Skin.m_ColorableSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(Info, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
 
+	if(AtlasSkin >= 0)
+		m_Atlas.SetColorable(AtlasSkin, Info);
+
 	Graphics()->FreePNG(&Info);
 
 	// set skin data
@@ -309,12 +332,23 @@ void CSkins::OnInit()
 		}
 	}
 
+	m_Atlas.Init(Graphics(), Engine(), MakeColorable);
+	m_Atlas.SetNumPages(g_Config.m_ClSkinAtlasPages);
+	RenderTools()->SetSkinAtlas(&m_Atlas);
+
 	// load skins;
 	Refresh([this](int SkinCounter) {
 		GameClient()->m_Menus.RenderLoading(Localize("Loading DDNet Client"), Localize("Loading skin files"), 0);
 	});
 }
 
+void CSkins::OnRender()
+{
+	if(m_Atlas.NumPages() != g_Config.m_ClSkinAtlasPages)
+		m_Atlas.SetNumPages(g_Config.m_ClSkinAtlasPages);
+	m_Atlas.NewFrame();
+}
+
 void CSkins::Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc)
 {
 	for(const auto &SkinIt : m_Skins)
@@ -340,6 +374,7 @@ void CSkins::Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc)
 	}
 
 	m_Skins.clear();
+	m_Atlas.Clear();
 	m_DownloadSkins.clear();
 	m_DownloadingSkins = 0;
 	SSkinScanUser SkinScanUser;
@@ -422,7 +457,7 @@ const CSkin *CSkins::FindImpl(const char *pName)
 			char aPath[IO_MAX_PATH_LENGTH];
 			str_format(aPath, sizeof(aPath), "downloadedskins/%s.png", SkinDownloadIt->second->GetName());
 			Storage()->RenameFile(SkinDownloadIt->second->m_aPath, aPath, IStorage::TYPE_SAVE);
-			const auto *pSkin = LoadSkin(SkinDownloadIt->second->GetName(), SkinDownloadIt->second->m_pTask->m_Info);
+			const auto *pSkin = LoadSkin(SkinDownloadIt->second->GetName(), SkinDownloadIt->second->m_pTask->m_Info, aPath, IStorage::TYPE_SAVE);
 			SkinDownloadIt->second->m_pTask = nullptr;
 			--m_DownloadingSkins;
 			return pSkin;
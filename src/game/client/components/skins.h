@@ -7,6 +7,7 @@
 #include <engine/shared/http.h>
 #include <game/client/component.h>
 #include <game/client/skin.h>
+#include <game/client/skin_atlas.h>
 #include <string_view>
 #include <unordered_map>
 
@@ -59,7 +60,9 @@ public:
 	typedef std::function<void(int)> TSkinLoadedCBFunc;
 
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "skins"; }
 	void OnInit() override;
+	void OnRender() override;
 
 	void Refresh(TSkinLoadedCBFunc &&SkinLoadedFunc);
 	int Num();
@@ -69,6 +72,8 @@ public:
 
 	bool IsDownloadingSkins() { return m_DownloadingSkins; }
 
+	const CSkinAtlas &Atlas() const { return m_Atlas; }
+
 	static bool IsVanillaSkin(const char *pName);
 
 	constexpr static const char *VANILLA_SKINS[] = {"bluekitty", "bluestripe", "brownbear",
@@ -81,10 +86,11 @@ private:
 	std::unordered_map<std::string_view, std::unique_ptr<CDownloadSkin>> m_DownloadSkins;
 	size_t m_DownloadingSkins = 0;
 	char m_aEventSkinPrefix[24];
+	CSkinAtlas m_Atlas;
 
 	bool LoadSkinPNG(CImageInfo &Info, const char *pName, const char *pPath, int DirType);
 	const CSkin *LoadSkin(const char *pName, const char *pPath, int DirType);
-	const CSkin *LoadSkin(const char *pName, CImageInfo &Info);
+	const CSkin *LoadSkin(const char *pName, CImageInfo &Info, const char *pPath, int DirType);
 	const CSkin *FindImpl(const char *pName);
 	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
 };
@@ -53,6 +53,7 @@ public:
 	};
 
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "sounds"; }
 	virtual void OnInit() override;
 	virtual void OnReset() override;
 	virtual void OnStateChange(int NewState, int OldState) override;
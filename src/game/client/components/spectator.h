@@ -34,6 +34,7 @@ class CSpectator : public CComponent
 public:
 	CSpectator();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "spectator"; }
 
 	virtual void OnConsoleInit() override;
 	virtual bool OnCursorMove(float x, float y, IInput::ECursorType CursorType) override;
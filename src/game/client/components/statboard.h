@@ -23,6 +23,7 @@ private:
 public:
 	CStatboard();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "statboard"; }
 	virtual void OnReset() override;
 	virtual void OnConsoleInit() override;
 	virtual void OnRender() override;
@@ -40,6 +40,7 @@ class CTooltips : public CComponent
 public:
 	CTooltips();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "tooltips"; }
 
 	/**
 	 * Adds the tooltip to a cache and renders it when active.
@@ -40,6 +40,7 @@ public:
 
 	CVoting();
 	virtual int Sizeof() const override { return sizeof(*this); }
+	virtual const char *Name() const override { return "voting"; }
 	virtual void OnReset() override;
 	virtual void OnConsoleInit() override;
 	virtual void OnMessage(int Msgtype, void *pRawMsg) override;
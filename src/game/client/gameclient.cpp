@@ -14,6 +14,7 @@
 #include <engine/map.h>
 #include <engine/serverbrowser.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/sound.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
@@ -82,6 +83,7 @@ const char *CGameClient::GetItemName(int Type) const { return m_NetObjHandler.Ge
 void CGameClient::OnConsoleInit()
 {
 	m_pEngine = Kernel()->RequestInterface<IEngine>();
+	m_pProfiler = Kernel()->RequestInterface<CProfiler>();
 	m_pClient = Kernel()->RequestInterface<IClient>();
 	m_pTextRender = Kernel()->RequestInterface<ITextRender>();
 	m_pSound = Kernel()->RequestInterface<ISound>();
@@ -642,7 +644,10 @@ void CGameClient::OnRender()
 
 	// render all systems
 	for(auto &pComponent : m_vpAll)
+	{
+		CProfiler::CScope Profile(m_pProfiler, pComponent->Name());
 		pComponent->OnRender();
+	}
 
 	// clear all events/input for this frame
 	Input()->Clear();
@@ -1139,6 +1144,8 @@ void CGameClient::InvalidateSnapshot()
 
 void CGameClient::OnNewSnapshot()
 {
+	CProfiler::CScope Profile(m_pProfiler, "OnNewSnapshot");
+
 	auto &&Evolve = [this](CNetObj_Character *pCharacter, int Tick) {
 		CWorldCore TempWorld;
 		CCharacterCore TempCore = CCharacterCore();
@@ -1699,7 +1706,10 @@ void CGameClient::OnNewSnapshot()
 	m_LastDummyConnected = Client()->DummyConnected();
 
 	for(auto &pComponent : m_vpAll)
+	{
+		CProfiler::CScope ProfileComponent(m_pProfiler, pComponent->Name());
 		pComponent->OnNewSnapshot();
+	}
 
 	// detect air jump for other players
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -1727,6 +1737,8 @@ void CGameClient::OnNewSnapshot()
 
 void CGameClient::OnPredict()
 {
+	CProfiler::CScope Profile(m_pProfiler, "OnPredict");
+
 	// store the previous values so we can detect prediction errors
 	CCharacterCore BeforePrevChar = m_PredictedPrevChar;
 	CCharacterCore BeforeChar = m_PredictedChar;
@@ -158,6 +158,7 @@ private:
 	CNetObjHandler m_NetObjHandler;
 
 	class IEngine *m_pEngine;
+	class CProfiler *m_pProfiler;
 	class IInput *m_pInput;
 	class IGraphics *m_pGraphics;
 	class ITextRender *m_pTextRender;
@@ -210,6 +211,7 @@ private:
 public:
 	IKernel *Kernel() { return IInterface::Kernel(); }
 	IEngine *Engine() const { return m_pEngine; }
+	class CProfiler *Profiler() const { return m_pProfiler; }
 	class IGraphics *Graphics() const { return m_pGraphics; }
 	class IClient *Client() const { return m_pClient; }
 	class CUI *UI() { return &m_UI; }
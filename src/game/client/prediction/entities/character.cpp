@@ -931,6 +931,24 @@ void CCharacter::HandleTiles(int Index)
 	{
 		m_LastRefillJumps = false;
 	}
+
+	if(GameWorld()->m_pTeleOuts && GameWorld()->m_pTeleCheckOuts)
+	{
+		HandleTeleports(MapIndex);
+	}
+}
+
+void CCharacter::HandleTeleports(int MapIndex)
+{
+	int TeleCheckpoint = Collision()->IsTeleCheckpoint(MapIndex);
+	if(TeleCheckpoint)
+		m_TeleCheckpoint = TeleCheckpoint;
+
+	// unlike the server, don't teleport to the start if no checkpoint out is found, the spawn points aren't known here
+	if(m_Core.HandleTeleports(MapIndex, m_TeleCheckpoint, GameWorld()->m_pTeleCheckOuts) == CCharacterCore::TELEPORT_RELEASE_HOOKED)
+	{
+		GameWorld()->ReleaseHooked(GetCID());
+	}
 }
 
 void CCharacter::HandleTuneLayer()
@@ -1029,11 +1047,11 @@ void CCharacter::DDRacePostCoreTick()
 	HandleSkippableTiles(CurrentIndex);
 
 	// handle Anti-Skip tiles
-	std::list<int> Indices = Collision()->GetMapIndices(m_PrevPos, m_Pos);
-	if(!Indices.empty())
-		for(int Index : Indices)
-			HandleTiles(Index);
-	else
+	int NumIndices = Collision()->VisitMapIndices(m_PrevPos, m_Pos, [this](int Index) {
+		HandleTiles(Index);
+		return true;
+	});
+	if(!NumIndices)
 	{
 		HandleTiles(CurrentIndex);
 	}
@@ -1121,7 +1139,7 @@ CCharacter::CCharacter(CGameWorld *pGameWorld, int ID, CNetObj_Character *pChar,
 	m_LastRefillJumps = false;
 	m_PrevPrevPos = m_PrevPos = m_Pos = vec2(pChar->m_X, pChar->m_Y);
 	m_Core.Reset();
-	m_Core.Init(&GameWorld()->m_Core, GameWorld()->Collision(), GameWorld()->Teams());
+	m_Core.Init(&GameWorld()->m_Core, GameWorld()->Collision(), GameWorld()->Teams(), GameWorld()->m_pTeleOuts);
 	m_Core.m_Id = ID;
 	mem_zero(&m_Core.m_Ninja, sizeof(m_Core.m_Ninja));
 	m_Core.m_LeftWall = true;
@@ -1358,6 +1376,7 @@ void CCharacter::SetCoreWorld(CGameWorld *pGameWorld)
 	m_Core.m_pWorld = &pGameWorld->m_Core;
 	m_Core.m_pCollision = pGameWorld->Collision();
 	m_Core.m_pTeams = pGameWorld->Teams();
+	m_Core.m_pTeleOuts = pGameWorld->m_pTeleOuts;
 }
 
 bool CCharacter::Match(CCharacter *pChar)
@@ -167,6 +167,7 @@ private:
 	static bool IsSwitchActiveCb(int Number, void *pUser);
 	void HandleTiles(int Index);
 	void HandleSkippableTiles(int Index);
+	void HandleTeleports(int MapIndex);
 	void DDRaceTick();
 	void DDRacePostCoreTick();
 	void HandleTuneLayer();
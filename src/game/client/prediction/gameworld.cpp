@@ -24,6 +24,8 @@ CGameWorld::CGameWorld()
 	for(auto &pCharacter : m_apCharacters)
 		pCharacter = 0;
 	m_pCollision = 0;
+	m_pTeleOuts = 0;
+	m_pTeleCheckOuts = 0;
 	m_GameTick = 0;
 	m_pParent = 0;
 	m_pChild = 0;
@@ -582,6 +584,8 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 		m_Core.m_aTuning[i] = pFrom->m_Core.m_aTuning[i];
 	}
 	m_pTuningList = pFrom->m_pTuningList;
+	m_pTeleOuts = pFrom->m_pTeleOuts;
+	m_pTeleCheckOuts = pFrom->m_pTeleCheckOuts;
 	m_Teams = pFrom->m_Teams;
 	m_Core.m_vSwitchers = pFrom->m_Core.m_vSwitchers;
 	// delete the previous entities
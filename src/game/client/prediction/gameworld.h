@@ -7,6 +7,8 @@
 #include <game/teamscore.h>
 
 #include <list>
+#include <map>
+#include <vector>
 
 class CCollision;
 class CCharacter;
@@ -97,6 +99,10 @@ public:
 	CTuningParams *TuningList() { return m_pTuningList; }
 	CTuningParams *GetTuning(int i) { return &TuningList()[i]; }
 
+	// teleporter outs by number, only set if the random outs can be chosen like on the server
+	std::map<int, std::vector<vec2>> *m_pTeleOuts;
+	std::map<int, std::vector<vec2>> *m_pTeleCheckOuts;
+
 private:
 	void RemoveEntities();
 
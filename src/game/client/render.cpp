@@ -6,6 +6,7 @@
 
 #include "animstate.h"
 #include "render.h"
+#include "skin_atlas.h"
 
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
@@ -277,6 +278,38 @@ void CRenderTools::RenderTee(CAnimState *pAnim, CTeeRenderInfo *pInfo, int Emote
 
 	const CSkin::SSkinTextures *pSkinTextures = pInfo->m_CustomColoredSkin ? &pInfo->m_ColorableRenderSkin : &pInfo->m_OriginalRenderSkin;
 
+	// skins in the atlas are drawn as quads of one texture, which can be
+	// merged with the ones of other tees on the same atlas page
+	CSkinAtlas::CSlot AtlasSlot;
+	const bool UseAtlas = m_pSkinAtlas && pSkinTextures->m_AtlasSkin >= 0 && m_pSkinAtlas->Use(pSkinTextures->m_AtlasSkin, &AtlasSlot);
+	if(UseAtlas)
+	{
+		Graphics()->TextureSet(m_pSkinAtlas->Page(AtlasSlot.m_Page));
+		Graphics()->QuadsBegin();
+	}
+
+	auto RenderPart = [&](IGraphics::CTextureHandle Texture, int Sprite, int QuadOffset, float x, float y, float ScaleX, float ScaleY) {
+		if(!UseAtlas)
+		{
+			Graphics()->TextureSet(Texture);
+			Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset, x, y, ScaleX, ScaleY);
+			return;
+		}
+
+		// same size and orientation as the quad in the container
+		const float Width = QuadOffset >= 2 && QuadOffset < 7 ? 64.0f * 0.4f : 64.0f;
+		const float Height = QuadOffset >= 7 ? 32.0f : Width;
+		float U0, V0, U1, V1;
+		CSkinAtlas::PartRect(&AtlasSlot, pInfo->m_CustomColoredSkin, &g_pData->m_aSprites[Sprite], &U0, &V0, &U1, &V1);
+		if((QuadOffset >= 9) != (ScaleX < 0))
+			std::swap(U0, U1);
+		if(ScaleY < 0)
+			std::swap(V0, V1);
+		Graphics()->QuadsSetSubset(U0, V0, U1, V1);
+		IGraphics::CQuadItem QuadItem(x, y, Width * absolute(ScaleX), Height * absolute(ScaleY));
+		Graphics()->QuadsDraw(&QuadItem, 1);
+	};
+
 	// first pass we draw the outline
 	// second pass we draw the filling
 	for(int p = 0; p < 2; p++)
@@ -296,8 +329,7 @@ void CRenderTools::RenderTee(CAnimState *pAnim, CTeeRenderInfo *pInfo, int Emote
 				vec2 BodyPos = Position + vec2(pAnim->GetBody()->m_X, pAnim->GetBody()->m_Y) * AnimScale;
 				float BodyScale;
 				GetRenderTeeBodyScale(BaseSize, BodyScale);
-				Graphics()->TextureSet(OutLine == 1 ? pSkinTextures->m_BodyOutline : pSkinTextures->m_Body);
-				Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, OutLine, BodyPos.x, BodyPos.y, BodyScale, BodyScale);
+				RenderPart(OutLine == 1 ? pSkinTextures->m_BodyOutline : pSkinTextures->m_Body, OutLine == 1 ? SPRITE_TEE_BODY_OUTLINE : SPRITE_TEE_BODY, OutLine, BodyPos.x, BodyPos.y, BodyScale, BodyScale);
 
 				// draw eyes
 				if(p == 1)
@@ -334,9 +366,8 @@ void CRenderTools::RenderTee(CAnimState *pAnim, CTeeRenderInfo *pInfo, int Emote
 					float EyeSeparation = (0.075f - 0.010f * absolute(Direction.x)) * BaseSize;
 					vec2 Offset = vec2(Direction.x * 0.125f, -0.05f + Direction.y * 0.10f) * BaseSize;
 
-					Graphics()->TextureSet(pSkinTextures->m_aEyes[TeeEye]);
-					Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, BodyPos.x - EyeSeparation + Offset.x, BodyPos.y + Offset.y, EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
-					Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, BodyPos.x + EyeSeparation + Offset.x, BodyPos.y + Offset.y, -EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
+					RenderPart(pSkinTextures->m_aEyes[TeeEye], SPRITE_TEE_EYE_NORMAL + TeeEye, QuadOffset + EyeQuadOffset, BodyPos.x - EyeSeparation + Offset.x, BodyPos.y + Offset.y, EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
+					RenderPart(pSkinTextures->m_aEyes[TeeEye], SPRITE_TEE_EYE_NORMAL + TeeEye, QuadOffset + EyeQuadOffset, BodyPos.x + EyeSeparation + Offset.x, BodyPos.y + Offset.y, -EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
 				}
 			}
 
@@ -366,11 +397,12 @@ void CRenderTools::RenderTee(CAnimState *pAnim, CTeeRenderInfo *pInfo, int Emote
 
 			Graphics()->SetColor(pInfo->m_ColorFeet.r * ColorScale, pInfo->m_ColorFeet.g * ColorScale, pInfo->m_ColorFeet.b * ColorScale, Alpha);
 
-			Graphics()->TextureSet(OutLine == 1 ? pSkinTextures->m_FeetOutline : pSkinTextures->m_Feet);
-			Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset, Position.x + pFoot->m_X * AnimScale, Position.y + pFoot->m_Y * AnimScale, w / 64.f, h / 32.f);
+			RenderPart(OutLine == 1 ? pSkinTextures->m_FeetOutline : pSkinTextures->m_Feet, OutLine == 1 ? SPRITE_TEE_FOOT_OUTLINE : SPRITE_TEE_FOOT, QuadOffset, Position.x + pFoot->m_X * AnimScale, Position.y + pFoot->m_Y * AnimScale, w / 64.f, h / 32.f);
 		}
 	}
 
+	if(UseAtlas)
+		Graphics()->QuadsEnd();
 	Graphics()->SetColor(1.f, 1.f, 1.f, 1.f);
 	Graphics()->QuadsSetRotation(0);
 }
@@ -9,6 +9,7 @@
 #include <game/client/skin.h>
 #include <game/client/ui_rect.h>
 
+class CSkinAtlas;
 class CSpeedupTile;
 class CSwitchTile;
 class CTeleTile;
@@ -76,6 +77,7 @@ class CRenderTools
 {
 	class IGraphics *m_pGraphics;
 	class ITextRender *m_pTextRender;
+	CSkinAtlas *m_pSkinAtlas = nullptr;
 
 	int m_TeeQuadContainerIndex;
 
@@ -87,6 +89,7 @@ public:
 	class ITextRender *TextRender() const { return m_pTextRender; }
 
 	void Init(class IGraphics *pGraphics, class ITextRender *pTextRender);
+	void SetSkinAtlas(CSkinAtlas *pSkinAtlas) { m_pSkinAtlas = pSkinAtlas; }
 
 	void SelectSprite(CDataSprite *pSprite, int Flags = 0, int sx = 0, int sy = 0);
 	void SelectSprite(int Id, int Flags = 0, int sx = 0, int sy = 0);
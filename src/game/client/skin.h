@@ -26,6 +26,9 @@ public:
 
 		IGraphics::CTextureHandle m_aEyes[6];
 
+		// index in the skin atlas or -1 to use the part textures
+		int m_AtlasSkin = -1;
+
 		void Reset()
 		{
 			m_Body = IGraphics::CTextureHandle();
@@ -36,6 +39,7 @@ public:
 			m_HandsOutline = IGraphics::CTextureHandle();
 			for(auto &Eye : m_aEyes)
 				Eye = IGraphics::CTextureHandle();
+			m_AtlasSkin = -1;
 		}
 	};
 
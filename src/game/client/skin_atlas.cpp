@@ -0,0 +1,238 @@
+#include "skin_atlas.h"
+
+#include <base/system.h>
+
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
+
+#include <game/generated/client_data.h>
+
+static constexpr int PIXELS_HEIGHT = CSkinAtlas::COLORABLE_OFFSET + CSkinAtlas::SKIN_HEIGHT;
+static constexpr size_t PIXELS_SIZE = (size_t)CSkinAtlas::SKIN_WIDTH * PIXELS_HEIGHT * 4;
+static constexpr size_t COLORABLE_START = (size_t)CSkinAtlas::SKIN_WIDTH * CSkinAtlas::COLORABLE_OFFSET * 4;
+
+class CSkinAtlas::CLoadJob : public IJob
+{
+	IGraphics *m_pGraphics;
+	FMakeColorable m_pfnMakeColorable;
+	std::string m_Path;
+	int m_StorageType;
+
+	void Run() override
+	{
+		CImageInfo Info;
+		if(!m_pGraphics->LoadPNG(&Info, m_Path.c_str(), m_StorageType))
+			return;
+		if(Info.m_Width == SKIN_WIDTH && Info.m_Height == SKIN_HEIGHT && Info.m_Format == CImageInfo::FORMAT_RGBA)
+		{
+			m_vData.resize(PIXELS_SIZE);
+			mem_copy(m_vData.data(), Info.m_pData, SKIN_WIDTH * SKIN_HEIGHT * 4);
+			m_pfnMakeColorable(Info);
+			mem_copy(m_vData.data() + COLORABLE_START, Info.m_pData, SKIN_WIDTH * SKIN_HEIGHT * 4);
+			m_Success = true;
+		}
+		m_pGraphics->FreePNG(&Info);
+	}
+
+public:
+	bool m_Success = false;
+	std::vector<uint8_t> m_vData;
+
+	CLoadJob(IGraphics *pGraphics, FMakeColorable pfnMakeColorable, const std::string &Path, int StorageType) :
+		m_pGraphics(pGraphics),
+		m_pfnMakeColorable(pfnMakeColorable),
+		m_Path(Path),
+		m_StorageType(StorageType)
+	{
+	}
+};
+
+void CSkinAtlas::Clear()
+{
+	SetNumPages(NumPages());
+	m_vSkins.clear();
+	m_lPixels.clear();
+}
+
+void CSkinAtlas::SetNumPages(int NumPages)
+{
+	for(auto &Page : m_vPages)
+		m_pGraphics->UnloadTexture(&Page);
+	m_vPages.clear();
+	m_vPages.resize(NumPages);
+	m_vSlots.clear();
+	m_vSlots.resize((size_t)NumPages * SLOTS_PER_PAGE, -1);
+	m_NumUsedSlots = 0;
+	for(auto &Skin : m_vSkins)
+		Skin.m_Slot = -1;
+}
+
+void CSkinAtlas::NewFrame()
+{
+	m_Frame++;
+	m_LastFrameUploads = m_FrameUploads;
+	m_FrameUploads = 0;
+}
+
+int CSkinAtlas::AddSkin(const CImageInfo &Original, const char *pPath, int StorageType)
+{
+	if(Original.m_Width != SKIN_WIDTH || Original.m_Height != SKIN_HEIGHT || Original.m_Format != CImageInfo::FORMAT_RGBA)
+		return -1;
+
+	CSkin &Skin = m_vSkins.emplace_back();
+	Skin.m_Path = pPath;
+	Skin.m_StorageType = StorageType;
+	const int Index = m_vSkins.size() - 1;
+	// the skin is likely to be rendered soon, keep the pixels for now
+	CPixels &Pixels = CachePixels(Index);
+	mem_copy(Pixels.m_vData.data(), Original.m_pData, SKIN_WIDTH * SKIN_HEIGHT * 4);
+	return Index;
+}
+
+void CSkinAtlas::SetColorable(int Skin, const CImageInfo &Colorable)
+{
+	dbg_assert(Colorable.m_Width == SKIN_WIDTH && Colorable.m_Height == SKIN_HEIGHT && Colorable.m_Format == CImageInfo::FORMAT_RGBA, "colorable skin does not match the original one");
+	dbg_assert(!m_lPixels.empty() && m_lPixels.front().m_Skin == Skin, "colorable skin was not set right after adding the skin");
+	mem_copy(m_lPixels.front().m_vData.data() + COLORABLE_START, Colorable.m_pData, SKIN_WIDTH * SKIN_HEIGHT * 4);
+}
+
+bool CSkinAtlas::Use(int Skin, CSlot *pSlot)
+{
+	CSkin &Entry = m_vSkins[Skin];
+	if(Entry.m_Slot < 0)
+	{
+		// only evict another skin once the pixels of this one are there
+		const CPixels *pPixels = Pixels(Skin);
+		if(pPixels == nullptr)
+			return false;
+		const int Slot = FindSlot();
+		if(Slot < 0)
+			return false;
+		Upload(Skin, Slot, *pPixels);
+	}
+	Entry.m_LastUsed = m_Frame;
+	*pSlot = SlotPosition(Entry.m_Slot);
+	return true;
+}
+
+int CSkinAtlas::PageOf(int Skin) const
+{
+	if(Skin < 0 || m_vSkins[Skin].m_Slot < 0)
+		return -1;
+	return m_vSkins[Skin].m_Slot / SLOTS_PER_PAGE;
+}
+
+void CSkinAtlas::PartRect(const CSlot *pSlot, bool Colorable, const CDataSprite *pSprite, float *pU0, float *pV0, float *pU1, float *pV1)
+{
+	const int CellWidth = SKIN_WIDTH / pSprite->m_pSet->m_Gridx;
+	const int CellHeight = SKIN_HEIGHT / pSprite->m_pSet->m_Gridy;
+	const int x = pSlot->m_X + pSprite->m_X * CellWidth;
+	const int y = pSlot->m_Y + (Colorable ? COLORABLE_OFFSET : 0) + pSprite->m_Y * CellHeight;
+
+	// keep half a texel away from the neighbouring parts
+	*pU0 = (x + 0.5f) / PAGE_SIZE;
+	*pV0 = (y + 0.5f) / PAGE_SIZE;
+	*pU1 = (x + pSprite->m_W * CellWidth - 0.5f) / PAGE_SIZE;
+	*pV1 = (y + pSprite->m_H * CellHeight - 0.5f) / PAGE_SIZE;
+}
+
+int CSkinAtlas::FindSlot()
+{
+	if(m_NumUsedSlots < NumSlots())
+	{
+		for(int Slot = 0; Slot < NumSlots(); Slot++)
+		{
+			if(m_vSlots[Slot] < 0)
+				return Slot;
+		}
+	}
+
+	// evict the least recently used skin, but none of this frame
+	int Oldest = -1;
+	for(int Slot = 0; Slot < NumSlots(); Slot++)
+	{
+		const CSkin &Skin = m_vSkins[m_vSlots[Slot]];
+		if(Skin.m_LastUsed < m_Frame && (Oldest < 0 || Skin.m_LastUsed < m_vSkins[m_vSlots[Oldest]].m_LastUsed))
+			Oldest = Slot;
+	}
+	if(Oldest >= 0)
+	{
+		m_vSkins[m_vSlots[Oldest]].m_Slot = -1;
+		m_vSlots[Oldest] = -1;
+		m_NumUsedSlots--;
+		m_NumEvictions++;
+	}
+	return Oldest;
+}
+
+CSkinAtlas::CPixels &CSkinAtlas::CachePixels(int Skin)
+{
+	if(m_lPixels.size() >= MAX_CACHED_PIXELS)
+		m_lPixels.pop_back();
+	CPixels &Pixels = m_lPixels.emplace_front();
+	Pixels.m_Skin = Skin;
+	// the padding between the original and the colorable skin stays empty
+	Pixels.m_vData.resize(PIXELS_SIZE);
+	return Pixels;
+}
+
+const CSkinAtlas::CPixels *CSkinAtlas::Pixels(int Skin)
+{
+	for(auto It = m_lPixels.begin(); It != m_lPixels.end(); ++It)
+	{
+		if(It->m_Skin == Skin)
+		{
+			m_lPixels.splice(m_lPixels.begin(), m_lPixels, It);
+			return &m_lPixels.front();
+		}
+	}
+
+	CSkin &Entry = m_vSkins[Skin];
+	if(Entry.m_Broken)
+		return nullptr;
+	if(!Entry.m_pLoadJob)
+	{
+		Entry.m_pLoadJob = std::make_shared<CLoadJob>(m_pGraphics, m_pfnMakeColorable, Entry.m_Path, Entry.m_StorageType);
+		m_pEngine->AddJob(Entry.m_pLoadJob);
+		return nullptr;
+	}
+	if(Entry.m_pLoadJob->Status() != IJob::STATE_DONE)
+		return nullptr;
+
+	std::shared_ptr<CLoadJob> pLoadJob = std::move(Entry.m_pLoadJob);
+	if(!pLoadJob->m_Success)
+	{
+		Entry.m_Broken = true;
+		return nullptr;
+	}
+	CPixels &Pixels = CachePixels(Skin);
+	Pixels.m_vData.swap(pLoadJob->m_vData);
+	return &Pixels;
+}
+
+void CSkinAtlas::Upload(int Skin, int Slot, const CPixels &Pixels)
+{
+	const int Page = Slot / SLOTS_PER_PAGE;
+	if(!m_vPages[Page].IsValid())
+	{
+		std::vector<uint8_t> vEmpty((size_t)PAGE_SIZE * PAGE_SIZE * 4, 0);
+		m_vPages[Page] = m_pGraphics->LoadTextureRaw(PAGE_SIZE, PAGE_SIZE, CImageInfo::FORMAT_RGBA, vEmpty.data(), CImageInfo::FORMAT_RGBA, 0, "skin atlas");
+	}
+
+	const CSlot Position = SlotPosition(Slot);
+	m_pGraphics->LoadTextureRawSub(m_vPages[Page], Position.m_X, Position.m_Y, SKIN_WIDTH, PIXELS_HEIGHT, CImageInfo::FORMAT_RGBA, Pixels.m_vData.data());
+
+	m_vSkins[Skin].m_Slot = Slot;
+	m_vSlots[Slot] = Skin;
+	m_NumUsedSlots++;
+	m_FrameUploads++;
+}
+
+CSkinAtlas::CSlot CSkinAtlas::SlotPosition(int Slot) const
+{
+	CSlot Position;
+	Position.m_Page = Slot / SLOTS_PER_PAGE;
+	Position.m_X = (Slot % SLOTS_PER_PAGE) % SLOTS_PER_ROW * SLOT_WIDTH + SLOT_PADDING;
+	Position.m_Y = (Slot % SLOTS_PER_PAGE) / SLOTS_PER_ROW * SLOT_HEIGHT + SLOT_PADDING;
+	return Position;
+}
@@ -0,0 +1,147 @@
+#ifndef GAME_CLIENT_SKIN_ATLAS_H
+#define GAME_CLIENT_SKIN_ATLAS_H
+
+#include <engine/graphics.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct CDataSprite;
+class IEngine;
+
+// Packs skins into a few large textures, so tees with different skins can
+// be rendered without switching textures.
+//
+// Every skin gets a slot with the original skin on top and the colorable
+// one below, surrounded by transparent padding so the mipmaps of the pages
+// don't mix neighbouring skins. Skins are uploaded to a slot when they are
+// rendered, if all slots are taken the least recently used skin that was
+// not rendered in the current frame is evicted. Only the pixels of the
+// last few added or uploaded skins are kept in memory, the others are read
+// from their file again by a job, until it is done the skin is rendered
+// with its part textures. Only skins in the default size fit into a slot,
+// the others always use their part textures.
+class CSkinAtlas
+{
+public:
+	enum
+	{
+		SKIN_WIDTH = 256,
+		SKIN_HEIGHT = 128,
+		PAGE_SIZE = 2048,
+		// transparent texels on each side of a skin, keeps the mipmap
+		// levels up to 16x16 texels per texel apart from the neighbours
+		SLOT_PADDING = 8,
+		// offset of the colorable skin to the original one
+		COLORABLE_OFFSET = SKIN_HEIGHT + SLOT_PADDING * 2,
+		SLOT_WIDTH = SKIN_WIDTH + SLOT_PADDING * 2,
+		SLOT_HEIGHT = COLORABLE_OFFSET + SKIN_HEIGHT + SLOT_PADDING * 2,
+		SLOTS_PER_ROW = PAGE_SIZE / SLOT_WIDTH,
+		SLOTS_PER_PAGE = SLOTS_PER_ROW * (PAGE_SIZE / SLOT_HEIGHT),
+	};
+
+	// position of the original skin in its page
+	struct CSlot
+	{
+		int m_Page;
+		int m_X;
+		int m_Y;
+	};
+
+	// turns the pixels of the original skin into the colorable ones
+	typedef void (*FMakeColorable)(CImageInfo &Info);
+
+	void Init(IGraphics *pGraphics, IEngine *pEngine, FMakeColorable pfnMakeColorable)
+	{
+		m_pGraphics = pGraphics;
+		m_pEngine = pEngine;
+		m_pfnMakeColorable = pfnMakeColorable;
+	}
+
+	// unloads the pages and forgets the skins
+	void Clear();
+	// unloads the pages, 0 disables the atlas
+	void SetNumPages(int NumPages);
+	void NewFrame();
+
+	// Returns the index of the skin or -1 if it doesn't fit into a slot.
+	// The file is read again if the skin is uploaded after its pixels
+	// were dropped, the colorable skin has to be set right after adding.
+	// The file must not change while the skin is registered.
+	int AddSkin(const CImageInfo &Original, const char *pPath, int StorageType);
+	void SetColorable(int Skin, const CImageInfo &Colorable);
+
+	// Uploads the skin if it isn't in the atlas yet and marks it as used
+	// in this frame. Returns false if there is no free slot or the pixels
+	// of the skin are still being read.
+	bool Use(int Skin, CSlot *pSlot);
+	// page of the skin or -1 if it isn't in the atlas
+	int PageOf(int Skin) const;
+	IGraphics::CTextureHandle Page(int Page) const { return m_vPages[Page]; }
+	// texture coordinates of a skin part in the page of the slot
+	static void PartRect(const CSlot *pSlot, bool Colorable, const CDataSprite *pSprite, float *pU0, float *pV0, float *pU1, float *pV1);
+
+	int NumPages() const { return m_vPages.size(); }
+	int NumSlots() const { return m_vSlots.size(); }
+	int NumUsedSlots() const { return m_NumUsedSlots; }
+	int NumSkins() const { return m_vSkins.size(); }
+	int NumUploadsLastFrame() const { return m_LastFrameUploads; }
+	int64_t NumEvictions() const { return m_NumEvictions; }
+
+private:
+	enum
+	{
+		// skins whose pixels are kept in memory
+		MAX_CACHED_PIXELS = 16,
+	};
+
+	class CLoadJob;
+
+	struct CSkin
+	{
+		std::string m_Path;
+		int m_StorageType;
+		int m_Slot = -1;
+		int64_t m_LastUsed = -1;
+		// the file couldn't be read again
+		bool m_Broken = false;
+		// reads the pixels again after they were dropped
+		std::shared_ptr<CLoadJob> m_pLoadJob;
+	};
+
+	struct CPixels
+	{
+		int m_Skin;
+		// original on top, colorable below with the padding between them,
+		// as uploaded
+		std::vector<uint8_t> m_vData;
+	};
+
+	IGraphics *m_pGraphics = nullptr;
+	IEngine *m_pEngine = nullptr;
+	FMakeColorable m_pfnMakeColorable = nullptr;
+	std::vector<IGraphics::CTextureHandle> m_vPages;
+	// skin in the slot or -1
+	std::vector<int> m_vSlots;
+	std::vector<CSkin> m_vSkins;
+	// most recently used first
+	std::list<CPixels> m_lPixels;
+	int m_NumUsedSlots = 0;
+	int64_t m_Frame = 0;
+	int m_FrameUploads = 0;
+	int m_LastFrameUploads = 0;
+	int64_t m_NumEvictions = 0;
+
+	int FindSlot();
+	// the cached pixels of the skin, starts reading them from its file
+	// if needed and returns nullptr until they are read
+	const CPixels *Pixels(int Skin);
+	CPixels &CachePixels(int Skin);
+	void Upload(int Skin, int Slot, const CPixels &Pixels);
+	CSlot SlotPosition(int Slot) const;
+};
+
+#endif
@@ -15,6 +15,21 @@
 
 #include <engine/shared/config.h>
 
+enum
+{
+	// game layer solid and unhookable tiles
+	COLFLAG_SOLID = 1 << 0,
+	// tiles that block or let through hooks, hook teleporters
+	COLFLAG_HOOK = 1 << 1,
+	// weapon teleporters
+	COLFLAG_WEAPON = 1 << 2,
+	// game or front layer laser blockers
+	COLFLAG_NOLASER = 1 << 3,
+
+	// width and height of the blocks of `m_vBlockFlags` in tiles
+	COLBLOCK_SIZE = 8,
+};
+
 vec2 ClampVel(int MoveRestriction, vec2 Vel)
 {
 	if(Vel.x > 0 && (MoveRestriction & CANTMOVE_RIGHT))
@@ -49,6 +64,7 @@ CCollision::CCollision()
 	m_pSwitch = 0;
 	m_pDoor = 0;
 	m_pTune = 0;
+	m_BlockWidth = 0;
 }
 
 CCollision::~CCollision()
@@ -131,6 +147,22 @@ void CCollision::Init(class CLayers *pLayers)
 			}
 		}
 	}
+
+	m_vSpecialTiles.assign((m_Width * m_Height + 63) / 64, 0);
+	for(int i = 0; i < m_Width * m_Height; i++)
+	{
+		if(TileExists(i))
+			m_vSpecialTiles[i / 64] |= uint64_t(1) << (i % 64);
+	}
+
+	m_BlockWidth = (m_Width + COLBLOCK_SIZE - 1) / COLBLOCK_SIZE;
+	m_vTileFlags.assign((size_t)m_Width * m_Height, 0);
+	m_vBlockFlags.assign((size_t)m_BlockWidth * ((m_Height + COLBLOCK_SIZE - 1) / COLBLOCK_SIZE), 0);
+	for(int i = 0; i < m_Width * m_Height; i++)
+	{
+		m_vTileFlags[i] = TileFlags(i);
+		m_vBlockFlags[i / m_Width / COLBLOCK_SIZE * m_BlockWidth + i % m_Width / COLBLOCK_SIZE] |= m_vTileFlags[i];
+	}
 }
 
 void CCollision::FillAntibot(CAntibotMapData *pMapData)
@@ -294,6 +326,7 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
 	vec2 Last = Pos0;
+	vec2 Step = (Pos1 - Pos0) / (float)End;
 	for(int i = 0; i <= End; i++)
 	{
 		float a = i / (float)End;
@@ -312,6 +345,8 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 		}
 
 		Last = Pos;
+		// the following samples up to the last skippable one can't hit
+		i += maximum(SkippableSamples(Pos, Step, COLFLAG_SOLID) - 1, 0);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -325,6 +360,7 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
 	vec2 Last = Pos0;
+	vec2 Step = (Pos1 - Pos0) / (float)End;
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
 	for(int i = 0; i <= End; i++)
@@ -369,6 +405,8 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 		}
 
 		Last = Pos;
+		// the following samples up to the last skippable one can't hit
+		i += maximum(SkippableSamples(Pos, Step, COLFLAG_SOLID | COLFLAG_HOOK) - 1, 0);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -382,6 +420,7 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
 	vec2 Last = Pos0;
+	vec2 Step = (Pos1 - Pos0) / (float)End;
 	for(int i = 0; i <= End; i++)
 	{
 		float a = i / (float)End;
@@ -414,6 +453,8 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 		}
 
 		Last = Pos;
+		// the following samples up to the last skippable one can't hit
+		i += maximum(SkippableSamples(Pos, Step, COLFLAG_SOLID | COLFLAG_WEAPON) - 1, 0);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -486,6 +527,11 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, float Elas
 
 	if(Distance > 0.00001f)
 	{
+		// no need to test the box if there's nothing solid around the
+		// whole move, it can't bounce off anything then
+		vec2 Extent = Size * 0.5f;
+		bool Free = !FlagsInRect(vec2(minimum(Pos.x, Pos.x + Vel.x), minimum(Pos.y, Pos.y + Vel.y)) - Extent, vec2(maximum(Pos.x, Pos.x + Vel.x), maximum(Pos.y, Pos.y + Vel.y)) + Extent, COLFLAG_SOLID);
+
 		float Fraction = 1.0f / (float)(Max + 1);
 		for(int i = 0; i <= Max; i++)
 		{
@@ -506,7 +552,7 @@ void CCollision::MoveBox(vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, float Elas
 				break;
 			}
 
-			if(TestBox(vec2(NewPos.x, NewPos.y), Size))
+			if(!Free && TestBox(vec2(NewPos.x, NewPos.y), Size))
 			{
 				int Hits = 0;
 
@@ -558,6 +604,10 @@ void CCollision::Dest()
 	m_pSwitch = 0;
 	m_pTune = 0;
 	m_pDoor = 0;
+	m_vSpecialTiles.clear();
+	m_vTileFlags.clear();
+	m_vBlockFlags.clear();
+	m_BlockWidth = 0;
 }
 
 int CCollision::IsSolid(int x, int y) const
@@ -886,52 +936,149 @@ int CCollision::GetMapIndex(vec2 Pos) const
 	int Ny = clamp((int)Pos.y / 32, 0, m_Height - 1);
 	int Index = Ny * m_Width + Nx;
 
-	if(TileExists(Index))
+	if(SpecialTileAt(Index))
 		return Index;
 	else
 		return -1;
 }
 
-std::list<int> CCollision::GetMapIndices(vec2 PrevPos, vec2 Pos, unsigned MaxIndices) const
+bool CCollision::SpecialTilesBetween(vec2 Pos0, vec2 Pos1) const
 {
-	std::list<int> Indices;
-	float d = distance(PrevPos, Pos);
-	int End(d + 1);
-	if(!d)
+	// one pixel of margin for rounding errors in the positions between
+	int MinX = clamp((int)(minimum(Pos0.x, Pos1.x) - 1) / 32, 0, m_Width - 1);
+	int MinY = clamp((int)(minimum(Pos0.y, Pos1.y) - 1) / 32, 0, m_Height - 1);
+	int MaxX = clamp((int)(maximum(Pos0.x, Pos1.x) + 1) / 32, 0, m_Width - 1);
+	int MaxY = clamp((int)(maximum(Pos0.y, Pos1.y) + 1) / 32, 0, m_Height - 1);
+	if((MaxX - MinX + 1) * (MaxY - MinY + 1) > 16)
+		return true;
+	for(int y = MinY; y <= MaxY; y++)
 	{
-		int Nx = clamp((int)Pos.x / 32, 0, m_Width - 1);
-		int Ny = clamp((int)Pos.y / 32, 0, m_Height - 1);
-		int Index = Ny * m_Width + Nx;
-
-		if(TileExists(Index))
+		for(int x = MinX; x <= MaxX; x++)
 		{
-			Indices.push_back(Index);
-			return Indices;
+			if(SpecialTileAt(y * m_Width + x))
+				return true;
 		}
+	}
+	return false;
+}
+
+void CCollision::UpdateSpecialTiles(int Index)
+{
+	// `TileExists` also looks at the stoppers around a tile
+	const int aIndices[] = {Index, Index - 1, Index + 1, Index - m_Width, Index + m_Width};
+	for(int i : aIndices)
+	{
+		if(i < 0 || i >= m_Width * m_Height)
+			continue;
+		if(TileExists(i))
+			m_vSpecialTiles[i / 64] |= uint64_t(1) << (i % 64);
 		else
-			return Indices;
+			m_vSpecialTiles[i / 64] &= ~(uint64_t(1) << (i % 64));
+	}
+}
+
+int CCollision::TileFlags(int Index) const
+{
+	int Flags = 0;
+	int Tile = m_pTiles[Index].m_Index;
+	int FTile = m_pFront ? m_pFront[Index].m_Index : 0;
+	int TeleType = m_pTele ? m_pTele[Index].m_Type : 0;
+	if(Tile == TILE_SOLID || Tile == TILE_NOHOOK)
+		Flags |= COLFLAG_SOLID;
+	if(Tile == TILE_THROUGH_ALL || Tile == TILE_THROUGH_DIR || FTile == TILE_THROUGH_ALL || FTile == TILE_THROUGH_DIR || TeleType == TILE_TELEIN || TeleType == TILE_TELEINHOOK)
+		Flags |= COLFLAG_HOOK;
+	if(TeleType == TILE_TELEIN || TeleType == TILE_TELEINWEAPON)
+		Flags |= COLFLAG_WEAPON;
+	if(Tile == TILE_NOLASER || FTile == TILE_NOLASER)
+		Flags |= COLFLAG_NOLASER;
+	return Flags;
+}
+
+void CCollision::UpdateTileFlags(int Index)
+{
+	m_vTileFlags[Index] = TileFlags(Index);
+
+	int BlockX = Index % m_Width / COLBLOCK_SIZE;
+	int BlockY = Index / m_Width / COLBLOCK_SIZE;
+	int BlockFlags = 0;
+	for(int y = BlockY * COLBLOCK_SIZE; y < minimum((BlockY + 1) * COLBLOCK_SIZE, m_Height); y++)
+	{
+		for(int x = BlockX * COLBLOCK_SIZE; x < minimum((BlockX + 1) * COLBLOCK_SIZE, m_Width); x++)
+		{
+			BlockFlags |= m_vTileFlags[y * m_Width + x];
+		}
+	}
+	m_vBlockFlags[BlockY * m_BlockWidth + BlockX] = BlockFlags;
+}
+
+int CCollision::SkippableSamples(vec2 Pos, vec2 Step, int Flags) const
+{
+	// Stay two pixels away from the border of the empty tile or block, for
+	// the rounding to pixels and the floating point error of the samples.
+	const float Margin = 2.0f;
+	if(Pos.x < 0 || Pos.y < 0 || Pos.x >= m_Width * 32.0f || Pos.y >= m_Height * 32.0f)
+		return 0;
+	int x = (int)Pos.x / 32;
+	int y = (int)Pos.y / 32;
+	float Size;
+	vec2 Min;
+	if(!(m_vBlockFlags[y / COLBLOCK_SIZE * m_BlockWidth + x / COLBLOCK_SIZE] & Flags))
+	{
+		Size = COLBLOCK_SIZE * 32.0f;
+		Min = vec2(x / COLBLOCK_SIZE, y / COLBLOCK_SIZE) * Size;
+	}
+	else if(!(m_vTileFlags[y * m_Width + x] & Flags))
+	{
+		Size = 32.0f;
+		Min = vec2(x, y) * Size;
 	}
 	else
 	{
-		int LastIndex = 0;
-		for(int i = 0; i < End; i++)
+		return 0;
+	}
+	vec2 Max = Min + vec2(Size - Margin, Size - Margin);
+	Min += vec2(Margin, Margin);
+	if(Pos.x < Min.x || Pos.y < Min.y || Pos.x > Max.x || Pos.y > Max.y)
+		return 0;
+
+	float Steps = 1 << 20;
+	if(Step.x > 0)
+		Steps = minimum(Steps, (Max.x - Pos.x) / Step.x);
+	else if(Step.x < 0)
+		Steps = minimum(Steps, (Min.x - Pos.x) / Step.x);
+	if(Step.y > 0)
+		Steps = minimum(Steps, (Max.y - Pos.y) / Step.y);
+	else if(Step.y < 0)
+		Steps = minimum(Steps, (Min.y - Pos.y) / Step.y);
+	return Steps;
+}
+
+bool CCollision::FlagsInRect(vec2 Min, vec2 Max, int Flags) const
+{
+	// same margin as in `SkippableSamples`
+	int MinX = (int)clamp(Min.x - 2.0f, 0.0f, m_Width * 32.0f - 1) / 32;
+	int MinY = (int)clamp(Min.y - 2.0f, 0.0f, m_Height * 32.0f - 1) / 32;
+	int MaxX = (int)clamp(Max.x + 2.0f, 0.0f, m_Width * 32.0f - 1) / 32;
+	int MaxY = (int)clamp(Max.y + 2.0f, 0.0f, m_Height * 32.0f - 1) / 32;
+	if((MaxX / COLBLOCK_SIZE - MinX / COLBLOCK_SIZE + 1) * (MaxY / COLBLOCK_SIZE - MinY / COLBLOCK_SIZE + 1) > 16)
+		return true;
+	for(int BlockY = MinY / COLBLOCK_SIZE; BlockY <= MaxY / COLBLOCK_SIZE; BlockY++)
+	{
+		for(int BlockX = MinX / COLBLOCK_SIZE; BlockX <= MaxX / COLBLOCK_SIZE; BlockX++)
 		{
-			float a = i / d;
-			vec2 Tmp = mix(PrevPos, Pos, a);
-			int Nx = clamp((int)Tmp.x / 32, 0, m_Width - 1);
-			int Ny = clamp((int)Tmp.y / 32, 0, m_Height - 1);
-			int Index = Ny * m_Width + Nx;
-			if(TileExists(Index) && LastIndex != Index)
+			if(!(m_vBlockFlags[BlockY * m_BlockWidth + BlockX] & Flags))
+				continue;
+			for(int y = maximum(MinY, BlockY * COLBLOCK_SIZE); y <= minimum(MaxY, BlockY * COLBLOCK_SIZE + COLBLOCK_SIZE - 1); y++)
 			{
-				if(MaxIndices && Indices.size() > MaxIndices)
-					return Indices;
-				Indices.push_back(Index);
-				LastIndex = Index;
+				for(int x = maximum(MinX, BlockX * COLBLOCK_SIZE); x <= minimum(MaxX, BlockX * COLBLOCK_SIZE + COLBLOCK_SIZE - 1); x++)
+				{
+					if(m_vTileFlags[y * m_Width + x] & Flags)
+						return true;
+				}
 			}
 		}
-
-		return Indices;
 	}
+	return false;
 }
 
 vec2 CCollision::GetPos(int Index) const
@@ -1085,6 +1232,8 @@ void CCollision::SetCollisionAt(float x, float y, int id)
 	int Ny = clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = id;
+	UpdateSpecialTiles(Ny * m_Width + Nx);
+	UpdateTileFlags(Ny * m_Width + Nx);
 }
 
 void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -1097,6 +1246,7 @@ void CCollision::SetDCollisionAt(float x, float y, int Type, int Flags, int Numb
 	m_pDoor[Ny * m_Width + Nx].m_Index = Type;
 	m_pDoor[Ny * m_Width + Nx].m_Flags = Flags;
 	m_pDoor[Ny * m_Width + Nx].m_Number = Number;
+	UpdateSpecialTiles(Ny * m_Width + Nx);
 }
 
 int CCollision::GetDTileIndex(int Index) const
@@ -1158,6 +1308,7 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 {
 	float d = distance(Pos0, Pos1);
 	vec2 Last = Pos0;
+	vec2 Step = (Pos1 - Pos0) / d;
 
 	for(int i = 0, id = std::ceil(d); i < id; i++)
 	{
@@ -1177,6 +1328,8 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 				return GetCollisionAt(Pos.x, Pos.y);
 		}
 		Last = Pos;
+		// the following samples up to the last skippable one can't hit
+		i += maximum(SkippableSamples(Pos, Step, COLFLAG_SOLID | COLFLAG_NOLASER) - 1, 0);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1189,6 +1342,7 @@ int CCollision::IntersectNoLaserNW(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, ve
 {
 	float d = distance(Pos0, Pos1);
 	vec2 Last = Pos0;
+	vec2 Step = (Pos1 - Pos0) / d;
 
 	for(int i = 0, id = std::ceil(d); i < id; i++)
 	{
@@ -1206,6 +1360,8 @@ int CCollision::IntersectNoLaserNW(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, ve
 				return GetFCollisionAt(Pos.x, Pos.y);
 		}
 		Last = Pos;
+		// the following samples up to the last skippable one can't hit
+		i += maximum(SkippableSamples(Pos, Step, COLFLAG_NOLASER) - 1, 0);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
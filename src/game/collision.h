@@ -6,7 +6,8 @@
 #include <base/vmath.h>
 #include <engine/shared/protocol.h>
 
-#include <list>
+#include <cstdint>
+#include <vector>
 
 enum
 {
@@ -73,9 +74,14 @@ public:
 	int Entity(int x, int y, int Layer) const;
 	int GetPureMapIndex(float x, float y) const;
 	int GetPureMapIndex(vec2 Pos) const { return GetPureMapIndex(Pos.x, Pos.y); }
-	std::list<int> GetMapIndices(vec2 PrevPos, vec2 Pos, unsigned MaxIndices = 0) const;
+	// Calls `Visit(Index)` for the tiles on the way from `PrevPos` to `Pos`
+	// for which `TileExists` is true, until it returns false. Returns the
+	// number of visited tiles.
+	template<typename F>
+	int VisitMapIndices(vec2 PrevPos, vec2 Pos, F &&Visit, int MaxIndices = 0) const;
 	int GetMapIndex(vec2 Pos) const;
 	bool TileExists(int Index) const;
+	bool SpecialTileAt(int Index) const { return m_vSpecialTiles[Index / 64] & (uint64_t(1) << (Index % 64)); }
 	bool TileExistsNext(int Index) const;
 	vec2 GetPos(int Index) const;
 	int GetTileIndex(int Index) const;
@@ -123,7 +129,65 @@ private:
 	class CSwitchTile *m_pSwitch;
 	class CTuneTile *m_pTune;
 	class CDoorTile *m_pDoor;
+
+	// `TileExists` of every tile, kept up to date when tiles change
+	std::vector<uint64_t> m_vSpecialTiles;
+	void UpdateSpecialTiles(int Index);
+	bool SpecialTilesBetween(vec2 Pos0, vec2 Pos1) const;
+
+	// Which kinds of tiles stopping the line and box tests are in each tile
+	// and in each block of tiles, kept up to date when tiles change. Used
+	// to skip the samples of those tests that can't hit anything.
+	std::vector<uint8_t> m_vTileFlags;
+	std::vector<uint8_t> m_vBlockFlags;
+	int m_BlockWidth;
+	int TileFlags(int Index) const;
+	void UpdateTileFlags(int Index);
+	int SkippableSamples(vec2 Pos, vec2 Step, int Flags) const;
+	bool FlagsInRect(vec2 Min, vec2 Max, int Flags) const;
 };
 
+template<typename F>
+int CCollision::VisitMapIndices(vec2 PrevPos, vec2 Pos, F &&Visit, int MaxIndices) const
+{
+	float d = distance(PrevPos, Pos);
+	if(!d)
+	{
+		int Nx = clamp((int)Pos.x / 32, 0, m_Width - 1);
+		int Ny = clamp((int)Pos.y / 32, 0, m_Height - 1);
+		int Index = Ny * m_Width + Nx;
+		if(!SpecialTileAt(Index))
+			return 0;
+		Visit(Index);
+		return 1;
+	}
+
+	// usually there are no special tiles around at all
+	if(!SpecialTilesBetween(PrevPos, Pos))
+		return 0;
+
+	int NumVisited = 0;
+	int End(d + 1);
+	int LastIndex = 0;
+	for(int i = 0; i < End; i++)
+	{
+		float a = i / d;
+		vec2 Tmp = mix(PrevPos, Pos, a);
+		int Nx = clamp((int)Tmp.x / 32, 0, m_Width - 1);
+		int Ny = clamp((int)Tmp.y / 32, 0, m_Height - 1);
+		int Index = Ny * m_Width + Nx;
+		if(LastIndex != Index && SpecialTileAt(Index))
+		{
+			if(MaxIndices && NumVisited > MaxIndices)
+				return NumVisited;
+			NumVisited++;
+			LastIndex = Index;
+			if(!Visit(Index))
+				return NumVisited;
+		}
+	}
+	return NumVisited;
+}
+
 void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY);
 #endif
@@ -295,12 +295,19 @@ void CCharacterCore::Tick(bool UseInput, bool DoDeferredTick)
 		// Check against other players first
 		if(!this->m_HookHitDisabled && m_pWorld && m_Tuning.m_PlayerHooking)
 		{
+			// only players near the way of the hook can be grabbed, with a
+			// pixel of margin for rounding errors
+			const float Reach = PhysicalSize() + 3.0f;
+			vec2 Min = vec2(minimum(m_HookPos.x, NewPos.x) - Reach, minimum(m_HookPos.y, NewPos.y) - Reach);
+			vec2 Max = vec2(maximum(m_HookPos.x, NewPos.x) + Reach, maximum(m_HookPos.y, NewPos.y) + Reach);
 			float Distance = 0.0f;
 			for(int i = 0; i < MAX_CLIENTS; i++)
 			{
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
 				if(!pCharCore || pCharCore == this || (!(m_Super || pCharCore->m_Super) && ((m_Id != -1 && !m_pTeams->CanCollide(i, m_Id)) || pCharCore->m_Solo || m_Solo)))
 					continue;
+				if(pCharCore->m_Pos.x < Min.x || pCharCore->m_Pos.y < Min.y || pCharCore->m_Pos.x > Max.x || pCharCore->m_Pos.y > Max.y)
+					continue;
 
 				vec2 ClosestPoint;
 				if(closest_point_on_line(m_HookPos, NewPos, pCharCore->m_Pos, ClosestPoint))
@@ -427,6 +434,11 @@ void CCharacterCore::TickDeferred()
 			if(!(m_Super || pCharCore->m_Super) && (m_Solo || pCharCore->m_Solo))
 				continue;
 
+			// players further away can only be influenced by the hook
+			const float Reach = PhysicalSize() * 1.25f + 1.0f;
+			if(m_HookedPlayer != i && (absolute(m_Pos.x - pCharCore->m_Pos.x) > Reach || absolute(m_Pos.y - pCharCore->m_Pos.y) > Reach))
+				continue;
+
 			// handle player <-> player collision
 			float Distance = distance(m_Pos, pCharCore->m_Pos);
 			if(Distance > 0)
@@ -512,19 +524,34 @@ void CCharacterCore::Move()
 		float Distance = distance(m_Pos, NewPos);
 		if(Distance > 0)
 		{
-			int End = Distance + 1;
+			// Only the players near the way to the new position can be
+			// touched, find them once instead of for every step.
+			const float Reach = PhysicalSize() + 1.0f;
+			vec2 Min = vec2(minimum(m_Pos.x, NewPos.x) - Reach, minimum(m_Pos.y, NewPos.y) - Reach);
+			vec2 Max = vec2(maximum(m_Pos.x, NewPos.x) + Reach, maximum(m_Pos.y, NewPos.y) + Reach);
+			CCharacterCore *apNear[MAX_CLIENTS];
+			int NumNear = 0;
+			for(int p = 0; p < MAX_CLIENTS; p++)
+			{
+				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
+				if(!pCharCore || pCharCore == this)
+					continue;
+				if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || pCharCore->m_CollisionDisabled || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
+					continue;
+				if(pCharCore->m_Pos.x < Min.x || pCharCore->m_Pos.y < Min.y || pCharCore->m_Pos.x > Max.x || pCharCore->m_Pos.y > Max.y)
+					continue;
+				apNear[NumNear++] = pCharCore;
+			}
+
+			int End = NumNear ? Distance + 1 : 0;
 			vec2 LastPos = m_Pos;
 			for(int i = 0; i < End; i++)
 			{
 				float a = i / Distance;
 				vec2 Pos = mix(m_Pos, NewPos, a);
-				for(int p = 0; p < MAX_CLIENTS; p++)
+				for(int n = 0; n < NumNear; n++)
 				{
-					CCharacterCore *pCharCore = m_pWorld->m_apCharacters[p];
-					if(!pCharCore || pCharCore == this)
-						continue;
-					if((!(pCharCore->m_Super || m_Super) && (m_Solo || pCharCore->m_Solo || pCharCore->m_CollisionDisabled || (m_Id != -1 && !m_pTeams->CanCollide(m_Id, p)))))
-						continue;
+					CCharacterCore *pCharCore = apNear[n];
 					float D = distance(Pos, pCharCore->m_Pos);
 					if(D < PhysicalSize() && D >= 0.0f)
 					{
@@ -678,6 +705,96 @@ void CCharacterCore::SetTeleOuts(std::map<int, std::vector<vec2>> *pTeleOuts)
 	m_pTeleOuts = pTeleOuts;
 }
 
+int CCharacterCore::HandleTeleports(int MapIndex, int TeleCheckpoint, std::map<int, std::vector<vec2>> *pTeleCheckOuts)
+{
+	if(!m_pTeleOuts || !m_pWorld)
+		return TELEPORT_NONE;
+
+	int z = Collision()->IsTeleport(MapIndex);
+	if(!g_Config.m_SvOldTeleportHook && !g_Config.m_SvOldTeleportWeapons && z && !(*m_pTeleOuts)[z - 1].empty())
+	{
+		if(m_Super)
+			return TELEPORT_NONE;
+		int TeleOut = m_pWorld->RandomOr0((*m_pTeleOuts)[z - 1].size());
+		m_Pos = (*m_pTeleOuts)[z - 1][TeleOut];
+		if(!g_Config.m_SvTeleportHoldHook)
+		{
+			ResetHook();
+		}
+		if(g_Config.m_SvTeleportLoseWeapons)
+			ResetPickups();
+		return TELEPORT_DONE;
+	}
+	int evilz = Collision()->IsEvilTeleport(MapIndex);
+	if(evilz && !(*m_pTeleOuts)[evilz - 1].empty())
+	{
+		if(m_Super)
+			return TELEPORT_NONE;
+		int TeleOut = m_pWorld->RandomOr0((*m_pTeleOuts)[evilz - 1].size());
+		m_Pos = (*m_pTeleOuts)[evilz - 1][TeleOut];
+		if(!g_Config.m_SvOldTeleportHook && !g_Config.m_SvOldTeleportWeapons)
+		{
+			m_Vel = vec2(0, 0);
+
+			if(g_Config.m_SvTeleportLoseWeapons)
+			{
+				ResetPickups();
+			}
+			if(!g_Config.m_SvTeleportHoldHook)
+			{
+				ResetHook();
+				return TELEPORT_RELEASE_HOOKED;
+			}
+		}
+		return TELEPORT_DONE;
+	}
+	const bool CheckEvil = Collision()->IsCheckEvilTeleport(MapIndex);
+	if(CheckEvil || Collision()->IsCheckTeleport(MapIndex))
+	{
+		if(m_Super)
+			return TELEPORT_NONE;
+		// first check if there is a TeleCheckOut for the current recorded checkpoint, if not check previous checkpoints
+		for(int k = TeleCheckpoint - 1; k >= 0; k--)
+		{
+			if(!(*pTeleCheckOuts)[k].empty())
+			{
+				int TeleOut = m_pWorld->RandomOr0((*pTeleCheckOuts)[k].size());
+				m_Pos = (*pTeleCheckOuts)[k][TeleOut];
+				if(CheckEvil)
+					m_Vel = vec2(0, 0);
+
+				if(!g_Config.m_SvTeleportHoldHook)
+				{
+					ResetHook();
+					if(CheckEvil)
+						return TELEPORT_RELEASE_HOOKED;
+				}
+				return TELEPORT_DONE;
+			}
+		}
+		return CheckEvil ? TELEPORT_EVIL_NO_CHECKPOINT_OUT : TELEPORT_NO_CHECKPOINT_OUT;
+	}
+	return TELEPORT_NONE;
+}
+
+void CCharacterCore::ResetHook()
+{
+	SetHookedPlayer(-1);
+	m_HookState = HOOK_RETRACTED;
+	m_TriggeredEvents |= COREEVENT_HOOK_RETRACT;
+	m_HookPos = m_Pos;
+}
+
+void CCharacterCore::ResetPickups()
+{
+	for(int i = WEAPON_SHOTGUN; i < NUM_WEAPONS - 1; i++)
+	{
+		m_aWeapons[i].m_Got = false;
+		if(m_ActiveWeapon == i)
+			m_ActiveWeapon = WEAPON_GUN;
+	}
+}
+
 bool CCharacterCore::IsSwitchActiveCb(int Number, void *pUser)
 {
 	CCharacterCore *pThis = (CCharacterCore *)pUser;
@@ -293,6 +293,23 @@ public:
 	// DDNet Character
 	void SetTeamsCore(CTeamsCore *pTeams);
 	void SetTeleOuts(std::map<int, std::vector<vec2>> *pTeleOuts);
+
+	enum
+	{
+		TELEPORT_NONE,
+		TELEPORT_DONE,
+		// teleported, other players have to release their hook
+		TELEPORT_RELEASE_HOOKED,
+		// on a checkpoint teleporter without a checkpoint out, the caller
+		// decides whether to teleport to the spawn
+		TELEPORT_NO_CHECKPOINT_OUT,
+		TELEPORT_EVIL_NO_CHECKPOINT_OUT,
+	};
+	// Teleports the character if there is a teleporter at `MapIndex`. The
+	// outs are chosen with the world's PRNG, like on the server.
+	int HandleTeleports(int MapIndex, int TeleCheckpoint, std::map<int, std::vector<vec2>> *pTeleCheckOuts);
+	void ResetHook();
+	void ResetPickups();
 	void ReadDDNet(const CNetObj_DDNetCharacter *pObjDDNet);
 	bool m_Solo;
 	bool m_Jetpack;
@@ -692,10 +692,7 @@ void CCharacter::OnDirectInput(CNetObj_PlayerInput *pNewInput)
 
 void CCharacter::ResetHook()
 {
-	m_Core.SetHookedPlayer(-1);
-	m_Core.m_HookState = HOOK_RETRACTED;
-	m_Core.m_TriggeredEvents |= COREEVENT_HOOK_RETRACT;
-	m_Core.m_HookPos = m_Core.m_Pos;
+	m_Core.ResetHook();
 }
 
 void CCharacter::ResetInput()
@@ -1818,113 +1815,29 @@ void CCharacter::HandleTiles(int Index)
 		m_LastBonus = false;
 	}
 
-	int z = Collision()->IsTeleport(MapIndex);
-	if(!g_Config.m_SvOldTeleportHook && !g_Config.m_SvOldTeleportWeapons && z && !(*m_pTeleOuts)[z - 1].empty())
+	const int Teleport = m_Core.HandleTeleports(MapIndex, m_TeleCheckpoint, m_pTeleCheckOuts);
+	if(Teleport == CCharacterCore::TELEPORT_RELEASE_HOOKED)
 	{
-		if(m_Core.m_Super)
-			return;
-		int TeleOut = m_Core.m_pWorld->RandomOr0((*m_pTeleOuts)[z - 1].size());
-		m_Core.m_Pos = (*m_pTeleOuts)[z - 1][TeleOut];
-		if(!g_Config.m_SvTeleportHoldHook)
-		{
-			ResetHook();
-		}
-		if(g_Config.m_SvTeleportLoseWeapons)
-			ResetPickups();
-		return;
-	}
-	int evilz = Collision()->IsEvilTeleport(MapIndex);
-	if(evilz && !(*m_pTeleOuts)[evilz - 1].empty())
-	{
-		if(m_Core.m_Super)
-			return;
-		int TeleOut = m_Core.m_pWorld->RandomOr0((*m_pTeleOuts)[evilz - 1].size());
-		m_Core.m_Pos = (*m_pTeleOuts)[evilz - 1][TeleOut];
-		if(!g_Config.m_SvOldTeleportHook && !g_Config.m_SvOldTeleportWeapons)
-		{
-			m_Core.m_Vel = vec2(0, 0);
-
-			if(!g_Config.m_SvTeleportHoldHook)
-			{
-				ResetHook();
-				GameWorld()->ReleaseHooked(GetPlayer()->GetCID());
-			}
-			if(g_Config.m_SvTeleportLoseWeapons)
-			{
-				ResetPickups();
-			}
-		}
-		return;
-	}
-	if(Collision()->IsCheckEvilTeleport(MapIndex))
-	{
-		if(m_Core.m_Super)
-			return;
-		// first check if there is a TeleCheckOut for the current recorded checkpoint, if not check previous checkpoints
-		for(int k = m_TeleCheckpoint - 1; k >= 0; k--)
-		{
-			if(!(*m_pTeleCheckOuts)[k].empty())
-			{
-				int TeleOut = m_Core.m_pWorld->RandomOr0((*m_pTeleCheckOuts)[k].size());
-				m_Core.m_Pos = (*m_pTeleCheckOuts)[k][TeleOut];
-				m_Core.m_Vel = vec2(0, 0);
-
-				if(!g_Config.m_SvTeleportHoldHook)
-				{
-					ResetHook();
-					GameWorld()->ReleaseHooked(GetPlayer()->GetCID());
-				}
-
-				return;
-			}
-		}
-		// if no checkpointout have been found (or if there no recorded checkpoint), teleport to start
-		vec2 SpawnPos;
-		if(GameServer()->m_pController->CanSpawn(m_pPlayer->GetTeam(), &SpawnPos, GameServer()->GetDDRaceTeam(GetPlayer()->GetCID())))
-		{
-			m_Core.m_Pos = SpawnPos;
-			m_Core.m_Vel = vec2(0, 0);
-
-			if(!g_Config.m_SvTeleportHoldHook)
-			{
-				ResetHook();
-				GameWorld()->ReleaseHooked(GetPlayer()->GetCID());
-			}
-		}
-		return;
+		GameWorld()->ReleaseHooked(GetPlayer()->GetCID());
 	}
-	if(Collision()->IsCheckTeleport(MapIndex))
+	else if(Teleport == CCharacterCore::TELEPORT_NO_CHECKPOINT_OUT || Teleport == CCharacterCore::TELEPORT_EVIL_NO_CHECKPOINT_OUT)
 	{
-		if(m_Core.m_Super)
-			return;
-		// first check if there is a TeleCheckOut for the current recorded checkpoint, if not check previous checkpoints
-		for(int k = m_TeleCheckpoint - 1; k >= 0; k--)
-		{
-			if(!(*m_pTeleCheckOuts)[k].empty())
-			{
-				int TeleOut = m_Core.m_pWorld->RandomOr0((*m_pTeleCheckOuts)[k].size());
-				m_Core.m_Pos = (*m_pTeleCheckOuts)[k][TeleOut];
-
-				if(!g_Config.m_SvTeleportHoldHook)
-				{
-					ResetHook();
-				}
-
-				return;
-			}
-		}
 		// if no checkpointout have been found (or if there no recorded checkpoint), teleport to start
+		const bool Evil = Teleport == CCharacterCore::TELEPORT_EVIL_NO_CHECKPOINT_OUT;
 		vec2 SpawnPos;
 		if(GameServer()->m_pController->CanSpawn(m_pPlayer->GetTeam(), &SpawnPos, GameServer()->GetDDRaceTeam(GetPlayer()->GetCID())))
 		{
 			m_Core.m_Pos = SpawnPos;
+			if(Evil)
+				m_Core.m_Vel = vec2(0, 0);
 
 			if(!g_Config.m_SvTeleportHoldHook)
 			{
 				ResetHook();
+				if(Evil)
+					GameWorld()->ReleaseHooked(GetPlayer()->GetCID());
 			}
 		}
-		return;
 	}
 }
 
@@ -2101,17 +2014,13 @@ void CCharacter::DDRacePostCoreTick()
 		return;
 
 	// handle Anti-Skip tiles
-	std::list<int> Indices = Collision()->GetMapIndices(m_PrevPos, m_Pos);
-	if(!Indices.empty())
-	{
-		for(int &Index : Indices)
-		{
-			HandleTiles(Index);
-			if(!m_Alive)
-				return;
-		}
-	}
-	else
+	int NumIndices = Collision()->VisitMapIndices(m_PrevPos, m_Pos, [this](int Index) {
+		HandleTiles(Index);
+		return m_Alive;
+	});
+	if(!m_Alive)
+		return;
+	if(!NumIndices)
 	{
 		HandleTiles(CurrentIndex);
 		if(!m_Alive)
@@ -2202,12 +2111,7 @@ void CCharacter::GiveAllWeapons()
 
 void CCharacter::ResetPickups()
 {
-	for(int i = WEAPON_SHOTGUN; i < NUM_WEAPONS - 1; i++)
-	{
-		m_Core.m_aWeapons[i].m_Got = false;
-		if(m_Core.m_ActiveWeapon == i)
-			m_Core.m_ActiveWeapon = WEAPON_GUN;
-	}
+	m_Core.ResetPickups();
 }
 
 void CCharacter::SetEndlessHook(bool Enable)
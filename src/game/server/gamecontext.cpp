@@ -18,6 +18,7 @@
 #include <engine/shared/json.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/ticktimings.h>
 #include <engine/storage.h>
 
 #include <game/collision.h>
@@ -105,6 +106,7 @@ void CGameContext::Construct(int Resetting)
 
 	m_aDeleteTempfile[0] = 0;
 	m_TeeHistorianActive = false;
+	m_pTeeHistorianBlockFile = nullptr;
 }
 
 void CGameContext::Destruct(int Resetting)
@@ -159,7 +161,20 @@ void CGameContext::Clear()
 void CGameContext::TeeHistorianWrite(const void *pData, int DataSize, void *pUser)
 {
 	CGameContext *pSelf = (CGameContext *)pUser;
-	aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
+	if(pSelf->m_pTeeHistorianBlockFile)
+	{
+		pSelf->m_pTeeHistorianBlockFile->Write(pData, DataSize);
+	}
+	else
+	{
+		aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
+	}
+}
+
+static void TeeHistorianKeyframeWrite(const void *pData, int DataSize, void *pUser)
+{
+	std::vector<unsigned char> *pvKeyframe = (std::vector<unsigned char> *)pUser;
+	pvKeyframe->insert(pvKeyframe->end(), (const unsigned char *)pData, (const unsigned char *)pData + DataSize);
 }
 
 void CGameContext::CommandCallback(int ClientID, int FlagMask, const char *pCmd, IConsole::IResult *pResult, void *pUser)
@@ -889,6 +904,10 @@ void CGameContext::OnPreTickTeehistorian()
 	if(!m_TeeHistorianActive)
 		return;
 
+	// recorded for the game tick, keep it inside of its phase
+	CTickTimings *pTimings = Server()->TickTimings();
+	CTickTimings::CScope GameScope(pTimings, CTickTimings::PHASE_GAME);
+	CTickTimings::CScope Scope(pTimings, CTickTimings::PHASE_TEEHISTORIAN);
 	auto *pController = ((CGameControllerDDRace *)m_pController);
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -905,12 +924,16 @@ void CGameContext::OnPreTickTeehistorian()
 
 void CGameContext::OnTick()
 {
+	CTickTimings *pTimings = Server()->TickTimings();
+	CTickTimings::CScope Scope(pTimings, CTickTimings::PHASE_GAME);
+
 	// check tuning
 	CheckPureTuning();
 
 	if(m_TeeHistorianActive)
 	{
-		int Error = aio_error(m_pTeeHistorianFile);
+		CTickTimings::CScope TeeHistorianScope(pTimings, CTickTimings::PHASE_TEEHISTORIAN);
+		int Error = m_pTeeHistorianBlockFile ? m_pTeeHistorianBlockFile->Error() : aio_error(m_pTeeHistorianFile);
 		if(Error)
 		{
 			dbg_msg("teehistorian", "error writing to file, err=%d", Error);
@@ -922,17 +945,29 @@ void CGameContext::OnTick()
 			m_TeeHistorian.EndInputs();
 			m_TeeHistorian.EndTick();
 		}
+		if(m_pTeeHistorianBlockFile && m_pTeeHistorianBlockFile->BlockSize() >= g_Config.m_SvTeeHistorianBlockSize * 1024)
+		{
+			std::vector<unsigned char> vKeyframe;
+			m_TeeHistorian.WriteKeyframe(TeeHistorianKeyframeWrite, &vKeyframe);
+			m_pTeeHistorianBlockFile->BeginBlock(m_TeeHistorian.LastWrittenTick(), vKeyframe.data(), vKeyframe.size());
+		}
 		m_TeeHistorian.BeginTick(Server()->Tick());
 		m_TeeHistorian.BeginPlayers();
 	}
 
 	// copy tuning
 	m_World.m_Core.m_aTuning[0] = m_Tuning;
+	int64_t PhaseStart = CTickTimings::Now();
 	m_World.Tick();
+	pTimings->Add(CTickTimings::PHASE_WORLD, CTickTimings::Now() - PhaseStart);
 
 	//if(world.paused) // make sure that the game object always updates
+	PhaseStart = CTickTimings::Now();
 	m_pController->Tick();
+	pTimings->Add(CTickTimings::PHASE_CONTROLLER, CTickTimings::Now() - PhaseStart);
 
+	// includes processing the score results
+	PhaseStart = CTickTimings::Now();
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
 		if(m_apPlayers[i])
@@ -950,10 +985,12 @@ void CGameContext::OnTick()
 		if(pPlayer)
 			pPlayer->PostPostTick();
 	}
+	pTimings->Add(CTickTimings::PHASE_PLAYERS, CTickTimings::Now() - PhaseStart);
 
 	// update voting
 	if(m_VoteCloseTime)
 	{
+		CTickTimings::CScope VoteScope(pTimings, CTickTimings::PHASE_VOTES);
 		// abort the kick-vote on player-leave
 		if(m_VoteEnforce == VOTE_ENFORCE_ABORT)
 		{
@@ -1198,6 +1235,7 @@ void CGameContext::OnTick()
 	// Record player position at the end of the tick
 	if(m_TeeHistorianActive)
 	{
+		CTickTimings::CScope TeeHistorianScope(pTimings, CTickTimings::PHASE_TEEHISTORIAN);
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
 			if(m_apPlayers[i] && m_apPlayers[i]->GetCharacter())
@@ -3444,7 +3482,7 @@ void CGameContext::OnInit()
 		FormatUuid(m_GameUuid, aGameUuid, sizeof(aGameUuid));
 
 		char aFilename[IO_MAX_PATH_LENGTH];
-		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aGameUuid);
+		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian%s", aGameUuid, g_Config.m_SvTeeHistorianCompress ? "z" : "");
 
 		IOHANDLE THFile = Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 		if(!THFile)
@@ -3457,7 +3495,16 @@ void CGameContext::OnInit()
 		{
 			dbg_msg("teehistorian", "recording to '%s'", aFilename);
 		}
-		m_pTeeHistorianFile = aio_new(THFile);
+		if(g_Config.m_SvTeeHistorianCompress)
+		{
+			// The block file compresses and writes on its own thread.
+			m_pTeeHistorianBlockFile = new CBlockFileWriter();
+			m_pTeeHistorianBlockFile->Open(THFile);
+		}
+		else
+		{
+			m_pTeeHistorianFile = aio_new(THFile);
+		}
 
 		char aVersion[128];
 		if(GIT_SHORTREV_HASH)
@@ -3764,15 +3811,25 @@ void CGameContext::OnShutdown()
 	if(m_TeeHistorianActive)
 	{
 		m_TeeHistorian.Finish();
-		aio_close(m_pTeeHistorianFile);
-		aio_wait(m_pTeeHistorianFile);
-		int Error = aio_error(m_pTeeHistorianFile);
+		int Error;
+		if(m_pTeeHistorianBlockFile)
+		{
+			Error = m_pTeeHistorianBlockFile->Close();
+			delete m_pTeeHistorianBlockFile;
+			m_pTeeHistorianBlockFile = nullptr;
+		}
+		else
+		{
+			aio_close(m_pTeeHistorianFile);
+			aio_wait(m_pTeeHistorianFile);
+			Error = aio_error(m_pTeeHistorianFile);
+			aio_free(m_pTeeHistorianFile);
+		}
 		if(Error)
 		{
 			dbg_msg("teehistorian", "error closing file, err=%d", Error);
 			Server()->SetErrorShutdown("teehistorian close error");
 		}
-		aio_free(m_pTeeHistorianFile);
 	}
 
 	DeleteTempfile();
@@ -187,6 +187,9 @@ void CGameControllerDDRace::Tick()
 		}
 		m_pLoadBestTimeResult = nullptr;
 	}
+
+	if(GameServer()->Score())
+		GameServer()->Score()->OnTick();
 }
 
 void CGameControllerDDRace::DoTeamChange(class CPlayer *pPlayer, int Team, bool DoChatMsg)
@@ -0,0 +1,127 @@
+#ifndef GAME_SERVER_RANKCACHE_H
+#define GAME_SERVER_RANKCACHE_H
+
+#include <engine/map.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Best value of each player, sorted so that ranks can be looked up with a
+// binary search. Lower values are better, unless constructed with
+// `Descending`. Ties are ordered by name.
+template<typename T>
+class CRanking
+{
+public:
+	struct CEntry
+	{
+		std::string m_Name;
+		T m_Value;
+	};
+
+	CRanking(bool Descending = false) :
+		m_Descending(Descending)
+	{
+	}
+
+	// Adds a value without keeping the ranking sorted, call `Sort` after
+	// adding all values.
+	void Add(const char *pName, T Value)
+	{
+		auto Result = m_Values.emplace(pName, Value);
+		if(!Result.second && Better(Value, Result.first->second))
+			Result.first->second = Value;
+	}
+
+	void Sort()
+	{
+		m_vEntries.clear();
+		m_vEntries.reserve(m_Values.size());
+		for(const auto &Value : m_Values)
+			m_vEntries.push_back({Value.first, Value.second});
+		std::sort(m_vEntries.begin(), m_vEntries.end(), [this](const CEntry &a, const CEntry &b) { return Less(a, b); });
+	}
+
+	// Sets the value of a player if it's better than the previous one.
+	// Returns true if the ranking changed.
+	bool Update(const char *pName, T Value)
+	{
+		auto Result = m_Values.emplace(pName, Value);
+		if(!Result.second)
+		{
+			if(!Better(Value, Result.first->second))
+				return false;
+			CEntry Old = {pName, Result.first->second};
+			m_vEntries.erase(LowerBound(Old));
+			Result.first->second = Value;
+		}
+		CEntry New = {pName, Value};
+		m_vEntries.insert(LowerBound(New), New);
+		return true;
+	}
+
+	int Size() const { return m_vEntries.size(); }
+	const CEntry &Entry(int Index) const { return m_vEntries[Index]; }
+
+	// Same as SQL's `RANK()`: one more than the number of better values.
+	int Rank(T Value) const
+	{
+		return 1 + std::partition_point(m_vEntries.begin(), m_vEntries.end(), [&](const CEntry &Entry) { return Better(Entry.m_Value, Value); }) - m_vEntries.begin();
+	}
+
+	// Returns false if the player has no value.
+	bool Find(const char *pName, T *pValue) const
+	{
+		auto It = m_Values.find(pName);
+		if(It == m_Values.end())
+			return false;
+		*pValue = It->second;
+		return true;
+	}
+
+private:
+	bool Better(T a, T b) const { return m_Descending ? a > b : a < b; }
+	bool Less(const CEntry &a, const CEntry &b) const
+	{
+		if(a.m_Value != b.m_Value)
+			return Better(a.m_Value, b.m_Value);
+		return a.m_Name < b.m_Name;
+	}
+	typename std::vector<CEntry>::iterator LowerBound(const CEntry &Entry)
+	{
+		return std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Entry, [this](const CEntry &a, const CEntry &b) { return Less(a, b); });
+	}
+
+	bool m_Descending;
+	std::vector<CEntry> m_vEntries;
+	std::unordered_map<std::string, T> m_Values;
+};
+
+// Ranks of the current map, used to answer /rank and /top5 without
+// querying the database.
+struct CRankCache
+{
+	CRankCache()
+	{
+		m_aMap[0] = '\0';
+		m_aServer[0] = '\0';
+	}
+
+	char m_aMap[MAX_MAP_LENGTH];
+	// regional ranks are those of servers with this string in their name
+	char m_aServer[5];
+
+	CRanking<float> m_Global;
+	CRanking<float> m_Regional;
+
+	// Applies a finish on this server.
+	void AddFinish(const char *pName, float Time)
+	{
+		m_Global.Update(pName, Time);
+		m_Regional.Update(pName, Time);
+	}
+};
+
+#endif // GAME_SERVER_RANKCACHE_H
@@ -30,7 +30,8 @@ void CScore::ExecPlayerThread(
 	const char *pThreadName,
 	int ClientID,
 	const char *pName,
-	int Offset)
+	int Offset,
+	void (*pCachedFunc)(const CRankCache *, const CSqlPlayerRequest *))
 {
 	auto pResult = NewSqlPlayerResult(ClientID);
 	if(pResult == nullptr)
@@ -42,7 +43,23 @@ void CScore::ExecPlayerThread(
 	str_copy(Tmp->m_aRequestingPlayer, Server()->ClientName(ClientID), sizeof(Tmp->m_aRequestingPlayer));
 	Tmp->m_Offset = Offset;
 
-	m_pPool->Execute(pFuncPtr, std::move(Tmp), pThreadName);
+	if(pCachedFunc && g_Config.m_SvRankCache && m_pRankCache &&
+		str_comp(m_pRankCache->m_Cache.m_aMap, Tmp->m_aMap) == 0 &&
+		str_comp(m_pRankCache->m_Cache.m_aServer, Tmp->m_aServer) == 0)
+	{
+		// finishes on other servers are only seen after a reload, do it
+		// in the background once the cache is used after getting old
+		if(Server()->Tick() > m_RankCacheLoadTick + (int64_t)g_Config.m_SvRankCacheRefresh * Server()->TickSpeed())
+			LoadRankCache();
+		pCachedFunc(&m_pRankCache->m_Cache, Tmp.get());
+		pResult->m_Success = true;
+		pResult->m_Completed.store(true);
+		return;
+	}
+
+	// see the writes of the requesting and the requested player
+	const char *pRequestingPlayer = Server()->ClientName(ClientID);
+	m_pPool->Execute(pFuncPtr, std::move(Tmp), pThreadName, {pRequestingPlayer, pName});
 }
 
 bool CScore::RateLimitPlayer(int ClientID)
@@ -71,7 +88,8 @@ void CScore::GeneratePassphrase(char *pBuf, int BufSize)
 CScore::CScore(CGameContext *pGameServer, CDbConnectionPool *pPool) :
 	m_pPool(pPool),
 	m_pGameServer(pGameServer),
-	m_pServer(pGameServer->Server())
+	m_pServer(pGameServer->Server()),
+	m_RankCacheLoadTick(0)
 {
 	LoadBestTime();
 
@@ -119,6 +137,43 @@ void CScore::LoadBestTime()
 	auto Tmp = std::make_unique<CSqlLoadBestTimeData>(LoadBestTimeResult);
 	str_copy(Tmp->m_aMap, g_Config.m_SvMap, sizeof(Tmp->m_aMap));
 	m_pPool->Execute(CScoreWorker::LoadBestTime, std::move(Tmp), "load best time");
+
+	if(!m_pRankCache)
+		LoadRankCache();
+}
+
+void CScore::LoadRankCache()
+{
+	if(!g_Config.m_SvRankCache || m_pRankCacheLoading)
+		return;
+
+	m_pRankCacheLoading = std::make_shared<CScoreRankCacheResult>();
+	m_vRankCacheFinishes.clear();
+	m_RankCacheLoadTick = Server()->Tick();
+
+	auto Tmp = std::make_unique<CSqlRankCacheRequest>(m_pRankCacheLoading);
+	str_copy(Tmp->m_aMap, g_Config.m_SvMap, sizeof(Tmp->m_aMap));
+	str_copy(Tmp->m_aServer, g_Config.m_SvSqlServerName, sizeof(Tmp->m_aServer));
+	m_pPool->Execute(CScoreWorker::LoadRankCache, std::move(Tmp), "load rank cache");
+}
+
+void CScore::OnTick()
+{
+	if(m_pRankCacheLoading && m_pRankCacheLoading->m_Completed)
+	{
+		if(m_pRankCacheLoading->m_Success)
+		{
+			// the finishes might not have been written when the cache was read
+			for(const auto &Finish : m_vRankCacheFinishes)
+				m_pRankCacheLoading->m_Cache.AddFinish(Finish.first.c_str(), Finish.second);
+			m_pRankCache = std::move(m_pRankCacheLoading);
+		}
+		m_pRankCacheLoading = nullptr;
+		m_vRankCacheFinishes.clear();
+	}
+
+	if(!g_Config.m_SvRankCache)
+		m_pRankCache = nullptr;
 }
 
 void CScore::LoadPlayerData(int ClientID, const char *pName)
@@ -160,7 +215,12 @@ void CScore::SaveScore(int ClientID, float Time, const char *pTimestamp, const f
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
-	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
+	if(m_pRankCache)
+		m_pRankCache->m_Cache.AddFinish(Tmp->m_aName, Time);
+	if(m_pRankCacheLoading)
+		m_vRankCacheFinishes.emplace_back(Tmp->m_aName, Time);
+
+	m_pPool->ExecuteBatchableWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score", {Server()->ClientName(ClientID)});
 }
 
 void CScore::SaveTeamScore(int *pClientIDs, unsigned int Size, float Time, const char *pTimestamp)
@@ -183,14 +243,17 @@ void CScore::SaveTeamScore(int *pClientIDs, unsigned int Size, float Time, const
 	str_copy(Tmp->m_aMap, g_Config.m_SvMap, sizeof(Tmp->m_aMap));
 	Tmp->m_TeamrankUuid = RandomUuid();
 
-	m_pPool->ExecuteWrite(CScoreWorker::SaveTeamScore, std::move(Tmp), "save team score");
+	std::vector<const char *> vpPlayers;
+	for(unsigned int i = 0; i < Size; i++)
+		vpPlayers.push_back(Server()->ClientName(pClientIDs[i]));
+	m_pPool->ExecuteBatchableWrite(CScoreWorker::SaveTeamScore, std::move(Tmp), "save team score", vpPlayers);
 }
 
 void CScore::ShowRank(int ClientID, const char *pName)
 {
 	if(RateLimitPlayer(ClientID))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientID, pName, 0);
+	ExecPlayerThread(CScoreWorker::ShowRank, "show rank", ClientID, pName, 0, CScoreWorker::ShowRank);
 }
 
 void CScore::ShowTeamRank(int ClientID, const char *pName)
@@ -204,7 +267,7 @@ void CScore::ShowTop(int ClientID, int Offset)
 {
 	if(RateLimitPlayer(ClientID))
 		return;
-	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientID, "", Offset);
+	ExecPlayerThread(CScoreWorker::ShowTop, "show top5", ClientID, "", Offset, CScoreWorker::ShowTop);
 }
 
 void CScore::ShowTeamTop5(int ClientID, int Offset)
@@ -317,9 +380,12 @@ void CScore::SaveTeam(int ClientID, const char *pCode, const char *pServer)
 			Tmp->m_aCode,
 			Tmp->m_aGeneratedCode);
 	}
+	std::vector<const char *> vpPlayers;
+	for(int i = 0; i < SaveResult->m_SavedTeam.GetMembersCount(); i++)
+		vpPlayers.push_back(SaveResult->m_SavedTeam.m_pSavedTees[i].GetName());
 	pController->m_Teams.KillSavedTeam(ClientID, Team);
 	GameServer()->SendChatTeam(Team, aBuf);
-	m_pPool->ExecuteWrite(CScoreWorker::SaveTeam, std::move(Tmp), "save team");
+	m_pPool->ExecuteWrite(CScoreWorker::SaveTeam, std::move(Tmp), "save team", vpPlayers);
 }
 
 void CScore::LoadTeam(const char *pCode, int ClientID)
@@ -359,7 +425,10 @@ void CScore::LoadTeam(const char *pCode, int ClientID)
 			Tmp->m_NumPlayer++;
 		}
 	}
-	m_pPool->ExecuteWrite(CScoreWorker::LoadTeam, std::move(Tmp), "load team");
+	std::vector<const char *> vpPlayers;
+	for(int i = 0; i < Tmp->m_NumPlayer; i++)
+		vpPlayers.push_back(Tmp->m_aClientNames[i]);
+	m_pPool->ExecuteWrite(CScoreWorker::LoadTeam, std::move(Tmp), "load team", vpPlayers);
 }
 
 void CScore::GetSaves(int ClientID)
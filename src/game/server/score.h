@@ -27,13 +27,23 @@ class CScore
 
 	// returns new SqlResult bound to the player, if no current Thread is active for this player
 	std::shared_ptr<CScorePlayerResult> NewSqlPlayerResult(int ClientID);
-	// Creates for player database requests
+	// Creates for player database requests, answered from the rank cache
+	// instead if `pCachedFunc` is given and the cache is loaded
 	void ExecPlayerThread(
 		bool (*pFuncPtr)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
 		const char *pThreadName,
 		int ClientID,
 		const char *pName,
-		int Offset);
+		int Offset,
+		void (*pCachedFunc)(const CRankCache *, const CSqlPlayerRequest *) = nullptr);
+
+	// ranks of the current map, loaded in the background
+	std::shared_ptr<CScoreRankCacheResult> m_pRankCache;
+	std::shared_ptr<CScoreRankCacheResult> m_pRankCacheLoading;
+	// finishes while the rank cache is loading, applied after it loaded
+	std::vector<std::pair<std::string, float>> m_vRankCacheFinishes;
+	int64_t m_RankCacheLoadTick;
+	void LoadRankCache();
 
 	// returns true if the player should be rate limited
 	bool RateLimitPlayer(int ClientID);
@@ -44,6 +54,8 @@ public:
 
 	CPlayerData *PlayerData(int ID) { return &m_aPlayerData[ID]; }
 
+	void OnTick();
+
 	void LoadBestTime();
 	void MapInfo(int ClientID, const char *pMapName);
 	void MapVote(int ClientID, const char *pMapName);
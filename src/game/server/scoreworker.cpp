@@ -471,6 +471,9 @@ bool CScoreWorker::SaveScore(IDbConnection *pSqlServer, const ISqlData *pGameDat
 
 	if(w == Write::NORMAL)
 	{
+		// a failed batch is executed again, don't keep the message of the
+		// rolled back attempt
+		paMessages[0][0] = '\0';
 		str_format(aBuf, sizeof(aBuf),
 			"SELECT COUNT(*) AS NumFinished FROM %s_race WHERE Map=? AND Name=? ORDER BY time ASC LIMIT 1",
 			pSqlServer->GetPrefix());
@@ -722,6 +725,47 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return false;
 }
 
+static void FormatRank(const CSqlPlayerRequest *pData, CScorePlayerResult *pResult, int Rank, float Time, float PercentRank, const char *pRegionalRank)
+{
+	char aBuf[64];
+	// CEIL and FLOOR are not supported in SQLite
+	int BetterThanPercent = std::floor(100.0f - 100.0f * PercentRank);
+	str_time_float(Time, TIME_HOURS_CENTISECS, aBuf, sizeof(aBuf));
+	if(g_Config.m_SvHideScore)
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"Your time: %s, better than %d%%", aBuf, BetterThanPercent);
+	}
+	else
+	{
+		pResult->m_MessageKind = CScorePlayerResult::ALL;
+
+		if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
+		{
+			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+				"%s - %s - better than %d%%",
+				pData->m_aName, aBuf, BetterThanPercent);
+		}
+		else
+		{
+			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+				"%s - %s - better than %d%% - requested by %s",
+				pData->m_aName, aBuf, BetterThanPercent, pData->m_aRequestingPlayer);
+		}
+
+		str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
+			"Global rank %d - %s %s",
+			Rank, pData->m_aServer, pRegionalRank);
+	}
+}
+
+static void FormatTopLine(char *pBuf, int BufSize, int Rank, const char *pName, float Time)
+{
+	char aTime[32];
+	str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+	str_format(pBuf, BufSize, "%d. %s Time: %s", Rank, pName, aTime);
+}
+
 bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
@@ -786,37 +830,7 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 
 	if(!End)
 	{
-		int Rank = pSqlServer->GetInt(1);
-		float Time = pSqlServer->GetFloat(2);
-		// CEIL and FLOOR are not supported in SQLite
-		int BetterThanPercent = std::floor(100.0f - 100.0f * pSqlServer->GetFloat(3));
-		str_time_float(Time, TIME_HOURS_CENTISECS, aBuf, sizeof(aBuf));
-		if(g_Config.m_SvHideScore)
-		{
-			str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-				"Your time: %s, better than %d%%", aBuf, BetterThanPercent);
-		}
-		else
-		{
-			pResult->m_MessageKind = CScorePlayerResult::ALL;
-
-			if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%%",
-					pData->m_aName, aBuf, BetterThanPercent);
-			}
-			else
-			{
-				str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
-					"%s - %s - better than %d%% - requested by %s",
-					pData->m_aName, aBuf, BetterThanPercent, pData->m_aRequestingPlayer);
-			}
-
-			str_format(pResult->m_Data.m_aaMessages[1], sizeof(pResult->m_Data.m_aaMessages[1]),
-				"Global rank %d - %s %s",
-				Rank, pData->m_aServer, aRegionalRank);
-		}
+		FormatRank(pData, pResult, pSqlServer->GetInt(1), pSqlServer->GetFloat(2), pSqlServer->GetFloat(3), aRegionalRank);
 	}
 	else
 	{
@@ -949,19 +963,14 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
 	Line++;
 
-	char aTime[32];
 	bool End = false;
 
 	while(!pSqlServer->Step(&End, pError, ErrorSize) && !End)
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
-
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
@@ -985,11 +994,8 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopLine(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
@@ -1384,6 +1390,108 @@ bool CScoreWorker::ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGam
 	return false;
 }
 
+bool CScoreWorker::LoadRankCache(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlRankCacheRequest *>(pGameData);
+	auto *pResult = dynamic_cast<CScoreRankCacheResult *>(pGameData->m_pResult.get());
+	CRankCache *pCache = &pResult->m_Cache;
+	str_copy(pCache->m_aMap, pData->m_aMap, sizeof(pCache->m_aMap));
+	str_copy(pCache->m_aServer, pData->m_aServer, sizeof(pCache->m_aServer));
+
+	// best time per player and server, the regional ranking is derived
+	// from the same rows
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, Server, MIN(Time) "
+		"FROM %s_race "
+		"WHERE Map = ? "
+		"GROUP BY Name, Server",
+		pSqlServer->GetPrefix());
+	if(pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	{
+		return true;
+	}
+	pSqlServer->BindString(1, pData->m_aMap);
+
+	bool End = false;
+	while(!pSqlServer->Step(&End, pError, ErrorSize) && !End)
+	{
+		char aName[MAX_NAME_LENGTH];
+		char aServer[5];
+		pSqlServer->GetString(1, aName, sizeof(aName));
+		pSqlServer->GetString(2, aServer, sizeof(aServer));
+		float Time = pSqlServer->GetFloat(3);
+		pCache->m_Global.Add(aName, Time);
+		// same as `Server LIKE '%<server>%'`
+		if(str_find_nocase(aServer, pData->m_aServer))
+			pCache->m_Regional.Add(aName, Time);
+	}
+	if(!End)
+	{
+		return true;
+	}
+	pCache->m_Global.Sort();
+	pCache->m_Regional.Sort();
+	return false;
+}
+
+void CScoreWorker::ShowRank(const CRankCache *pCache, const CSqlPlayerRequest *pData)
+{
+	auto *pResult = dynamic_cast<CScorePlayerResult *>(pData->m_pResult.get());
+
+	float Time;
+	char aRegionalRank[16];
+	if(pCache->m_Regional.Find(pData->m_aName, &Time))
+	{
+		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", pCache->m_Regional.Rank(Time));
+	}
+	else
+	{
+		str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
+	}
+
+	if(pCache->m_Global.Find(pData->m_aName, &Time))
+	{
+		int Rank = pCache->m_Global.Rank(Time);
+		int NumRanks = pCache->m_Global.Size();
+		// same as PERCENT_RANK()
+		float PercentRank = NumRanks > 1 ? (double)(Rank - 1) / (NumRanks - 1) : 0.0;
+		FormatRank(pData, pResult, Rank, Time, PercentRank, aRegionalRank);
+	}
+	else
+	{
+		str_format(pResult->m_Data.m_aaMessages[0], sizeof(pResult->m_Data.m_aaMessages[0]),
+			"%s is not ranked", pData->m_aName);
+	}
+}
+
+static void ShowTopLines(const CRanking<float> *pRanking, const CSqlPlayerRequest *pData, int NumLines, CScorePlayerResult *pResult, int *pLine)
+{
+	int LimitStart = maximum(absolute(pData->m_Offset) - 1, 0);
+	for(int i = LimitStart; i < LimitStart + NumLines && i < pRanking->Size(); i++)
+	{
+		const auto &Entry = pRanking->Entry(pData->m_Offset >= 0 ? i : pRanking->Size() - 1 - i);
+		FormatTopLine(pResult->m_Data.m_aaMessages[*pLine], sizeof(pResult->m_Data.m_aaMessages[*pLine]),
+			pRanking->Rank(Entry.m_Value), Entry.m_Name.c_str(), Entry.m_Value);
+		(*pLine)++;
+	}
+}
+
+void CScoreWorker::ShowTop(const CRankCache *pCache, const CSqlPlayerRequest *pData)
+{
+	auto *pResult = dynamic_cast<CScorePlayerResult *>(pData->m_pResult.get());
+
+	int Line = 0;
+	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+	Line++;
+	ShowTopLines(&pCache->m_Global, pData, 5, pResult, &Line);
+
+	str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+		"------------ %s Top ------------", pData->m_aServer);
+	Line++;
+	ShowTopLines(&pCache->m_Regional, pData, 3, pResult, &Line);
+}
+
 bool CScoreWorker::RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlRandomMapRequest *>(pGameData);
@@ -10,6 +10,7 @@
 #include <engine/server/databases/connection_pool.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/uuid_manager.h>
+#include <game/server/rankcache.h>
 #include <game/server/save.h>
 #include <game/voting.h>
 
@@ -82,6 +83,23 @@ struct CSqlLoadBestTimeData : ISqlData
 	char m_aMap[MAX_MAP_LENGTH];
 };
 
+struct CScoreRankCacheResult : ISqlResult
+{
+	CRankCache m_Cache;
+};
+
+struct CSqlRankCacheRequest : ISqlData
+{
+	CSqlRankCacheRequest(std::shared_ptr<CScoreRankCacheResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+
+	// current map
+	char m_aMap[MAX_MAP_LENGTH];
+	char m_aServer[5];
+};
+
 struct CSqlPlayerRequest : ISqlData
 {
 	CSqlPlayerRequest(std::shared_ptr<CScorePlayerResult> pResult) :
@@ -291,6 +309,11 @@ struct CScoreWorker
 	static bool ShowTopPoints(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool GetSaves(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
+	static bool LoadRankCache(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+	// same as above, but answered from the rank cache on the main thread
+	static void ShowRank(const CRankCache *pCache, const CSqlPlayerRequest *pData);
+	static void ShowTop(const CRankCache *pCache, const CSqlPlayerRequest *pData);
+
 	static bool SaveTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 	static bool LoadTeam(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize);
 
@@ -14,22 +14,6 @@ static const char TEEHISTORIAN_VERSION_MINOR[] = "4";
 #include <engine/shared/teehistorian_ex_chunks.h>
 #undef UUID
 
-enum
-{
-	TEEHISTORIAN_NONE,
-	TEEHISTORIAN_FINISH,
-	TEEHISTORIAN_TICK_SKIP,
-	TEEHISTORIAN_PLAYER_NEW,
-	TEEHISTORIAN_PLAYER_OLD,
-	TEEHISTORIAN_INPUT_DIFF,
-	TEEHISTORIAN_INPUT_NEW,
-	TEEHISTORIAN_MESSAGE,
-	TEEHISTORIAN_JOIN,
-	TEEHISTORIAN_DROP,
-	TEEHISTORIAN_CONSOLE_COMMAND,
-	TEEHISTORIAN_EX,
-};
-
 CTeeHistorian::CTeeHistorian()
 {
 	m_State = STATE_START;
@@ -777,3 +761,490 @@ void CTeeHistorian::Finish()
 
 	Write(Buffer.Data(), Buffer.Size());
 }
+
+void CTeeHistorian::WriteKeyframe(WRITE_CALLBACK pfnWriteCallback, void *pUser) const
+{
+	dbg_assert(m_State == STATE_START || m_State == STATE_BEFORE_TICK, "invalid teehistorian state");
+
+	CPacker Buffer;
+	Buffer.Reset();
+	Buffer.AddInt(m_LastWrittenTick);
+	Buffer.AddInt(m_MaxClientID);
+	pfnWriteCallback(Buffer.Data(), Buffer.Size(), pUser);
+
+	for(const auto &PrevPlayer : m_aPrevPlayers)
+	{
+		bool HasInput = PrevPlayer.m_UniqueClientID != 0;
+		Buffer.Reset();
+		Buffer.AddInt((PrevPlayer.m_Alive ? 1 : 0) | (HasInput ? 2 : 0));
+		if(PrevPlayer.m_Alive)
+		{
+			Buffer.AddInt(PrevPlayer.m_X);
+			Buffer.AddInt(PrevPlayer.m_Y);
+		}
+		if(HasInput)
+		{
+			for(size_t i = 0; i < sizeof(PrevPlayer.m_Input) / sizeof(int32_t); i++)
+			{
+				Buffer.AddInt(((const int *)&PrevPlayer.m_Input)[i]);
+			}
+		}
+		Buffer.AddInt(PrevPlayer.m_Team);
+		pfnWriteCallback(Buffer.Data(), Buffer.Size(), pUser);
+	}
+
+	int NumPracticeTeams = 0;
+	for(const auto &PrevTeam : m_aPrevTeams)
+	{
+		NumPracticeTeams += PrevTeam.m_Practice;
+	}
+	Buffer.Reset();
+	Buffer.AddInt(NumPracticeTeams);
+	for(int Team = 0; Team < MAX_CLIENTS; Team++)
+	{
+		if(m_aPrevTeams[Team].m_Practice)
+		{
+			Buffer.AddInt(Team);
+		}
+	}
+	pfnWriteCallback(Buffer.Data(), Buffer.Size(), pUser);
+}
+
+CTeeHistorianReader::CTeeHistorianReader() :
+	m_File(0),
+	m_Compressed(false),
+	m_Block(-1),
+	m_Eof(true),
+	m_Finished(false),
+	m_Pos(0)
+{
+	ResetState();
+}
+
+bool CTeeHistorianReader::Open(IOHANDLE File)
+{
+	Close();
+
+	unsigned char aMagic[8];
+	unsigned MagicSize = io_read(File, aMagic, sizeof(aMagic));
+	io_seek(File, 0, IOSEEK_START);
+	m_Compressed = CBlockFileReader::IsBlockFile(aMagic, MagicSize);
+	if(m_Compressed)
+	{
+		if(m_BlockFile.Open(File) || m_BlockFile.NumBlocks() == 0)
+		{
+			return true;
+		}
+	}
+	else
+	{
+		m_File = File;
+	}
+	return Seek(0);
+}
+
+void CTeeHistorianReader::Close()
+{
+	if(m_File)
+	{
+		io_close(m_File);
+		m_File = 0;
+	}
+	m_BlockFile.Close();
+	m_Compressed = false;
+	m_Block = -1;
+	m_Eof = true;
+	m_Finished = false;
+	m_vData.clear();
+	m_Pos = 0;
+	m_HeaderJson.clear();
+	ResetState();
+}
+
+void CTeeHistorianReader::ResetState()
+{
+	// Tick 0 is implicit at the start, see `CTeeHistorian::Reset`.
+	m_Tick = 0;
+	m_LastPlayerClientID = MAX_CLIENTS;
+	for(auto &Player : m_aPlayers)
+	{
+		mem_zero(&Player, sizeof(Player));
+	}
+	for(auto &TeamPractice : m_aTeamPractice)
+	{
+		TeamPractice = false;
+	}
+}
+
+bool CTeeHistorianReader::ReadKeyframe()
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(m_vKeyframe.data(), m_vKeyframe.size());
+
+	m_Tick = Unpacker.GetInt();
+	m_LastPlayerClientID = Unpacker.GetInt();
+	for(auto &Player : m_aPlayers)
+	{
+		int Flags = Unpacker.GetInt();
+		mem_zero(&Player, sizeof(Player));
+		Player.m_Alive = Flags & 1;
+		Player.m_HasInput = Flags & 2;
+		if(Player.m_Alive)
+		{
+			Player.m_X = Unpacker.GetInt();
+			Player.m_Y = Unpacker.GetInt();
+		}
+		if(Player.m_HasInput)
+		{
+			for(size_t i = 0; i < sizeof(Player.m_Input) / sizeof(int32_t); i++)
+			{
+				((int *)&Player.m_Input)[i] = Unpacker.GetInt();
+			}
+		}
+		Player.m_Team = Unpacker.GetInt();
+	}
+	for(auto &TeamPractice : m_aTeamPractice)
+	{
+		TeamPractice = false;
+	}
+	int NumPracticeTeams = Unpacker.GetInt();
+	for(int i = 0; i < NumPracticeTeams && !Unpacker.Error(); i++)
+	{
+		int Team = Unpacker.GetInt();
+		if(Team < 0 || Team >= MAX_CLIENTS)
+		{
+			return true;
+		}
+		m_aTeamPractice[Team] = true;
+	}
+	return Unpacker.Error();
+}
+
+bool CTeeHistorianReader::LoadBlock(int Block, bool Keyframe)
+{
+	m_vData.clear();
+	m_Pos = 0;
+	m_Block = Block;
+	m_Eof = false;
+	if(m_BlockFile.ReadBlock(Block, &m_vKeyframe, &m_vData))
+	{
+		return true;
+	}
+	return Keyframe && ReadKeyframe();
+}
+
+bool CTeeHistorianReader::Refill()
+{
+	m_vData.erase(m_vData.begin(), m_vData.begin() + m_Pos);
+	m_Pos = 0;
+
+	if(m_Compressed)
+	{
+		if(m_Block + 1 >= m_BlockFile.NumBlocks())
+		{
+			m_Eof = true;
+			return false;
+		}
+		// Chunks never span blocks, a block only starts between ticks.
+		std::vector<unsigned char> vData;
+		if(m_BlockFile.ReadBlock(m_Block + 1, &m_vKeyframe, &vData))
+		{
+			return true;
+		}
+		m_Block++;
+		m_vData.insert(m_vData.end(), vData.begin(), vData.end());
+		return false;
+	}
+
+	size_t Size = m_vData.size();
+	m_vData.resize(Size + READ_SIZE);
+	unsigned Read = io_read(m_File, m_vData.data() + Size, READ_SIZE);
+	m_vData.resize(Size + Read);
+	m_Eof = Read < READ_SIZE;
+	return false;
+}
+
+bool CTeeHistorianReader::EnsureData()
+{
+	while(!m_Eof && m_vData.size() - m_Pos < REFILL_THRESHOLD)
+	{
+		if(Refill())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CTeeHistorianReader::ReadHeader()
+{
+	if(EnsureData() || m_vData.size() - m_Pos < sizeof(TEEHISTORIAN_UUID) ||
+		mem_comp(m_vData.data() + m_Pos, &TEEHISTORIAN_UUID, sizeof(TEEHISTORIAN_UUID)) != 0)
+	{
+		return true;
+	}
+	size_t Start = m_Pos + sizeof(TEEHISTORIAN_UUID);
+	for(size_t i = Start; i < m_vData.size(); i++)
+	{
+		if(m_vData[i] == 0)
+		{
+			m_HeaderJson.assign((const char *)m_vData.data() + Start, i - Start);
+			m_Pos = i + 1;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CTeeHistorianReader::Seek(int Tick)
+{
+	m_Finished = false;
+	if(m_Compressed)
+	{
+		int Block = m_BlockFile.FindBlock(Tick - 1);
+		if(Block <= 0)
+		{
+			ResetState();
+			if(LoadBlock(0, false) || ReadHeader())
+			{
+				return true;
+			}
+		}
+		else if(LoadBlock(Block, true))
+		{
+			return true;
+		}
+	}
+	else
+	{
+		if(!m_File)
+		{
+			return true;
+		}
+		io_seek(m_File, 0, IOSEEK_START);
+		m_vData.clear();
+		m_Pos = 0;
+		m_Eof = false;
+		ResetState();
+		if(ReadHeader())
+		{
+			return true;
+		}
+	}
+
+	CChunk Chunk;
+	while(PeekTick() < Tick)
+	{
+		int Result = Next(&Chunk);
+		if(Result == READ_FINISHED)
+		{
+			break;
+		}
+		else if(Result == READ_ERROR)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void CTeeHistorianReader::UpdatePlayerTick(int ClientID)
+{
+	if(ClientID <= m_LastPlayerClientID)
+	{
+		m_Tick++;
+	}
+	m_LastPlayerClientID = ClientID;
+}
+
+int CTeeHistorianReader::PeekTick()
+{
+	if(EnsureData() || m_Pos == m_vData.size())
+	{
+		return m_Tick;
+	}
+	CUnpacker Unpacker;
+	Unpacker.Reset(m_vData.data() + m_Pos, m_vData.size() - m_Pos);
+	int Type = Unpacker.GetInt();
+	int ClientID = Type;
+	if(Type == -TEEHISTORIAN_TICK_SKIP)
+	{
+		return m_Tick + Unpacker.GetInt() + 1;
+	}
+	else if(Type == -TEEHISTORIAN_PLAYER_NEW || Type == -TEEHISTORIAN_PLAYER_OLD)
+	{
+		ClientID = Unpacker.GetInt();
+	}
+	else if(Type < 0)
+	{
+		return m_Tick;
+	}
+	return ClientID <= m_LastPlayerClientID ? m_Tick + 1 : m_Tick;
+}
+
+int CTeeHistorianReader::Next(CChunk *pChunk)
+{
+	if(m_Finished)
+	{
+		return READ_FINISHED;
+	}
+	if(EnsureData() || m_Pos == m_vData.size())
+	{
+		return READ_ERROR;
+	}
+
+	CUnpacker Unpacker;
+	Unpacker.Reset(m_vData.data() + m_Pos, m_vData.size() - m_Pos);
+
+	pChunk->m_Type = Unpacker.GetInt();
+	pChunk->m_ClientID = -1;
+	pChunk->m_pData = 0;
+	pChunk->m_DataSize = 0;
+	pChunk->m_pString = 0;
+	pChunk->m_FlagMask = 0;
+	pChunk->m_NumArgs = 0;
+
+	bool Valid = true;
+	if(pChunk->m_Type >= 0)
+	{
+		pChunk->m_ClientID = pChunk->m_Type;
+		pChunk->m_Type = CHUNK_PLAYER_DIFF;
+	}
+	else
+	{
+		pChunk->m_Type = -pChunk->m_Type;
+		switch(pChunk->m_Type)
+		{
+		case TEEHISTORIAN_PLAYER_NEW:
+		case TEEHISTORIAN_PLAYER_OLD:
+		case TEEHISTORIAN_INPUT_DIFF:
+		case TEEHISTORIAN_INPUT_NEW:
+		case TEEHISTORIAN_MESSAGE:
+		case TEEHISTORIAN_JOIN:
+		case TEEHISTORIAN_DROP:
+		case TEEHISTORIAN_CONSOLE_COMMAND:
+			pChunk->m_ClientID = Unpacker.GetInt();
+			break;
+		case TEEHISTORIAN_FINISH:
+		case TEEHISTORIAN_TICK_SKIP:
+		case TEEHISTORIAN_EX:
+			break;
+		default:
+			Valid = false;
+		}
+	}
+	// Console commands can come from the server itself.
+	int MinClientID = pChunk->m_Type == TEEHISTORIAN_CONSOLE_COMMAND ? -1 : 0;
+	if(!Valid || Unpacker.Error() || (pChunk->m_ClientID != -1 && (pChunk->m_ClientID < MinClientID || pChunk->m_ClientID >= MAX_CLIENTS)))
+	{
+		return READ_ERROR;
+	}
+
+	CPlayer *pPlayer = pChunk->m_ClientID >= 0 ? &m_aPlayers[pChunk->m_ClientID] : 0;
+	switch(pChunk->m_Type)
+	{
+	case CHUNK_PLAYER_DIFF:
+		UpdatePlayerTick(pChunk->m_ClientID);
+		pPlayer->m_X += Unpacker.GetInt();
+		pPlayer->m_Y += Unpacker.GetInt();
+		break;
+	case TEEHISTORIAN_PLAYER_NEW:
+		UpdatePlayerTick(pChunk->m_ClientID);
+		pPlayer->m_Alive = true;
+		pPlayer->m_X = Unpacker.GetInt();
+		pPlayer->m_Y = Unpacker.GetInt();
+		break;
+	case TEEHISTORIAN_PLAYER_OLD:
+		UpdatePlayerTick(pChunk->m_ClientID);
+		pPlayer->m_Alive = false;
+		break;
+	case TEEHISTORIAN_TICK_SKIP:
+		m_Tick += Unpacker.GetInt() + 1;
+		m_LastPlayerClientID = -1;
+		break;
+	case TEEHISTORIAN_INPUT_DIFF:
+	case TEEHISTORIAN_INPUT_NEW:
+	{
+		int *pInput = (int *)&pPlayer->m_Input;
+		bool Diff = pChunk->m_Type == TEEHISTORIAN_INPUT_DIFF;
+		for(size_t i = 0; i < sizeof(pPlayer->m_Input) / sizeof(int32_t); i++)
+		{
+			int Value = Unpacker.GetInt();
+			pInput[i] = Diff ? pInput[i] + Value : Value;
+		}
+		pPlayer->m_HasInput = true;
+		break;
+	}
+	case TEEHISTORIAN_MESSAGE:
+		pChunk->m_DataSize = Unpacker.GetInt();
+		if(pChunk->m_DataSize < 0)
+		{
+			return READ_ERROR;
+		}
+		pChunk->m_pData = Unpacker.GetRaw(pChunk->m_DataSize);
+		break;
+	case TEEHISTORIAN_DROP:
+		pChunk->m_pString = Unpacker.GetString(0);
+		break;
+	case TEEHISTORIAN_CONSOLE_COMMAND:
+		pChunk->m_FlagMask = Unpacker.GetInt();
+		pChunk->m_pString = Unpacker.GetString(0);
+		pChunk->m_NumArgs = Unpacker.GetInt();
+		if(pChunk->m_NumArgs < 0 || pChunk->m_NumArgs > MAX_ARGS)
+		{
+			return READ_ERROR;
+		}
+		for(int i = 0; i < pChunk->m_NumArgs; i++)
+		{
+			pChunk->m_apArgs[i] = Unpacker.GetString(0);
+		}
+		break;
+	case TEEHISTORIAN_EX:
+	{
+		const unsigned char *pUuid = Unpacker.GetRaw(sizeof(pChunk->m_Uuid));
+		pChunk->m_DataSize = Unpacker.GetInt();
+		if(Unpacker.Error() || pChunk->m_DataSize < 0)
+		{
+			return READ_ERROR;
+		}
+		mem_copy(&pChunk->m_Uuid, pUuid, sizeof(pChunk->m_Uuid));
+		pChunk->m_pData = Unpacker.GetRaw(pChunk->m_DataSize);
+		if(Unpacker.Error())
+		{
+			return READ_ERROR;
+		}
+
+		CUnpacker Ex;
+		Ex.Reset(pChunk->m_pData, pChunk->m_DataSize);
+		if(pChunk->m_Uuid == UUID_TEEHISTORIAN_PLAYER_TEAM)
+		{
+			int ClientID = Ex.GetInt();
+			int Team = Ex.GetInt();
+			if(!Ex.Error() && ClientID >= 0 && ClientID < MAX_CLIENTS)
+			{
+				m_aPlayers[ClientID].m_Team = Team;
+			}
+		}
+		else if(pChunk->m_Uuid == UUID_TEEHISTORIAN_TEAM_PRACTICE)
+		{
+			int Team = Ex.GetInt();
+			int Practice = Ex.GetInt();
+			if(!Ex.Error() && Team >= 0 && Team < MAX_CLIENTS)
+			{
+				m_aTeamPractice[Team] = Practice;
+			}
+		}
+		break;
+	}
+	case TEEHISTORIAN_FINISH:
+		m_Finished = true;
+		break;
+	}
+	if(Unpacker.Error())
+	{
+		return READ_ERROR;
+	}
+	pChunk->m_Tick = m_Tick;
+	m_Pos += Unpacker.Position();
+	return m_Finished ? READ_FINISHED : READ_CHUNK;
+}
@@ -3,15 +3,35 @@
 
 #include <base/hash.h>
 #include <engine/console.h>
+#include <engine/shared/blockfile.h>
 #include <engine/shared/protocol.h>
+#include <engine/shared/uuid_manager.h>
 #include <game/generated/protocol.h>
 
 #include <ctime>
+#include <string>
+#include <vector>
 
 class CConfig;
 class CTuningParams;
 class CUuidManager;
 
+enum
+{
+	TEEHISTORIAN_NONE,
+	TEEHISTORIAN_FINISH,
+	TEEHISTORIAN_TICK_SKIP,
+	TEEHISTORIAN_PLAYER_NEW,
+	TEEHISTORIAN_PLAYER_OLD,
+	TEEHISTORIAN_INPUT_DIFF,
+	TEEHISTORIAN_INPUT_NEW,
+	TEEHISTORIAN_MESSAGE,
+	TEEHISTORIAN_JOIN,
+	TEEHISTORIAN_DROP,
+	TEEHISTORIAN_CONSOLE_COMMAND,
+	TEEHISTORIAN_EX,
+};
+
 class CTeeHistorian
 {
 public:
@@ -84,6 +104,12 @@ public:
 	void RecordAuthLogin(int ClientID, int Level, const char *pAuthName);
 	void RecordAuthLogout(int ClientID);
 
+	// For seekable output: the state a reader needs to continue decoding
+	// from the current position. Only valid between `EndTick` and
+	// `BeginTick`.
+	int LastWrittenTick() const { return m_LastWrittenTick; }
+	void WriteKeyframe(WRITE_CALLBACK pfnWriteCallback, void *pUser) const;
+
 	int m_Debug; // Possible values: 0, 1, 2.
 
 private:
@@ -138,4 +164,127 @@ private:
 	CTeam m_aPrevTeams[MAX_CLIENTS];
 };
 
+// Reads plain teehistorian files as well as the seekable, compressed ones
+// written through `CBlockFileWriter` with keyframes from
+// `CTeeHistorian::WriteKeyframe`.
+class CTeeHistorianReader
+{
+public:
+	enum
+	{
+		// Position changes of alive players don't have a chunk type of
+		// their own.
+		CHUNK_PLAYER_DIFF = -1,
+
+		MAX_ARGS = 16,
+
+		READ_CHUNK = 0,
+		READ_FINISHED,
+		READ_ERROR,
+	};
+
+	struct CPlayer
+	{
+		bool m_Alive;
+		int m_X;
+		int m_Y;
+
+		bool m_HasInput;
+		CNetObj_PlayerInput m_Input;
+
+		// DDNet team
+		int m_Team;
+	};
+
+	struct CChunk
+	{
+		// One of `TEEHISTORIAN_*` or `CHUNK_PLAYER_DIFF`.
+		int m_Type;
+		int m_Tick;
+		int m_ClientID;
+
+		// `TEEHISTORIAN_MESSAGE` and `TEEHISTORIAN_EX`, only valid until
+		// the next call to `Next`.
+		CUuid m_Uuid;
+		const unsigned char *m_pData;
+		int m_DataSize;
+
+		// `TEEHISTORIAN_DROP` and `TEEHISTORIAN_CONSOLE_COMMAND`, only
+		// valid until the next call to `Next`.
+		const char *m_pString;
+		int m_FlagMask;
+		int m_NumArgs;
+		const char *m_apArgs[MAX_ARGS];
+	};
+
+	CTeeHistorianReader();
+
+	/**
+	 * Takes ownership of `File` and reads the header.
+	 *
+	 * @return `true` on error.
+	 */
+	bool Open(IOHANDLE File);
+	void Close();
+
+	bool Compressed() const { return m_Compressed; }
+	const char *HeaderJson() const { return m_HeaderJson.c_str(); }
+
+	/**
+	 * Positions the reader before the first chunk of a tick greater than
+	 * or equal to `Tick`. Compressed files only decode the data after the
+	 * closest keyframe, plain files are read from the start.
+	 *
+	 * @return `true` on error.
+	 */
+	bool Seek(int Tick);
+
+	/**
+	 * Reads the next chunk and applies it to the player state.
+	 *
+	 * @return `READ_CHUNK`, `READ_FINISHED` after the final chunk or
+	 *         `READ_ERROR`.
+	 */
+	int Next(CChunk *pChunk);
+
+	// Tick of the last chunk read.
+	int Tick() const { return m_Tick; }
+	const CPlayer &Player(int ClientID) const { return m_aPlayers[ClientID]; }
+	bool TeamPractice(int Team) const { return m_aTeamPractice[Team]; }
+
+private:
+	enum
+	{
+		REFILL_THRESHOLD = 256 * 1024,
+		READ_SIZE = 1024 * 1024,
+	};
+
+	void ResetState();
+	bool ReadKeyframe();
+	bool LoadBlock(int Block, bool Keyframe);
+	bool ReadHeader();
+	bool Refill();
+	bool EnsureData();
+	int PeekTick();
+	void UpdatePlayerTick(int ClientID);
+
+	IOHANDLE m_File;
+	bool m_Compressed;
+	CBlockFileReader m_BlockFile;
+	int m_Block;
+	bool m_Eof;
+	bool m_Finished;
+
+	std::vector<unsigned char> m_vData;
+	std::vector<unsigned char> m_vKeyframe;
+	size_t m_Pos;
+
+	std::string m_HeaderJson;
+
+	int m_Tick;
+	int m_LastPlayerClientID;
+	CPlayer m_aPlayers[MAX_CLIENTS];
+	bool m_aTeamPractice[MAX_CLIENTS];
+};
+
 #endif // GAME_SERVER_TEEHISTORIAN_H
@@ -0,0 +1,162 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/blockfile.h>
+
+#include <vector>
+
+class BlockFile : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+
+	~BlockFile()
+	{
+		fs_remove(m_Info.m_aFilename);
+	}
+
+	void WriteBlocks(int NumBlocks)
+	{
+		IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		CBlockFileWriter Writer;
+		Writer.Open(File);
+		for(int Block = 0; Block < NumBlocks; Block++)
+		{
+			if(Block > 0)
+			{
+				int Keyframe = Block * 10;
+				Writer.BeginBlock(Block * 10, &Keyframe, sizeof(Keyframe));
+			}
+			for(int i = 0; i < 1000; i++)
+			{
+				int Value = Block * 1000 + i;
+				Writer.Write(&Value, sizeof(Value));
+			}
+		}
+		EXPECT_EQ(Writer.Close(), 0);
+	}
+
+	void ExpectBlocks(CBlockFileReader *pReader, int NumBlocks)
+	{
+		ASSERT_EQ(pReader->NumBlocks(), NumBlocks);
+		std::vector<unsigned char> vKeyframe;
+		std::vector<unsigned char> vData;
+		for(int Block = NumBlocks - 1; Block >= 0; Block--)
+		{
+			EXPECT_EQ(pReader->BlockKey(Block), Block * 10);
+			ASSERT_FALSE(pReader->ReadBlock(Block, &vKeyframe, &vData));
+			if(Block > 0)
+			{
+				ASSERT_EQ(vKeyframe.size(), sizeof(int));
+				EXPECT_EQ(*(int *)vKeyframe.data(), Block * 10);
+			}
+			else
+			{
+				EXPECT_TRUE(vKeyframe.empty());
+			}
+			ASSERT_EQ(vData.size(), 1000 * sizeof(int));
+			for(int i = 0; i < 1000; i++)
+			{
+				EXPECT_EQ(((int *)vData.data())[i], Block * 1000 + i);
+			}
+		}
+	}
+};
+
+TEST_F(BlockFile, RoundTrip)
+{
+	WriteBlocks(5);
+	CBlockFileReader Reader;
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Reader.Open(File));
+	ExpectBlocks(&Reader, 5);
+}
+
+TEST_F(BlockFile, FindBlock)
+{
+	WriteBlocks(3);
+	CBlockFileReader Reader;
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Reader.Open(File));
+	EXPECT_EQ(Reader.FindBlock(-1), -1);
+	EXPECT_EQ(Reader.FindBlock(0), 0);
+	EXPECT_EQ(Reader.FindBlock(9), 0);
+	EXPECT_EQ(Reader.FindBlock(10), 1);
+	EXPECT_EQ(Reader.FindBlock(19), 1);
+	EXPECT_EQ(Reader.FindBlock(1000), 2);
+}
+
+TEST_F(BlockFile, MissingIndex)
+{
+	WriteBlocks(4);
+
+	// Cut off index and trailer, as if the writer had crashed.
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	void *pData;
+	unsigned DataSize;
+	io_read_all(File, &pData, &DataSize);
+	io_close(File);
+	unsigned char *pBytes = (unsigned char *)pData;
+	unsigned IndexOffset = bytes_be_to_uint(pBytes + DataSize - 12);
+	File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, pData, IndexOffset);
+	io_close(File);
+	free(pData);
+
+	CBlockFileReader Reader;
+	File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Reader.Open(File));
+	ExpectBlocks(&Reader, 4);
+}
+
+TEST_F(BlockFile, NotBlockFile)
+{
+	EXPECT_FALSE(CBlockFileReader::IsBlockFile("TWBLKS", 6));
+	EXPECT_FALSE(CBlockFileReader::IsBlockFile("teehistorian....", 16));
+	EXPECT_TRUE(CBlockFileReader::IsBlockFile("TWBLKS01", 8));
+}
+
+TEST_F(BlockFile, CorruptHeader)
+{
+	WriteBlocks(3);
+
+	IOHANDLE File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	void *pData;
+	unsigned DataSize;
+	io_read_all(File, &pData, &DataSize);
+	io_close(File);
+	unsigned char *pBytes = (unsigned char *)pData;
+
+	// The first block starts right after the magic. Claim a compressed size
+	// running into the next block and a huge uncompressed size for the
+	// second one.
+	const unsigned FirstBlock = 8;
+	const unsigned SecondBlock = FirstBlock + 16 + bytes_be_to_uint(pBytes + FirstBlock + 12);
+	uint_to_bytes_be(pBytes + FirstBlock + 12, bytes_be_to_uint(pBytes + FirstBlock + 12) + 1);
+	uint_to_bytes_be(pBytes + SecondBlock + 8, 0xffffffff);
+	File = io_open(m_Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, pData, DataSize);
+	io_close(File);
+	free(pData);
+
+	CBlockFileReader Reader;
+	File = io_open(m_Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Reader.Open(File));
+	ASSERT_EQ(Reader.NumBlocks(), 3);
+	std::vector<unsigned char> vKeyframe;
+	std::vector<unsigned char> vData;
+	EXPECT_TRUE(Reader.ReadBlock(0, &vKeyframe, &vData));
+	EXPECT_TRUE(Reader.ReadBlock(1, &vKeyframe, &vData));
+	EXPECT_FALSE(Reader.ReadBlock(2, &vKeyframe, &vData));
+	EXPECT_LT(vData.capacity(), (size_t)1024 * 1024);
+}
@@ -0,0 +1,432 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+
+#include <memory>
+#include <vector>
+
+// The line and box tests before they skipped empty tiles, to check that the
+// results stay exactly the same.
+
+static int RefIntersectLine(const CCollision &Col, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		if(Col.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Col.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleHook(const CCollision &Col, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	int dx = 0, dy = 0;
+	ThroughOffset(Pos0, Pos1, &dx, &dy);
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		int Index = Col.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportHook)
+			*pTeleNr = Col.IsTeleport(Index);
+		else
+			*pTeleNr = Col.IsTeleportHook(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINHOOK;
+		}
+		int hit = 0;
+		if(Col.CheckPoint(ix, iy))
+		{
+			if(!Col.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+				hit = Col.GetCollisionAt(ix, iy);
+		}
+		else if(Col.IsHookBlocker(ix, iy, Pos0, Pos1))
+		{
+			hit = TILE_NOHOOK;
+		}
+		if(hit)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return hit;
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectLineTeleWeapon(const CCollision &Col, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Last = Pos0;
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i / (float)End;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int ix = round_to_int(Pos.x);
+		int iy = round_to_int(Pos.y);
+		int Index = Col.GetPureMapIndex(Pos);
+		if(g_Config.m_SvOldTeleportWeapons)
+			*pTeleNr = Col.IsTeleport(Index);
+		else
+			*pTeleNr = Col.IsTeleportWeapon(Index);
+		if(*pTeleNr)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return TILE_TELEINWEAPON;
+		}
+		if(Col.CheckPoint(ix, iy))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return Col.GetCollisionAt(ix, iy);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaser(const CCollision &Col, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float d = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	for(int i = 0, id = std::ceil(d); i < id; i++)
+	{
+		float a = (int)i / d;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		int Nx = clamp(round_to_int(Pos.x) / 32, 0, Col.GetWidth() - 1);
+		int Ny = clamp(round_to_int(Pos.y) / 32, 0, Col.GetHeight() - 1);
+		if(Col.GetIndex(Nx, Ny) == TILE_SOLID || Col.GetIndex(Nx, Ny) == TILE_NOHOOK || Col.GetIndex(Nx, Ny) == TILE_NOLASER || Col.GetFIndex(Nx, Ny) == TILE_NOLASER)
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Col.GetFIndex(Nx, Ny) == TILE_NOLASER)
+				return Col.GetFCollisionAt(Pos.x, Pos.y);
+			else
+				return Col.GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static int RefIntersectNoLaserNW(const CCollision &Col, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float d = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	for(int i = 0, id = std::ceil(d); i < id; i++)
+	{
+		float a = (float)i / d;
+		vec2 Pos = mix(Pos0, Pos1, a);
+		if(Col.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || Col.IsFNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			if(Col.IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+				return Col.GetCollisionAt(Pos.x, Pos.y);
+			else
+				return Col.GetFCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static void RefMoveBox(const CCollision &Col, vec2 *pInoutPos, vec2 *pInoutVel, vec2 Size, float Elasticity)
+{
+	vec2 Pos = *pInoutPos;
+	vec2 Vel = *pInoutVel;
+	float Distance = length(Vel);
+	int Max = (int)Distance;
+	if(Distance > 0.00001f)
+	{
+		float Fraction = 1.0f / (float)(Max + 1);
+		for(int i = 0; i <= Max; i++)
+		{
+			if(Vel == vec2(0, 0))
+				break;
+			vec2 NewPos = Pos + Vel * Fraction;
+			if(NewPos == Pos)
+				break;
+			if(Col.TestBox(vec2(NewPos.x, NewPos.y), Size))
+			{
+				int Hits = 0;
+				if(Col.TestBox(vec2(Pos.x, NewPos.y), Size))
+				{
+					NewPos.y = Pos.y;
+					Vel.y *= -Elasticity;
+					Hits++;
+				}
+				if(Col.TestBox(vec2(NewPos.x, Pos.y), Size))
+				{
+					NewPos.x = Pos.x;
+					Vel.x *= -Elasticity;
+					Hits++;
+				}
+				if(Hits == 0)
+				{
+					NewPos.y = Pos.y;
+					Vel.y *= -Elasticity;
+					NewPos.x = Pos.x;
+					Vel.x *= -Elasticity;
+				}
+			}
+			Pos = NewPos;
+		}
+	}
+	*pInoutPos = Pos;
+	*pInoutVel = Vel;
+}
+
+class Collision : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IKernel> m_pKernel;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	void Load(const char *pMapName)
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		IStorage *pStorage = CreateTempStorage("data/maps");
+		IEngineMap *pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(pStorage);
+		m_pKernel->RegisterInterface(pMap);
+		m_pKernel->RegisterInterface(static_cast<IMap *>(pMap), false);
+		ASSERT_TRUE(pMap->Load(pMapName));
+		m_Layers.Init(m_pKernel.get());
+		m_Collision.Init(&m_Layers);
+	}
+
+	// the tile traversal before the special tile bitmap
+	std::vector<int> ReferenceMapIndices(vec2 PrevPos, vec2 Pos) const
+	{
+		std::vector<int> vIndices;
+		float d = distance(PrevPos, Pos);
+		int End(d + 1);
+		if(!d)
+		{
+			int Nx = clamp((int)Pos.x / 32, 0, m_Collision.GetWidth() - 1);
+			int Ny = clamp((int)Pos.y / 32, 0, m_Collision.GetHeight() - 1);
+			int Index = Ny * m_Collision.GetWidth() + Nx;
+			if(m_Collision.TileExists(Index))
+				vIndices.push_back(Index);
+			return vIndices;
+		}
+		int LastIndex = 0;
+		for(int i = 0; i < End; i++)
+		{
+			float a = i / d;
+			vec2 Tmp = mix(PrevPos, Pos, a);
+			int Nx = clamp((int)Tmp.x / 32, 0, m_Collision.GetWidth() - 1);
+			int Ny = clamp((int)Tmp.y / 32, 0, m_Collision.GetHeight() - 1);
+			int Index = Ny * m_Collision.GetWidth() + Nx;
+			if(m_Collision.TileExists(Index) && LastIndex != Index)
+			{
+				vIndices.push_back(Index);
+				LastIndex = Index;
+			}
+		}
+		return vIndices;
+	}
+
+	std::vector<int> MapIndices(vec2 PrevPos, vec2 Pos) const
+	{
+		std::vector<int> vIndices;
+		int Num = m_Collision.VisitMapIndices(PrevPos, Pos, [&](int Index) {
+			vIndices.push_back(Index);
+			return true;
+		});
+		EXPECT_EQ(Num, (int)vIndices.size());
+		return vIndices;
+	}
+
+	vec2 RandomPos() const
+	{
+		// also outside of the map
+		return vec2(secure_rand_below(m_Collision.GetWidth() * 32 + 200) - 100 + secure_rand_below(1000) / 1000.0f,
+			secure_rand_below(m_Collision.GetHeight() * 32 + 200) - 100 + secure_rand_below(1000) / 1000.0f);
+	}
+
+	vec2 RandomSegmentEnd(vec2 Pos) const
+	{
+		switch(secure_rand_below(4))
+		{
+		case 0: return Pos;
+		case 1: return Pos + vec2(secure_rand_below(81) - 40, secure_rand_below(81) - 40) / 2.0f;
+		case 2: return Pos + vec2(secure_rand_below(401) - 200, secure_rand_below(401) - 200);
+		default: return RandomPos();
+		}
+	}
+
+	void CompareIntersect(int Num)
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			vec2 Pos0 = RandomPos();
+			// lasers are longer than hooks
+			vec2 Pos1 = Pos0 + direction(secure_rand_below(36000) / 18000.0f * pi) * (secure_rand_below(8000) / 10.0f);
+			vec2 aOut[2], aRefOut[2];
+			int TeleNr, RefTeleNr;
+			ASSERT_EQ(m_Collision.IntersectLine(Pos0, Pos1, &aOut[0], &aOut[1]), RefIntersectLine(m_Collision, Pos0, Pos1, &aRefOut[0], &aRefOut[1]));
+			ASSERT_TRUE(aOut[0] == aRefOut[0] && aOut[1] == aRefOut[1]);
+			ASSERT_EQ(m_Collision.IntersectLineTeleHook(Pos0, Pos1, &aOut[0], &aOut[1], &TeleNr), RefIntersectLineTeleHook(m_Collision, Pos0, Pos1, &aRefOut[0], &aRefOut[1], &RefTeleNr));
+			ASSERT_TRUE(aOut[0] == aRefOut[0] && aOut[1] == aRefOut[1]);
+			ASSERT_EQ(TeleNr, RefTeleNr);
+			ASSERT_EQ(m_Collision.IntersectLineTeleWeapon(Pos0, Pos1, &aOut[0], &aOut[1], &TeleNr), RefIntersectLineTeleWeapon(m_Collision, Pos0, Pos1, &aRefOut[0], &aRefOut[1], &RefTeleNr));
+			ASSERT_TRUE(aOut[0] == aRefOut[0] && aOut[1] == aRefOut[1]);
+			ASSERT_EQ(TeleNr, RefTeleNr);
+			ASSERT_EQ(m_Collision.IntersectNoLaser(Pos0, Pos1, &aOut[0], &aOut[1]), RefIntersectNoLaser(m_Collision, Pos0, Pos1, &aRefOut[0], &aRefOut[1]));
+			ASSERT_TRUE(aOut[0] == aRefOut[0] && aOut[1] == aRefOut[1]);
+			ASSERT_EQ(m_Collision.IntersectNoLaserNW(Pos0, Pos1, &aOut[0], &aOut[1]), RefIntersectNoLaserNW(m_Collision, Pos0, Pos1, &aRefOut[0], &aRefOut[1]));
+			ASSERT_TRUE(aOut[0] == aRefOut[0] && aOut[1] == aRefOut[1]);
+		}
+	}
+
+	void CompareMoveBox(int Num)
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			vec2 Pos = RandomPos();
+			vec2 Vel = direction(secure_rand_below(36000) / 18000.0f * pi) * (secure_rand_below(secure_rand_below(2) ? 300 : 3000) / 10.0f);
+			float Elasticity = secure_rand_below(2) ? 0.0f : 0.5f;
+			vec2 RefPos = Pos, RefVel = Vel;
+			m_Collision.MoveBox(&Pos, &Vel, vec2(28.0f, 28.0f), Elasticity);
+			RefMoveBox(m_Collision, &RefPos, &RefVel, vec2(28.0f, 28.0f), Elasticity);
+			ASSERT_TRUE(Pos == RefPos && Vel == RefVel);
+		}
+	}
+
+	void CompareMapIndices(int Num)
+	{
+		for(int i = 0; i < Num; i++)
+		{
+			vec2 Pos0 = RandomPos();
+			vec2 Pos1 = RandomSegmentEnd(Pos0);
+			ASSERT_EQ(MapIndices(Pos0, Pos1), ReferenceMapIndices(Pos0, Pos1)) << Pos0.x << " " << Pos0.y << " " << Pos1.x << " " << Pos1.y;
+		}
+	}
+};
+
+TEST_F(Collision, MapIndices)
+{
+	Load("Tutorial.map");
+	int NumSpecial = 0;
+	for(int i = 0; i < m_Collision.GetWidth() * m_Collision.GetHeight(); i++)
+	{
+		EXPECT_EQ(m_Collision.SpecialTileAt(i), m_Collision.TileExists(i));
+		NumSpecial += m_Collision.SpecialTileAt(i);
+	}
+	EXPECT_GT(NumSpecial, 0);
+	CompareMapIndices(5000);
+}
+
+TEST_F(Collision, MapIndicesAfterChanges)
+{
+	Load("Tutorial.map");
+	for(int Step = 0; Step < 50; Step++)
+	{
+		// lasers of the old DDRace mods change the game layer, doors the
+		// door layer
+		vec2 Pos = RandomPos();
+		if(secure_rand_below(2))
+			m_Collision.SetCollisionAt(Pos.x, Pos.y, secure_rand_below(2) ? TILE_FREEZE : TILE_STOPA);
+		else
+			m_Collision.SetDCollisionAt(Pos.x, Pos.y, secure_rand_below(2) ? TILE_STOPA : 0, 0, 0);
+		CompareMapIndices(100);
+	}
+	for(int i = 0; i < m_Collision.GetWidth() * m_Collision.GetHeight(); i++)
+	{
+		ASSERT_EQ(m_Collision.SpecialTileAt(i), m_Collision.TileExists(i));
+	}
+}
+
+TEST_F(Collision, MapIndicesMaxIndices)
+{
+	Load("Tutorial.map");
+	for(int i = 0; i < 500; i++)
+	{
+		vec2 Pos0 = RandomPos();
+		vec2 Pos1 = RandomPos();
+		std::vector<int> vExpected = ReferenceMapIndices(Pos0, Pos1);
+		// like the list version, one more than `MaxIndices`
+		if(vExpected.size() > 3)
+			vExpected.resize(3);
+		std::vector<int> vIndices;
+		m_Collision.VisitMapIndices(
+			Pos0, Pos1, [&](int Index) {
+				vIndices.push_back(Index);
+				return true;
+			},
+			2);
+		ASSERT_EQ(vIndices, vExpected);
+	}
+}
+
+TEST_F(Collision, Intersect)
+{
+	Load("Tutorial.map");
+	CompareIntersect(2000);
+	g_Config.m_SvOldTeleportHook = 1;
+	g_Config.m_SvOldTeleportWeapons = 1;
+	CompareIntersect(2000);
+	g_Config.m_SvOldTeleportHook = 0;
+	g_Config.m_SvOldTeleportWeapons = 0;
+}
+
+TEST_F(Collision, IntersectAfterChanges)
+{
+	Load("Tutorial.map");
+	for(int Step = 0; Step < 50; Step++)
+	{
+		vec2 Pos = RandomPos();
+		m_Collision.SetCollisionAt(Pos.x, Pos.y, secure_rand_below(3) ? TILE_SOLID : TILE_AIR);
+		CompareIntersect(40);
+		CompareMoveBox(200);
+	}
+}
+
+TEST_F(Collision, MoveBox)
+{
+	Load("Tutorial.map");
+	CompareMoveBox(20000);
+}
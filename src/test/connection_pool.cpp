@@ -0,0 +1,327 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/server/databases/connection.h>
+#include <engine/server/databases/connection_pool.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+struct CCountResult : ISqlResult
+{
+	int m_Count = 0;
+};
+
+struct CValueData : ISqlData
+{
+	CValueData(std::shared_ptr<ISqlResult> pResult) :
+		ISqlData(std::move(pResult))
+	{
+	}
+	int m_Value = 0;
+};
+
+struct CBlockData : ISqlData
+{
+	CBlockData(std::shared_ptr<ISqlResult> pResult, std::atomic_bool *pRelease) :
+		ISqlData(std::move(pResult)), m_pRelease(pRelease)
+	{
+	}
+	std::atomic_bool *m_pRelease;
+};
+
+static std::atomic_int s_NumConcurrentReads{0};
+static std::atomic_int s_MaxConcurrentReads{0};
+
+static bool CreateTable(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	int NumUpdated;
+	return pSqlServer->PrepareStatement("CREATE TABLE IF NOT EXISTS pool_values (Value INTEGER NOT NULL)", pError, ErrorSize) ||
+	       pSqlServer->ExecuteUpdate(&NumUpdated, pError, ErrorSize);
+}
+
+static bool Block(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CBlockData *>(pGameData);
+	while(!pData->m_pRelease->load())
+	{
+		std::this_thread::sleep_for(1ms);
+	}
+	return false;
+}
+
+static bool InsertValue(IDbConnection *pSqlServer, const ISqlData *pGameData, Write w, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CValueData *>(pGameData);
+	if(pData->m_Value < 0)
+	{
+		str_copy(pError, "negative value", ErrorSize);
+		return true;
+	}
+	if(pSqlServer->PrepareStatement("INSERT INTO pool_values (Value) VALUES (?)", pError, ErrorSize))
+	{
+		return true;
+	}
+	pSqlServer->BindInt(1, pData->m_Value);
+	int NumInserted;
+	return pSqlServer->ExecuteUpdate(&NumInserted, pError, ErrorSize);
+}
+
+static bool CountValues(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	int NumReads = ++s_NumConcurrentReads;
+	int Max = s_MaxConcurrentReads.load();
+	while(NumReads > Max && !s_MaxConcurrentReads.compare_exchange_weak(Max, NumReads))
+	{
+	}
+	// give the other read workers a chance to pick up queries
+	std::this_thread::sleep_for(20ms);
+	s_NumConcurrentReads--;
+
+	auto *pResult = dynamic_cast<CCountResult *>(pGameData->m_pResult.get());
+	if(pSqlServer->PrepareStatement("SELECT COUNT(*) FROM pool_values", pError, ErrorSize))
+	{
+		return true;
+	}
+	bool End;
+	if(pSqlServer->Step(&End, pError, ErrorSize) || End)
+	{
+		return true;
+	}
+	pResult->m_Count = pSqlServer->GetInt(1);
+	return false;
+}
+
+class ConnectionPool : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	CDbConnectionPool m_Pool;
+	bool m_ShutDown = false;
+
+	ConnectionPool()
+	{
+		m_Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, m_Info.m_aFilename);
+		m_Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, m_Info.m_aFilename);
+		auto pResult = std::make_shared<ISqlResult>();
+		m_Pool.ExecuteWrite(CreateTable, std::make_unique<CValueData>(pResult), "create table");
+		Wait(pResult.get());
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	~ConnectionPool()
+	{
+		Shutdown();
+		char aBuf[IO_MAX_PATH_LENGTH];
+		fs_remove(m_Info.m_aFilename);
+		str_format(aBuf, sizeof(aBuf), "%s-wal", m_Info.m_aFilename);
+		fs_remove(aBuf);
+		str_format(aBuf, sizeof(aBuf), "%s-shm", m_Info.m_aFilename);
+		fs_remove(aBuf);
+	}
+
+	void Shutdown()
+	{
+		if(!m_ShutDown)
+		{
+			m_Pool.OnShutdown();
+			m_ShutDown = true;
+		}
+	}
+
+	static void Wait(ISqlResult *pResult)
+	{
+		for(int i = 0; i < 10000 && !pResult->m_Completed.load(); i++)
+		{
+			std::this_thread::sleep_for(1ms);
+		}
+		ASSERT_TRUE(pResult->m_Completed.load());
+	}
+};
+
+TEST_F(ConnectionPool, BatchedWrites)
+{
+	// Hold the write worker back, so that the inserts queue up.
+	std::atomic_bool Release{false};
+	auto pBlockResult = std::make_shared<ISqlResult>();
+	m_Pool.ExecuteWrite(Block, std::make_unique<CBlockData>(pBlockResult, &Release), "block");
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 100; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		auto pData = std::make_unique<CValueData>(vpResults.back());
+		pData->m_Value = i;
+		m_Pool.ExecuteBatchableWrite(InsertValue, std::move(pData), "insert value");
+	}
+	CDbConnectionPool::CStats Stats;
+	m_Pool.GetStats(&Stats);
+	EXPECT_GE(Stats.m_WriteQueueDepth, 100);
+	std::this_thread::sleep_for(50ms);
+	Release.store(true);
+
+	Wait(pBlockResult.get());
+	for(auto &pResult : vpResults)
+	{
+		Wait(pResult.get());
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	m_Pool.GetStats(&Stats);
+	EXPECT_EQ(Stats.m_WriteQueueDepth, 0);
+	EXPECT_EQ(Stats.m_NumWrites, 102);
+	EXPECT_GE(Stats.m_NumWriteBatches, 100 / CDbConnectionPool::MAX_WRITE_BATCH);
+	EXPECT_LE(Stats.m_NumBatchedWrites, 100);
+
+	auto pCount = std::make_shared<CCountResult>();
+	m_Pool.Execute(CountValues, std::make_unique<CValueData>(pCount), "count values");
+	Wait(pCount.get());
+	EXPECT_TRUE(pCount->m_Success);
+	EXPECT_EQ(pCount->m_Count, 100);
+}
+
+TEST_F(ConnectionPool, FailedBatchedWrite)
+{
+	std::atomic_bool Release{false};
+	auto pBlockResult = std::make_shared<ISqlResult>();
+	m_Pool.ExecuteWrite(Block, std::make_unique<CBlockData>(pBlockResult, &Release), "block");
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 10; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		auto pData = std::make_unique<CValueData>(vpResults.back());
+		pData->m_Value = i == 5 ? -1 : i;
+		m_Pool.ExecuteBatchableWrite(InsertValue, std::move(pData), "insert value");
+	}
+	std::this_thread::sleep_for(50ms);
+	Release.store(true);
+
+	// The batch is rolled back and the writes are executed one by one,
+	// only the failing one fails.
+	Wait(pBlockResult.get());
+	for(int i = 0; i < 10; i++)
+	{
+		Wait(vpResults[i].get());
+		EXPECT_EQ(vpResults[i]->m_Success, i != 5);
+	}
+
+	CDbConnectionPool::CStats Stats;
+	m_Pool.GetStats(&Stats);
+	EXPECT_EQ(Stats.m_NumWriteBatches, 0);
+
+	auto pCount = std::make_shared<CCountResult>();
+	m_Pool.Execute(CountValues, std::make_unique<CValueData>(pCount), "count values");
+	Wait(pCount.get());
+	EXPECT_TRUE(pCount->m_Success);
+	EXPECT_EQ(pCount->m_Count, 9);
+}
+
+TEST_F(ConnectionPool, WritesNotBatchedByDefault)
+{
+	std::atomic_bool Release{false};
+	auto pBlockResult = std::make_shared<ISqlResult>();
+	m_Pool.ExecuteWrite(Block, std::make_unique<CBlockData>(pBlockResult, &Release), "block");
+	std::vector<std::shared_ptr<ISqlResult>> vpResults;
+	for(int i = 0; i < 10; i++)
+	{
+		vpResults.push_back(std::make_shared<ISqlResult>());
+		auto pData = std::make_unique<CValueData>(vpResults.back());
+		pData->m_Value = i;
+		m_Pool.ExecuteWrite(InsertValue, std::move(pData), "insert value");
+	}
+	std::this_thread::sleep_for(50ms);
+	Release.store(true);
+
+	Wait(pBlockResult.get());
+	for(auto &pResult : vpResults)
+	{
+		Wait(pResult.get());
+		EXPECT_TRUE(pResult->m_Success);
+	}
+
+	CDbConnectionPool::CStats Stats;
+	m_Pool.GetStats(&Stats);
+	EXPECT_EQ(Stats.m_NumWriteBatches, 0);
+	EXPECT_EQ(Stats.m_NumBatchedWrites, 0);
+}
+
+TEST_F(ConnectionPool, ConcurrentReads)
+{
+	s_NumConcurrentReads = 0;
+	s_MaxConcurrentReads = 0;
+	std::vector<std::shared_ptr<CCountResult>> vpResults;
+	for(int i = 0; i < 2 * CDbConnectionPool::DEFAULT_READ_WORKERS; i++)
+	{
+		vpResults.push_back(std::make_shared<CCountResult>());
+		m_Pool.Execute(CountValues, std::make_unique<CValueData>(vpResults.back()), "count values");
+	}
+	for(auto &pResult : vpResults)
+	{
+		Wait(pResult.get());
+		EXPECT_TRUE(pResult->m_Success);
+		EXPECT_EQ(pResult->m_Count, 0);
+	}
+	EXPECT_GT(s_MaxConcurrentReads.load(), 1);
+
+	CDbConnectionPool::CStats Stats;
+	m_Pool.GetStats(&Stats);
+	EXPECT_EQ(Stats.m_ReadQueueDepth, 0);
+	EXPECT_EQ(Stats.m_NumReads, 2 * CDbConnectionPool::DEFAULT_READ_WORKERS);
+	EXPECT_LE(Stats.m_aReadLatency[CDbConnectionPool::PERCENTILE_50], Stats.m_aReadLatency[CDbConnectionPool::PERCENTILE_MAX]);
+	EXPECT_GT(Stats.m_aReadLatency[CDbConnectionPool::PERCENTILE_MAX], 0.0f);
+}
+
+TEST_F(ConnectionPool, ShutdownDismissesReads)
+{
+	std::vector<std::shared_ptr<CCountResult>> vpResults;
+	for(int i = 0; i < 50; i++)
+	{
+		vpResults.push_back(std::make_shared<CCountResult>());
+		m_Pool.Execute(CountValues, std::make_unique<CValueData>(vpResults.back()), "count values");
+	}
+	Shutdown();
+	int NumDismissed = 0;
+	for(auto &pResult : vpResults)
+	{
+		ASSERT_TRUE(pResult->m_Completed.load());
+		NumDismissed += !pResult->m_Success;
+	}
+	EXPECT_GT(NumDismissed, 0);
+}
+
+TEST_F(ConnectionPool, ReadAfterWriteOfSamePlayer)
+{
+	// Hold the write worker back, so that the insert of the player is
+	// still queued when its read is.
+	std::atomic_bool Release{false};
+	auto pBlockResult = std::make_shared<ISqlResult>();
+	m_Pool.ExecuteWrite(Block, std::make_unique<CBlockData>(pBlockResult, &Release), "block");
+	auto pInsertResult = std::make_shared<ISqlResult>();
+	auto pData = std::make_unique<CValueData>(pInsertResult);
+	pData->m_Value = 1;
+	m_Pool.ExecuteWrite(InsertValue, std::move(pData), "insert value", {"nameless tee"});
+
+	auto pCount = std::make_shared<CCountResult>();
+	m_Pool.Execute(CountValues, std::make_unique<CValueData>(pCount), "count values", {"nameless tee"});
+	// reads of other players don't wait
+	auto pOtherCount = std::make_shared<CCountResult>();
+	m_Pool.Execute(CountValues, std::make_unique<CValueData>(pOtherCount), "count values", {"brainless tee"});
+	Wait(pOtherCount.get());
+	EXPECT_TRUE(pOtherCount->m_Success);
+	EXPECT_EQ(pOtherCount->m_Count, 0);
+	EXPECT_FALSE(pCount->m_Completed.load());
+
+	Release.store(true);
+	Wait(pCount.get());
+	EXPECT_TRUE(pInsertResult->m_Completed.load());
+	EXPECT_TRUE(pCount->m_Success);
+	EXPECT_EQ(pCount->m_Count, 1);
+
+	// the write is done, later reads don't wait
+	auto pLaterCount = std::make_shared<CCountResult>();
+	m_Pool.Execute(CountValues, std::make_unique<CValueData>(pLaterCount), "count values", {"nameless tee"});
+	Wait(pLaterCount.get());
+	EXPECT_EQ(pLaterCount->m_Count, 1);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Console : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IConsole> m_pConsole = CreateConsole(CFGFLAG_SERVER);
+	std::vector<std::string> m_vCalls;
+
+	static void ConRecord(IConsole::IResult *pResult, void *pUserData)
+	{
+		Console *pSelf = static_cast<Console *>(pUserData);
+		std::string Call;
+		for(int i = 0; i < pResult->NumArguments(); i++)
+		{
+			if(i)
+				Call += ',';
+			Call += pResult->GetString(i);
+		}
+		pSelf->m_vCalls.push_back(Call);
+	}
+};
+
+TEST_F(Console, Lookup)
+{
+	m_pConsole->Register("test_cmd", "s[name] ?i[number] ?r[rest]", CFGFLAG_SERVER, ConRecord, this, "");
+	m_pConsole->Register("test_client", "", CFGFLAG_CLIENT, ConRecord, this, "");
+
+	m_pConsole->ExecuteLine("test_cmd a");
+	m_pConsole->ExecuteLine("TEST_Cmd \"b c\" 5 the rest");
+	m_pConsole->ExecuteLine("test_cm a");
+	m_pConsole->ExecuteLine("test_client");
+	EXPECT_EQ(m_vCalls, (std::vector<std::string>{"a", "b c,5,the rest"}));
+
+	EXPECT_TRUE(m_pConsole->LineIsValid("Test_Cmd x"));
+	EXPECT_FALSE(m_pConsole->LineIsValid("test_cmd"));
+	EXPECT_FALSE(m_pConsole->LineIsValid("test_client"));
+	ASSERT_TRUE(m_pConsole->GetCommandInfo("TEST_CMD", CFGFLAG_SERVER, false));
+	EXPECT_STREQ(m_pConsole->GetCommandInfo("TEST_CMD", CFGFLAG_SERVER, false)->m_pParams, "s[name] ?i[number] ?r[rest]");
+	EXPECT_FALSE(m_pConsole->GetCommandInfo("test_client", CFGFLAG_SERVER, false));
+}
+
+TEST_F(Console, TempCommands)
+{
+	for(int i = 0; i < 100; i++)
+	{
+		char aName[32];
+		str_format(aName, sizeof(aName), "temp%d", i);
+		m_pConsole->RegisterTemp(aName, "i[a] s[b]", CFGFLAG_SERVER, "");
+	}
+	EXPECT_TRUE(m_pConsole->GetCommandInfo("temp42", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(m_pConsole->GetCommandInfo("temp42", CFGFLAG_SERVER, false));
+
+	m_pConsole->DeregisterTemp("temp42");
+	EXPECT_FALSE(m_pConsole->GetCommandInfo("temp42", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(m_pConsole->GetCommandInfo("temp41", CFGFLAG_SERVER, true));
+
+	// reuses the removed command
+	m_pConsole->RegisterTemp("temp_new", "r[rest]", CFGFLAG_SERVER, "");
+	ASSERT_TRUE(m_pConsole->GetCommandInfo("temp_new", CFGFLAG_SERVER, true));
+	EXPECT_STREQ(m_pConsole->GetCommandInfo("temp_new", CFGFLAG_SERVER, true)->m_pParams, "r[rest]");
+
+	m_pConsole->DeregisterTempAll();
+	EXPECT_FALSE(m_pConsole->GetCommandInfo("temp0", CFGFLAG_SERVER, true));
+	EXPECT_FALSE(m_pConsole->GetCommandInfo("temp_new", CFGFLAG_SERVER, true));
+	EXPECT_TRUE(m_pConsole->GetCommandInfo("echo", CFGFLAG_SERVER, false));
+}
@@ -0,0 +1,211 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static const char *const TEST_NET_VERSION = "0.6 test";
+
+class CDemoCollector : public CDemoPlayer::IListener
+{
+public:
+	struct CEntry
+	{
+		int m_Tick;
+		bool m_Snapshot;
+		std::vector<char> m_vData;
+
+		bool operator==(const CEntry &Other) const
+		{
+			return m_Tick == Other.m_Tick && m_Snapshot == Other.m_Snapshot && m_vData == Other.m_vData;
+		}
+	};
+
+	CDemoPlayer *m_pPlayer = nullptr;
+	std::vector<CEntry> m_vEntries;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		m_vEntries.push_back({m_pPlayer->Info()->m_Info.m_CurrentTick, true, std::vector<char>((char *)pData, (char *)pData + Size)});
+	}
+	void OnDemoPlayerMessage(void *pData, int Size) override
+	{
+		m_vEntries.push_back({m_pPlayer->Info()->m_Info.m_CurrentTick, false, std::vector<char>((char *)pData, (char *)pData + Size)});
+	}
+};
+
+class Demo : public ::testing::Test
+{
+protected:
+	CTestInfo m_Info;
+	std::unique_ptr<IStorage> m_pStorage;
+	CSnapshotDelta m_SnapshotDelta;
+
+	Demo() :
+		m_pStorage(m_Info.CreateTestStorage())
+	{
+		m_Info.m_DeleteTestStorageFilesOnSuccess = true;
+		// demo chunks are huffman compressed
+		CNetBase::Init();
+	}
+
+	// 30 seconds with moving items, ticks without changes, skipped ticks
+	// and messages
+	void Record(const char *pFilename)
+	{
+		CDemoRecorder Recorder(&m_SnapshotDelta);
+		unsigned char aMap[16] = {1, 2, 3, 4};
+		SHA256_DIGEST Sha256 = SHA256_ZEROED;
+		ASSERT_EQ(Recorder.Start(m_pStorage.get(), nullptr, pFilename, TEST_NET_VERSION, "testmap", &Sha256, 0, "client", sizeof(aMap), aMap), 0);
+		Record(&Recorder);
+		Recorder.Stop();
+	}
+
+	static void Record(CDemoRecorder *pRecorder)
+	{
+		CSnapshotBuilder Builder;
+		static char s_aSnapshot[CSnapshot::MAX_SIZE];
+		for(int Tick = 100; Tick < 1600; Tick++)
+		{
+			if(Tick % 13 == 0)
+				continue;
+
+			Builder.Init();
+			int NumItems = 5 + (Tick / 40) % 4;
+			for(int i = 0; i < NumItems; i++)
+			{
+				int *pItem = (int *)Builder.NewItem(1, i, 4 * sizeof(int));
+				pItem[0] = i;
+				pItem[1] = Tick / 2 * (i + 1);
+				pItem[2] = i % 2 ? Tick / 10 : 0;
+				pItem[3] = -i;
+			}
+			int Size = Builder.Finish(s_aSnapshot);
+			pRecorder->RecordSnapshot(Tick, s_aSnapshot, Size);
+
+			if(Tick % 3 == 0)
+			{
+				int aMessage[3] = {Tick, Tick % 2, 12345};
+				pRecorder->RecordMessage(aMessage, sizeof(aMessage));
+			}
+			if(Tick == 800 || Tick == 1500)
+				pRecorder->AddDemoMarker(Tick);
+		}
+	}
+
+	std::vector<CDemoCollector::CEntry> Play(const char *pFilename, CDemoPlayer::CPlaybackInfo *pInfo = nullptr)
+	{
+		CDemoPlayer Player(&m_SnapshotDelta);
+		CDemoCollector Collector;
+		Collector.m_pPlayer = &Player;
+		Player.SetListener(&Collector);
+		EXPECT_EQ(Player.Load(m_pStorage.get(), nullptr, pFilename, IStorage::TYPE_ALL), 0);
+		if(pInfo)
+			*pInfo = *Player.Info();
+		Player.Play();
+		while(Player.IsPlaying() && !Player.Info()->m_Info.m_Paused)
+			Player.Update(false);
+		Player.Stop();
+		return Collector.m_vEntries;
+	}
+
+	static std::vector<CDemoCollector::CEntry> Range(const std::vector<CDemoCollector::CEntry> &vEntries, int StartTick, int EndTick, bool DropOdd = false)
+	{
+		std::vector<CDemoCollector::CEntry> vResult;
+		for(const auto &Entry : vEntries)
+		{
+			if(Entry.m_Tick < StartTick || Entry.m_Tick > EndTick)
+				continue;
+			if(DropOdd && !Entry.m_Snapshot && ((int *)Entry.m_vData.data())[1])
+				continue;
+			vResult.push_back(Entry);
+		}
+		return vResult;
+	}
+};
+
+TEST_F(Demo, SlicePlaysBackIdentically)
+{
+	Record("original.demo");
+	std::vector<CDemoCollector::CEntry> vOriginal = Play("original.demo");
+	ASSERT_FALSE(vOriginal.empty());
+
+	CDemoEditor Editor;
+	Editor.Init(TEST_NET_VERSION, &m_SnapshotDelta, nullptr, m_pStorage.get());
+
+	// starting on a key frame, between key frames, on a skipped tick and
+	// the whole demo
+	const int aaSlices[][2] = {{100, 1599}, {700, 1200}, {701, 703}, {1000, 1000}, {1209, 1350}, {-1, -1}};
+	for(const auto &aSlice : aaSlices)
+	{
+		Editor.Slice("original.demo", "sliced.demo", aSlice[0], aSlice[1], nullptr, nullptr);
+		CDemoPlayer::CPlaybackInfo Info;
+		std::vector<CDemoCollector::CEntry> vSliced = Play("sliced.demo", &Info);
+		int StartTick = aSlice[0] == -1 ? 0 : aSlice[0];
+		int EndTick = aSlice[1] == -1 ? 1 << 30 : aSlice[1];
+		EXPECT_TRUE(vSliced == Range(vOriginal, StartTick, EndTick)) << aSlice[0] << "-" << aSlice[1];
+		EXPECT_GE(Info.m_Info.m_FirstTick, StartTick);
+		EXPECT_LE(Info.m_Info.m_LastTick, EndTick);
+		EXPECT_EQ(Info.m_Info.m_NumTimelineMarkers, (StartTick <= 800 && EndTick >= 800) + (StartTick <= 1500 && EndTick >= 1500));
+		EXPECT_TRUE(m_pStorage->RemoveFile("sliced.demo", IStorage::TYPE_SAVE));
+	}
+	EXPECT_TRUE(m_pStorage->RemoveFile("original.demo", IStorage::TYPE_SAVE));
+}
+
+TEST_F(Demo, SliceFilter)
+{
+	Record("original.demo");
+	std::vector<CDemoCollector::CEntry> vOriginal = Play("original.demo");
+
+	CDemoEditor Editor;
+	Editor.Init(TEST_NET_VERSION, &m_SnapshotDelta, nullptr, m_pStorage.get());
+	auto DropOdd = [](const void *pData, int Size, void *pUser) {
+		(*(int *)pUser)++;
+		return Size >= 2 * (int)sizeof(int) && ((const int *)pData)[1] != 0;
+	};
+	int NumFiltered = 0;
+	Editor.Slice("original.demo", "sliced.demo", 500, 900, DropOdd, &NumFiltered);
+	EXPECT_GT(NumFiltered, 0);
+	EXPECT_TRUE(Play("sliced.demo") == Range(vOriginal, 500, 900, true));
+	EXPECT_TRUE(m_pStorage->RemoveFile("sliced.demo", IStorage::TYPE_SAVE));
+	EXPECT_TRUE(m_pStorage->RemoveFile("original.demo", IStorage::TYPE_SAVE));
+}
+
+TEST_F(Demo, MemoryRecording)
+{
+	Record("original.demo");
+	CDemoPlayer::CPlaybackInfo OriginalInfo;
+	std::vector<CDemoCollector::CEntry> vOriginal = Play("original.demo", &OriginalInfo);
+
+	CDemoRecorder Recorder(&m_SnapshotDelta);
+	SHA256_DIGEST Sha256 = SHA256_ZEROED;
+	ASSERT_EQ(Recorder.StartMemory(nullptr, TEST_NET_VERSION, "testmap", Sha256, 0, "client", 10), 0);
+	Record(&Recorder);
+	EXPECT_TRUE(Recorder.IsRecording());
+	// whole key frame intervals are kept
+	EXPECT_GE(Recorder.Length(), 10);
+	EXPECT_LE(Recorder.Length(), 16);
+
+	for(int Seconds : {3, 10, 60})
+	{
+		ASSERT_EQ(Recorder.SaveMemory(m_pStorage.get(), "replay.demo", Seconds, nullptr), 0);
+		CDemoPlayer::CPlaybackInfo Info;
+		std::vector<CDemoCollector::CEntry> vReplay = Play("replay.demo", &Info);
+		int FirstTick = Info.m_Info.m_FirstTick;
+		EXPECT_LE(FirstTick, 1599 - std::min(Seconds, 10) * SERVER_TICK_SPEED) << Seconds;
+		EXPECT_EQ(Info.m_Info.m_LastTick, OriginalInfo.m_Info.m_LastTick);
+		EXPECT_TRUE(vReplay == Range(vOriginal, FirstTick, 1599)) << Seconds;
+		EXPECT_EQ(Info.m_Info.m_NumTimelineMarkers, FirstTick <= 1500);
+		EXPECT_TRUE(m_pStorage->RemoveFile("replay.demo", IStorage::TYPE_SAVE));
+	}
+	Recorder.Stop();
+	EXPECT_FALSE(Recorder.IsRecording());
+	EXPECT_TRUE(m_pStorage->RemoveFile("original.demo", IStorage::TYPE_SAVE));
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <base/hash.h>
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/storage.h>
+#include <game/collision.h>
+#include <game/gamecore.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/teamscore.h>
+
+#include <memory>
+#include <vector>
+
+// Steps a crowd of players around the spawn of a map with pseudo-random
+// inputs, like the server does, and checks that the outcome didn't change.
+// The checksum was recorded before the player-player checks were
+// optimized. Velocity ramping is turned off and the angles aren't compared
+// because they depend on the platform's `pow` and `atan2f`.
+TEST(GameCore, CrowdChecksum)
+{
+	std::unique_ptr<IKernel> pKernel(IKernel::Create());
+	IStorage *pStorage = CreateTempStorage("data/maps");
+	IEngineMap *pMap = CreateEngineMap();
+	pKernel->RegisterInterface(pStorage);
+	pKernel->RegisterInterface(pMap);
+	pKernel->RegisterInterface(static_cast<IMap *>(pMap), false);
+	ASSERT_TRUE(pMap->Load("Tutorial.map"));
+	CLayers Layers;
+	Layers.Init(pKernel.get());
+	CCollision Collision;
+	Collision.Init(&Layers);
+
+	vec2 Spawn;
+	bool FoundSpawn = false;
+	for(int i = 0; i < Collision.GetWidth() * Collision.GetHeight() && !FoundSpawn; i++)
+	{
+		if(Collision.GetTileIndex(i) == ENTITY_OFFSET + ENTITY_SPAWN)
+		{
+			Spawn = Collision.GetPos(i);
+			FoundSpawn = true;
+		}
+	}
+	ASSERT_TRUE(FoundSpawn);
+
+	CWorldCore World;
+	World.InitSwitchers(Collision.m_HighestSwitchNumber);
+	CTeamsCore Teams;
+	std::vector<CCharacterCore> vCores(MAX_CLIENTS);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		// a few players in another team and a few solo ones
+		Teams.Team(i, i % 4 == 3 ? 1 : 0);
+		Teams.SetSolo(i, i % 16 == 5);
+		CCharacterCore &Core = vCores[i];
+		Core.Init(&World, &Collision, &Teams);
+		Core.m_Id = i;
+		Core.m_Solo = i % 16 == 5;
+		Core.m_Tuning.m_VelrampStart = 100000.0f;
+		Core.m_Pos = Spawn + vec2(i % 8 - 4, i / 8 - 4) * 8.0f;
+		Core.Quantize();
+		World.m_apCharacters[i] = &Core;
+	}
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x1234567890abcdefull, 0xfedcba0987654321ull};
+	Prng.Seed(aSeed);
+	std::vector<CNetObj_CharacterCore> vStates;
+	int NumGrabbed = 0;
+	for(int Tick = 0; Tick < 1000; Tick++)
+	{
+		for(auto &Core : vCores)
+		{
+			if(Prng.RandomBits() % 8 == 0)
+			{
+				Core.m_Input.m_Direction = (int)(Prng.RandomBits() % 3) - 1;
+				Core.m_Input.m_Jump = Prng.RandomBits() % 4 == 0;
+				Core.m_Input.m_Hook = Prng.RandomBits() % 2;
+				Core.m_Input.m_TargetX = (int)(Prng.RandomBits() % 401) - 200;
+				Core.m_Input.m_TargetY = (int)(Prng.RandomBits() % 401) - 200;
+			}
+			Core.Tick(true);
+		}
+		for(auto &Core : vCores)
+		{
+			Core.Move();
+			Core.Quantize();
+			CNetObj_CharacterCore State;
+			Core.Write(&State);
+			State.m_Tick = Tick;
+			State.m_Angle = 0;
+			vStates.push_back(State);
+			NumGrabbed += Core.m_HookedPlayer != -1;
+		}
+	}
+	// make sure the players actually interacted
+	EXPECT_GT(NumGrabbed, 1000);
+
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(sha256(vStates.data(), vStates.size() * sizeof(vStates[0])), aSha256, sizeof(aSha256));
+	EXPECT_STREQ(aSha256, "16e2214e52c2cf9e82258d9b59100bbe849336639f2c73e4949af073f0afd9f7");
+}
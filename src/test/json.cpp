@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <base/system.h>
 #include <engine/shared/json.h>
 
+#include <string>
+#include <vector>
+
 TEST(Json, Escape)
 {
 	char aBuf[128];
@@ -20,3 +24,113 @@ TEST(Json, Escape)
 	EXPECT_STREQ(EscapeJson(aSix, sizeof(aSix), "\x01"), "");
 	EXPECT_STREQ(EscapeJson(aSix, sizeof(aSix), "aaaaaa"), "aaaaa");
 }
+
+class CTestJsonStream : public CJsonStreamParser
+{
+public:
+	std::vector<std::string> m_vMembers;
+	std::vector<std::string> m_vElements;
+	int m_NumIntegers = 0;
+
+protected:
+	bool OnMember(const char *pKey, bool IsArray) override
+	{
+		m_vMembers.push_back(std::string(pKey) + (IsArray ? "[]" : ""));
+		return false;
+	}
+	bool OnArrayElement(const char *pKey, const json_value *pValue) override
+	{
+		std::string Element = pKey;
+		Element += ":";
+		switch(pValue->type)
+		{
+		case json_object: Element += "object"; break;
+		case json_array: Element += "array"; break;
+		case json_integer:
+			Element += std::to_string(pValue->u.integer);
+			m_NumIntegers++;
+			break;
+		case json_string: Element += pValue->u.string.ptr; break;
+		case json_boolean: Element += pValue->u.boolean ? "true" : "false"; break;
+		case json_null: Element += "null"; break;
+		default: Element += "other";
+		}
+		m_vElements.push_back(Element);
+		return false;
+	}
+};
+
+static const char STREAM_DOCUMENT[] = R"({"servers": [{"a": [1, "]"]}, 12, "x\"]", true, null, []], "skip": {"b": "}"}, "n": 3,"servers_legacy":[]})";
+
+TEST(Json, Stream)
+{
+	CTestJsonStream Parser;
+	EXPECT_FALSE(Parser.Feed(STREAM_DOCUMENT, str_length(STREAM_DOCUMENT)));
+	EXPECT_FALSE(Parser.Finish());
+	std::vector<std::string> vExpectedMembers = {"servers[]", "skip", "n", "servers_legacy[]"};
+	std::vector<std::string> vExpectedElements = {"servers:object", "servers:12", "servers:x\"]", "servers:true", "servers:null", "servers:array"};
+	EXPECT_EQ(Parser.m_vMembers, vExpectedMembers);
+	EXPECT_EQ(Parser.m_vElements, vExpectedElements);
+}
+
+TEST(Json, StreamByteByByte)
+{
+	CTestJsonStream Parser;
+	for(int i = 0; i < str_length(STREAM_DOCUMENT); i++)
+	{
+		ASSERT_FALSE(Parser.Feed(STREAM_DOCUMENT + i, 1));
+	}
+	EXPECT_FALSE(Parser.Finish());
+	EXPECT_EQ(Parser.m_vElements.size(), 6u);
+	EXPECT_EQ(Parser.m_vMembers.size(), 4u);
+}
+
+TEST(Json, StreamInvalid)
+{
+	const char *apInvalid[] = {
+		"",
+		"[]",
+		"{",
+		"{\"a\": [1, 2}",
+		"{\"a\": [1,, 2]}",
+		"{\"a\": [1 2]}",
+		"{\"a\": [{]}]}",
+		"{\"a\" [1]}",
+		"{\"a\": [1]} x",
+		"{\"a\": [1],}",
+	};
+	for(const char *pInvalid : apInvalid)
+	{
+		CTestJsonStream Parser;
+		bool Error = Parser.Feed(pInvalid, str_length(pInvalid));
+		Error = Parser.Finish() || Error;
+		EXPECT_TRUE(Error) << pInvalid;
+	}
+	CTestJsonStream Empty;
+	EXPECT_FALSE(Empty.Feed(" { } ", 5));
+	EXPECT_FALSE(Empty.Finish());
+}
+
+TEST(Json, StreamLargeDocument)
+{
+	// Roughly the size of the real server list.
+	std::string Document = "{\"servers\":[";
+	const int NumServers = 10000;
+	for(int i = 0; i < NumServers; i++)
+	{
+		char aServer[512];
+		str_format(aServer, sizeof(aServer), "%s{\"addresses\":[\"tw-0.6+udp://127.0.0.1:%d\"],\"location\":\"eu:de\",\"info\":{\"max_clients\":64,\"max_players\":64,\"passworded\":false,\"game_type\":\"DDraceNetwork\",\"name\":\"Server %d\",\"map\":{\"name\":\"Kobra 4\",\"sha256\":\"0000000000000000000000000000000000000000000000000000000000000000\",\"size\":1234},\"version\":\"0.6.4, 16.7.2\",\"clients\":[]},\"id\":%d}",
+			i > 0 ? "," : "", 8303 + i % 1000, i, i);
+		Document += aServer;
+	}
+	Document += "]}";
+	ASSERT_GT(Document.size(), 3000000u);
+
+	CTestJsonStream Parser;
+	for(size_t Offset = 0; Offset < Document.size(); Offset += 16384)
+	{
+		ASSERT_FALSE(Parser.Feed(Document.data() + Offset, std::min<size_t>(16384, Document.size() - Offset)));
+	}
+	EXPECT_FALSE(Parser.Finish());
+	EXPECT_EQ(Parser.m_vElements.size(), (size_t)NumServers);
+}
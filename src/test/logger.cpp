@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CCollectingLogger : public ILogger
+{
+public:
+	std::mutex m_Lock;
+	std::vector<std::string> m_vMessages;
+	int m_NumBatches = 0;
+
+	void Log(const CLogMessage *pMessage) override
+	{
+		std::unique_lock<std::mutex> Lock(m_Lock);
+		m_vMessages.emplace_back(pMessage->Message());
+	}
+	void LogBatch(const CLogMessage *const *ppMessages, int NumMessages) override
+	{
+		std::unique_lock<std::mutex> Lock(m_Lock);
+		for(int i = 0; i < NumMessages; i++)
+			m_vMessages.emplace_back(ppMessages[i]->Message());
+		m_NumBatches++;
+	}
+};
+
+static CLogMessage Message(LEVEL Level, const char *pText)
+{
+	CLogMessage Msg;
+	Msg.m_Level = Level;
+	Msg.m_HaveColor = false;
+	Msg.m_Color = LOG_COLOR{0, 0, 0};
+	str_copy(Msg.m_aTimestamp, "2000-01-01 00:00:00");
+	Msg.m_TimestampLength = str_length(Msg.m_aTimestamp);
+	str_copy(Msg.m_aSystem, "test");
+	Msg.m_SystemLength = str_length(Msg.m_aSystem);
+	str_format(Msg.m_aLine, sizeof(Msg.m_aLine), "%s I %s: ", Msg.m_aTimestamp, Msg.m_aSystem);
+	Msg.m_LineMessageOffset = str_length(Msg.m_aLine);
+	str_append(Msg.m_aLine, pText, sizeof(Msg.m_aLine));
+	Msg.m_LineLength = str_length(Msg.m_aLine);
+	return Msg;
+}
+
+// returns the number of dropped messages reported
+static int CheckMessages(const std::vector<std::string> &vMessages, int NumThreads, std::vector<int> *pvReceived)
+{
+	pvReceived->assign(NumThreads, 0);
+	std::vector<int> vLast(NumThreads, -1);
+	int NumDropped = 0;
+	for(const std::string &Message : vMessages)
+	{
+		int Dropped;
+		int Thread, Index;
+		if(sscanf(Message.c_str(), "dropped %d", &Dropped) == 1)
+			NumDropped += Dropped;
+		else if(sscanf(Message.c_str(), "%d %d", &Thread, &Index) == 2)
+		{
+			// every thread's messages arrive in order
+			EXPECT_GT(Index, vLast[Thread]);
+			vLast[Thread] = Index;
+			(*pvReceived)[Thread]++;
+		}
+		else
+			ADD_FAILURE() << Message;
+	}
+	return NumDropped;
+}
+
+TEST(Logger, AsyncNoneLost)
+{
+	auto pSink = std::make_shared<CCollectingLogger>();
+	std::unique_ptr<ILogger> pLogger = log_logger_async({pSink}, 8);
+
+	const int NUM_THREADS = 4;
+	const int NUM_MESSAGES = 2000;
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NUM_THREADS; t++)
+	{
+		vThreads.emplace_back([&, t]() {
+			char aBuf[64];
+			for(int i = 0; i < NUM_MESSAGES; i++)
+			{
+				str_format(aBuf, sizeof(aBuf), "%d %d", t, i);
+				// warnings wait for space in the queue
+				CLogMessage Msg = Message(LEVEL_WARN, aBuf);
+				pLogger->Log(&Msg);
+			}
+		});
+	}
+	for(auto &Thread : vThreads)
+		Thread.join();
+	pLogger->GlobalFinish();
+
+	std::vector<int> vReceived;
+	EXPECT_EQ(CheckMessages(pSink->m_vMessages, NUM_THREADS, &vReceived), 0);
+	for(int Received : vReceived)
+		EXPECT_EQ(Received, NUM_MESSAGES);
+	EXPECT_GE(pSink->m_NumBatches, 1);
+}
+
+TEST(Logger, AsyncDropCounted)
+{
+	auto pSink = std::make_shared<CCollectingLogger>();
+	std::unique_ptr<ILogger> pLogger = log_logger_async({pSink}, 4);
+
+	const int NUM_THREADS = 3;
+	const int NUM_MESSAGES = 5000;
+	std::vector<std::thread> vThreads;
+	for(int t = 0; t < NUM_THREADS; t++)
+	{
+		vThreads.emplace_back([&, t]() {
+			char aBuf[64];
+			for(int i = 0; i < NUM_MESSAGES; i++)
+			{
+				str_format(aBuf, sizeof(aBuf), "%d %d", t, i);
+				CLogMessage Msg = Message(LEVEL_DEBUG, aBuf);
+				pLogger->Log(&Msg);
+			}
+		});
+	}
+	for(auto &Thread : vThreads)
+		Thread.join();
+	// destroying the logger writes everything still queued
+	pLogger = nullptr;
+
+	std::vector<int> vReceived;
+	int NumDropped = CheckMessages(pSink->m_vMessages, NUM_THREADS, &vReceived);
+	int NumReceived = 0;
+	for(int Received : vReceived)
+		NumReceived += Received;
+	EXPECT_EQ(NumReceived + NumDropped, NUM_THREADS * NUM_MESSAGES);
+}
+
+TEST(Logger, AsyncShortLivedThreads)
+{
+	auto pSink = std::make_shared<CCollectingLogger>();
+	std::unique_ptr<ILogger> pLogger = log_logger_async({pSink}, 4);
+
+	// every thread exits before the next one starts logging, so they all
+	// share one queue
+	const int NUM_THREADS = 50;
+	const int NUM_MESSAGES = 20;
+	for(int t = 0; t < NUM_THREADS; t++)
+	{
+		std::thread Thread([&, t]() {
+			char aBuf[64];
+			for(int i = 0; i < NUM_MESSAGES; i++)
+			{
+				str_format(aBuf, sizeof(aBuf), "%d %d", t, i);
+				CLogMessage Msg = Message(LEVEL_WARN, aBuf);
+				pLogger->Log(&Msg);
+			}
+		});
+		Thread.join();
+	}
+	pLogger->GlobalFinish();
+
+	std::vector<int> vReceived;
+	EXPECT_EQ(CheckMessages(pSink->m_vMessages, NUM_THREADS, &vReceived), 0);
+	for(int Received : vReceived)
+		EXPECT_EQ(Received, NUM_MESSAGES);
+}
@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+#include <game/prng.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class NetBan : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IConsole> m_pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan m_Ban;
+	CPrng m_Prng;
+
+	// ranges of the active bans, single addresses have `m_LB == m_UB`
+	std::vector<CNetRange> m_vBans;
+
+	NetBan()
+	{
+		m_Ban.Init(m_pConsole.get(), nullptr);
+		uint64_t aSeed[2] = {0x0f1e2d3c4b5a6978ull, 0x8796a5b4c3d2e1f0ull};
+		m_Prng.Seed(aSeed);
+	}
+
+	static bool Contains(const CNetRange &Range, const NETADDR &Addr)
+	{
+		int Bytes = Addr.type == NETTYPE_IPV4 ? 4 : 16;
+		return Range.m_LB.type == Addr.type && mem_comp(Range.m_LB.ip, Addr.ip, Bytes) <= 0 && mem_comp(Range.m_UB.ip, Addr.ip, Bytes) >= 0;
+	}
+
+	bool BruteForceBanned(const NETADDR &Addr) const
+	{
+		for(const CNetRange &Range : m_vBans)
+		{
+			if(Contains(Range, Addr))
+				return true;
+		}
+		return false;
+	}
+
+	NETADDR RandomAddr(int Type)
+	{
+		NETADDR Addr;
+		mem_zero(&Addr, sizeof(Addr));
+		Addr.type = Type;
+		for(int i = 0; i < (Type == NETTYPE_IPV4 ? 4 : 16); i++)
+			Addr.ip[i] = m_Prng.RandomBits();
+		// keep the ranges away from localhost, which can't be banned
+		Addr.ip[0] |= 0x80;
+		return Addr;
+	}
+
+	CNetRange RandomBan()
+	{
+		int Type = m_Prng.RandomBits() % 3 == 0 ? NETTYPE_IPV6 : NETTYPE_IPV4;
+		int Bits = Type == NETTYPE_IPV4 ? 32 : 128;
+		CNetRange Range;
+		Range.m_LB = RandomAddr(Type);
+		Range.m_UB = Range.m_LB;
+		switch(m_Prng.RandomBits() % 3)
+		{
+		case 0:
+			// single address
+			break;
+		case 1:
+		{
+			// CIDR prefix
+			int Length = 8 + m_Prng.RandomBits() % (Bits - 8);
+			for(int Bit = Length; Bit < Bits; Bit++)
+			{
+				Range.m_LB.ip[Bit / 8] &= ~(1 << (7 - Bit % 8));
+				Range.m_UB.ip[Bit / 8] |= 1 << (7 - Bit % 8);
+			}
+			break;
+		}
+		default:
+			// arbitrary range
+			Range.m_UB = RandomAddr(Type);
+			mem_copy(Range.m_UB.ip, Range.m_LB.ip, 1 + m_Prng.RandomBits() % (Bits / 8 - 1));
+			if(mem_comp(Range.m_LB.ip, Range.m_UB.ip, Bits / 8) > 0)
+				std::swap(Range.m_LB, Range.m_UB);
+		}
+		return Range;
+	}
+
+	// an address in, at the border of, or just outside a ban
+	NETADDR RandomTestAddr()
+	{
+		if(m_vBans.empty() || m_Prng.RandomBits() % 8 == 0)
+			return RandomAddr(m_Prng.RandomBits() % 2 ? NETTYPE_IPV4 : NETTYPE_IPV6);
+
+		const CNetRange &Range = m_vBans[m_Prng.RandomBits() % m_vBans.size()];
+		NETADDR Addr = m_Prng.RandomBits() % 2 ? Range.m_LB : Range.m_UB;
+		int Last = (Addr.type == NETTYPE_IPV4 ? 4 : 16) - 1;
+		switch(m_Prng.RandomBits() % 3)
+		{
+		case 0: Addr.ip[Last]--; break;
+		case 1: Addr.ip[Last]++; break;
+		}
+		return Addr;
+	}
+
+	void ImportBans(int Num)
+	{
+		std::string Banlist;
+		char aLB[NETADDR_MAXSTRSIZE], aUB[NETADDR_MAXSTRSIZE], aLine[256];
+		for(int i = 0; i < Num; i++)
+		{
+			CNetRange Range = RandomBan();
+			m_vBans.push_back(Range);
+			net_addr_str(&Range.m_LB, aLB, sizeof(aLB), false);
+			net_addr_str(&Range.m_UB, aUB, sizeof(aUB), false);
+			int Minutes = m_Prng.RandomBits() % 2 ? -1 : 1 + m_Prng.RandomBits() % 1000;
+			if(NetComp(&Range.m_LB, &Range.m_UB) == 0)
+				str_format(aLine, sizeof(aLine), "ban %s %d test ban %d\n", aLB, Minutes, i);
+			else
+				str_format(aLine, sizeof(aLine), "ban_range %s %s %d test ban %d\r\n", aLB, aUB, Minutes, i);
+			Banlist += aLine;
+		}
+		EXPECT_EQ(m_Ban.ImportBans(Banlist.c_str()), Num);
+	}
+
+	void CheckBans(int NumChecks)
+	{
+		char aReason[256];
+		for(int i = 0; i < NumChecks; i++)
+		{
+			NETADDR Addr = RandomTestAddr();
+			ASSERT_EQ(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)), BruteForceBanned(Addr)) << i;
+		}
+	}
+};
+
+TEST_F(NetBan, MatchesBruteForce)
+{
+	ImportBans(2000);
+	CheckBans(20000);
+
+	// remove some bans again and add others one by one
+	for(int i = 0; i < 100; i++)
+	{
+		int Index = m_Prng.RandomBits() % m_vBans.size();
+		const CNetRange &Range = m_vBans[Index];
+		if(NetComp(&Range.m_LB, &Range.m_UB) == 0)
+			EXPECT_EQ(m_Ban.UnbanByAddr(&Range.m_LB), 0);
+		else
+			EXPECT_EQ(m_Ban.UnbanByRange(&Range), 0);
+		m_vBans.erase(m_vBans.begin() + Index);
+
+		CNetRange New = RandomBan();
+		if(NetComp(&New.m_LB, &New.m_UB) == 0)
+			EXPECT_EQ(m_Ban.BanAddr(&New.m_LB, 60, "test"), 0);
+		else
+			EXPECT_EQ(m_Ban.BanRange(&New, 60, "test"), 0);
+		m_vBans.push_back(New);
+	}
+	CheckBans(20000);
+
+	m_Ban.UnbanAll();
+	m_vBans.clear();
+	CheckBans(1000);
+}
+
+TEST_F(NetBan, Import)
+{
+	const char *pBanlist =
+		"ban 1.2.3.4 -1 cheating\n"
+		"ban_range 10.0.0.0 10.255.255.255 30 proxies\n"
+		"ban 127.0.0.1 -1 localhost is never banned\n"
+		"ban_range 10.0.0.5 10.0.0.1 30 reversed range\n"
+		"kick 0\n"
+		"\n"
+		"ban 1.2.3.4 -1 again, updates the first one\n"
+		"ban_range [ffff::1] [ffff::ffff] 5\n";
+	EXPECT_EQ(m_Ban.ImportBans(pBanlist), 4);
+
+	char aReason[256];
+	NETADDR Addr;
+	ASSERT_FALSE(net_addr_from_str(&Addr, "1.2.3.4"));
+	EXPECT_TRUE(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)));
+	EXPECT_STREQ(aReason, "You have been banned (again, updates the first one)");
+	ASSERT_FALSE(net_addr_from_str(&Addr, "10.1.2.3"));
+	EXPECT_TRUE(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)));
+	ASSERT_FALSE(net_addr_from_str(&Addr, "11.0.0.0"));
+	EXPECT_FALSE(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)));
+	ASSERT_FALSE(net_addr_from_str(&Addr, "[ffff::abc]"));
+	EXPECT_TRUE(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)));
+	EXPECT_STREQ(aReason, "You have been banned for 5 minutes (No reason given)");
+	ASSERT_FALSE(net_addr_from_str(&Addr, "127.0.0.1"));
+	EXPECT_FALSE(m_Ban.IsBanned(&Addr, aReason, sizeof(aReason)));
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/network.h>
+
+static NETADDR Addr(const char *pStr)
+{
+	NETADDR Result;
+	EXPECT_FALSE(net_addr_from_str(&Result, pStr));
+	return Result;
+}
+
+TEST(NetSlotMap, SetFindRemove)
+{
+	CNetSlotMap Map;
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8303")), -1);
+
+	Map.Set(Addr("127.0.0.1:8303"), 3);
+	Map.Set(Addr("127.0.0.1:8304"), 5);
+	Map.Set(Addr("[::1]:8303"), 7);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8303")), 3);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8304")), 5);
+	EXPECT_EQ(Map.Find(Addr("[::1]:8303")), 7);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.2:8303")), -1);
+
+	Map.Remove(5);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8304")), -1);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8303")), 3);
+	Map.Remove(5);
+	EXPECT_EQ(Map.Find(Addr("127.0.0.1:8303")), 3);
+}
+
+TEST(NetSlotMap, SetReplaces)
+{
+	CNetSlotMap Map;
+
+	// a slot changing its address, like on a timeout rejoin
+	Map.Set(Addr("1.2.3.4:1"), 0);
+	Map.Set(Addr("1.2.3.4:2"), 0);
+	EXPECT_EQ(Map.Find(Addr("1.2.3.4:1")), -1);
+	EXPECT_EQ(Map.Find(Addr("1.2.3.4:2")), 0);
+
+	// another slot taking over the address
+	Map.Set(Addr("1.2.3.4:2"), 1);
+	EXPECT_EQ(Map.Find(Addr("1.2.3.4:2")), 1);
+	Map.Remove(0);
+	EXPECT_EQ(Map.Find(Addr("1.2.3.4:2")), 1);
+}
+
+TEST(NetSlotMap, Random)
+{
+	// compare with a linear scan, with few different addresses so that
+	// probe sequences overlap a lot
+	CNetSlotMap Map;
+	NETADDR aSlotAddrs[NET_MAX_CLIENTS];
+	bool aUsed[NET_MAX_CLIENTS] = {false};
+	for(int Step = 0; Step < 100000; Step++)
+	{
+		char aBuf[NETADDR_MAXSTRSIZE];
+		str_format(aBuf, sizeof(aBuf), "10.0.%d.%d:%d", secure_rand() % 2, secure_rand() % 50, 8303 + secure_rand() % 2);
+		NETADDR Address = Addr(aBuf);
+		int Slot = secure_rand() % NET_MAX_CLIENTS;
+		if(secure_rand() % 3)
+		{
+			Map.Set(Address, Slot);
+			for(int i = 0; i < NET_MAX_CLIENTS; i++)
+			{
+				if(aUsed[i] && aSlotAddrs[i] == Address)
+					aUsed[i] = false;
+			}
+			aSlotAddrs[Slot] = Address;
+			aUsed[Slot] = true;
+		}
+		else
+		{
+			Map.Remove(Slot);
+			aUsed[Slot] = false;
+		}
+
+		int Expected = -1;
+		for(int i = 0; i < NET_MAX_CLIENTS; i++)
+		{
+			if(aUsed[i] && aSlotAddrs[i] == Address)
+				Expected = i;
+		}
+		ASSERT_EQ(Map.Find(Address), Expected);
+		for(int i = 0; i < NET_MAX_CLIENTS; i++)
+		{
+			if(aUsed[i])
+			{
+				ASSERT_EQ(Map.Find(aSlotAddrs[i]), i);
+			}
+		}
+	}
+}
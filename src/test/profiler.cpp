@@ -0,0 +1,129 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/profiler.h>
+
+TEST(Profiler, Disabled)
+{
+	CProfiler Profiler;
+	Profiler.BeginFrame();
+	EXPECT_FALSE(Profiler.IsRecording());
+	{
+		CProfiler::CScope Scope(&Profiler, "zone");
+		CProfiler::CCounterScope Counter(&Profiler, "counter");
+	}
+	Profiler.EndFrame();
+	EXPECT_EQ(Profiler.NumFrames(), 0);
+	EXPECT_EQ(Profiler.Frame(0), nullptr);
+}
+
+TEST(Profiler, Zones)
+{
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	Profiler.BeginFrame();
+	{
+		CProfiler::CScope Outer(&Profiler, "outer");
+		{
+			CProfiler::CScope Inner(&Profiler, "inner");
+			for(int i = 0; i < 3; i++)
+				CProfiler::CCounterScope Counter(&Profiler, "counter");
+		}
+		CProfiler::CScope Second(&Profiler, "second");
+	}
+	// ended with the frame
+	Profiler.BeginZone("open");
+	Profiler.EndFrame();
+
+	ASSERT_EQ(Profiler.NumFrames(), 1);
+	const CProfiler::CFrame *pFrame = Profiler.Frame(0);
+	ASSERT_EQ(pFrame->m_NumZones, 4);
+	EXPECT_STREQ(pFrame->m_aZones[0].m_pName, "outer");
+	EXPECT_STREQ(pFrame->m_aZones[1].m_pName, "inner");
+	EXPECT_STREQ(pFrame->m_aZones[2].m_pName, "second");
+	EXPECT_STREQ(pFrame->m_aZones[3].m_pName, "open");
+	EXPECT_EQ(pFrame->m_aZones[0].m_Depth, 0);
+	EXPECT_EQ(pFrame->m_aZones[1].m_Depth, 1);
+	EXPECT_EQ(pFrame->m_aZones[2].m_Depth, 1);
+	EXPECT_EQ(pFrame->m_aZones[3].m_Depth, 0);
+	EXPECT_GE(pFrame->m_aZones[0].m_Duration, pFrame->m_aZones[1].m_Duration + pFrame->m_aZones[2].m_Duration);
+	EXPECT_LE(pFrame->m_aZones[1].m_Start + pFrame->m_aZones[1].m_Duration, pFrame->m_aZones[2].m_Start);
+	EXPECT_LE(pFrame->m_aZones[3].m_Start + pFrame->m_aZones[3].m_Duration, pFrame->m_Duration);
+	ASSERT_EQ(pFrame->m_NumCounters, 1);
+	EXPECT_STREQ(pFrame->m_aCounters[0].m_pName, "counter");
+	EXPECT_EQ(pFrame->m_aCounters[0].m_Count, 3);
+}
+
+TEST(Profiler, CounterCount)
+{
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	Profiler.BeginFrame();
+	Profiler.AddCounter("commands", 0, 5);
+	Profiler.AddCounter("commands", 0, 3);
+	Profiler.EndFrame();
+
+	const CProfiler::CFrame *pFrame = Profiler.Frame(0);
+	ASSERT_EQ(pFrame->m_NumCounters, 1);
+	EXPECT_EQ(pFrame->m_aCounters[0].m_Count, 8);
+	EXPECT_EQ(pFrame->m_aCounters[0].m_Duration, 0);
+}
+
+TEST(Profiler, Ring)
+{
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	for(int i = 0; i < CProfiler::NUM_FRAMES * 2 + 10; i++)
+	{
+		Profiler.BeginFrame();
+		// only every other frame is kept
+		if(i % 2)
+			Profiler.DiscardFrame();
+		else
+			Profiler.EndFrame();
+	}
+	ASSERT_EQ(Profiler.NumFrames(), CProfiler::NUM_FRAMES - 1);
+	for(int Age = 0; Age < Profiler.NumFrames(); Age++)
+		EXPECT_EQ(Profiler.Frame(Age)->m_Index, CProfiler::NUM_FRAMES + 4 - Age);
+
+	Profiler.SetEnabled(false);
+	Profiler.BeginFrame();
+	EXPECT_EQ(Profiler.NumFrames(), 0);
+}
+
+TEST(Profiler, ExportCsv)
+{
+	CTestInfo Info;
+	CProfiler Profiler;
+	Profiler.SetEnabled(true);
+	for(int i = 0; i < 3; i++)
+	{
+		Profiler.BeginFrame();
+		CProfiler::CScope Zone(&Profiler, "a, \"zone\"");
+		Profiler.AddCounter("counter", 1000);
+		Profiler.EndFrame();
+	}
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	Profiler.ExportCsv(File);
+	io_close(File);
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	char *pData = io_read_all_str(File);
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+	ASSERT_TRUE(pData);
+
+	// header and frame, zone and counter of every frame
+	int NumLines = 0;
+	for(const char *p = pData; *p; p++)
+		NumLines += *p == '\n';
+	EXPECT_EQ(NumLines, 1 + 3 * 3);
+	EXPECT_TRUE(str_startswith(pData, "frame,type,name,depth,start_us,duration_us,count"));
+	EXPECT_TRUE(str_find(pData, "\"a, \"\"zone\"\"\",0,"));
+	EXPECT_TRUE(str_find(pData, "counter,-1,0,1.000,1"));
+	free(pData);
+}
@@ -456,6 +456,131 @@ TEST_P(Points, EqualPointsTop)
 			"-------------------------------"});
 }
 
+struct RankCache : public Score
+{
+	std::shared_ptr<CScoreRankCacheResult> m_pCacheResult{std::make_shared<CScoreRankCacheResult>()};
+
+	RankCache()
+	{
+		InsertRank(100.0);
+		InsertRankOn("brainless tee", 90.0, "GER");
+		InsertRankOn("brainless tee", 80.0, "USA");
+		InsertRankOn("tee", 120.0, "GER");
+		InsertRankOn("another tee", 130.0, "GER");
+		str_copy(m_PlayerRequest.m_aMap, "Kobra 3", sizeof(m_PlayerRequest.m_aMap));
+		str_copy(m_PlayerRequest.m_aRequestingPlayer, "brainless tee", sizeof(m_PlayerRequest.m_aRequestingPlayer));
+		str_copy(m_PlayerRequest.m_aServer, "GER", sizeof(m_PlayerRequest.m_aServer));
+	}
+
+	void InsertRankOn(const char *pName, float Time, const char *pServer)
+	{
+		str_copy(g_Config.m_SvSqlServerName, pServer, sizeof(g_Config.m_SvSqlServerName));
+		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+		str_copy(ScoreData.m_aMap, "Kobra 3", sizeof(ScoreData.m_aMap));
+		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320", sizeof(ScoreData.m_aGameUuid));
+		str_copy(ScoreData.m_aName, pName, sizeof(ScoreData.m_aName));
+		ScoreData.m_ClientID = 0;
+		ScoreData.m_Time = Time;
+		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08", sizeof(ScoreData.m_aTimestamp));
+		for(float &TimeCp : ScoreData.m_aCurrentTimeCp)
+			TimeCp = 0;
+		str_copy(ScoreData.m_aRequestingPlayer, pName, sizeof(ScoreData.m_aRequestingPlayer));
+		ASSERT_FALSE(CScoreWorker::SaveScore(m_pConn, &ScoreData, Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void LoadCache(const char *pServer)
+	{
+		CSqlRankCacheRequest Request(m_pCacheResult);
+		str_copy(Request.m_aMap, "Kobra 3", sizeof(Request.m_aMap));
+		str_copy(Request.m_aServer, pServer, sizeof(Request.m_aServer));
+		ASSERT_FALSE(CScoreWorker::LoadRankCache(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	void ExpectSameAsDatabase(
+		bool (*pFunc)(IDbConnection *, const ISqlData *, char *pError, int ErrorSize),
+		void (*pCachedFunc)(const CRankCache *, const CSqlPlayerRequest *))
+	{
+		m_pPlayerResult = std::make_shared<CScorePlayerResult>();
+		m_PlayerRequest.m_pResult = m_pPlayerResult;
+		ASSERT_FALSE(pFunc(m_pConn, &m_PlayerRequest, m_aError, sizeof(m_aError))) << m_aError;
+
+		auto pCachedResult = std::make_shared<CScorePlayerResult>();
+		CSqlPlayerRequest CachedRequest = m_PlayerRequest;
+		CachedRequest.m_pResult = pCachedResult;
+		pCachedFunc(&m_pCacheResult->m_Cache, &CachedRequest);
+
+		EXPECT_EQ(pCachedResult->m_MessageKind, m_pPlayerResult->m_MessageKind);
+		for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+		{
+			EXPECT_STREQ(pCachedResult->m_Data.m_aaMessages[i], m_pPlayerResult->m_Data.m_aaMessages[i]);
+		}
+	}
+
+	void ExpectAllSameAsDatabase()
+	{
+		for(const char *pName : {"nameless tee", "brainless tee", "another tee", "unknown tee"})
+		{
+			str_copy(m_PlayerRequest.m_aName, pName, sizeof(m_PlayerRequest.m_aName));
+			ExpectSameAsDatabase(CScoreWorker::ShowRank, CScoreWorker::ShowRank);
+		}
+		for(int Offset : {0, 1, 2, 4, -1, -3, 10})
+		{
+			m_PlayerRequest.m_Offset = Offset;
+			ExpectSameAsDatabase(CScoreWorker::ShowTop, CScoreWorker::ShowTop);
+		}
+	}
+};
+
+TEST_P(RankCache, SameAsDatabase)
+{
+	LoadCache("GER");
+	ExpectAllSameAsDatabase();
+}
+
+TEST_P(RankCache, SameAsDatabaseOtherServer)
+{
+	str_copy(m_PlayerRequest.m_aServer, "USA", sizeof(m_PlayerRequest.m_aServer));
+	LoadCache("USA");
+	ExpectAllSameAsDatabase();
+}
+
+TEST_P(RankCache, AddFinish)
+{
+	LoadCache("GER");
+	for(auto Finish : {std::make_pair("new tee", 95.0f), std::make_pair("tee", 85.0f), std::make_pair("tee", 110.0f)})
+	{
+		InsertRankOn(Finish.first, Finish.second, "GER");
+		m_pCacheResult->m_Cache.AddFinish(Finish.first, Finish.second);
+	}
+	ExpectAllSameAsDatabase();
+}
+
+TEST(Ranking, Update)
+{
+	CRanking<int> Ranking(true);
+	Ranking.Add("a", 1);
+	Ranking.Add("b", 3);
+	Ranking.Add("a", 2);
+	Ranking.Sort();
+	ASSERT_EQ(Ranking.Size(), 2);
+	EXPECT_EQ(Ranking.Entry(0).m_Name, "b");
+	EXPECT_EQ(Ranking.Rank(3), 1);
+	EXPECT_EQ(Ranking.Rank(2), 2);
+
+	EXPECT_FALSE(Ranking.Update("b", 1));
+	EXPECT_TRUE(Ranking.Update("c", 3));
+	EXPECT_TRUE(Ranking.Update("a", 4));
+	ASSERT_EQ(Ranking.Size(), 3);
+	EXPECT_EQ(Ranking.Entry(0).m_Name, "a");
+	EXPECT_EQ(Ranking.Entry(1).m_Name, "b");
+	EXPECT_EQ(Ranking.Entry(2).m_Name, "c");
+	EXPECT_EQ(Ranking.Rank(3), 2);
+	int Value;
+	ASSERT_TRUE(Ranking.Find("a", &Value));
+	EXPECT_EQ(Value, 4);
+	EXPECT_FALSE(Ranking.Find("d", &Value));
+}
+
 struct RandomMap : public Score
 {
 	std::shared_ptr<CScoreRandomMapResult> m_pRandomMapResult{std::make_shared<CScoreRandomMapResult>(0)};
@@ -554,4 +679,5 @@ INSTANTIATE(TeamScore);
 INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
 INSTANTIATE(Points);
+INSTANTIATE(RankCache);
 INSTANTIATE(RandomMap);
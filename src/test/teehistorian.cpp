@@ -1,3 +1,4 @@
+#include "test.h"
 #include <gtest/gtest.h>
 
 #include <base/detect.h>
@@ -757,3 +758,142 @@ TEST_F(TeeHistorian, PlayerReadyMultiple)
 	Finish();
 	Expect(EXPECTED, sizeof(EXPECTED));
 }
+
+struct CSeekOutput
+{
+	CBlockFileWriter m_Writer;
+	std::vector<unsigned char> m_vPlain;
+};
+
+static void WriteSeekOutput(const void *pData, int DataSize, void *pUser)
+{
+	CSeekOutput *pOutput = (CSeekOutput *)pUser;
+	pOutput->m_Writer.Write(pData, DataSize);
+	pOutput->m_vPlain.insert(pOutput->m_vPlain.end(), (const unsigned char *)pData, (const unsigned char *)pData + DataSize);
+}
+
+static void WriteKeyframe(const void *pData, int DataSize, void *pUser)
+{
+	std::vector<unsigned char> *pvKeyframe = (std::vector<unsigned char> *)pUser;
+	pvKeyframe->insert(pvKeyframe->end(), (const unsigned char *)pData, (const unsigned char *)pData + DataSize);
+}
+
+TEST_F(TeeHistorian, SeekCompressed)
+{
+	CTestInfo Info;
+	char aPlainFilename[IO_MAX_PATH_LENGTH];
+	str_format(aPlainFilename, sizeof(aPlainFilename), "%s.plain", Info.m_aFilename);
+
+	CSeekOutput Output;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	Output.m_Writer.Open(File);
+	m_TH.Reset(&m_GameInfo, WriteSeekOutput, &Output);
+
+	const int NUM_TICKS = 2000;
+	const int NUM_PLAYERS = 8;
+	for(int t = 1; t <= NUM_TICKS; t++)
+	{
+		m_TH.BeginTick(t);
+		m_TH.BeginPlayers();
+		for(int i = 0; i < NUM_PLAYERS; i++)
+		{
+			if(i == NUM_PLAYERS - 1 && (t / 50) % 2 == 1)
+			{
+				m_TH.RecordDeadPlayer(i);
+				continue;
+			}
+			// Nobody moves on every seventh tick, so nothing is written.
+			int MoveTick = t - t % 7;
+			CNetObj_CharacterCore Char;
+			mem_zero(&Char, sizeof(Char));
+			Char.m_X = MoveTick * (i + 1);
+			Char.m_Y = i;
+			m_TH.RecordPlayer(i, &Char);
+		}
+		m_TH.EndPlayers();
+		m_TH.BeginInputs();
+		CNetObj_PlayerInput Input;
+		mem_zero(&Input, sizeof(Input));
+		Input.m_Direction = t / 10 % 3 - 1;
+		m_TH.RecordPlayerInput(0, 1, &Input);
+		m_TH.EndInputs();
+		m_TH.EndTick();
+		if(t % 100 == 0)
+		{
+			m_TH.RecordPlayerTeam(t / 100 % NUM_PLAYERS, t / 100);
+		}
+		if(Output.m_Writer.BlockSize() >= 1024)
+		{
+			std::vector<unsigned char> vKeyframe;
+			m_TH.WriteKeyframe(WriteKeyframe, &vKeyframe);
+			Output.m_Writer.BeginBlock(m_TH.LastWrittenTick(), vKeyframe.data(), vKeyframe.size());
+		}
+	}
+	m_TH.Finish();
+	ASSERT_EQ(Output.m_Writer.Close(), 0);
+
+	File = io_open(aPlainFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_write(File, Output.m_vPlain.data(), Output.m_vPlain.size());
+	io_close(File);
+
+	CBlockFileReader BlockReader;
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(BlockReader.Open(File));
+	EXPECT_GT(BlockReader.NumBlocks(), 5);
+	BlockReader.Close();
+
+	CTeeHistorianReader Compressed;
+	CTeeHistorianReader Plain;
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Compressed.Open(File));
+	EXPECT_TRUE(Compressed.Compressed());
+	File = io_open(aPlainFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	ASSERT_FALSE(Plain.Open(File));
+	EXPECT_FALSE(Plain.Compressed());
+	EXPECT_STREQ(Compressed.HeaderJson(), Plain.HeaderJson());
+
+	const int aTicks[] = {1, 2, 7, 8, 99, 100, 101, 555, 1000, 1234, 1999, 2000, 500, 3};
+	for(int Tick : aTicks)
+	{
+		ASSERT_FALSE(Compressed.Seek(Tick + 1));
+		ASSERT_FALSE(Plain.Seek(Tick + 1));
+		EXPECT_EQ(Compressed.Tick(), Plain.Tick());
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CTeeHistorianReader::CPlayer &Player = Compressed.Player(i);
+			EXPECT_EQ(mem_comp(&Player, &Plain.Player(i), sizeof(Player)), 0);
+			bool Alive = i < NUM_PLAYERS && !(i == NUM_PLAYERS - 1 && (Tick / 50) % 2 == 1);
+			EXPECT_EQ(Player.m_Alive, Alive);
+			if(Alive)
+			{
+				EXPECT_EQ(Player.m_X, (Tick - Tick % 7) * (i + 1));
+				EXPECT_EQ(Player.m_Y, i);
+			}
+		}
+		EXPECT_EQ(Compressed.Player(0).m_Input.m_Direction, Tick / 10 % 3 - 1);
+	}
+
+	// Reading on from a seek position reaches the end.
+	ASSERT_FALSE(Compressed.Seek(1500));
+	CTeeHistorianReader::CChunk Chunk;
+	int Result;
+	int LastTick = 0;
+	while((Result = Compressed.Next(&Chunk)) == CTeeHistorianReader::READ_CHUNK)
+	{
+		EXPECT_GE(Chunk.m_Tick, 1500);
+		EXPECT_GE(Chunk.m_Tick, LastTick);
+		LastTick = Chunk.m_Tick;
+	}
+	EXPECT_EQ(Result, CTeeHistorianReader::READ_FINISHED);
+	EXPECT_EQ(LastTick, NUM_TICKS);
+
+	Compressed.Close();
+	Plain.Close();
+	fs_remove(Info.m_aFilename);
+	fs_remove(aPlainFilename);
+}
@@ -0,0 +1,114 @@
+#include "test.h"
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/ticktimings.h>
+
+static const int64_t MS = 1000000;
+
+TEST(TickTimings, Buckets)
+{
+	int Last = -1;
+	for(int64_t Micros = 0; Micros < 100000000; Micros += Micros / 7 + 1)
+	{
+		int Bucket = CTickTimings::CHistogram::Bucket(Micros * 1000);
+		EXPECT_GE(Bucket, Last);
+		EXPECT_LT(Micros * 1000, CTickTimings::CHistogram::BucketEnd(Bucket));
+		if(Bucket > 0)
+		{
+			EXPECT_GE(Micros * 1000, CTickTimings::CHistogram::BucketEnd(Bucket - 1));
+		}
+		Last = Bucket;
+	}
+	EXPECT_EQ(CTickTimings::CHistogram::Bucket(-5), 0);
+	EXPECT_EQ(CTickTimings::CHistogram::Bucket(INT64_MAX / 2), CTickTimings::CHistogram::NUM_BUCKETS - 1);
+}
+
+TEST(TickTimings, Percentiles)
+{
+	CTickTimings::CHistogram Histogram;
+	EXPECT_EQ(Histogram.Percentile(0.5f), 0);
+	for(int i = 1; i <= 1000; i++)
+		Histogram.Add(i * 10000);
+	EXPECT_EQ(Histogram.Count(), 1000);
+	EXPECT_EQ(Histogram.Max(), 10 * MS);
+	// within the bucket width
+	EXPECT_GE(Histogram.Percentile(0.5f), 5 * MS);
+	EXPECT_LE(Histogram.Percentile(0.5f), 5 * MS * 5 / 4);
+	EXPECT_GE(Histogram.Percentile(0.99f), 9900000);
+	EXPECT_LE(Histogram.Percentile(0.99f), 10 * MS);
+	EXPECT_EQ(Histogram.Percentile(1.0f), 10 * MS);
+}
+
+TEST(TickTimings, Windows)
+{
+	CTickTimings Timings;
+	Timings.SetSlowTickBudget(20 * MS);
+	int64_t Now = 0;
+	for(int i = 0; i < 50 * CTickTimings::WINDOW_SECONDS; i++)
+	{
+		Timings.Add(CTickTimings::PHASE_TICK, i % 100 == 0 ? 30 * MS : MS);
+		// phases that run several times or not at all
+		Timings.Add(CTickTimings::PHASE_NETWORK, MS / 4);
+		Timings.Add(CTickTimings::PHASE_NETWORK, MS / 4);
+		if(i % 2 == 0)
+			Timings.Add(CTickTimings::PHASE_SNAPSHOT, MS / 2);
+		EXPECT_EQ(Timings.EndTick(Now), i % 100 == 0);
+		Now += 20 * MS;
+	}
+	EXPECT_FALSE(Timings.HaveCompleteWindow());
+	EXPECT_EQ(Timings.Window(CTickTimings::PHASE_TICK).Count(), 3000);
+	EXPECT_EQ(Timings.Window(CTickTimings::PHASE_SNAPSHOT).Count(), 1500);
+	EXPECT_EQ(Timings.Window(CTickTimings::PHASE_GAME).Count(), 0);
+	EXPECT_EQ(Timings.LastTick(CTickTimings::PHASE_NETWORK), MS / 2);
+	EXPECT_EQ(Timings.LastTick(CTickTimings::PHASE_SNAPSHOT), -1);
+	EXPECT_EQ(Timings.WindowSlowTicks(), 30);
+
+	// the next tick starts a new minute
+	Timings.Add(CTickTimings::PHASE_TICK, MS);
+	EXPECT_FALSE(Timings.EndTick(Now));
+	EXPECT_TRUE(Timings.HaveCompleteWindow());
+	EXPECT_EQ(Timings.Window(CTickTimings::PHASE_TICK).Count(), 3000);
+	EXPECT_EQ(Timings.Window(CTickTimings::PHASE_TICK).Max(), 30 * MS);
+	EXPECT_LE(Timings.Window(CTickTimings::PHASE_TICK).Percentile(0.5f), MS * 5 / 4);
+	EXPECT_EQ(Timings.CurrentWindow(CTickTimings::PHASE_TICK).Count(), 1);
+	EXPECT_EQ(Timings.CurrentSlowTicks(), 0);
+
+	char aBuf[256];
+	Timings.FormatLastTick(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "tick=1.00ms");
+}
+
+TEST(TickTimings, WriteMetrics)
+{
+	CTestInfo Info;
+	CTickTimings Timings;
+	for(int i = 0; i < 10; i++)
+	{
+		Timings.Add(CTickTimings::PHASE_TICK, 2 * MS);
+		Timings.Add(CTickTimings::PHASE_GAME, MS);
+		Timings.EndTick(i * 20 * MS);
+	}
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	Timings.WriteMetrics(File);
+	io_close(File);
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	char *pData = io_read_all_str(File);
+	io_close(File);
+	fs_remove(Info.m_aFilename);
+	ASSERT_TRUE(pData);
+
+	EXPECT_FALSE(str_find(pData, "\r"));
+	EXPECT_TRUE(str_find(pData, "# TYPE ddnet_tick_phase_seconds summary\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_tick_phase_seconds{phase=\"tick\",quantile=\"0.5\"} 0.002000\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_tick_phase_seconds{phase=\"game\",quantile=\"0.99\"} 0.001000\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_tick_phase_seconds_sum{phase=\"tick\"} 0.020000\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_tick_phase_seconds_count{phase=\"game\"} 10\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_tick_phase_max_seconds{phase=\"tick\"} 0.002000\n"));
+	EXPECT_TRUE(str_find(pData, "\nddnet_slow_ticks_total 0\n"));
+	free(pData);
+}
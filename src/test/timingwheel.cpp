@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include <engine/shared/timingwheel.h>
+#include <game/prng.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+static const int NUM_TIMERS = 512;
+static const int64_t GRANULARITY = 10;
+
+// Checks that `Advance` fires exactly the timers a brute force sweep over
+// all timers finds, including timers far in the future that overflow the
+// levels and timers rescheduled while they fire.
+TEST(TimingWheel, MatchesBruteForce)
+{
+	auto pWheel = std::make_unique<CTimingWheel<NUM_TIMERS>>();
+	int64_t Now = 123456;
+	pWheel->Init(GRANULARITY, Now);
+
+	// -1 if not scheduled
+	std::vector<int64_t> vDeadlines(NUM_TIMERS, -1);
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x0123456789abcdefull, 0x1122334455667788ull};
+	Prng.Seed(aSeed);
+	auto RandomDeadline = [&]() -> int64_t {
+		switch(Prng.RandomBits() % 4)
+		{
+		case 0: return Now - (int64_t)(Prng.RandomBits() % 1000);
+		case 1: return Now + (int64_t)(Prng.RandomBits() % 1000);
+		case 2: return Now + (int64_t)(Prng.RandomBits() % 1000000);
+		default: return Now + (int64_t)(Prng.RandomBits() % 1000) * 1000000000;
+		}
+	};
+
+	for(int Round = 0; Round < 20000; Round++)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			int ID = Prng.RandomBits() % NUM_TIMERS;
+			if(Prng.RandomBits() % 8 == 0)
+			{
+				pWheel->Cancel(ID);
+				vDeadlines[ID] = -1;
+			}
+			else
+			{
+				vDeadlines[ID] = RandomDeadline();
+				pWheel->Schedule(ID, vDeadlines[ID]);
+			}
+		}
+
+		// mostly small steps, sometimes huge ones
+		Now += Prng.RandomBits() % 64 == 0 ? Prng.RandomBits() % 1000000 : Prng.RandomBits() % 50;
+
+		std::vector<int> vExpected;
+		for(int ID = 0; ID < NUM_TIMERS; ID++)
+		{
+			if(vDeadlines[ID] != -1 && vDeadlines[ID] / GRANULARITY < Now / GRANULARITY)
+				vExpected.push_back(ID);
+		}
+
+		std::vector<int> vFired;
+		pWheel->Advance(Now, [&](int ID) {
+			EXPECT_FALSE(pWheel->Scheduled(ID));
+			EXPECT_LT(vDeadlines[ID], Now);
+			vFired.push_back(ID);
+			vDeadlines[ID] = -1;
+			// reschedule some from the callback, after the current time
+			if(ID % 3 == 0)
+			{
+				vDeadlines[ID] = Now + 1 + Prng.RandomBits() % 10000;
+				pWheel->Schedule(ID, vDeadlines[ID]);
+			}
+		});
+		std::sort(vFired.begin(), vFired.end());
+		ASSERT_EQ(vFired, vExpected) << "round " << Round;
+
+		int NumScheduled = std::count_if(vDeadlines.begin(), vDeadlines.end(), [](int64_t Deadline) { return Deadline != -1; });
+		ASSERT_EQ(pWheel->NumScheduled(), NumScheduled);
+	}
+}
+
+TEST(TimingWheel, NeverEarly)
+{
+	auto pWheel = std::make_unique<CTimingWheel<1>>();
+	pWheel->Init(GRANULARITY, 0);
+	int NumFired = 0;
+	auto Count = [&](int ID) { NumFired++; };
+
+	pWheel->Schedule(0, 25);
+	pWheel->Advance(25, Count);
+	pWheel->Advance(29, Count);
+	EXPECT_EQ(NumFired, 0);
+	EXPECT_TRUE(pWheel->Scheduled(0));
+	pWheel->Advance(30, Count);
+	EXPECT_EQ(NumFired, 1);
+	EXPECT_FALSE(pWheel->Scheduled(0));
+
+	// deadlines in the past fire in the next `Advance`
+	pWheel->Schedule(0, 0);
+	pWheel->Advance(30, Count);
+	EXPECT_EQ(NumFired, 2);
+
+	pWheel->Schedule(0, 1000);
+	pWheel->Cancel(0);
+	pWheel->Advance(100000, Count);
+	EXPECT_EQ(NumFired, 2);
+	EXPECT_EQ(pWheel->NumScheduled(), 0);
+}
+
+// `Expired` may cancel or reschedule timers that are due in the same call,
+// both for due timers scheduled in the past and for timers of a slot
+TEST(TimingWheel, ChangeOthersFromCallback)
+{
+	for(int64_t Deadline : {0, 1005})
+	{
+		auto pWheel = std::make_unique<CTimingWheel<8>>();
+		pWheel->Init(GRANULARITY, 1000);
+		for(int ID = 0; ID < 8; ID++)
+			pWheel->Schedule(ID, Deadline);
+
+		std::vector<int> vFired;
+		pWheel->Advance(1010, [&](int ID) {
+			EXPECT_FALSE(pWheel->Scheduled(ID));
+			vFired.push_back(ID);
+			// the first fired timer cancels two and moves two others
+			if(vFired.size() == 1)
+			{
+				pWheel->Cancel((ID + 7) % 8);
+				pWheel->Cancel((ID + 6) % 8);
+				pWheel->Schedule((ID + 5) % 8, 5000);
+				pWheel->Schedule((ID + 4) % 8, 0);
+			}
+		});
+		EXPECT_EQ(vFired.size(), 4u);
+		EXPECT_EQ(pWheel->NumScheduled(), 2);
+
+		const int First = vFired[0];
+		for(int ID : vFired)
+			EXPECT_TRUE(ID == First || (ID - First + 8) % 8 < 4);
+		EXPECT_FALSE(pWheel->Scheduled((First + 7) % 8));
+		EXPECT_FALSE(pWheel->Scheduled((First + 6) % 8));
+		EXPECT_TRUE(pWheel->Scheduled((First + 5) % 8));
+		EXPECT_TRUE(pWheel->Scheduled((First + 4) % 8));
+
+		// the timer moved to the past fires in the next call, the other one later
+		vFired.clear();
+		pWheel->Advance(1010, [&](int ID) { vFired.push_back(ID); });
+		EXPECT_EQ(vFired, std::vector<int>{(First + 4) % 8});
+		vFired.clear();
+		pWheel->Advance(5010, [&](int ID) { vFired.push_back(ID); });
+		EXPECT_EQ(vFired, std::vector<int>{(First + 5) % 8});
+		EXPECT_EQ(pWheel->NumScheduled(), 0);
+	}
+}
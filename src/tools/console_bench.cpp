@@ -0,0 +1,88 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Executes a large generated server config, mostly setting config
+// variables like the configs of big servers do, and measures the lines
+// executed per second.
+
+static const char *const s_apIntVariables[] = {
+	"sv_max_clients",
+	"sv_port",
+	"sv_spectator_slots",
+	"sv_vote_kick_min",
+	"sv_chat_delay",
+	"sv_register",
+};
+
+static const char *const s_apStrVariables[] = {
+	"sv_name",
+	"sv_motd",
+	"sv_rcon_password",
+	"sv_map",
+	"password",
+};
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	int NumLines = 10000;
+	int NumRuns = 20;
+	for(int i = 1; i + 1 < argc; i += 2)
+	{
+		if(str_comp(argv[i], "-n") == 0)
+			NumLines = maximum(str_toint(argv[i + 1]), 1);
+		else if(str_comp(argv[i], "-r") == 0)
+			NumRuns = maximum(str_toint(argv[i + 1]), 1);
+		else
+		{
+			log_error("console_bench", "usage: %s [-n LINES] [-r RUNS]", argv[0]);
+			return -1;
+		}
+	}
+
+	std::unique_ptr<IKernel> pKernel(IKernel::Create());
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER).release();
+	IConfigManager *pConfigManager = CreateConfigManager();
+	pKernel->RegisterInterface(pConsole);
+	pKernel->RegisterInterface(pConfigManager);
+	pConfigManager->Init();
+	pConsole->Init();
+
+	std::vector<std::string> vLines;
+	char aLine[256];
+	for(int i = 0; i < NumLines; i++)
+	{
+		if(i % 2)
+			str_format(aLine, sizeof(aLine), "%s %d", s_apIntVariables[i / 2 % std::size(s_apIntVariables)], i % 64);
+		else
+			str_format(aLine, sizeof(aLine), "%s \"bench value %d\"", s_apStrVariables[i / 2 % std::size(s_apStrVariables)], i);
+		vLines.emplace_back(aLine);
+	}
+
+	int64_t Best = -1;
+	for(int Run = 0; Run < NumRuns; Run++)
+	{
+		int64_t Start = time_get();
+		for(const std::string &Line : vLines)
+			pConsole->ExecuteLine(Line.c_str());
+		int64_t Time = time_get() - Start;
+		if(Best < 0 || Time < Best)
+			Best = Time;
+	}
+
+	log_info("console_bench", "%d lines, best of %d runs: %.3fms, %.0f lines/s",
+		NumLines, NumRuns, Best * 1000.0 / time_freq(), NumLines * (double)time_freq() / Best);
+	pKernel->Shutdown();
+	return 0;
+}
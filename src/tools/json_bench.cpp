@@ -0,0 +1,360 @@
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/external/json-parser/json.h>
+#include <engine/shared/json.h>
+#include <engine/shared/serverinfo.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <string>
+
+// Parses a server list like the one from the master server with the
+// streaming parser, in pieces like they arrive from the download, and with
+// the DOM parser on the whole document. Reports the time and the peak
+// memory allocated while parsing, not counting the document itself. The
+// DOM parser additionally needs the whole document in memory, the
+// streaming one only the current piece.
+//
+// Without a file, a list with realistic client entries is generated.
+
+enum
+{
+	// Keeps the returned memory aligned for any type.
+	ALLOC_HEADER_SIZE = 16,
+};
+
+static std::atomic<size_t> s_Allocated(0);
+static std::atomic<size_t> s_PeakAllocated(0);
+static std::atomic<int64_t> s_NumAllocations(0);
+
+static void *TrackedAlloc(size_t Size)
+{
+	unsigned char *pBlock = (unsigned char *)malloc(Size + ALLOC_HEADER_SIZE);
+	if(!pBlock)
+		return nullptr;
+	mem_copy(pBlock, &Size, sizeof(Size));
+	size_t Allocated = s_Allocated += Size;
+	size_t Peak = s_PeakAllocated;
+	while(Allocated > Peak && !s_PeakAllocated.compare_exchange_weak(Peak, Allocated))
+	{
+	}
+	s_NumAllocations++;
+	return pBlock + ALLOC_HEADER_SIZE;
+}
+
+static void TrackedFree(void *pData)
+{
+	if(!pData)
+		return;
+	unsigned char *pBlock = (unsigned char *)pData - ALLOC_HEADER_SIZE;
+	size_t Size;
+	mem_copy(&Size, pBlock, sizeof(Size));
+	s_Allocated -= Size;
+	free(pBlock);
+}
+
+void *operator new(size_t Size)
+{
+	void *pData = TrackedAlloc(Size);
+	dbg_assert(pData != nullptr, "out of memory");
+	return pData;
+}
+
+void *operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void operator delete(void *pData) noexcept
+{
+	TrackedFree(pData);
+}
+
+void operator delete[](void *pData) noexcept
+{
+	TrackedFree(pData);
+}
+
+void operator delete(void *pData, size_t Size) noexcept
+{
+	TrackedFree(pData);
+}
+
+void operator delete[](void *pData, size_t Size) noexcept
+{
+	TrackedFree(pData);
+}
+
+static void *JsonAlloc(size_t Size, int Zero, void *pUser)
+{
+	void *pData = TrackedAlloc(Size);
+	if(pData && Zero)
+		mem_zero(pData, Size);
+	return pData;
+}
+
+static void JsonFree(void *pData, void *pUser)
+{
+	TrackedFree(pData);
+}
+
+static uint32_t s_Random = 1;
+static uint32_t Random()
+{
+	s_Random ^= s_Random << 13;
+	s_Random ^= s_Random >> 17;
+	s_Random ^= s_Random << 5;
+	return s_Random;
+}
+
+static const char *const s_apGameTypes[] = {"DDraceNetwork", "DDraceNetwork", "DDraceNetwork", "Gores", "Block", "CTF", "DM", "fng2", "iCTF", "zCatch"};
+static const char *const s_apMaps[] = {"Kobra 4", "Multeasymap", "Sunny Side Up", "Tutorial", "Grandma", "Back in Time 3", "ctf5", "Skychase", "Stronghold", "Lazy"};
+static const char *const s_apSkins[] = {"default", "santa_default", "greyfox", "Rudolph", "coala_bluekitty", "x_ninja", "nanas", "pinky", "bluestripe", "saddo"};
+static const char *const s_apLocations[] = {"eu:de", "eu:fr", "eu:pl", "na:us", "as:cn", "as:kr", "sa:br", "af:za", "oc:au", "eu:ru"};
+
+static void RandomName(char *pName, int Length)
+{
+	static const char CHARS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-.";
+	for(int i = 0; i < Length; i++)
+		pName[i] = CHARS[Random() % (sizeof(CHARS) - 1)];
+	pName[Length] = '\0';
+}
+
+static std::string GenerateServerList(int NumServers, int *pNumClients)
+{
+	std::string Document = "{\"servers\":[";
+	*pNumClients = 0;
+	char aBuf[1024];
+	for(int i = 0; i < NumServers; i++)
+	{
+		// Most servers are empty, a few are full.
+		int MaxClients = Random() % 4 == 0 ? 16 : 64;
+		int NumClients = 0;
+		if(Random() % 5 < 2)
+			NumClients = minimum(MaxClients, 1 + (int)(Random() % (Random() % 8 == 0 ? MaxClients : 8)));
+		*pNumClients += NumClients;
+
+		char aName[32];
+		RandomName(aName, 8 + Random() % 20);
+		str_format(aBuf, sizeof(aBuf), "%s{\"addresses\":[\"tw-0.6+udp://%d.%d.%d.%d:%d\",\"tw-0.7+udp://%d.%d.%d.%d:%d\"],\"location\":\"%s\",\"info\":{\"max_clients\":%d,\"max_players\":%d,\"passworded\":%s,\"game_type\":\"%s\",\"name\":\"DDNet %s\",\"map\":{\"name\":\"%s\",\"sha256\":\"%08x%08x%08x%08x%08x%08x%08x%08x\",\"size\":%d},\"version\":\"0.6.4, 16.7.2\",\"clients\":[",
+			i > 0 ? "," : "",
+			i >> 8 & 255, i & 255, 1, 2, 8303 + i % 10,
+			i >> 8 & 255, i & 255, 1, 2, 8303 + i % 10,
+			s_apLocations[Random() % std::size(s_apLocations)],
+			MaxClients, MaxClients, Random() % 20 == 0 ? "true" : "false",
+			s_apGameTypes[Random() % std::size(s_apGameTypes)], aName,
+			s_apMaps[Random() % std::size(s_apMaps)],
+			Random(), Random(), Random(), Random(), Random(), Random(), Random(), Random(),
+			(int)(Random() % 500000));
+		Document += aBuf;
+
+		for(int c = 0; c < NumClients; c++)
+		{
+			char aClientName[16];
+			char aClan[12];
+			RandomName(aClientName, 1 + Random() % 15);
+			RandomName(aClan, Random() % 3 == 0 ? 0 : 1 + Random() % 11);
+			str_format(aBuf, sizeof(aBuf), "%s{\"name\":\"%s\",\"clan\":\"%s\",\"country\":%d,\"score\":%d,\"is_player\":%s,\"skin\":{\"name\":\"%s\",\"color_body\":%d,\"color_feet\":%d},\"afk\":%s,\"team\":%d}",
+				c > 0 ? "," : "",
+				aClientName, aClan, (int)(Random() % 1000) - 1, Random() % 2 ? -9999 : -(int)(Random() % 100000),
+				Random() % 10 == 0 ? "false" : "true",
+				s_apSkins[Random() % std::size(s_apSkins)], (int)(Random() % 0x1000000), (int)(Random() % 0x1000000),
+				Random() % 4 == 0 ? "true" : "false", (int)(Random() % 64));
+			Document += aBuf;
+		}
+		Document += "]}}";
+	}
+	Document += "]}";
+	return Document;
+}
+
+class CCountingStream : public CJsonStreamParser
+{
+protected:
+	bool OnArrayElement(const char *pKey, const json_value *pValue) override
+	{
+		if(str_comp(pKey, "servers") == 0)
+		{
+			CServerInfo2 Info;
+			if(!CServerInfo2::FromJson(&Info, json_object_get(pValue, "info")))
+			{
+				m_NumServers++;
+				m_NumClients += Info.m_NumClients;
+			}
+		}
+		return false;
+	}
+
+public:
+	CCountingStream()
+	{
+		m_Settings.mem_alloc = JsonAlloc;
+		m_Settings.mem_free = JsonFree;
+	}
+
+	int m_NumServers = 0;
+	int m_NumClients = 0;
+};
+
+struct SResult
+{
+	int64_t m_Time;
+	size_t m_PeakAllocated;
+	int64_t m_NumAllocations;
+	int m_NumServers;
+	int m_NumClients;
+};
+
+static void BeginMeasure()
+{
+	s_PeakAllocated = s_Allocated.load();
+	s_NumAllocations = 0;
+}
+
+static void EndMeasure(SResult *pResult, size_t Baseline, int64_t Start)
+{
+	pResult->m_Time = time_get() - Start;
+	pResult->m_PeakAllocated = s_PeakAllocated - Baseline;
+	pResult->m_NumAllocations = s_NumAllocations;
+}
+
+static bool ParseStream(const std::string &Document, int PieceSize, SResult *pResult)
+{
+	size_t Baseline = s_Allocated;
+	BeginMeasure();
+	int64_t Start = time_get();
+	bool Error = false;
+	{
+		CCountingStream Parser;
+		for(size_t Offset = 0; Offset < Document.size() && !Error; Offset += PieceSize)
+		{
+			Error = Parser.Feed(Document.data() + Offset, minimum<size_t>(PieceSize, Document.size() - Offset));
+		}
+		Error = Error || Parser.Finish();
+		pResult->m_NumServers = Parser.m_NumServers;
+		pResult->m_NumClients = Parser.m_NumClients;
+	}
+	EndMeasure(pResult, Baseline, Start);
+	return Error;
+}
+
+static bool ParseDom(const std::string &Document, SResult *pResult)
+{
+	size_t Baseline = s_Allocated;
+	BeginMeasure();
+	int64_t Start = time_get();
+	json_settings Settings = {};
+	Settings.mem_alloc = JsonAlloc;
+	Settings.mem_free = JsonFree;
+	json_value *pJson = json_parse_ex(&Settings, Document.data(), Document.size(), nullptr);
+	if(!pJson)
+	{
+		return true;
+	}
+	pResult->m_NumServers = 0;
+	pResult->m_NumClients = 0;
+	const json_value &Servers = (*pJson)["servers"];
+	for(unsigned i = 0; i < Servers.u.array.length; i++)
+	{
+		CServerInfo2 Info;
+		if(!CServerInfo2::FromJson(&Info, json_object_get(&Servers[i], "info")))
+		{
+			pResult->m_NumServers++;
+			pResult->m_NumClients += Info.m_NumClients;
+		}
+	}
+	json_value_free_ex(&Settings, pJson);
+	EndMeasure(pResult, Baseline, Start);
+	return false;
+}
+
+static void Report(const char *pName, const SResult &Result, size_t DocumentSize)
+{
+	log_info("json_bench", "%-6s %8.3fms %7.1fMB/s  peak %8.1fKiB  %8lld allocations  %d servers, %d clients",
+		pName, Result.m_Time * 1000.0 / time_freq(), DocumentSize / (1024.0 * 1024.0) / maximum(Result.m_Time / (double)time_freq(), 1e-9),
+		Result.m_PeakAllocated / 1024.0, (long long)Result.m_NumAllocations, Result.m_NumServers, Result.m_NumClients);
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	const char *pFilename = nullptr;
+	int NumServers = 2000;
+	int PieceSize = 16384;
+	int NumRuns = 5;
+	for(int i = 1; i + 1 < argc; i += 2)
+	{
+		if(str_comp(argv[i], "-f") == 0)
+			pFilename = argv[i + 1];
+		else if(str_comp(argv[i], "-s") == 0)
+			NumServers = maximum(str_toint(argv[i + 1]), 1);
+		else if(str_comp(argv[i], "-p") == 0)
+			PieceSize = maximum(str_toint(argv[i + 1]), 1);
+		else if(str_comp(argv[i], "-r") == 0)
+			NumRuns = maximum(str_toint(argv[i + 1]), 1);
+		else
+		{
+			log_error("json_bench", "usage: %s [-f SERVERS_JSON] [-s SERVERS] [-p PIECE_SIZE] [-r RUNS]", argv[0]);
+			return -1;
+		}
+	}
+
+	std::string Document;
+	if(pFilename)
+	{
+		IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+		if(!File)
+		{
+			log_error("json_bench", "failed to open '%s'", pFilename);
+			return -1;
+		}
+		void *pData;
+		unsigned DataSize;
+		io_read_all(File, &pData, &DataSize);
+		io_close(File);
+		Document.assign((const char *)pData, DataSize);
+		free(pData);
+		log_info("json_bench", "read %s, %.1fKiB", pFilename, Document.size() / 1024.0);
+	}
+	else
+	{
+		int NumClients;
+		Document = GenerateServerList(NumServers, &NumClients);
+		log_info("json_bench", "generated %d servers with %d clients, %.1fKiB", NumServers, NumClients, Document.size() / 1024.0);
+	}
+
+	// Keep the fastest run of each.
+	SResult Stream, Dom;
+	for(int Run = 0; Run < NumRuns; Run++)
+	{
+		SResult Result;
+		if(ParseStream(Document, PieceSize, &Result))
+		{
+			log_error("json_bench", "streaming parser failed");
+			return 1;
+		}
+		if(Run == 0 || Result.m_Time < Stream.m_Time)
+			Stream = Result;
+		if(ParseDom(Document, &Result))
+		{
+			log_error("json_bench", "DOM parser failed");
+			return 1;
+		}
+		if(Run == 0 || Result.m_Time < Dom.m_Time)
+			Dom = Result;
+	}
+	Report("stream", Stream, Document.size());
+	Report("dom", Dom, Document.size());
+	if(Stream.m_NumServers != Dom.m_NumServers || Stream.m_NumClients != Dom.m_NumClients)
+	{
+		log_error("json_bench", "parsers disagree");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,620 @@
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/message.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/protocol_ex.h>
+#include <engine/shared/uuid_manager.h>
+
+#include <game/generated/protocol.h>
+#include <game/prng.h>
+#include <game/server/teehistorian.h>
+#include <game/version.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Connects many clients to a server, plays scripted inputs and reports the
+// snapshot bandwidth, round trip time and snapshot arrival jitter of every
+// client.
+//
+// Only 0.6/DDNet connections are made, `CNetClient` doesn't implement the
+// 0.7 handshake. All connections come from the same address, so the server
+// has to allow that, e.g. with `sv_max_clients_per_ip 64`.
+//
+// Snapshots are acknowledged as soon as all their parts arrived, without
+// unpacking them, so that the server sends deltas like to real clients.
+
+using namespace std::chrono_literals;
+
+static const int64_t TICK_NS = 1000000000 / SERVER_TICK_SPEED;
+
+enum
+{
+	INPUT_WALK,
+	INPUT_HOOK,
+	INPUT_REPLAY,
+};
+
+class CInputStreams
+{
+	struct CEntry
+	{
+		int m_Tick;
+		CNetObj_PlayerInput m_Input;
+	};
+	std::vector<std::vector<CEntry>> m_vvStreams;
+
+public:
+	// one stream per recorded player, returns `true` on error
+	bool Load(const char *pFilename)
+	{
+		IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+		if(!File)
+		{
+			log_error("loadgen", "failed to open '%s'", pFilename);
+			return true;
+		}
+		CTeeHistorianReader Reader;
+		if(Reader.Open(File))
+		{
+			log_error("loadgen", "failed to read '%s'", pFilename);
+			return true;
+		}
+		std::vector<CEntry> avStreams[MAX_CLIENTS];
+		CTeeHistorianReader::CChunk Chunk;
+		int Result;
+		while((Result = Reader.Next(&Chunk)) == CTeeHistorianReader::READ_CHUNK)
+		{
+			if(Chunk.m_Type == TEEHISTORIAN_INPUT_DIFF || Chunk.m_Type == TEEHISTORIAN_INPUT_NEW)
+				avStreams[Chunk.m_ClientID].push_back({Chunk.m_Tick, Reader.Player(Chunk.m_ClientID).m_Input});
+		}
+		if(Result == CTeeHistorianReader::READ_ERROR)
+			log_warn("loadgen", "'%s' is damaged, using the inputs read so far", pFilename);
+		for(auto &vStream : avStreams)
+		{
+			if(vStream.size() >= 2)
+				m_vvStreams.push_back(std::move(vStream));
+		}
+		if(m_vvStreams.empty())
+		{
+			log_error("loadgen", "'%s' contains no inputs", pFilename);
+			return true;
+		}
+		log_info("loadgen", "loaded %d input streams from '%s'", (int)m_vvStreams.size(), pFilename);
+		return false;
+	}
+
+	// Inputs of a stream, looped. `pCursor` remembers the position.
+	void Get(int Stream, int Tick, int *pCursor, CNetObj_PlayerInput *pInput) const
+	{
+		const std::vector<CEntry> &vStream = m_vvStreams[Stream % m_vvStreams.size()];
+		int First = vStream.front().m_Tick;
+		int StreamTick = First + Tick % (vStream.back().m_Tick - First + 1);
+		if(*pCursor >= (int)vStream.size() || vStream[*pCursor].m_Tick > StreamTick)
+			*pCursor = 0;
+		while(*pCursor + 1 < (int)vStream.size() && vStream[*pCursor + 1].m_Tick <= StreamTick)
+			(*pCursor)++;
+		*pInput = vStream[*pCursor].m_Input;
+	}
+};
+
+class CLoadClient
+{
+public:
+	enum
+	{
+		STATE_CONNECTING,
+		STATE_LOADING,
+		STATE_READY,
+		STATE_INGAME,
+		STATE_OFFLINE,
+	};
+
+	int m_Index;
+	int m_State = STATE_CONNECTING;
+
+	int64_t m_ConnectTime = 0;
+	int64_t m_InGameTime = 0;
+	int m_MapSize = 0;
+	int m_MapReceived = 0;
+
+	int64_t m_NumSnapshots = 0;
+	int64_t m_SnapshotBytes = 0;
+	int64_t m_NumRtt = 0;
+	int64_t m_RttSum = 0;
+	int64_t m_RttMax = 0;
+	// interarrival jitter of the snapshots like RFC 3550, nanoseconds
+	int64_t m_Jitter = 0;
+	int64_t m_NumInputTimings = 0;
+	int64_t m_InputTimeLeftSum = 0;
+
+	CLoadClient(int Index, int InputMode, const CInputStreams *pStreams) :
+		m_Index(Index), m_InputMode(InputMode), m_pStreams(pStreams)
+	{
+		uint64_t aSeed[2] = {(uint64_t)Index + 1, 0x6c6f616467656e};
+		m_Prng.Seed(aSeed);
+	}
+	~CLoadClient() { m_NetClient.Close(); }
+
+	bool Connect(const NETADDR &Addr, const char *pPassword)
+	{
+		NETADDR BindAddr;
+		mem_zero(&BindAddr, sizeof(BindAddr));
+		BindAddr.type = Addr.type;
+		if(!m_NetClient.Open(BindAddr))
+			return true;
+		m_pPassword = pPassword;
+		m_ConnectTime = time_get_nanoseconds().count();
+		m_NetClient.Connect(&Addr, 1);
+		return false;
+	}
+
+	void Disconnect()
+	{
+		if(m_State != STATE_OFFLINE)
+			m_NetClient.Disconnect("load test finished");
+	}
+
+	void Update(int64_t Now)
+	{
+		if(m_State == STATE_OFFLINE)
+			return;
+
+		m_NetClient.Update();
+		CNetChunk Packet;
+		while(m_NetClient.Recv(&Packet))
+		{
+			if(!(Packet.m_Flags & NETSENDFLAG_CONNLESS))
+				OnPacket(&Packet, Now);
+		}
+
+		if(m_NetClient.State() == NETSTATE_OFFLINE)
+		{
+			log_warn("loadgen", "client %d disconnected: %s", m_Index, m_NetClient.ErrorString());
+			m_State = STATE_OFFLINE;
+			return;
+		}
+		if(m_State == STATE_CONNECTING && m_NetClient.State() == NETSTATE_ONLINE)
+		{
+			SendInfo();
+			m_State = STATE_LOADING;
+		}
+		if(m_State == STATE_INGAME && m_AckGameTick > 0)
+		{
+			if(Now >= m_NextInput)
+			{
+				SendInput(Now);
+				m_NextInput = maximum(m_NextInput + TICK_NS, Now - TICK_NS);
+			}
+			if(!m_PingSent && Now >= m_NextPing)
+			{
+				CMsgPacker Msg(NETMSG_PING, true);
+				SendMsg(&Msg, MSGFLAG_FLUSH);
+				m_PingSent = Now;
+			}
+		}
+	}
+
+	int64_t InGameNanoseconds(int64_t Now) const { return m_InGameTime ? Now - m_InGameTime : 0; }
+
+private:
+	CNetClient m_NetClient;
+	const char *m_pPassword = "";
+	CPrng m_Prng;
+	int m_InputMode;
+	const CInputStreams *m_pStreams;
+
+	int m_MapChunk = 0;
+	int m_MapCrc = 0;
+
+	int m_AckGameTick = -1;
+	int64_t m_AckTime = 0;
+	int m_SnapPartsTick = -1;
+	uint64_t m_SnapParts = 0;
+	int64_t m_LastTransit = 0;
+
+	int m_InputTick = 0;
+	int64_t m_NextInput = 0;
+	int m_StreamCursor = 0;
+	CNetObj_PlayerInput m_Input = {0};
+
+	int64_t m_PingSent = 0;
+	int64_t m_NextPing = 0;
+
+	void SendMsg(CMsgPacker *pMsg, int Flags)
+	{
+		CPacker Packer;
+		Packer.Reset();
+		if(pMsg->m_MsgID < OFFSET_UUID)
+		{
+			Packer.AddInt((pMsg->m_MsgID << 1) | (pMsg->m_System ? 1 : 0));
+		}
+		else
+		{
+			Packer.AddInt(pMsg->m_System ? 1 : 0);
+			g_UuidManager.PackUuid(pMsg->m_MsgID, &Packer);
+		}
+		Packer.AddRaw(pMsg->Data(), pMsg->Size());
+
+		CNetChunk Packet;
+		mem_zero(&Packet, sizeof(Packet));
+		Packet.m_ClientID = 0;
+		Packet.m_pData = Packer.Data();
+		Packet.m_DataSize = Packer.Size();
+		if(Flags & MSGFLAG_VITAL)
+			Packet.m_Flags |= NETSENDFLAG_VITAL;
+		if(Flags & MSGFLAG_FLUSH)
+			Packet.m_Flags |= NETSENDFLAG_FLUSH;
+		m_NetClient.Send(&Packet);
+	}
+
+	void SendInfo()
+	{
+		CUuid ConnectionID = RandomUuid();
+		CMsgPacker MsgVer(NETMSG_CLIENTVER, true);
+		MsgVer.AddRaw(&ConnectionID, sizeof(ConnectionID));
+		MsgVer.AddInt(CLIENT_VERSIONNR);
+		MsgVer.AddString(GAME_NAME " " GAME_RELEASE_VERSION " (loadgen)", 0);
+		SendMsg(&MsgVer, MSGFLAG_VITAL);
+
+		CMsgPacker Msg(NETMSG_INFO, true);
+		Msg.AddString(GAME_NETVERSION, 128);
+		Msg.AddString(m_pPassword, 128);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendMapRequest()
+	{
+		CMsgPacker Msg(NETMSG_REQUEST_MAP_DATA, true);
+		Msg.AddInt(m_MapChunk);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+	}
+
+	void SendReady()
+	{
+		CMsgPacker Msg(NETMSG_READY, true);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+		m_State = STATE_READY;
+	}
+
+	void EnterGame(int64_t Now)
+	{
+		char aName[16];
+		str_format(aName, sizeof(aName), "load %d", m_Index);
+		CNetMsg_Cl_StartInfo Info;
+		Info.m_pName = aName;
+		Info.m_pClan = "";
+		Info.m_Country = -1;
+		Info.m_pSkin = "default";
+		Info.m_UseCustomColor = 0;
+		Info.m_ColorBody = 0;
+		Info.m_ColorFeet = 0;
+		CMsgPacker InfoPacker(&Info);
+		Info.Pack(&InfoPacker);
+		SendMsg(&InfoPacker, MSGFLAG_VITAL);
+
+		CMsgPacker Msg(NETMSG_ENTERGAME, true);
+		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH);
+		m_State = STATE_INGAME;
+		m_InGameTime = Now;
+		m_NextPing = Now + 1000000000;
+	}
+
+	void NextInput()
+	{
+		switch(m_InputMode)
+		{
+		case INPUT_WALK:
+			if(m_Prng.RandomBits() % 50 == 0)
+				m_Input.m_Direction = (int)(m_Prng.RandomBits() % 3) - 1;
+			m_Input.m_Jump = m_Prng.RandomBits() % 40 == 0;
+			m_Input.m_TargetX = clamp(m_Input.m_TargetX + (int)(m_Prng.RandomBits() % 21) - 10, -200, 200);
+			m_Input.m_TargetY = clamp(m_Input.m_TargetY + (int)(m_Prng.RandomBits() % 21) - 10, -200, 200);
+			break;
+		case INPUT_HOOK:
+			m_Input.m_Hook = (m_InputTick / 4) % 2;
+			m_Input.m_Direction = (m_InputTick / 100) % 2 ? 1 : -1;
+			m_Input.m_TargetX = (int)(200 * cosf(m_InputTick / 10.0f));
+			m_Input.m_TargetY = (int)(200 * sinf(m_InputTick / 10.0f));
+			break;
+		case INPUT_REPLAY:
+			m_pStreams->Get(m_Index, m_InputTick, &m_StreamCursor, &m_Input);
+			break;
+		}
+		if(m_Input.m_TargetX == 0 && m_Input.m_TargetY == 0)
+			m_Input.m_TargetX = 1;
+		m_Input.m_PlayerFlags = PLAYERFLAG_PLAYING;
+		m_InputTick++;
+	}
+
+	void SendInput(int64_t Now)
+	{
+		NextInput();
+
+		// aim for the tick the input arrives at, like the prediction of
+		// the client does
+		int64_t Latency = m_NumRtt ? m_RttSum / m_NumRtt / 2 : 0;
+		int PredTick = m_AckGameTick + (Now - m_AckTime + Latency) / TICK_NS + 2;
+
+		CMsgPacker Msg(NETMSG_INPUT, true);
+		Msg.AddInt(m_AckGameTick);
+		Msg.AddInt(PredTick);
+		Msg.AddInt(sizeof(m_Input));
+		const int *pData = (const int *)&m_Input;
+		for(unsigned i = 0; i < sizeof(m_Input) / sizeof(int); i++)
+			Msg.AddInt(pData[i]);
+		SendMsg(&Msg, MSGFLAG_FLUSH);
+	}
+
+	void OnSnapshot(int GameTick, int64_t Now)
+	{
+		m_NumSnapshots++;
+		int64_t Transit = Now - GameTick * TICK_NS;
+		if(m_AckGameTick > 0)
+			m_Jitter += (absolute(Transit - m_LastTransit) - m_Jitter) / 16;
+		m_LastTransit = Transit;
+		m_AckGameTick = GameTick;
+		m_AckTime = Now;
+		if(!m_NextInput)
+			m_NextInput = Now;
+	}
+
+	void OnPacket(CNetChunk *pPacket, int64_t Now)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pPacket->m_pData, pPacket->m_DataSize);
+		CMsgPacker Packer(NETMSG_EX, true);
+
+		int Msg;
+		bool Sys;
+		CUuid Uuid;
+		int Result = UnpackMessageID(&Msg, &Sys, &Uuid, &Unpacker, &Packer);
+		if(Result == UNPACKMESSAGE_ERROR)
+			return;
+		else if(Result == UNPACKMESSAGE_ANSWER)
+			SendMsg(&Packer, MSGFLAG_VITAL);
+		if(!Sys)
+			return;
+
+		if(Msg == NETMSG_MAP_CHANGE && (pPacket->m_Flags & NET_CHUNKFLAG_VITAL))
+		{
+			Unpacker.GetString();
+			m_MapCrc = Unpacker.GetInt();
+			m_MapSize = Unpacker.GetInt();
+			if(Unpacker.Error())
+				return;
+			m_MapChunk = 0;
+			m_MapReceived = 0;
+			m_AckGameTick = -1;
+			m_NextInput = 0;
+			m_State = STATE_LOADING;
+			SendMapRequest();
+		}
+		else if(Msg == NETMSG_MAP_DATA && m_State == STATE_LOADING)
+		{
+			int Last = Unpacker.GetInt();
+			int MapCrc = Unpacker.GetInt();
+			int Chunk = Unpacker.GetInt();
+			int Size = Unpacker.GetInt();
+			Unpacker.GetRaw(Size);
+			if(Unpacker.Error() || Size <= 0 || MapCrc != m_MapCrc || Chunk != m_MapChunk)
+				return;
+			m_MapReceived += Size;
+			if(Last)
+			{
+				if(m_MapReceived != m_MapSize)
+					log_warn("loadgen", "client %d received %d of %d map bytes", m_Index, m_MapReceived, m_MapSize);
+				SendReady();
+			}
+			else
+			{
+				m_MapChunk++;
+				SendMapRequest();
+			}
+		}
+		else if(Msg == NETMSG_CON_READY && (pPacket->m_Flags & NET_CHUNKFLAG_VITAL) && m_State == STATE_READY)
+		{
+			EnterGame(Now);
+		}
+		else if(Msg == NETMSG_PING)
+		{
+			CMsgPacker MsgP(NETMSG_PING_REPLY, true);
+			SendMsg(&MsgP, MSGFLAG_FLUSH);
+		}
+		else if(Msg == NETMSG_PING_REPLY && m_PingSent)
+		{
+			int64_t Rtt = Now - m_PingSent;
+			m_NumRtt++;
+			m_RttSum += Rtt;
+			m_RttMax = maximum(m_RttMax, Rtt);
+			m_PingSent = 0;
+			m_NextPing = Now + 1000000000;
+		}
+		else if(Msg == NETMSG_INPUTTIMING)
+		{
+			Unpacker.GetInt();
+			int TimeLeft = Unpacker.GetInt();
+			if(!Unpacker.Error())
+			{
+				m_NumInputTimings++;
+				m_InputTimeLeftSum += TimeLeft;
+			}
+		}
+		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+		{
+			int GameTick = Unpacker.GetInt();
+			Unpacker.GetInt();
+			int NumParts = 1;
+			int Part = 0;
+			if(Msg == NETMSG_SNAP)
+			{
+				NumParts = Unpacker.GetInt();
+				Part = Unpacker.GetInt();
+			}
+			if(Unpacker.Error() || NumParts < 1 || NumParts > 64 || Part < 0 || Part >= NumParts)
+				return;
+			m_SnapshotBytes += pPacket->m_DataSize;
+			if(GameTick <= m_AckGameTick)
+				return;
+
+			if(m_SnapPartsTick != GameTick)
+			{
+				m_SnapPartsTick = GameTick;
+				m_SnapParts = 0;
+			}
+			m_SnapParts |= (uint64_t)1 << Part;
+			if(m_SnapParts == (NumParts == 64 ? ~(uint64_t)0 : ((uint64_t)1 << NumParts) - 1))
+				OnSnapshot(GameTick, Now);
+		}
+	}
+};
+
+static void PrintSummary(const std::vector<std::unique_ptr<CLoadClient>> &vpClients, int64_t Now, int64_t Interval, std::vector<int64_t> *pvLastBytes)
+{
+	int NumInGame = 0;
+	int64_t Bytes = 0;
+	int64_t RttSum = 0, NumRtt = 0, RttMax = 0;
+	int64_t JitterSum = 0, JitterMax = 0;
+	for(unsigned i = 0; i < vpClients.size(); i++)
+	{
+		const CLoadClient &Client = *vpClients[i];
+		Bytes += Client.m_SnapshotBytes - (*pvLastBytes)[i];
+		(*pvLastBytes)[i] = Client.m_SnapshotBytes;
+		if(Client.m_State != CLoadClient::STATE_INGAME)
+			continue;
+		NumInGame++;
+		RttSum += Client.m_RttSum;
+		NumRtt += Client.m_NumRtt;
+		RttMax = maximum(RttMax, Client.m_RttMax);
+		JitterSum += Client.m_Jitter;
+		JitterMax = maximum(JitterMax, Client.m_Jitter);
+	}
+	double Kbits = Bytes * 8 / 1000.0 / (Interval / 1000000000.0);
+	log_info("loadgen", "%d/%d in game, snapshots %.1f kbit/s per client (%.2f Mbit/s total), rtt avg %.2fms max %.2fms, jitter avg %.2fms max %.2fms",
+		NumInGame, (int)vpClients.size(), NumInGame ? Kbits / NumInGame : 0.0, Kbits / 1000.0,
+		NumRtt ? RttSum / (double)NumRtt / 1000000.0 : 0.0, RttMax / 1000000.0,
+		NumInGame ? JitterSum / (double)NumInGame / 1000000.0 : 0.0, JitterMax / 1000000.0);
+}
+
+static void PrintClients(const std::vector<std::unique_ptr<CLoadClient>> &vpClients, int64_t Now)
+{
+	static const char *const s_apStates[] = {"connecting", "loading", "ready", "ingame", "offline"};
+	log_info("loadgen", "client  state       join_ms  map_kib  snaps/s  snap_kbit/s  rtt_avg_ms  rtt_max_ms  jitter_ms  input_left_ms");
+	for(const auto &pClient : vpClients)
+	{
+		const CLoadClient &Client = *pClient;
+		double Seconds = maximum(Client.InGameNanoseconds(Now) / 1000000000.0, 0.001);
+		log_info("loadgen", "%6d  %-10s  %7.0f  %7d  %7.1f  %11.1f  %10.2f  %10.2f  %9.2f  %13.1f",
+			Client.m_Index, s_apStates[Client.m_State],
+			Client.m_InGameTime ? (Client.m_InGameTime - Client.m_ConnectTime) / 1000000.0 : -1.0,
+			Client.m_MapReceived / 1024,
+			Client.m_NumSnapshots / Seconds, Client.m_SnapshotBytes * 8 / 1000.0 / Seconds,
+			Client.m_NumRtt ? Client.m_RttSum / (double)Client.m_NumRtt / 1000000.0 : 0.0, Client.m_RttMax / 1000000.0,
+			Client.m_Jitter / 1000000.0,
+			Client.m_NumInputTimings ? Client.m_InputTimeLeftSum / (double)Client.m_NumInputTimings : 0.0);
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	int NumClients = 16;
+	int Seconds = 60;
+	int ConnectsPerSecond = 10;
+	int InputMode = INPUT_WALK;
+	const char *pTeeHistorian = nullptr;
+	const char *pPassword = "";
+	int Arg = 1;
+	for(; Arg + 1 < argc && argv[Arg][0] == '-'; Arg += 2)
+	{
+		if(str_comp(argv[Arg], "-n") == 0)
+			NumClients = maximum(str_toint(argv[Arg + 1]), 1);
+		else if(str_comp(argv[Arg], "-t") == 0)
+			Seconds = maximum(str_toint(argv[Arg + 1]), 1);
+		else if(str_comp(argv[Arg], "-c") == 0)
+			ConnectsPerSecond = maximum(str_toint(argv[Arg + 1]), 1);
+		else if(str_comp(argv[Arg], "-i") == 0 && str_comp(argv[Arg + 1], "walk") == 0)
+			InputMode = INPUT_WALK;
+		else if(str_comp(argv[Arg], "-i") == 0 && str_comp(argv[Arg + 1], "hook") == 0)
+			InputMode = INPUT_HOOK;
+		else if(str_comp(argv[Arg], "-r") == 0)
+		{
+			InputMode = INPUT_REPLAY;
+			pTeeHistorian = argv[Arg + 1];
+		}
+		else if(str_comp(argv[Arg], "-p") == 0)
+			pPassword = argv[Arg + 1];
+		else
+			break;
+	}
+	if(Arg + 1 != argc)
+	{
+		log_error("loadgen", "usage: %s [-n CLIENTS] [-t SECONDS] [-c CONNECTS_PER_SECOND] [-i walk|hook] [-r TEEHISTORIAN] [-p PASSWORD] server[:port]", argv[0]);
+		return -1;
+	}
+
+	secure_random_init();
+	net_init();
+	CNetBase::Init();
+
+	NETADDR Addr;
+	if(net_host_lookup(argv[Arg], &Addr, NETTYPE_ALL))
+	{
+		log_error("loadgen", "host lookup failed");
+		return -1;
+	}
+	if(Addr.port == 0)
+		Addr.port = 8303;
+	if(NumClients > MAX_CLIENTS)
+		log_warn("loadgen", "a server has at most %d slots", (int)MAX_CLIENTS);
+
+	CInputStreams Streams;
+	if(pTeeHistorian && Streams.Load(pTeeHistorian))
+		return -1;
+
+	std::vector<std::unique_ptr<CLoadClient>> vpClients;
+	std::vector<int64_t> vLastBytes(NumClients, 0);
+	const int64_t Start = time_get_nanoseconds().count();
+	const int64_t End = Start + Seconds * (int64_t)1000000000;
+	const int64_t SummaryInterval = 5 * (int64_t)1000000000;
+	int64_t NextSummary = Start + SummaryInterval;
+	int64_t Now = Start;
+	while(Now < End)
+	{
+		// connect gradually, the server limits new connections
+		while((int)vpClients.size() < NumClients && (int64_t)vpClients.size() * 1000000000 / ConnectsPerSecond <= Now - Start)
+		{
+			vpClients.push_back(std::make_unique<CLoadClient>((int)vpClients.size(), InputMode, &Streams));
+			if(vpClients.back()->Connect(Addr, pPassword))
+			{
+				log_error("loadgen", "failed to open a socket");
+				return -1;
+			}
+		}
+
+		for(auto &pClient : vpClients)
+			pClient->Update(Now);
+
+		if(Now >= NextSummary)
+		{
+			PrintSummary(vpClients, Now, SummaryInterval, &vLastBytes);
+			NextSummary += SummaryInterval;
+		}
+
+		std::this_thread::sleep_for(1ms);
+		Now = time_get_nanoseconds().count();
+	}
+
+	PrintClients(vpClients, Now);
+	for(auto &pClient : vpClients)
+		pClient->Disconnect();
+	return 0;
+}
@@ -0,0 +1,207 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/shared/config.h>
+#include <engine/shared/network.h>
+
+#include <memory>
+#include <vector>
+
+// Measures how many packets per second `CNetServer::Recv` processes with
+// connected clients sending packets and another socket sending junk, all
+// over localhost. With `-t 1`, the packets are received by the network
+// thread and only the time `Recv` spends on the main thread is measured.
+
+static int s_NumConnected = 0;
+
+static int NewClient(int ClientID, void *pUser, bool Sixup)
+{
+	s_NumConnected++;
+	return 0;
+}
+
+static int NewClientNoAuth(int ClientID, void *pUser)
+{
+	s_NumConnected++;
+	return 0;
+}
+
+static int ClientRejoin(int ClientID, void *pUser)
+{
+	return 0;
+}
+
+static int DelClient(int ClientID, const char *pReason, void *pUser)
+{
+	s_NumConnected--;
+	return 0;
+}
+
+static int DrainServer(CNetServer *pServer)
+{
+	int NumChunks = 0;
+	CNetChunk Chunk;
+	SECURITY_TOKEN ResponseToken;
+	while(pServer->Recv(&Chunk, &ResponseToken))
+	{
+		NumChunks++;
+	}
+	return NumChunks;
+}
+
+static void UpdateClients(std::vector<std::unique_ptr<CNetClient>> &vpClients)
+{
+	CNetChunk Chunk;
+	for(auto &pClient : vpClients)
+	{
+		pClient->Update();
+		while(pClient->Recv(&Chunk))
+		{
+		}
+	}
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	secure_random_init();
+	log_set_global_logger_default();
+	net_init();
+	CNetBase::Init();
+
+	int NumClients = NET_MAX_CLIENTS;
+	int NumRounds = 20000;
+	int JunkPerRound = NET_MAX_CLIENTS;
+	bool Thread = false;
+	for(int i = 1; i + 1 < argc; i += 2)
+	{
+		if(str_comp(argv[i], "-c") == 0)
+			NumClients = clamp(str_toint(argv[i + 1]), 0, (int)NET_MAX_CLIENTS);
+		else if(str_comp(argv[i], "-r") == 0)
+			NumRounds = maximum(str_toint(argv[i + 1]), 1);
+		else if(str_comp(argv[i], "-j") == 0)
+			JunkPerRound = maximum(str_toint(argv[i + 1]), 0);
+		else if(str_comp(argv[i], "-t") == 0)
+			Thread = str_toint(argv[i + 1]) != 0;
+		else
+		{
+			log_error("net_recv_bench", "usage: %s [-c CLIENTS] [-r ROUNDS] [-j JUNK_PER_ROUND] [-t THREAD]", argv[0]);
+			return -1;
+		}
+	}
+
+	CConfigManager ConfigManager;
+	ConfigManager.Reset();
+
+	NETADDR BindAddr;
+	if(net_addr_from_str(&BindAddr, "127.0.0.1"))
+	{
+		log_error("net_recv_bench", "failed to parse bind address");
+		return -1;
+	}
+	std::unique_ptr<CNetServer> pServer = std::make_unique<CNetServer>();
+	do
+	{
+		BindAddr.port = secure_rand() % 64511 + 1024;
+	} while(!pServer->Open(BindAddr, nullptr, NET_MAX_CLIENTS, NET_MAX_CLIENTS));
+	pServer->SetCallbacks(NewClient, NewClientNoAuth, ClientRejoin, DelClient, nullptr);
+	if(Thread && !pServer->StartRecvThread(nullptr, nullptr))
+	{
+		log_error("net_recv_bench", "failed to start network thread");
+		return -1;
+	}
+	NETADDR ServerAddr = BindAddr;
+
+	BindAddr.port = 0;
+	std::vector<std::unique_ptr<CNetClient>> vpClients;
+	for(int i = 0; i < NumClients; i++)
+	{
+		vpClients.push_back(std::make_unique<CNetClient>());
+		if(!vpClients.back()->Open(BindAddr))
+		{
+			log_error("net_recv_bench", "failed to open client socket");
+			return -1;
+		}
+		vpClients.back()->Connect(&ServerAddr, 1);
+	}
+	NETSOCKET JunkSocket = net_udp_create(BindAddr);
+	if(!JunkSocket)
+	{
+		log_error("net_recv_bench", "failed to open junk socket");
+		return -1;
+	}
+
+	int64_t ConnectStart = time_get();
+	while(s_NumConnected < NumClients)
+	{
+		if(time_get() - ConnectStart > time_freq() * 10)
+		{
+			log_error("net_recv_bench", "only %d of %d clients connected", s_NumConnected, NumClients);
+			return -1;
+		}
+		UpdateClients(vpClients);
+		pServer->Update();
+		DrainServer(pServer.get());
+		pServer->WaitForPackets(1000);
+	}
+	log_info("net_recv_bench", "%d clients connected", NumClients);
+
+	unsigned char aPayload[32] = {0};
+	CNetChunk Chunk;
+	Chunk.m_ClientID = 0;
+	Chunk.m_Flags = NETSENDFLAG_FLUSH;
+	Chunk.m_DataSize = sizeof(aPayload);
+	Chunk.m_pData = aPayload;
+
+	int64_t NumPackets = 0;
+	int64_t NumChunks = 0;
+	int64_t RecvTime = 0;
+	for(int Round = 0; Round < NumRounds; Round++)
+	{
+		// Interleave junk with the client packets, the socket buffer is
+		// small, so keep the number of packets per round low.
+		for(int i = 0; i < maximum(NumClients, JunkPerRound); i++)
+		{
+			if(i < NumClients)
+			{
+				vpClients[i]->Send(&Chunk);
+				NumPackets++;
+			}
+			if(i < JunkPerRound)
+			{
+				unsigned char aJunk[48];
+				secure_random_fill(aJunk, sizeof(aJunk));
+				net_udp_send(JunkSocket, &ServerAddr, aJunk, sizeof(aJunk));
+				NumPackets++;
+			}
+		}
+
+		do
+		{
+			int64_t Start = time_get();
+			NumChunks += DrainServer(pServer.get());
+			RecvTime += time_get() - Start;
+		} while(Thread && pServer->WaitForPackets(200));
+
+		if(Round % 100 == 0)
+		{
+			// keep the connections alive
+			UpdateClients(vpClients);
+			pServer->Update();
+			DrainServer(pServer.get());
+		}
+	}
+
+	if(s_NumConnected < NumClients)
+		log_warn("net_recv_bench", "%d clients disconnected during the benchmark", NumClients - s_NumConnected);
+
+	float Seconds = RecvTime / (float)time_freq();
+	log_info("net_recv_bench", "%lld packets, %lld chunks in %.3fs: %.0f packets/s, %.0f ns/packet",
+		(long long)NumPackets, (long long)NumChunks, Seconds, NumPackets / maximum(Seconds, 0.000001f), Seconds * 1e9f / maximum(NumPackets, (int64_t)1));
+
+	net_udp_close(JunkSocket);
+	for(auto &pClient : vpClients)
+		pClient->Close();
+	pServer->Close();
+	return 0;
+}
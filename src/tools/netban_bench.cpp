@@ -0,0 +1,136 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/netban.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Imports a banlist with many random address and range bans and measures
+// `CNetBan::IsBanned` for random addresses, compared with checking every
+// ban one after another.
+
+static uint32_t s_Random = 1;
+static uint32_t Random()
+{
+	s_Random ^= s_Random << 13;
+	s_Random ^= s_Random >> 17;
+	s_Random ^= s_Random << 5;
+	return s_Random;
+}
+
+static NETADDR RandomAddr(int Type)
+{
+	NETADDR Addr;
+	mem_zero(&Addr, sizeof(Addr));
+	Addr.type = Type;
+	for(int i = 0; i < (Type == NETTYPE_IPV4 ? 4 : 16); i++)
+		Addr.ip[i] = Random();
+	// localhost can't be banned
+	if(Addr.ip[0] == 0 || Addr.ip[0] == 127)
+		Addr.ip[0] = 1;
+	return Addr;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	int NumBans = 100000;
+	int NumLookups = 1000000;
+	for(int i = 1; i + 1 < argc; i += 2)
+	{
+		if(str_comp(argv[i], "-b") == 0)
+			NumBans = maximum(str_toint(argv[i + 1]), 1);
+		else if(str_comp(argv[i], "-l") == 0)
+			NumLookups = maximum(str_toint(argv[i + 1]), 1);
+		else
+		{
+			log_error("netban_bench", "usage: %s [-b BANS] [-l LOOKUPS]", argv[0]);
+			return -1;
+		}
+	}
+
+	// mostly IPv4 ranges like the shared banlists, some addresses and IPv6
+	std::vector<CNetRange> vBans;
+	std::string Banlist;
+	char aLB[NETADDR_MAXSTRSIZE], aUB[NETADDR_MAXSTRSIZE], aLine[256];
+	for(int i = 0; i < NumBans; i++)
+	{
+		int Type = Random() % 8 == 0 ? NETTYPE_IPV6 : NETTYPE_IPV4;
+		CNetRange Range;
+		Range.m_LB = Range.m_UB = RandomAddr(Type);
+		if(Random() % 4 != 0)
+		{
+			int Bits = Type == NETTYPE_IPV4 ? 32 : 128;
+			int Length = Bits - 1 - Random() % (Bits / 2);
+			for(int Bit = Length; Bit < Bits; Bit++)
+			{
+				Range.m_LB.ip[Bit / 8] &= ~(1 << (7 - Bit % 8));
+				Range.m_UB.ip[Bit / 8] |= 1 << (7 - Bit % 8);
+			}
+		}
+		vBans.push_back(Range);
+		net_addr_str(&Range.m_LB, aLB, sizeof(aLB), false);
+		net_addr_str(&Range.m_UB, aUB, sizeof(aUB), false);
+		if(NetComp(&Range.m_LB, &Range.m_UB) == 0)
+			str_format(aLine, sizeof(aLine), "ban %s -1 bench\n", aLB);
+		else
+			str_format(aLine, sizeof(aLine), "ban_range %s %s -1 bench\n", aLB, aUB);
+		Banlist += aLine;
+	}
+
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	CNetBan Ban;
+	Ban.Init(pConsole.get(), nullptr);
+
+	int64_t Start = time_get();
+	int NumImported = Ban.ImportBans(Banlist.c_str());
+	int64_t ImportTime = time_get() - Start;
+	log_info("netban_bench", "imported %d bans in %.3fms", NumImported, ImportTime * 1000.0 / time_freq());
+
+	std::vector<NETADDR> vAddrs;
+	for(int i = 0; i < NumLookups; i++)
+	{
+		// half of them inside of bans
+		if(i % 2)
+			vAddrs.push_back(vBans[Random() % vBans.size()].m_UB);
+		else
+			vAddrs.push_back(RandomAddr(Random() % 8 == 0 ? NETTYPE_IPV6 : NETTYPE_IPV4));
+	}
+
+	char aReason[256];
+	int NumBanned = 0;
+	Start = time_get();
+	for(const NETADDR &Addr : vAddrs)
+		NumBanned += Ban.IsBanned(&Addr, aReason, sizeof(aReason));
+	int64_t LookupTime = time_get() - Start;
+	log_info("netban_bench", "trie: %d lookups, %d banned, %.1fns/lookup",
+		NumLookups, NumBanned, LookupTime * 1e9 / time_freq() / NumLookups);
+
+	// the linear scan is slow, only do a few lookups
+	int NumScans = minimum(NumLookups, 1000);
+	int NumBannedScan = 0;
+	Start = time_get();
+	for(int i = 0; i < NumScans; i++)
+	{
+		const NETADDR &Addr = vAddrs[i];
+		int Bytes = Addr.type == NETTYPE_IPV4 ? 4 : 16;
+		for(const CNetRange &Range : vBans)
+		{
+			if(Range.m_LB.type == Addr.type && mem_comp(Range.m_LB.ip, Addr.ip, Bytes) <= 0 && mem_comp(Range.m_UB.ip, Addr.ip, Bytes) >= 0)
+			{
+				NumBannedScan++;
+				break;
+			}
+		}
+	}
+	int64_t ScanTime = time_get() - Start;
+	log_info("netban_bench", "scan: %d lookups, %d banned, %.1fns/lookup",
+		NumScans, NumBannedScan, ScanTime * 1e9 / time_freq() / NumScans);
+	return 0;
+}
@@ -0,0 +1,635 @@
+#include <base/logger.h>
+#include <base/system.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/json.h>
+#include <engine/storage.h>
+#include <game/client/prediction/entities/character.h>
+#include <game/client/prediction/gameworld.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+#include <game/server/teehistorian.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Replays teehistorian files through the game world and compares the
+// simulated positions with the recorded ones.
+//
+// The world is the one used for the client side prediction, set up like the
+// server's: the map's tiles, switches and tune zones (from the header and the
+// map settings), the recorded config and teams, and the recorded PRNG seed so
+// that teleporters choose the same outs. Characters are only placed at the
+// recorded position when they spawn, afterwards they move on their own until
+// their position first differs from the recording. Things the world doesn't
+// know about, like the spawn points or chat commands, may still cause
+// mismatches.
+
+typedef std::vector<std::pair<std::string, int>> CGameConfig;
+
+// Sets a game config variable in `pConfig` if it's not `nullptr`. Returns
+// whether `pScriptName` names such a variable.
+static bool SetGameConfig(CConfig *pConfig, const char *pScriptName, int Value)
+{
+#define MACRO_CONFIG_INT(Name, ScriptName, Def, Min, Max, Flags, Desc) \
+	if((Flags)&CFGFLAG_GAME && str_comp(pScriptName, #ScriptName) == 0) \
+	{ \
+		if(pConfig) \
+			pConfig->m_##Name = Value; \
+		return true; \
+	}
+#define MACRO_CONFIG_COL(Name, ScriptName, Def, Flags, Desc)
+#define MACRO_CONFIG_STR(Name, ScriptName, Len, Def, Flags, Desc)
+
+#include <engine/shared/config_variables.h>
+
+#undef MACRO_CONFIG_INT
+#undef MACRO_CONFIG_COL
+#undef MACRO_CONFIG_STR
+	return false;
+}
+
+class CReplayJob : public IJob
+{
+	enum
+	{
+		NUM_TUNEZONES = 256
+	};
+
+	char m_aFilename[IO_MAX_PATH_LENGTH];
+	const char *m_pMapDirectory;
+
+	char m_aMapFilename[IO_MAX_PATH_LENGTH];
+	CTuningParams m_aTuningList[NUM_TUNEZONES];
+	bool m_Seeded;
+	uint64_t m_aSeed[2];
+
+	IKernel *m_pKernel;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	std::map<int, std::vector<vec2>> m_TeleOuts;
+	std::map<int, std::vector<vec2>> m_TeleCheckOuts;
+	CPrng m_Prng;
+	CGameWorld m_GameWorld;
+
+	CTeeHistorianReader m_Reader;
+	bool m_aRecordedAlive[MAX_CLIENTS];
+	int m_aRecordedX[MAX_CLIENTS];
+	int m_aRecordedY[MAX_CLIENTS];
+	bool m_aDiverged[MAX_CLIENTS];
+
+	void Run() override;
+	void Replay();
+	bool LoadMap();
+	void LoadMapSettings(IMap *pMap);
+	void InitWorld();
+	void OnInput(int ClientID);
+	void Simulate(int Tick);
+	void Compare(int Tick);
+
+public:
+	CReplayJob(const char *pFilename, const char *pMapDirectory);
+
+	bool ReadHeader();
+
+	CGameConfig m_Config;
+
+	int64_t m_Ticks;
+	int64_t m_CheckedPositions;
+	int m_Diverged;
+	int m_FirstMismatchTick;
+	bool m_Error;
+	char m_aError[128];
+
+	const char *Filename() const { return m_aFilename; }
+};
+
+CReplayJob::CReplayJob(const char *pFilename, const char *pMapDirectory) :
+	m_pMapDirectory(pMapDirectory),
+	m_Seeded(false),
+	m_pKernel(nullptr),
+	m_Ticks(0),
+	m_CheckedPositions(0),
+	m_Diverged(0),
+	m_FirstMismatchTick(-1),
+	m_Error(false)
+{
+	str_copy(m_aFilename, pFilename);
+	m_aMapFilename[0] = '\0';
+	m_aError[0] = '\0';
+
+	// Same defaults as the server's tune zones.
+	for(auto &Tuning : m_aTuningList)
+	{
+		Tuning.Set("gun_curvature", 0);
+		Tuning.Set("gun_speed", 1400);
+		Tuning.Set("shotgun_curvature", 0);
+		Tuning.Set("shotgun_speed", 500);
+		Tuning.Set("shotgun_speeddiff", 0);
+	}
+}
+
+bool CReplayJob::ReadHeader()
+{
+	IOHANDLE File = io_open(m_aFilename, IOFLAG_READ);
+	if(!File)
+	{
+		str_copy(m_aError, "failed to open file");
+		return true;
+	}
+	if(m_Reader.Open(File))
+	{
+		str_copy(m_aError, "failed to read header");
+		return true;
+	}
+	json_value *pHeader = json_parse(m_Reader.HeaderJson(), str_length(m_Reader.HeaderJson()));
+	// The file is opened again for the replay, don't keep it open while
+	// waiting for a thread.
+	m_Reader.Close();
+	if(!pHeader || pHeader->type != json_object)
+	{
+		str_copy(m_aError, "invalid header");
+		json_value_free(pHeader);
+		return true;
+	}
+
+	const json_value *pMapName = json_object_get(pHeader, "map_name");
+	if(pMapName->type != json_string)
+	{
+		str_copy(m_aError, "header contains no map name");
+		json_value_free(pHeader);
+		return true;
+	}
+	str_format(m_aMapFilename, sizeof(m_aMapFilename), "%s.map", json_string_get(pMapName));
+
+	// The global tuning, only values different from the defaults are
+	// written, as hundredths.
+	m_aTuningList[0] = CTuningParams();
+	const json_value *pTuning = json_object_get(pHeader, "tuning");
+	if(pTuning->type == json_object)
+	{
+		for(unsigned i = 0; i < pTuning->u.object.length; i++)
+		{
+			const json_value *pValue = pTuning->u.object.values[i].value;
+			for(int Index = 0; Index < CTuningParams::Num(); Index++)
+			{
+				if(pValue->type == json_string && str_comp(CTuningParams::Name(Index), pTuning->u.object.values[i].name) == 0)
+				{
+					m_aTuningList[0].Set(Index, str_toint(json_string_get(pValue)) / 100.0f);
+				}
+			}
+		}
+	}
+
+	// Config variables different from the defaults. Only the ones affecting
+	// the game are kept.
+	const json_value *pConfig = json_object_get(pHeader, "config");
+	if(pConfig->type == json_object)
+	{
+		for(unsigned i = 0; i < pConfig->u.object.length; i++)
+		{
+			const char *pName = pConfig->u.object.values[i].name;
+			const json_value *pValue = pConfig->u.object.values[i].value;
+			if(pValue->type == json_string && SetGameConfig(nullptr, pName, 0))
+			{
+				m_Config.emplace_back(pName, str_toint(json_string_get(pValue)));
+			}
+		}
+	}
+
+	// "pcg-xsh-rr:<seed[0]>:<seed[1]>" with the seeds as 16 hex digits.
+	const json_value *pPrng = json_object_get(pHeader, "prng_description");
+	if(pPrng->type == json_string)
+	{
+		const char *pSeeds = str_startswith(json_string_get(pPrng), "pcg-xsh-rr:");
+		unsigned char aaSeed[2][8];
+		if(pSeeds && str_length(pSeeds) == 2 * 16 + 1 && pSeeds[16] == ':')
+		{
+			char aSeed0[17];
+			str_copy(aSeed0, pSeeds);
+			if(str_hex_decode(aaSeed[0], sizeof(aaSeed[0]), aSeed0) == 0 &&
+				str_hex_decode(aaSeed[1], sizeof(aaSeed[1]), pSeeds + 17) == 0)
+			{
+				for(int i = 0; i < 2; i++)
+				{
+					m_aSeed[i] = ((uint64_t)bytes_be_to_uint(aaSeed[i]) << 32) | bytes_be_to_uint(aaSeed[i] + 4);
+				}
+				m_Seeded = true;
+			}
+		}
+	}
+	json_value_free(pHeader);
+	return false;
+}
+
+void CReplayJob::LoadMapSettings(IMap *pMap)
+{
+	// Only the tune zones, other settings are part of the header's config
+	// and tuning.
+	int Start, Num;
+	pMap->GetType(MAPITEMTYPE_INFO, &Start, &Num);
+	for(int i = Start; i < Start + Num; i++)
+	{
+		int ItemID;
+		CMapItemInfoSettings *pItem = (CMapItemInfoSettings *)pMap->GetItem(i, 0, &ItemID);
+		int ItemSize = pMap->GetItemSize(i);
+		if(!pItem || ItemID != 0)
+			continue;
+
+		if(ItemSize < (int)sizeof(CMapItemInfoSettings))
+			break;
+		if(!(pItem->m_Settings > -1))
+			break;
+
+		int Size = pMap->GetDataSize(pItem->m_Settings);
+		char *pSettings = (char *)pMap->GetData(pItem->m_Settings);
+		char *pNext = pSettings;
+		while(pNext < pSettings + Size)
+		{
+			int StrSize = str_length(pNext) + 1;
+			char aCommand[16];
+			char aZone[16];
+			char aName[64];
+			char aValue[32];
+			const char *pRest = str_next_token(pNext, " ", aCommand, sizeof(aCommand));
+			if(str_comp(aCommand, "tune_zone") == 0 && pRest &&
+				(pRest = str_next_token(pRest, " ", aZone, sizeof(aZone))) &&
+				(pRest = str_next_token(pRest, " ", aName, sizeof(aName))) &&
+				str_next_token(pRest, " ", aValue, sizeof(aValue)))
+			{
+				int Zone = str_toint(aZone);
+				if(Zone >= 0 && Zone < NUM_TUNEZONES)
+				{
+					m_aTuningList[Zone].Set(aName, str_tofloat(aValue));
+				}
+			}
+			pNext += StrSize;
+		}
+		pMap->UnloadData(pItem->m_Settings);
+		break;
+	}
+}
+
+bool CReplayJob::LoadMap()
+{
+	m_pKernel = IKernel::Create();
+	IStorage *pStorage = CreateTempStorage(m_pMapDirectory);
+	IEngineMap *pMap = CreateEngineMap();
+	m_pKernel->RegisterInterface(pStorage);
+	m_pKernel->RegisterInterface(pMap);
+	m_pKernel->RegisterInterface(static_cast<IMap *>(pMap), false);
+	if(!pMap->Load(m_aMapFilename))
+	{
+		str_format(m_aError, sizeof(m_aError), "failed to load map '%s'", m_aMapFilename);
+		return true;
+	}
+	m_Layers.Init(m_pKernel);
+	m_Collision.Init(&m_Layers);
+	LoadMapSettings(pMap);
+
+	// Same as `CGameControllerDDRace::InitTeleporter`.
+	if(m_Layers.TeleLayer())
+	{
+		int Width = m_Layers.TeleLayer()->m_Width;
+		int Height = m_Layers.TeleLayer()->m_Height;
+		for(int i = 0; i < Width * Height; i++)
+		{
+			int Number = m_Collision.TeleLayer()[i].m_Number;
+			int Type = m_Collision.TeleLayer()[i].m_Type;
+			if(Number > 0)
+			{
+				if(Type == TILE_TELEOUT)
+				{
+					m_TeleOuts[Number - 1].push_back(
+						vec2(i % Width * 32 + 16, i / Width * 32 + 16));
+				}
+				else if(Type == TILE_TELECHECKOUT)
+				{
+					m_TeleCheckOuts[Number - 1].push_back(
+						vec2(i % Width * 32 + 16, i / Width * 32 + 16));
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void CReplayJob::InitWorld()
+{
+	m_GameWorld.m_GameTickSpeed = SERVER_TICK_SPEED;
+	m_GameWorld.m_pCollision = &m_Collision;
+	m_GameWorld.m_pTuningList = m_aTuningList;
+	m_GameWorld.m_pTeleOuts = &m_TeleOuts;
+	m_GameWorld.m_pTeleCheckOuts = &m_TeleCheckOuts;
+	m_GameWorld.m_Core.m_aTuning[0] = m_aTuningList[0];
+	m_GameWorld.m_Core.InitSwitchers(m_Collision.m_HighestSwitchNumber);
+	if(m_Seeded)
+	{
+		m_Prng.Seed(m_aSeed);
+		m_GameWorld.m_Core.m_pPrng = &m_Prng;
+	}
+
+	m_GameWorld.m_WorldConfig.m_IsDDRace = true;
+	m_GameWorld.m_WorldConfig.m_IsVanilla = false;
+	m_GameWorld.m_WorldConfig.m_IsFNG = false;
+	m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
+	m_GameWorld.m_WorldConfig.m_PredictTiles = true;
+	m_GameWorld.m_WorldConfig.m_PredictFreeze = true;
+	m_GameWorld.m_WorldConfig.m_PredictWeapons = true;
+	m_GameWorld.m_WorldConfig.m_PredictDDRace = true;
+	m_GameWorld.m_WorldConfig.m_IsSolo = false;
+	m_GameWorld.m_WorldConfig.m_UseTuneZones = true;
+	// Chatting is handled below, like in `CPlayer`.
+	m_GameWorld.m_WorldConfig.m_BugDDRaceInput = true;
+	m_GameWorld.m_WorldConfig.m_NoWeakHookAndBounce = g_Config.m_SvNoWeakHook;
+}
+
+void CReplayJob::OnInput(int ClientID)
+{
+	// Same as `CPlayer::OnPredictedEarlyInput`.
+	CCharacter *pChar = m_GameWorld.GetCharacterByID(ClientID);
+	CNetObj_PlayerInput Input = m_Reader.Player(ClientID).m_Input;
+	if(pChar && !(Input.m_PlayerFlags & PLAYERFLAG_CHATTING))
+	{
+		pChar->OnDirectInput(&Input);
+	}
+}
+
+void CReplayJob::Simulate(int Tick)
+{
+	// Same as `CPlayer::OnPredictedInput`.
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChar = m_GameWorld.GetCharacterByID(i);
+		CNetObj_PlayerInput Input = m_Reader.Player(i).m_Input;
+		if(pChar && m_Reader.Player(i).m_HasInput && !(Input.m_PlayerFlags & PLAYERFLAG_CHATTING))
+		{
+			pChar->OnPredictedInput(&Input);
+		}
+	}
+	m_GameWorld.m_GameTick = Tick;
+	m_GameWorld.m_Core.m_aTuning[0] = m_aTuningList[0];
+	m_GameWorld.Tick();
+}
+
+void CReplayJob::Compare(int Tick)
+{
+	m_Ticks++;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_GameWorld.m_Teams.Team(i, m_Reader.Player(i).m_Team);
+		CCharacter *pChar = m_GameWorld.GetCharacterByID(i);
+		if(!m_aRecordedAlive[i])
+		{
+			delete pChar;
+			continue;
+		}
+		if(!pChar)
+		{
+			// Spawned in this tick, start at the recorded position.
+			CNetObj_Character Char;
+			mem_zero(&Char, sizeof(Char));
+			Char.m_X = m_aRecordedX[i];
+			Char.m_Y = m_aRecordedY[i];
+			Char.m_Weapon = WEAPON_GUN;
+			pChar = new CCharacter(&m_GameWorld, i, &Char);
+			m_GameWorld.InsertEntity(pChar);
+
+			// Same as `CCharacter::Spawn` on the server.
+			pChar->GiveWeapon(WEAPON_HAMMER);
+			pChar->Core()->m_EndlessHook = g_Config.m_SvEndlessDrag;
+			if(!g_Config.m_SvHit)
+			{
+				pChar->Core()->m_HammerHitDisabled = true;
+				pChar->Core()->m_ShotgunHitDisabled = true;
+				pChar->Core()->m_GrenadeHitDisabled = true;
+				pChar->Core()->m_LaserHitDisabled = true;
+			}
+			m_aDiverged[i] = false;
+			continue;
+		}
+		if(m_aDiverged[i])
+		{
+			continue;
+		}
+
+		CNetObj_CharacterCore Core;
+		pChar->Core()->Write(&Core);
+		m_CheckedPositions++;
+		if(Core.m_X != m_aRecordedX[i] || Core.m_Y != m_aRecordedY[i])
+		{
+			if(m_FirstMismatchTick == -1)
+			{
+				m_FirstMismatchTick = Tick;
+			}
+			m_Diverged++;
+			m_aDiverged[i] = true;
+		}
+	}
+}
+
+void CReplayJob::Run()
+{
+	Replay();
+
+	// Free the map before the next file is replayed.
+	m_GameWorld.Clear();
+	m_Reader.Close();
+	m_Collision.Dest();
+	delete m_pKernel;
+	m_pKernel = nullptr;
+}
+
+void CReplayJob::Replay()
+{
+	if(LoadMap())
+	{
+		m_Error = true;
+		return;
+	}
+	IOHANDLE File = io_open(m_aFilename, IOFLAG_READ);
+	if(!File || m_Reader.Open(File))
+	{
+		str_copy(m_aError, "failed to reopen file");
+		m_Error = true;
+		return;
+	}
+	InitWorld();
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_aRecordedAlive[i] = false;
+		m_aRecordedX[i] = 0;
+		m_aRecordedY[i] = 0;
+		m_aDiverged[i] = false;
+	}
+
+	// Player positions are recorded at the end of a tick, followed by the
+	// inputs which are applied in the next tick.
+	int CurTick = 0;
+	CTeeHistorianReader::CChunk Chunk;
+	int Result;
+	while((Result = m_Reader.Next(&Chunk)) == CTeeHistorianReader::READ_CHUNK)
+	{
+		if(Chunk.m_Tick > CurTick)
+		{
+			if(CurTick > 0)
+			{
+				Compare(CurTick);
+			}
+			for(int Tick = CurTick + 1; Tick < Chunk.m_Tick; Tick++)
+			{
+				Simulate(Tick);
+				Compare(Tick);
+			}
+			Simulate(Chunk.m_Tick);
+			CurTick = Chunk.m_Tick;
+		}
+
+		switch(Chunk.m_Type)
+		{
+		case CTeeHistorianReader::CHUNK_PLAYER_DIFF:
+		case TEEHISTORIAN_PLAYER_NEW:
+		case TEEHISTORIAN_PLAYER_OLD:
+		{
+			const CTeeHistorianReader::CPlayer &Player = m_Reader.Player(Chunk.m_ClientID);
+			m_aRecordedAlive[Chunk.m_ClientID] = Player.m_Alive;
+			m_aRecordedX[Chunk.m_ClientID] = Player.m_X;
+			m_aRecordedY[Chunk.m_ClientID] = Player.m_Y;
+			break;
+		}
+		case TEEHISTORIAN_INPUT_DIFF:
+		case TEEHISTORIAN_INPUT_NEW:
+			OnInput(Chunk.m_ClientID);
+			break;
+		}
+	}
+	if(CurTick > 0)
+	{
+		Compare(CurTick);
+	}
+	if(Result == CTeeHistorianReader::READ_ERROR)
+	{
+		str_format(m_aError, sizeof(m_aError), "error reading chunk after tick %d", CurTick);
+		m_Error = true;
+	}
+}
+
+using namespace std::chrono_literals;
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	int NumThreads = std::thread::hardware_concurrency();
+	const char *pMapDirectory = "maps";
+	int FirstFile = 1;
+	while(FirstFile + 1 < argc && argv[FirstFile][0] == '-')
+	{
+		if(str_comp(argv[FirstFile], "-j") == 0)
+		{
+			NumThreads = str_toint(argv[FirstFile + 1]);
+		}
+		else if(str_comp(argv[FirstFile], "-m") == 0)
+		{
+			pMapDirectory = argv[FirstFile + 1];
+		}
+		else
+		{
+			break;
+		}
+		FirstFile += 2;
+	}
+	if(FirstFile >= argc)
+	{
+		dbg_msg("usage", "%s [-j THREADS] [-m MAP_DIRECTORY] <TEEHISTORIAN>...", argv[0]);
+		return -1;
+	}
+
+	CJobPool Pool;
+	Pool.Init(clamp(NumThreads, 1, 32));
+
+	int64_t Start = time_get();
+	std::vector<std::shared_ptr<CReplayJob>> vpJobs;
+	std::vector<std::shared_ptr<CReplayJob>> vpReplayJobs;
+	for(int i = FirstFile; i < argc; i++)
+	{
+		vpJobs.push_back(std::make_shared<CReplayJob>(argv[i], pMapDirectory));
+		if(vpJobs.back()->ReadHeader())
+		{
+			vpJobs.back()->m_Error = true;
+		}
+		else
+		{
+			vpReplayJobs.push_back(vpJobs.back());
+		}
+	}
+
+	// The world reads the game config from `g_Config`, so files recorded
+	// with the same config are replayed together.
+	std::stable_sort(vpReplayJobs.begin(), vpReplayJobs.end(), [](const std::shared_ptr<CReplayJob> &pA, const std::shared_ptr<CReplayJob> &pB) {
+		return pA->m_Config < pB->m_Config;
+	});
+	CConfigManager ConfigManager;
+	for(size_t First = 0; First < vpReplayJobs.size();)
+	{
+		size_t End = First;
+		while(End < vpReplayJobs.size() && vpReplayJobs[End]->m_Config == vpReplayJobs[First]->m_Config)
+		{
+			End++;
+		}
+		ConfigManager.Reset();
+		for(const auto &[Name, Value] : vpReplayJobs[First]->m_Config)
+		{
+			SetGameConfig(&g_Config, Name.c_str(), Value);
+		}
+		for(size_t i = First; i < End; i++)
+		{
+			Pool.Add(vpReplayJobs[i]);
+		}
+		for(size_t i = First; i < End; i++)
+		{
+			while(vpReplayJobs[i]->Status() != IJob::STATE_DONE)
+			{
+				std::this_thread::sleep_for(1ms);
+			}
+		}
+		First = End;
+	}
+
+	int64_t TotalTicks = 0;
+	int NumFailed = 0;
+	for(auto &pJob : vpJobs)
+	{
+		TotalTicks += pJob->m_Ticks;
+		if(pJob->m_Error)
+		{
+			NumFailed++;
+			dbg_msg("teehistorian_replay", "%s: %s", pJob->Filename(), pJob->m_aError);
+		}
+		else if(pJob->m_Diverged)
+		{
+			NumFailed++;
+			dbg_msg("teehistorian_replay", "%s: %d characters diverged from the recording (%lld positions checked), first at tick %d", pJob->Filename(), pJob->m_Diverged, (long long)pJob->m_CheckedPositions, pJob->m_FirstMismatchTick);
+		}
+		else
+		{
+			dbg_msg("teehistorian_replay", "%s: ok, %lld ticks", pJob->Filename(), (long long)pJob->m_Ticks);
+		}
+	}
+	float Seconds = (time_get() - Start) / (float)time_freq();
+	dbg_msg("teehistorian_replay", "%d files, %d failed, %lld ticks in %.2fs (%.0f ticks/s)", (int)vpJobs.size(), NumFailed, (long long)TotalTicks, Seconds, TotalTicks / maximum(Seconds, 0.001f));
+	Pool.Destroy();
+	return NumFailed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#include <base/logger.h>
+#include <base/system.h>
+#include <game/server/teehistorian.h>
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+	if(argc != 2 && argc != 3)
+	{
+		dbg_msg("usage", "%s <TEEHISTORIAN> [TICK]", argv[0]);
+		return -1;
+	}
+
+	IOHANDLE File = io_open(argv[1], IOFLAG_READ);
+	if(!File)
+	{
+		dbg_msg("teehistorian_seek", "failed to open '%s'", argv[1]);
+		return -1;
+	}
+	CTeeHistorianReader Reader;
+	if(Reader.Open(File))
+	{
+		dbg_msg("teehistorian_seek", "failed to read '%s'", argv[1]);
+		return -1;
+	}
+
+	if(argc == 2)
+	{
+		// Print the header only.
+		dbg_msg("teehistorian_seek", "compressed=%d", Reader.Compressed());
+		dbg_msg("teehistorian_seek", "%s", Reader.HeaderJson());
+		return 0;
+	}
+
+	// Seek past the wanted tick so the state includes it.
+	int Tick = str_toint(argv[2]);
+	int64_t Start = time_get();
+	if(Reader.Seek(Tick + 1))
+	{
+		dbg_msg("teehistorian_seek", "failed to seek to tick %d", Tick);
+		return -1;
+	}
+	dbg_msg("teehistorian_seek", "seeked to tick %d in %.3fms", Tick, (time_get() - Start) * 1000.0 / time_freq());
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const CTeeHistorianReader::CPlayer &Player = Reader.Player(i);
+		if(Player.m_Alive)
+		{
+			dbg_msg("teehistorian_seek", "cid=%d x=%d y=%d team=%d", i, Player.m_X, Player.m_Y, Player.m_Team);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/shared/timingwheel.h>
+
+#include <memory>
+#include <vector>
+
+// Compares `CTimingWheel` with checking every timer on every tick, like the
+// server used to update its connections. Timers get random deadlines of up
+// to a few seconds and are rescheduled whenever they fire.
+
+static const int NUM_TIMERS = 100000;
+static const int64_t TICK = 20; // ms
+static const int64_t MAX_DELAY = 5000; // ms
+
+static uint32_t s_Random = 1;
+static int64_t RandomDelay()
+{
+	// xorshift, fast and deterministic so both runs see the same deadlines
+	s_Random ^= s_Random << 13;
+	s_Random ^= s_Random >> 17;
+	s_Random ^= s_Random << 5;
+	return 1 + s_Random % MAX_DELAY;
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	int NumTicks = 3000;
+	if(argc == 3 && str_comp(argv[1], "-t") == 0)
+		NumTicks = maximum(str_toint(argv[2]), 1);
+	else if(argc != 1)
+	{
+		log_error("timingwheel_bench", "usage: %s [-t TICKS]", argv[0]);
+		return -1;
+	}
+
+	int64_t NumFiredNaive = 0;
+	int64_t NaiveTime;
+	{
+		s_Random = 1;
+		std::vector<int64_t> vDeadlines(NUM_TIMERS);
+		for(auto &Deadline : vDeadlines)
+			Deadline = RandomDelay();
+		int64_t Start = time_get();
+		for(int64_t Now = TICK; Now <= NumTicks * TICK; Now += TICK)
+		{
+			for(int ID = 0; ID < NUM_TIMERS; ID++)
+			{
+				if(vDeadlines[ID] < Now)
+				{
+					NumFiredNaive++;
+					vDeadlines[ID] = Now + RandomDelay();
+				}
+			}
+		}
+		NaiveTime = time_get() - Start;
+	}
+
+	int64_t NumFiredWheel = 0;
+	int64_t WheelTime;
+	{
+		s_Random = 1;
+		auto pWheel = std::make_unique<CTimingWheel<NUM_TIMERS>>();
+		pWheel->Init(1, 0);
+		for(int ID = 0; ID < NUM_TIMERS; ID++)
+			pWheel->Schedule(ID, RandomDelay());
+		int64_t Start = time_get();
+		for(int64_t Now = TICK; Now <= NumTicks * TICK; Now += TICK)
+		{
+			pWheel->Advance(Now, [&](int ID) {
+				NumFiredWheel++;
+				pWheel->Schedule(ID, Now + RandomDelay());
+			});
+		}
+		WheelTime = time_get() - Start;
+	}
+
+	// the timers fire in a different order and get different delays, so the
+	// counts may differ slightly
+	log_info("timingwheel_bench", "%d timers, %d ticks of %dms", NUM_TIMERS, NumTicks, (int)TICK);
+	log_info("timingwheel_bench", "sweep: %lld fired, %.3fms, %.3fus/tick",
+		(long long)NumFiredNaive, NaiveTime * 1000.0 / time_freq(), NaiveTime * 1000000.0 / time_freq() / NumTicks);
+	log_info("timingwheel_bench", "wheel: %lld fired, %.3fms, %.3fus/tick",
+		(long long)NumFiredWheel, WheelTime * 1000.0 / time_freq(), WheelTime * 1000000.0 / time_freq() / NumTicks);
+	return 0;
+}